@@ -37,6 +37,7 @@ typedef struct
 	uint8_t* p;
 	uint8_t* end;
 	int bits_left;
+	void* priv; // owner of the bitstream, e.g. the h264_stream_t while reading a nal; not used by bs_* functions
 } bs_t;
 
 #define _OPTIMIZE_BS_ 1
@@ -56,6 +57,7 @@ static uint32_t bs_byte_aligned(bs_t* b);
 static int bs_eof(bs_t* b);
 static int bs_overrun(bs_t* b);
 static int bs_pos(bs_t* b);
+static int bs_bit_pos(bs_t* b);
 
 static uint32_t bs_peek_u1(bs_t* b);
 static uint32_t bs_read_u1(bs_t* b);
@@ -74,6 +76,7 @@ static void bs_write_se(bs_t* b, int32_t v);
 
 static int bs_read_bytes(bs_t* b, uint8_t* buf, int len);
 static int bs_write_bytes(bs_t* b, uint8_t* buf, int len);
+static void bs_write_bits(bs_t* b, const uint8_t* src, int src_bit_offset, int num_bits);
 static int bs_skip_bytes(bs_t* b, int len);
 static uint32_t bs_next_bits(bs_t* b, int nbits);
 // IMPLEMENTATION
@@ -84,6 +87,7 @@ static inline bs_t* bs_init(bs_t* b, uint8_t* buf, size_t size)
     b->p = buf;
     b->end = buf + size;
     b->bits_left = 8;
+    b->priv = NULL;
     return b;
 }
 
@@ -105,6 +109,7 @@ static inline bs_t* bs_clone(bs_t* dest, const bs_t* src)
     dest->p = src->p;
     dest->end = src->end;
     dest->bits_left = src->bits_left;
+    dest->priv = src->priv;
     return dest;
 }
 
@@ -119,6 +124,8 @@ static inline int bs_overrun(bs_t* b) { if (b->p > b->end) { return 1; } else {
 
 static inline int bs_pos(bs_t* b) { if (b->p > b->end) { return (b->end - b->start); } else { return (b->p - b->start); } }
 
+static inline int bs_bit_pos(bs_t* b) { return (b->p - b->start) * 8 + (8 - b->bits_left); }
+
 static inline int bs_bytes_left(bs_t* b) { return (b->end - b->p); }
 
 static inline uint32_t bs_read_u1(bs_t* b)
@@ -200,7 +207,7 @@ static inline uint32_t bs_read_ue(bs_t* b)
         i++;
     }
     r = bs_read_u(b, i);
-    r += (1 << i) - 1;
+    r += (uint32_t)((1ULL << i) - 1); // i can be 32 on corrupt data, avoid the undefined 1 << 32
     return r;
 }
 
@@ -350,6 +357,54 @@ static inline int bs_write_bytes(bs_t* b, uint8_t* buf, int len)
     return actual_len;
 }
 
+// write num_bits bits of src, from bit src_bit_offset on (0 is the most significant bit of src[0]), at any bit position of b
+static inline void bs_write_bits(bs_t* b, const uint8_t* src, int src_bit_offset, int num_bits)
+{
+    src += src_bit_offset >> 3;
+    src_bit_offset &= 7;
+
+    // a bit at a time until the output is byte aligned
+    while (num_bits > 0 && b->bits_left != 8)
+    {
+        bs_write_u1(b, (src[0] >> (7 - src_bit_offset)) & 0x01);
+        if (++src_bit_offset == 8) { src++; src_bit_offset = 0; }
+        num_bits--;
+    }
+
+    // whole bytes: a copy, or if the input is not aligned each byte made of two, 64 bits at a time
+    int len = num_bits >> 3;
+    int actual_len = len;
+    if (b->end - b->p < actual_len) { actual_len = b->end - b->p; }
+    if (actual_len < 0) { actual_len = 0; }
+    if (src_bit_offset == 0)
+    {
+        memcpy(b->p, src, actual_len);
+    }
+    else
+    {
+        int s = src_bit_offset;
+        int i = 0;
+        for ( ; i + 8 <= actual_len; i += 8)
+        {
+            uint64_t w = 0;
+            for (int j = 0; j < 8; j++) { w = (w << 8) | src[i + j]; }
+            w = (w << s) | (src[i + 8] >> (8 - s));
+            for (int j = 7; j >= 0; j--) { b->p[i + j] = (uint8_t)w; w >>= 8; }
+        }
+        for ( ; i < actual_len; i++) { b->p[i] = (uint8_t)((src[i] << s) | (src[i + 1] >> (8 - s))); }
+    }
+    b->p += len;
+    src += len;
+    num_bits &= 7;
+
+    while (num_bits > 0)
+    {
+        bs_write_u1(b, (src[0] >> (7 - src_bit_offset)) & 0x01);
+        if (++src_bit_offset == 8) { src++; src_bit_offset = 0; }
+        num_bits--;
+    }
+}
+
 static inline int bs_skip_bytes(bs_t* b, int len)
 {
     int actual_len = len;
@@ -20,6 +20,10 @@
  */
 
 #include "h264_stream.h"
+#include "h264_ts.h"
+#include "h264_rtp.h"
+#include "h264_avcc.h"
+#include "h264_mp4.h"
 
 #include <stdlib.h>
 #include <stdint.h>
@@ -41,6 +45,11 @@ static struct option long_options[] =
     { "output",  required_argument, NULL, 'o'},
     { "help",    no_argument,       NULL, 'h'},
     { "verbose", required_argument, NULL, 'v'},
+    { "rtp",     required_argument, NULL, 'r'},
+    { "rtp-file", required_argument, NULL, 'R'},
+    { "rtp-in",  no_argument,       NULL, 'D'},
+    { "mp4",     required_argument, NULL, 'm'},
+    { NULL,      0,                 NULL, 0 },
 };
 #endif
 
@@ -48,21 +57,414 @@ static char options[] =
 "\t-o output_file, defaults to test.264\n"
 "\t-v verbose_level, print more info\n"
 "\t-p print codec for HTML5 video tag's codecs parameter, per RFC6381\n"
+"\t-r mtu, packetize into RTP packets (RFC 6184) of at most mtu bytes and print them, at 30 frames per second\n"
+"\t-R rtp_file, also write the RTP packets to rtp_file, each after its 16-bit length (RFC 4571)\n"
+"\t-D the input is RTP packets, each after its 16-bit length (RFC 4571), e.g. from -R\n"
+"\t-m mp4_file, also write the stream as fragmented MP4 to mp4_file, a fragment per IDR at 30 frames per second, and print its samples\n"
 "\t-h print this message and exit\n";
 
 void usage( )
 {
 
     fprintf( stderr, "h264_analyze, version 0.2.0\n");
-    fprintf( stderr, "Analyze H.264 bitstreams in Annex B format\n");
+    fprintf( stderr, "Analyze H.264 bitstreams in Annex B format, or in MPEG-2 transport streams\n");
     fprintf( stderr, "Usage: \n");
 
     fprintf( stderr, "h264_analyze [options] <input bitstream>\noptions:\n%s\n", options);
 }
 
+// parse and print a NAL; returns 1 when probing is done
+static int analyze_nal(h264_stream_t* h, uint8_t* p, int size, int opt_probe)
+{
+    read_debug_nal_unit(h, p, size);
+
+    if ( opt_probe && h->nal->nal_unit_type == NAL_UNIT_TYPE_SPS )
+    {
+        // print codec parameter, per RFC 6381.
+        int constraint_byte = h->sps->constraint_set0_flag << 7;
+        constraint_byte = h->sps->constraint_set1_flag << 6;
+        constraint_byte = h->sps->constraint_set2_flag << 5;
+        constraint_byte = h->sps->constraint_set3_flag << 4;
+        constraint_byte = h->sps->constraint_set4_flag << 3;
+        constraint_byte = h->sps->constraint_set4_flag << 3;
+
+        h264_dbg_printf( h, "codec: avc1.%02X%02X%02X\n",h->sps->profile_idc, constraint_byte, h->sps->level_idc );
+
+        // TODO: add more, move to h264_stream (?)
+        return 1;
+    }
+    return 0;
+}
+
+typedef struct
+{
+    h264_stream_t* h;
+    int opt_verbose;
+    int opt_probe;
+    int done;
+    uint8_t* nal;       // a NAL which came in pieces, put together
+    int nal_size;
+    int nal_capacity;
+} ts_analyze_t;
+
+static void ts_nal(void* opaque, const uint8_t* data, int size, int flags, int64_t pts, int64_t dts)
+{
+    ts_analyze_t* a = (ts_analyze_t*)opaque;
+    if ( a->done ) { return; }
+
+    if ( (flags & H264_TS_AU_START) && a->opt_verbose > 0 )
+    {
+        h264_dbg_printf( a->h, "!! Found PES, PTS %lld, DTS %lld \n", (long long int)pts, (long long int)dts );
+    }
+
+    // a NAL in one piece is parsed where it is
+    if ( (flags & H264_TS_NAL_START) && (flags & H264_TS_NAL_END) )
+    {
+        a->nal_size = 0;
+    }
+    else
+    {
+        if ( flags & H264_TS_NAL_START ) { a->nal_size = 0; }
+        if ( a->nal_size + size > a->nal_capacity )
+        {
+            a->nal_capacity = 2 * (a->nal_size + size);
+            a->nal = (uint8_t*)realloc(a->nal, a->nal_capacity);
+        }
+        memcpy(a->nal + a->nal_size, data, size);
+        a->nal_size += size;
+        if ( !(flags & H264_TS_NAL_END) ) { return; }
+        data = a->nal;
+        size = a->nal_size;
+    }
+
+    if ( a->opt_verbose > 0 )
+    {
+        h264_dbg_printf( a->h, "!! Found NAL, size %lld (0x%04llX) \n", (long long int)size, (long long int)size );
+    }
+    if ( size > 0 ) { a->done = analyze_nal(a->h, (uint8_t*)data, size, a->opt_probe); }
+}
+
+static void analyze_ts(h264_stream_t* h, FILE* infile, uint8_t* buf, size_t sz, int opt_verbose, int opt_probe)
+{
+    ts_analyze_t a;
+    memset(&a, 0, sizeof(a));
+    a.h = h;
+    a.opt_verbose = opt_verbose;
+    a.opt_probe = opt_probe;
+    h264_ts_t* ts = h264_ts_new(ts_nal, &a);
+
+    while ( !a.done )
+    {
+        size_t used = h264_ts_demux(ts, buf, sz);
+        sz -= used;
+        memmove(buf, buf + used, sz);
+
+        size_t rsz = fread(buf + sz, 1, BUFSIZE - sz, infile);
+        if ( rsz == 0 )
+        {
+            if (ferror(infile)) { fprintf( stderr, "!! Error: read failed: %s \n", strerror(errno)); }
+            break;
+        }
+        sz += rsz;
+    }
+    if ( !a.done ) { h264_ts_flush(ts); }
+
+    if ( ts->discontinuities > 0 ) { fprintf( stderr, "!! Lost %d transport stream packets \n", ts->discontinuities ); }
+    h264_ts_free(ts);
+    free(a.nal);
+}
+
+static int nal_is_vcl(h264_stream_t* h)
+{
+    int nal_unit_type = h->nal->nal_unit_type;
+    return ( nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_NON_IDR || nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_IDR ||
+             nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION );
+}
+
+// whether the NAL just read starts a new access unit, if it comes after a VCL NAL (7.4.1.2.3)
+static int nal_starts_au(h264_stream_t* h)
+{
+    int nal_unit_type = h->nal->nal_unit_type;
+    return ( nal_unit_type >= NAL_UNIT_TYPE_SEI && nal_unit_type <= NAL_UNIT_TYPE_AUD ) ||
+           ( nal_unit_type >= 14 && nal_unit_type <= 18 ) ||
+           ( nal_is_vcl(h) && nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION && h->sh->first_mb_in_slice == 0 );
+}
+
+typedef struct
+{
+    h264_rtp_packetizer_t* r;
+    FILE* file;                 // packets, each after its length, or NULL
+    h264_nal_span_t* nals;      // of the access unit, so far
+    int num_nals;
+    int nals_capacity;
+    int after_vcl;
+    uint32_t timestamp;
+} rtp_analyze_t;
+
+static void rtp_flush(h264_stream_t* h, rtp_analyze_t* a, int end_of_au)
+{
+    h264_rtp_packetizer_t* r = a->r;
+    int n = h264_rtp_packetize(r, a->nals, a->num_nals, a->timestamp, end_of_au);
+    a->num_nals = 0;
+    if ( n < 0 ) { fprintf( stderr, "!! Error: MTU %d is too small \n", r->mtu ); return; }
+
+    for ( int i = 0; i < n; i++ )
+    {
+        h264_rtp_packet_t* pkt = &r->packets[i];
+        uint8_t* hdr = pkt->header;
+        int type = ( pkt->header_size > H264_RTP_HEADER_SIZE ) ? hdr[H264_RTP_HEADER_SIZE] & 0x1F : r->iov[pkt->iov_start].base[0] & 0x1F;
+        h264_dbg_printf( h, "!! RTP packet seq %d, timestamp %u, marker %d, size %d, ",
+                         ( hdr[2] << 8 ) | hdr[3], a->timestamp, hdr[1] >> 7, pkt->size );
+        if ( type == H264_RTP_STAP_A ) { h264_dbg_printf( h, "STAP-A of %d NALs \n", pkt->num_iov / 2 ); }
+        else if ( type == H264_RTP_FU_A )
+        {
+            uint8_t fu = hdr[H264_RTP_HEADER_SIZE + 1];
+            h264_dbg_printf( h, "FU-A%s%s of NAL type %d \n", ( fu & 0x80 ) ? " start" : "", ( fu & 0x40 ) ? " end" : "", fu & 0x1F );
+        }
+        else { h264_dbg_printf( h, "NAL type %d \n", type ); }
+
+        if ( a->file != NULL )
+        {
+            fputc( pkt->size >> 8, a->file );
+            fputc( pkt->size & 0xFF, a->file );
+            fwrite( pkt->header, 1, pkt->header_size, a->file );
+            for ( int j = pkt->iov_start; j < pkt->iov_start + pkt->num_iov; j++ ) { fwrite( r->iov[j].base, 1, r->iov[j].len, a->file ); }
+        }
+    }
+}
+
+// collect the NALs of an access unit, packetizing them when the next one starts (7.4.1.2.3)
+static void rtp_nal(h264_stream_t* h, rtp_analyze_t* a, uint8_t* p, int size)
+{
+    int vcl = nal_is_vcl(h);
+    if ( a->after_vcl && nal_starts_au(h) )
+    {
+        rtp_flush(h, a, 1);
+        a->timestamp += 3000;
+        a->after_vcl = 0;
+    }
+    if ( vcl ) { a->after_vcl = 1; }
+
+    if ( a->num_nals == a->nals_capacity )
+    {
+        a->nals_capacity = ( a->nals_capacity > 0 ) ? a->nals_capacity * 2 : 64;
+        a->nals = (h264_nal_span_t*)realloc(a->nals, a->nals_capacity * sizeof(h264_nal_span_t));
+    }
+    a->nals[a->num_nals].buf = p;
+    a->nals[a->num_nals].size = size;
+    a->num_nals++;
+}
+
+typedef struct
+{
+    h264_mp4_t* m;
+    FILE* file;
+    uint8_t* sps;               // the first SPS and PPS, which go into the avcC record
+    int sps_size;
+    uint8_t* pps;
+    int pps_size;
+    int init_written;
+    uint8_t* data;              // NALs of the fragment so far, each after its 32-bit length
+    int data_size;
+    int data_capacity;
+    int au_start;               // offset in data of the access unit being collected
+    h264_mp4_sample_t* samples; // of the fragment, followed by that of the access unit being collected
+    int num_samples;
+    int samples_capacity;
+    int after_vcl;
+} mp4_analyze_t;
+
+static int mp4_write_init(h264_stream_t* h, mp4_analyze_t* a)
+{
+    if ( a->sps == NULL || a->pps == NULL || a->sps_size < 4 ) { fprintf( stderr, "!! Error: no SPS and PPS for the MP4 init segment \n" ); return -1; }
+
+    // an avcC record of the first SPS and PPS, with 4-byte lengths, parsed with a stream of its own
+    int record_size = 11 + a->sps_size + a->pps_size;
+    uint8_t* record = (uint8_t*)malloc(record_size);
+    record[0] = 1;
+    memcpy(record + 1, a->sps + 1, 3);  // profile_idc, constraint flags, level_idc
+    record[4] = 0xFF;
+    record[5] = 0xE1;
+    record[6] = a->sps_size >> 8;
+    record[7] = a->sps_size & 0xFF;
+    memcpy(record + 8, a->sps, a->sps_size);
+    record[8 + a->sps_size] = 1;
+    record[9 + a->sps_size] = a->pps_size >> 8;
+    record[10 + a->sps_size] = a->pps_size & 0xFF;
+    memcpy(record + 11 + a->sps_size, a->pps, a->pps_size);
+
+    avcc_t* avcc = avcc_new();
+    h264_stream_t* ps = h264_new();
+    bs_t b;
+    bs_init(&b, record, record_size);
+    int init_capacity = 1024 + record_size;
+    uint8_t* init = (uint8_t*)malloc(init_capacity);
+    int n = -1;
+    if ( read_avcc(avcc, ps, &b) >= 0 ) { n = h264_mp4_write_init(a->m, avcc, ps, init, init_capacity); }
+    if ( n < 0 ) { fprintf( stderr, "!! Error: could not write the MP4 init segment \n" ); }
+    else
+    {
+        fwrite(init, 1, n, a->file);
+        h264_dbg_printf( h, "!! MP4 init segment, size %d \n", n );
+    }
+
+    free(init);
+    h264_free(ps);
+    avcc_free(avcc);
+    free(record);
+    return n;
+}
+
+// write the complete access units collected so far as a fragment
+static void mp4_flush(h264_stream_t* h, mp4_analyze_t* a)
+{
+    if ( a->num_samples == 0 ) { return; }
+    if ( !a->init_written && mp4_write_init(h, a) >= 0 ) { a->init_written = 1; }
+
+    if ( a->init_written )
+    {
+        h264_mp4_composition_offsets(a->samples, a->num_samples);
+        uint32_t sequence_number = a->m->sequence_number;
+        int moof_capacity = 256 + 16 * a->num_samples;
+        uint8_t* moof = (uint8_t*)malloc(moof_capacity);
+        int n = h264_mp4_write_fragment(a->m, a->samples, a->num_samples, moof, moof_capacity);
+        if ( n < 0 ) { fprintf( stderr, "!! Error: could not write MP4 fragment %u \n", sequence_number ); }
+        else
+        {
+            fwrite(moof, 1, n, a->file);
+            fwrite(a->data, 1, a->au_start, a->file);
+
+            h264_dbg_printf( h, "!! MP4 fragment %u, %d samples, size %d \n", sequence_number, a->num_samples, n + a->au_start );
+            for ( int i = 0; i < a->num_samples; i++ )
+            {
+                h264_mp4_sample_t* s = &a->samples[i];
+                h264_dbg_printf( h, "!! MP4 sample size %u, duration %u, sync %d, picture order count %d, composition offset %d \n",
+                                 s->size, s->duration, s->is_sync, s->poc, s->composition_offset );
+            }
+        }
+        free(moof);
+    }
+
+    // the access unit being collected starts the next fragment
+    memmove(a->data, a->data + a->au_start, a->data_size - a->au_start);
+    a->data_size -= a->au_start;
+    a->au_start = 0;
+    a->samples[0] = a->samples[a->num_samples];
+    a->num_samples = 0;
+}
+
+// the end of an access unit: its sample is complete
+static void mp4_end_au(mp4_analyze_t* a)
+{
+    a->samples[a->num_samples].size = a->data_size - a->au_start;
+    a->num_samples++;
+    a->au_start = a->data_size;
+    a->after_vcl = 0;
+}
+
+// collect the access units of a fragment, writing it when an IDR starts the next one
+static void mp4_nal(h264_stream_t* h, mp4_analyze_t* a, uint8_t* p, int size)
+{
+    int nal_unit_type = h->nal->nal_unit_type;
+    int vcl = nal_is_vcl(h);
+    if ( a->after_vcl && nal_starts_au(h) ) { mp4_end_au(a); }
+
+    // the parameter sets are in the avcC record, not in the samples
+    if ( nal_unit_type == NAL_UNIT_TYPE_SPS || nal_unit_type == NAL_UNIT_TYPE_PPS )
+    {
+        uint8_t** ps = ( nal_unit_type == NAL_UNIT_TYPE_SPS ) ? &a->sps : &a->pps;
+        int* ps_size = ( nal_unit_type == NAL_UNIT_TYPE_SPS ) ? &a->sps_size : &a->pps_size;
+        if ( *ps == NULL )
+        {
+            *ps = (uint8_t*)malloc(size);
+            memcpy(*ps, p, size);
+            *ps_size = size;
+        }
+        return;
+    }
+
+    if ( vcl && !a->after_vcl )
+    {
+        if ( nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_IDR ) { mp4_flush(h, a); }
+        if ( a->num_samples + 1 >= a->samples_capacity )
+        {
+            a->samples_capacity = ( a->samples_capacity > 0 ) ? a->samples_capacity * 2 : 64;
+            a->samples = (h264_mp4_sample_t*)realloc(a->samples, a->samples_capacity * sizeof(h264_mp4_sample_t));
+        }
+        h264_mp4_sample_from_slice(a->m, h, &a->samples[a->num_samples]);
+    }
+    if ( vcl ) { a->after_vcl = 1; }
+
+    if ( a->data_size + 4 + size > a->data_capacity )
+    {
+        a->data_capacity = 2 * ( a->data_size + 4 + size );
+        a->data = (uint8_t*)realloc(a->data, a->data_capacity);
+    }
+    uint8_t* d = a->data + a->data_size;
+    d[0] = size >> 24;
+    d[1] = size >> 16;
+    d[2] = size >> 8;
+    d[3] = size;
+    memcpy(d + 4, p, size);
+    a->data_size += 4 + size;
+}
+
+typedef struct
+{
+    h264_stream_t* h;
+    int opt_verbose;
+    int opt_probe;
+    int done;
+} rtp_in_analyze_t;
+
+static void rtp_in_au(void* opaque, const h264_nal_span_t* nals, int num_nals, uint32_t timestamp, int flags)
+{
+    rtp_in_analyze_t* a = (rtp_in_analyze_t*)opaque;
+    if ( a->done ) { return; }
+
+    if ( a->opt_verbose > 0 )
+    {
+        h264_dbg_printf( a->h, "!! Found access unit, timestamp %u, %d NALs%s \n", timestamp, num_nals,
+                         ( flags & H264_RTP_AU_INCOMPLETE ) ? ", incomplete" : "" );
+    }
+    for ( int i = 0; i < num_nals && !a->done; i++ )
+    {
+        if ( a->opt_verbose > 0 )
+        {
+            h264_dbg_printf( a->h, "!! Found NAL, size %lld (0x%04llX) \n", (long long int)nals[i].size, (long long int)nals[i].size );
+        }
+        a->done = analyze_nal(a->h, (uint8_t*)nals[i].buf, nals[i].size, a->opt_probe);
+    }
+}
+
+static void analyze_rtp_in(h264_stream_t* h, FILE* infile, uint8_t* buf, int opt_verbose, int opt_probe)
+{
+    rtp_in_analyze_t a;
+    memset(&a, 0, sizeof(a));
+    a.h = h;
+    a.opt_verbose = opt_verbose;
+    a.opt_probe = opt_probe;
+    h264_rtp_depacketizer_t* d = h264_rtp_depacketizer_new(64, 65535, rtp_in_au, &a);
+
+    while ( !a.done && fread(buf, 1, 2, infile) == 2 )
+    {
+        int size = ( buf[0] << 8 ) | buf[1];
+        if ( fread(buf, 1, size, infile) != (size_t)size ) { break; }
+        if ( h264_rtp_depacketize(d, buf, size) < 0 ) { fprintf( stderr, "!! Not an RTP packet, size %d, dropped \n", size ); }
+    }
+    if ( !a.done ) { h264_rtp_depacketizer_flush(d); }
+
+    if ( d->lost_packets > 0 || d->late_packets > 0 )
+    {
+        fprintf( stderr, "!! Lost %d RTP packets, %d late \n", d->lost_packets, d->late_packets );
+    }
+    h264_rtp_depacketizer_free(d);
+}
+
 int main(int argc, char *argv[])
 {
     FILE* infile;
+    FILE* outfile = NULL;
 
     uint8_t* buf = (uint8_t*)malloc( BUFSIZE );
 
@@ -72,6 +474,10 @@ int main(int argc, char *argv[])
 
     int opt_verbose = 1;
     int opt_probe = 0;
+    int opt_rtp_mtu = 0;
+    char* opt_rtp_file = NULL;
+    int opt_rtp_in = 0;
+    char* opt_mp4_file = NULL;
 
 #ifdef HAVE_GETOPT_LONG
     int c;
@@ -79,12 +485,12 @@ int main(int argc, char *argv[])
     extern char* optarg;
     extern int   optind;
 
-    while ( ( c = getopt_long( argc, argv, "o:phv:", long_options, &long_options_index) ) != -1 )
+    while ( ( c = getopt_long( argc, argv, "o:phv:r:R:Dm:", long_options, &long_options_index) ) != -1 )
     {
         switch ( c )
         {
             case 'o':
-                if (h264_dbgfile == NULL) { h264_dbgfile = fopen( optarg, "wt"); }
+                if (outfile == NULL) { outfile = fopen( optarg, "wt"); }
                 break;
             case 'p':
                 opt_probe = 1;
@@ -93,6 +499,18 @@ int main(int argc, char *argv[])
             case 'v':
                 opt_verbose = atoi( optarg );
                 break;
+            case 'r':
+                opt_rtp_mtu = atoi( optarg );
+                break;
+            case 'R':
+                opt_rtp_file = optarg;
+                break;
+            case 'D':
+                opt_rtp_in = 1;
+                break;
+            case 'm':
+                opt_mp4_file = optarg;
+                break;
             case 'h':
             default:
                 usage( );
@@ -110,7 +528,8 @@ int main(int argc, char *argv[])
 
     if (infile == NULL) { fprintf( stderr, "!! Error: could not open file: %s \n", strerror(errno)); exit(EXIT_FAILURE); }
 
-    if (h264_dbgfile == NULL) { h264_dbgfile = stdout; }
+    if (outfile == NULL) { outfile = stdout; }
+    h264_dbg_set_file(h, outfile);
     
 
     size_t rsz = 0;
@@ -120,6 +539,42 @@ int main(int argc, char *argv[])
 
     int nal_start, nal_end;
 
+    rtp_analyze_t rtp;
+    memset(&rtp, 0, sizeof(rtp));
+    if ( opt_rtp_mtu > 0 )
+    {
+        rtp.r = h264_rtp_packetizer_new(opt_rtp_mtu, 96, 0x12345678, 0);
+        if ( opt_rtp_file != NULL ) { rtp.file = fopen(opt_rtp_file, "wb"); }
+        if ( opt_rtp_file != NULL && rtp.file == NULL ) { fprintf( stderr, "!! Error: could not open file: %s \n", strerror(errno)); exit(EXIT_FAILURE); }
+    }
+
+    mp4_analyze_t mp4;
+    memset(&mp4, 0, sizeof(mp4));
+    if ( opt_mp4_file != NULL )
+    {
+        mp4.m = h264_mp4_new(90000, 3000);
+        mp4.file = fopen(opt_mp4_file, "wb");
+        if ( mp4.file == NULL ) { fprintf( stderr, "!! Error: could not open file: %s \n", strerror(errno)); exit(EXIT_FAILURE); }
+    }
+
+    // transport streams are recognized by their sync bytes; Annex B starts with a zero byte
+    sz = opt_rtp_in ? 0 : fread(buf, 1, 2 * H264_TS_PACKET_SIZE, infile);
+    if ( opt_rtp_in )
+    {
+        analyze_rtp_in(h, infile, buf, opt_verbose, opt_probe);
+        fseek(infile, 0, SEEK_END);
+    }
+    else if ( sz > H264_TS_PACKET_SIZE && buf[0] == 0x47 && buf[H264_TS_PACKET_SIZE] == 0x47 )
+    {
+        analyze_ts(h, infile, buf, sz, opt_verbose, opt_probe);
+        fseek(infile, 0, SEEK_END);
+    }
+    else
+    {
+        fseek(infile, 0, SEEK_SET);
+    }
+    sz = 0;
+
     while (1)
     {
         rsz = fread(buf + sz, 1, BUFSIZE - sz, infile);
@@ -135,7 +590,7 @@ int main(int argc, char *argv[])
         {
             if ( opt_verbose > 0 )
             {
-               fprintf( h264_dbgfile, "!! Found NAL at offset %lld (0x%04llX), size %lld (0x%04llX) \n",
+               h264_dbg_printf( h, "!! Found NAL at offset %lld (0x%04llX), size %lld (0x%04llX) \n",
                       (long long int)(off + (p - buf) + nal_start),
                       (long long int)(off + (p - buf) + nal_start),
                       (long long int)(nal_end - nal_start),
@@ -143,28 +598,14 @@ int main(int argc, char *argv[])
             }
 
             p += nal_start;
-            read_debug_nal_unit(h, p, nal_end - nal_start);
-
-            if ( opt_probe && h->nal->nal_unit_type == NAL_UNIT_TYPE_SPS )
-            {
-                // print codec parameter, per RFC 6381.
-                int constraint_byte = h->sps->constraint_set0_flag << 7;
-                constraint_byte = h->sps->constraint_set1_flag << 6;
-                constraint_byte = h->sps->constraint_set2_flag << 5;
-                constraint_byte = h->sps->constraint_set3_flag << 4;
-                constraint_byte = h->sps->constraint_set4_flag << 3;
-                constraint_byte = h->sps->constraint_set4_flag << 3;
-
-                fprintf( h264_dbgfile, "codec: avc1.%02X%02X%02X\n",h->sps->profile_idc, constraint_byte, h->sps->level_idc );
-
-                // TODO: add more, move to h264_stream (?)
-                break; // we've seen enough, bailing out.
-            }
+            if ( analyze_nal(h, p, nal_end - nal_start, opt_probe) ) { break; } // we've seen enough, bailing out.
+            if ( rtp.r != NULL ) { rtp_nal(h, &rtp, p, nal_end - nal_start); }
+            if ( mp4.m != NULL ) { mp4_nal(h, &mp4, p, nal_end - nal_start); }
 
             if ( opt_verbose > 0 )
             {
-                // fprintf( h264_dbgfile, "XX ");
-                // debug_bytes(p-4, nal_end - nal_start + 4 >= 16 ? 16: nal_end - nal_start + 4);
+                // h264_dbg_printf( h, "XX ");
+                // debug_bytes(h, p-4, nal_end - nal_start + 4 >= 16 ? 16: nal_end - nal_start + 4);
 
                 // debug_nal(h, h->nal);
             }
@@ -173,6 +614,9 @@ int main(int argc, char *argv[])
             sz -= nal_end;
         }
 
+        // the NALs are about to move; an access unit still open at the end of the stream is complete
+        if ( rtp.r != NULL && rtp.num_nals > 0 ) { rtp_flush(h, &rtp, feof(infile)); }
+
         // if no NALs found in buffer, discard it
         if (p == buf) 
         {
@@ -191,10 +635,26 @@ int main(int argc, char *argv[])
         p = buf;
     }
 
-    h264_free(h);
+    if ( rtp.file != NULL ) { fclose(rtp.file); }
+    h264_rtp_packetizer_free(rtp.r);
+    free(rtp.nals);
+
+    if ( mp4.m != NULL )
+    {
+        if ( mp4.after_vcl ) { mp4_end_au(&mp4); }
+        mp4_flush(h, &mp4);
+        fclose(mp4.file);
+        h264_mp4_free(mp4.m);
+    }
+    free(mp4.sps);
+    free(mp4.pps);
+    free(mp4.data);
+    free(mp4.samples);
+
+    h264_free(h); // flushes debug output
     free(buf);
 
-    fclose(h264_dbgfile);
+    fclose(outfile);
     fclose(infile);
 
     return 0;
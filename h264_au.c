@@ -0,0 +1,607 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bs.h"
+#include "h264_stream.h"
+#include "h264_au.h"
+#include "h264_svc.h"
+
+static const uint8_t start_code[4] = { 0x00, 0x00, 0x00, 0x01 };
+
+// NALs which start the coded picture(s) of an access unit; SEI has to come before the first of them
+// 7.4.1.2.3 Order of NAL units and coded pictures and association to access units
+static int starts_picture(int nal_unit_type)
+{
+    return ( ( nal_unit_type >= NAL_UNIT_TYPE_CODED_SLICE_NON_IDR && nal_unit_type <= NAL_UNIT_TYPE_CODED_SLICE_IDR ) ||
+             nal_unit_type == NAL_UNIT_TYPE_PREFIX_NAL ||
+             nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION ||
+             nal_unit_type == 21 ); // coded slice extension (MVC, 3D-AVC)
+}
+
+static int is_replaced(int payloadType, sei_t** seis, int num_seis)
+{
+    for ( int i = 0; i < num_seis; i++ ) { if ( seis[i]->payloadType == payloadType ) { return 1; } }
+    return 0;
+}
+
+// the messages of an existing SEI NAL which are carried over into the new one
+typedef struct
+{
+    sei_view_t* views;
+    int num_views;
+    uint8_t* scratch;
+} carried_t;
+
+static int carry(carried_t* c, const h264_nal_span_t* nal)
+{
+    int max_views = nal->size / 2 + 1; // a message takes at least 2 bytes
+    c->views = (sei_view_t*)malloc(max_views * sizeof(sei_view_t));
+    c->scratch = (uint8_t*)malloc(nal->size);
+    c->num_views = sei_find_payloads(nal->buf, nal->size, NULL, c->views, max_views, c->scratch, nal->size);
+    if ( c->num_views < 0 || c->num_views > max_views ) { return -1; }
+    for ( int i = 0; i < c->num_views; i++ ) { if ( c->views[i].data == NULL ) { return -1; } }
+    return 0;
+}
+
+/**
+ Insert SEI messages into an access unit, or replace existing ones, without copying the rest of the access unit.
+ The messages are written into one new SEI NAL, placed after the AUD, parameter sets and existing SEI NALs and before the first
+ slice (or prefix NAL), or before the existing SEI if the new messages include a buffering period, which has to be first.
+ With H264_SEI_SPLICE_REPLACE, existing messages of the payload types given are removed; SEI NALs which had any are dropped and
+ their other messages moved into the new NAL, which then takes the place of the first of them.
+ The output is a list of pieces to be written in order: Annex B start codes, the untouched NALs themselves and the new SEI NAL in buf.
+ @param[in]  h          stream with the parameter sets the messages refer to (for buffering period and picture timing)
+ @param[in]  nals       the NALs of the access unit, in order
+ @param[in]  num_nals   number of NALs
+ @param[in]  seis       the messages to insert
+ @param[in]  num_seis   number of messages
+ @param[in]  flags      H264_SEI_SPLICE_INSERT or H264_SEI_SPLICE_REPLACE
+ @param[out] buf        memory for the new SEI NAL
+ @param[in]  buf_size   size of buf
+ @param[out] iov        the output pieces, at most 2 * (num_nals + 1)
+ @param[in]  max_iov    size of iov
+ @return     number of output pieces, or -1 if buf or iov were too small or an existing SEI NAL could not be parsed
+ */
+int h264_au_splice_sei(h264_stream_t* h, const h264_nal_span_t* nals, int num_nals, sei_t** seis, int num_seis, int flags,
+                       uint8_t* buf, int buf_size, h264_iovec_t* iov, int max_iov)
+{
+    int first_vcl = num_nals;
+    int first_sei = -1;
+    int has_bp = 0;
+    for ( int i = 0; i < num_seis; i++ ) { if ( seis[i]->payloadType == SEI_TYPE_BUFFERING_PERIOD ) { has_bp = 1; } }
+
+    carried_t* carried = (carried_t*)calloc(num_nals > 0 ? num_nals : 1, sizeof(carried_t));
+    int* dropped = (int*)calloc(num_nals > 0 ? num_nals : 1, sizeof(int));
+    int first_dropped = -1;
+    int rc = 0;
+
+    for ( int i = 0; i < num_nals && rc == 0; i++ )
+    {
+        if ( nals[i].size < 1 ) { continue; }
+        int nal_unit_type = nals[i].buf[0] & 0x1F;
+        if ( starts_picture(nal_unit_type) ) { first_vcl = i; break; }
+        if ( nal_unit_type != NAL_UNIT_TYPE_SEI ) { continue; }
+        if ( first_sei < 0 ) { first_sei = i; }
+        if ( !( flags & H264_SEI_SPLICE_REPLACE ) ) { continue; }
+
+        // a quick look first; most SEI NALs do not have any of the replaced types and stay as they are
+        sei_view_t view;
+        int types[1];
+        sei_filter_t filter = { types, 1, NULL, 0 };
+        for ( int j = 0; j < num_seis && !dropped[i]; j++ )
+        {
+            types[0] = seis[j]->payloadType;
+            if ( sei_find_payloads(nals[i].buf, nals[i].size, &filter, &view, 1, NULL, 0) > 0 ) { dropped[i] = 1; }
+        }
+        if ( !dropped[i] ) { continue; }
+        if ( first_dropped < 0 ) { first_dropped = i; }
+        rc = carry(&carried[i], &nals[i]);
+    }
+
+    int pos = first_vcl;
+    if ( first_dropped >= 0 ) { pos = first_dropped; }
+    if ( has_bp && first_sei >= 0 && first_sei < pos ) { pos = first_sei; }
+
+    // write the new SEI NAL: buffering period messages first, then all others
+    uint8_t* rbsp_buf = (uint8_t*)malloc(buf_size > 0 ? buf_size : 1);
+    bs_t* b = bs_new(rbsp_buf, buf_size);
+    b->priv = h;
+    int num_messages = 0;
+    bs_write_u(b, 1, 0);
+    bs_write_u(b, 2, NAL_REF_IDC_PRIORITY_DISPOSABLE);
+    bs_write_u(b, 5, NAL_UNIT_TYPE_SEI);
+    for ( int pass = 0; pass < 2 && rc == 0; pass++ )
+    {
+        for ( int i = 0; i < num_seis; i++ )
+        {
+            if ( ( seis[i]->payloadType == SEI_TYPE_BUFFERING_PERIOD ) != ( pass == 0 ) ) { continue; }
+            h->sei = seis[i];
+            seis[i]->payloadSize = sei_payload_size(h, seis[i]);
+            _write_ff_coded_number(b, seis[i]->payloadType);
+            _write_ff_coded_number(b, seis[i]->payloadSize);
+            write_sei_payload(h, b);
+            num_messages++;
+        }
+        for ( int i = 0; i < num_nals; i++ )
+        {
+            for ( int j = 0; j < carried[i].num_views; j++ )
+            {
+                sei_view_t* v = &carried[i].views[j];
+                if ( ( v->payloadType == SEI_TYPE_BUFFERING_PERIOD ) != ( pass == 0 ) ) { continue; }
+                if ( is_replaced(v->payloadType, seis, num_seis) ) { continue; }
+                _write_ff_coded_number(b, v->payloadType);
+                _write_ff_coded_number(b, v->payloadSize);
+                bs_write_bytes(b, (uint8_t*)v->data, v->payloadSize);
+                num_messages++;
+            }
+        }
+    }
+    h->sei = NULL;
+    write_rbsp_trailing_bits(b);
+
+    int nal_size = buf_size;
+    if ( rc == 0 && bs_overrun(b) ) { rc = -1; }
+    if ( rc == 0 && num_messages > 0 )
+    {
+        int rbsp_size = bs_pos(b);
+        if ( rbsp_to_nal(rbsp_buf, &rbsp_size, buf, &nal_size) < 0 ) { rc = -1; }
+    }
+    bs_free(b);
+    free(rbsp_buf);
+
+    // rbsp_to_nal leaves buf[0] as a zero byte, the NAL itself starts at buf + 1
+    int num_iov = 0;
+    for ( int i = 0; i <= num_nals && rc == 0; i++ )
+    {
+        if ( i == pos && num_messages > 0 )
+        {
+            if ( num_iov + 2 > max_iov ) { rc = -1; break; }
+            iov[num_iov].base = start_code; iov[num_iov].len = 4; num_iov++;
+            iov[num_iov].base = buf + 1; iov[num_iov].len = nal_size - 1; num_iov++;
+        }
+        if ( i == num_nals || dropped[i] ) { continue; }
+        if ( num_iov + 2 > max_iov ) { rc = -1; break; }
+        iov[num_iov].base = start_code; iov[num_iov].len = 4; num_iov++;
+        iov[num_iov].base = nals[i].buf; iov[num_iov].len = nals[i].size; num_iov++;
+    }
+
+    for ( int i = 0; i < num_nals; i++ ) { free(carried[i].views); free(carried[i].scratch); }
+    free(carried);
+    free(dropped);
+
+    return ( rc < 0 ) ? -1 : num_iov;
+}
+
+/**
+ Create a converter between Annex B and length-prefixed framing.
+ @param[in]  in_length_size   framing of the input: 0 for Annex B start codes, or the size of the length prefixes, 1 to 4
+ @param[in]  out_length_size  framing of the output, the same way
+ @param[in]  flags            H264_CONVERT_STRIP_PS and/or H264_CONVERT_INJECT_PS
+ @param[in]  avcc             parameter sets to inject, may be NULL; must stay valid while the converter is used
+ */
+h264_convert_t* h264_convert_new(int in_length_size, int out_length_size, int flags, avcc_t* avcc)
+{
+    h264_convert_t* c = (h264_convert_t*)calloc(1, sizeof(h264_convert_t));
+    c->in_length_size = in_length_size;
+    c->out_length_size = out_length_size;
+    c->flags = flags;
+    c->avcc = avcc;
+    return c;
+}
+
+void h264_convert_free(h264_convert_t* c)
+{
+    if ( c == NULL ) { return; }
+    free(c->nals);
+    free(c->prefixes);
+    free(c->iov);
+    free(c);
+}
+
+static void convert_add_nal(h264_convert_t* c, const uint8_t* buf, int size)
+{
+    if ( c->num_nals == c->nals_capacity )
+    {
+        c->nals_capacity = ( c->nals_capacity > 0 ) ? c->nals_capacity * 2 : 64;
+        c->nals = (h264_nal_span_t*)realloc(c->nals, c->nals_capacity * sizeof(h264_nal_span_t));
+    }
+    c->nals[c->num_nals].buf = buf;
+    c->nals[c->num_nals].size = size;
+    c->num_nals++;
+}
+
+// insert the parameter sets of the avcC record into the NALs to output, at position pos
+static void convert_inject_ps(h264_convert_t* c, int pos)
+{
+    int num_nals = c->num_nals;
+    for ( int i = 0; i < c->avcc->numOfSequenceParameterSets; i++ )
+    {
+        if ( c->avcc->sps_table[i].nal != NULL ) { convert_add_nal(c, c->avcc->sps_table[i].nal, c->avcc->sps_table[i].size); }
+    }
+    for ( int i = 0; i < c->avcc->numOfPictureParameterSets; i++ )
+    {
+        if ( c->avcc->pps_table[i].nal != NULL ) { convert_add_nal(c, c->avcc->pps_table[i].nal, c->avcc->pps_table[i].size); }
+    }
+
+    // rotate them from the end to pos
+    int n = c->num_nals - num_nals;
+    if ( n == 0 || pos == num_nals ) { return; }
+    h264_nal_span_t* tmp = (h264_nal_span_t*)malloc(n * sizeof(h264_nal_span_t));
+    memcpy(tmp, c->nals + num_nals, n * sizeof(h264_nal_span_t));
+    memmove(c->nals + pos + n, c->nals + pos, ( num_nals - pos ) * sizeof(h264_nal_span_t));
+    memcpy(c->nals + pos, tmp, n * sizeof(h264_nal_span_t));
+    free(tmp);
+}
+
+static int is_vcl(int nal_unit_type)
+{
+    return ( nal_unit_type >= NAL_UNIT_TYPE_CODED_SLICE_NON_IDR && nal_unit_type <= NAL_UNIT_TYPE_CODED_SLICE_IDR ) ||
+           nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_AUX || nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION || nal_unit_type == 21;
+}
+
+/**
+ Convert the framing of a piece of a stream.
+ Only complete NALs are converted; the bytes which are not consumed have to be passed again, followed by more data, in the next call.
+ That is the last NAL if it may continue after the end of buf and, with H264_CONVERT_INJECT_PS, the NALs before the first slice of
+ an access unit which is not complete yet, so at most one access unit is ever held back; nothing is copied.
+ The output is c->iov[0 .. c->num_iov - 1]: start codes or length prefixes (in c), and the NALs themselves (in buf or in the avcC record).
+ It stays valid until the next call, as long as buf does.
+ With H264_CONVERT_INJECT_PS, the parameter sets of the avcC record are put at the start of each access unit with an IDR picture
+ (after its access unit delimiter) which does not have parameter sets already.
+ @param[in]  c              the converter
+ @param[in]  buf            the input
+ @param[in]  size           size of the input
+ @param[in]  end_of_stream  whether the input ends with the end of the stream, so that the last NAL is complete
+ @return     number of bytes of buf consumed, or -1 if a NAL does not fit the output length prefix
+ */
+int h264_convert(h264_convert_t* c, const uint8_t* buf, int size, int end_of_stream)
+{
+    int inject = ( c->flags & H264_CONVERT_INJECT_PS ) && c->avcc != NULL;
+    h264_nal_iter_t it;
+    h264_nal_span_t nal;
+    int consumed = 0;
+    int rc;
+
+    // NALs after a slice start a new access unit (7.4.1.2.3); when injecting, a call always starts after a slice
+    int after_vcl = 1;
+    int au_first = -1;      // index of the first NAL of the access unit before its first slice
+    int au_consumed = 0;    // consumed before that NAL
+    int au_has_ps = 0;
+
+    c->num_nals = 0;
+    c->num_iov = 0;
+
+    h264_nal_iter_init(&it, buf, size, c->in_length_size);
+    while ( ( rc = h264_nal_iter_next(&it, &nal) ) != 0 )
+    {
+        if ( rc < 0 && !end_of_stream ) { break; }
+        int consumed_before = consumed;
+        consumed = it.p - buf;
+        if ( nal.size < 1 ) { continue; }
+
+        int nal_unit_type = nal.buf[0] & 0x1F;
+        if ( is_vcl(nal_unit_type) )
+        {
+            // first_mb_in_slice is ue(v), 0 is a single 1 bit
+            if ( inject && nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_IDR && !au_has_ps && nal.size > 1 && ( nal.buf[1] & 0x80 ) )
+            {
+                int pos = ( au_first >= 0 ) ? au_first : c->num_nals;
+                if ( pos < c->num_nals && ( c->nals[pos].buf[0] & 0x1F ) == NAL_UNIT_TYPE_AUD ) { pos++; }
+                convert_inject_ps(c, pos);
+            }
+            after_vcl = 1;
+            au_first = -1;
+            au_has_ps = 0;
+        }
+        else if ( after_vcl )
+        {
+            after_vcl = 0;
+            au_first = c->num_nals;
+            au_consumed = consumed_before;
+            au_has_ps = 0;
+        }
+
+        if ( nal_unit_type == NAL_UNIT_TYPE_SPS || nal_unit_type == NAL_UNIT_TYPE_PPS )
+        {
+            if ( c->flags & H264_CONVERT_STRIP_PS ) { continue; }
+            au_has_ps = 1;
+        }
+
+        convert_add_nal(c, nal.buf, nal.size);
+    }
+
+    // hold back the start of an access unit whose first slice has not been seen yet
+    if ( inject && !end_of_stream && au_first >= 0 )
+    {
+        c->num_nals = au_first;
+        consumed = au_consumed;
+    }
+
+    // the prefixes are all written before the iovecs point at them, so growing the storage cannot move them
+    int prefix_size = ( c->out_length_size > 0 ) ? c->out_length_size : 4;
+    if ( c->prefixes_capacity < c->num_nals * prefix_size )
+    {
+        c->prefixes_capacity = c->num_nals * prefix_size;
+        c->prefixes = (uint8_t*)realloc(c->prefixes, c->prefixes_capacity);
+    }
+    if ( c->iov_capacity < c->num_nals * 2 )
+    {
+        c->iov_capacity = c->num_nals * 2;
+        c->iov = (h264_iovec_t*)realloc(c->iov, c->iov_capacity * sizeof(h264_iovec_t));
+    }
+
+    for ( int i = 0; i < c->num_nals; i++ )
+    {
+        uint8_t* prefix = c->prefixes + i * prefix_size;
+        uint32_t len = c->nals[i].size;
+        if ( c->out_length_size > 0 )
+        {
+            if ( c->out_length_size < 4 && len >= ( 1u << ( 8 * c->out_length_size ) ) ) { c->num_iov = 0; return -1; }
+            for ( int j = c->out_length_size - 1; j >= 0; j-- ) { prefix[j] = len & 0xFF; len >>= 8; }
+        }
+        else
+        {
+            memcpy(prefix, start_code, 4);
+        }
+        c->iov[c->num_iov].base = prefix; c->iov[c->num_iov].len = prefix_size; c->num_iov++;
+        c->iov[c->num_iov].base = c->nals[i].buf; c->iov[c->num_iov].len = c->nals[i].size; c->num_iov++;
+    }
+
+    return consumed;
+}
+
+/**
+ Create a keyframe extractor.
+ */
+h264_keyframes_t* h264_keyframes_new()
+{
+    return (h264_keyframes_t*)calloc(1, sizeof(h264_keyframes_t));
+}
+
+static void keyframes_free_retired(h264_keyframes_t* k)
+{
+    for ( int i = 0; i < k->num_retired; i++ ) { free(k->retired[i]); }
+    k->num_retired = 0;
+}
+
+void h264_keyframes_free(h264_keyframes_t* k)
+{
+    if ( k == NULL ) { return; }
+    for ( int i = 0; i < 32; i++ ) { free(k->sps[i]); }
+    for ( int i = 0; i < 256; i++ ) { free(k->pps[i]); }
+    keyframes_free_retired(k);
+    free(k->retired);
+    free(k->au_nals);
+    free(k->keyframes);
+    free(k->iov);
+    free(k);
+}
+
+// keep a copy of a parameter set, unless it is the same as the one kept already
+static void keyframes_keep_ps(h264_keyframes_t* k, uint8_t** ps, int* ps_size, const h264_nal_span_t* nal)
+{
+    if ( *ps != NULL && *ps_size == nal->size && memcmp(*ps, nal->buf, nal->size) == 0 ) { return; }
+    if ( *ps != NULL )
+    {
+        if ( k->num_retired == k->retired_capacity )
+        {
+            k->retired_capacity = ( k->retired_capacity > 0 ) ? k->retired_capacity * 2 : 16;
+            k->retired = (uint8_t**)realloc(k->retired, k->retired_capacity * sizeof(uint8_t*));
+        }
+        k->retired[k->num_retired++] = *ps;
+    }
+    *ps = (uint8_t*)malloc(nal->size);
+    memcpy(*ps, nal->buf, nal->size);
+    *ps_size = nal->size;
+}
+
+static void keyframes_add_nal(h264_keyframes_t* k, const uint8_t* buf, int size)
+{
+    if ( k->num_iov + 2 > k->iov_capacity )
+    {
+        k->iov_capacity = ( k->iov_capacity > 0 ) ? k->iov_capacity * 2 : 64;
+        k->iov = (h264_iovec_t*)realloc(k->iov, k->iov_capacity * sizeof(h264_iovec_t));
+    }
+    k->iov[k->num_iov].base = start_code; k->iov[k->num_iov].len = 4; k->num_iov++;
+    k->iov[k->num_iov].base = buf; k->iov[k->num_iov].len = size; k->num_iov++;
+}
+
+static int au_has_ps(h264_keyframes_t* k, int nal_unit_type, int skip, uint32_t id)
+{
+    uint32_t au_id;
+    for ( int i = 0; i < k->num_au_nals; i++ )
+    {
+        const h264_nal_span_t* nal = &k->au_nals[i];
+        if ( ( nal->buf[0] & 0x1F ) == nal_unit_type && h264_peek_ue(nal->buf, nal->size, skip, &au_id, 1) == 0 && au_id == id ) { return 1; }
+    }
+    return 0;
+}
+
+// output the access unit of k->au_nals, if it is a keyframe
+static void keyframes_end_au(h264_keyframes_t* k, int64_t offset, int size, int idr_flag, int recovery_frame_cnt, int pps_id)
+{
+    if ( pps_id < 0 ) { return; }
+    k->access_units++;
+    if ( !idr_flag && recovery_frame_cnt < 0 ) { return; }
+
+    if ( k->num_keyframes == k->keyframes_capacity )
+    {
+        k->keyframes_capacity = ( k->keyframes_capacity > 0 ) ? k->keyframes_capacity * 2 : 16;
+        k->keyframes = (h264_keyframe_t*)realloc(k->keyframes, k->keyframes_capacity * sizeof(h264_keyframe_t));
+    }
+    h264_keyframe_t* kf = &k->keyframes[k->num_keyframes++];
+    kf->offset = offset;
+    kf->size = size;
+    kf->idr_flag = idr_flag;
+    kf->recovery_frame_cnt = ( recovery_frame_cnt > 0 ) ? recovery_frame_cnt : 0;
+
+    // the parameter sets go after the access unit delimiter
+    int i = 0;
+    if ( k->num_au_nals > 0 && ( k->au_nals[0].buf[0] & 0x1F ) == NAL_UNIT_TYPE_AUD )
+    {
+        keyframes_add_nal(k, k->au_nals[0].buf, k->au_nals[0].size);
+        i = 1;
+    }
+    uint32_t ids[2];
+    if ( pps_id >= 0 && k->pps[pps_id] != NULL && h264_peek_ue(k->pps[pps_id], k->pps_size[pps_id], 1, ids, 2) == 0 && ids[1] < 32 )
+    {
+        if ( k->sps[ids[1]] != NULL && !au_has_ps(k, NAL_UNIT_TYPE_SPS, 4, ids[1]) )
+        {
+            keyframes_add_nal(k, k->sps[ids[1]], k->sps_size[ids[1]]);
+        }
+        if ( !au_has_ps(k, NAL_UNIT_TYPE_PPS, 1, pps_id) )
+        {
+            keyframes_add_nal(k, k->pps[pps_id], k->pps_size[pps_id]);
+        }
+    }
+    for ( ; i < k->num_au_nals; i++ ) { keyframes_add_nal(k, k->au_nals[i].buf, k->au_nals[i].size); }
+}
+
+/**
+ Find the keyframes in a piece of an Annex B stream: access units with an IDR picture, or with a recovery point SEI.
+ Only the NAL headers are looked at, and the first exp-Golomb codes of slice headers and parameter sets; of SEI NALs only
+ recovery points are read.  Each keyframe is output in k->keyframes as the byte range it takes in the input, e.g. for an
+ HLS I-frame playlist, and in k->iov as Annex B NALs, with the SPS and PPS its first slice refers to put before it where it does
+ not have them itself: the NALs in buf, start codes and parameter sets in k.  They stay valid until the next call, as long as
+ buf does.  An access unit is only output once the next one starts, so the last one is held back until the end of the stream.
+ @param[in]  k              the extractor
+ @param[in]  buf            the input
+ @param[in]  size           size of the input
+ @param[in]  end_of_stream  whether the input ends with the end of the stream, so that the last access unit is complete
+ @return     number of bytes of buf consumed, the rest has to be passed again followed by more data
+ */
+int h264_extract_keyframes(h264_keyframes_t* k, const uint8_t* buf, int size, int end_of_stream)
+{
+    h264_nal_iter_t it;
+    h264_nal_span_t nal;
+    int consumed = 0;
+    int rc;
+    uint32_t id;
+    h264_svc_slice_t slice;
+
+    // the access unit being looked at
+    int au_start = -1;
+    int after_vcl = 0;        // a slice of it was seen
+    int idr_flag = 0;
+    int recovery_frame_cnt = -1;
+    int pps_id = -1;
+
+    k->num_keyframes = 0;
+    k->num_iov = 0;
+    k->num_au_nals = 0;
+    keyframes_free_retired(k);
+
+    h264_nal_iter_init(&it, buf, size, 0);
+    while ( ( rc = h264_nal_iter_next(&it, &nal) ) != 0 )
+    {
+        if ( rc < 0 && !end_of_stream ) { break; }
+        int consumed_before = consumed;
+        consumed = it.p - buf;
+        if ( nal.size < 1 ) { continue; }
+
+        // 7.4.1.2.3: a new access unit starts with the first slice of a primary picture, or the NALs before it
+        int nal_unit_type = nal.buf[0] & 0x1F;
+        int first_slice = 0;
+        if ( nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_NON_IDR || nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_IDR )
+        {
+            if ( h264_peek_svc_slice_header(nal.buf, nal.size, &slice) < 1 ) { slice.first_mb_in_slice = 1; slice.pic_parameter_set_id = -1; }
+            first_slice = ( slice.first_mb_in_slice == 0 );
+        }
+        int starts_au = first_slice || nal_unit_type == NAL_UNIT_TYPE_SEI || nal_unit_type == NAL_UNIT_TYPE_SPS ||
+                        nal_unit_type == NAL_UNIT_TYPE_PPS || nal_unit_type == NAL_UNIT_TYPE_AUD ||
+                        ( nal_unit_type >= NAL_UNIT_TYPE_PREFIX_NAL && nal_unit_type <= 18 );
+
+        if ( au_start < 0 || ( starts_au && after_vcl ) )
+        {
+            if ( au_start >= 0 ) { keyframes_end_au(k, k->offset + au_start, consumed_before - au_start, idr_flag, recovery_frame_cnt, pps_id); }
+            au_start = consumed_before;
+            after_vcl = 0;
+            idr_flag = 0;
+            recovery_frame_cnt = -1;
+            pps_id = -1;
+            k->num_au_nals = 0;
+        }
+
+        if ( k->num_au_nals == k->au_nals_capacity )
+        {
+            k->au_nals_capacity = ( k->au_nals_capacity > 0 ) ? k->au_nals_capacity * 2 : 64;
+            k->au_nals = (h264_nal_span_t*)realloc(k->au_nals, k->au_nals_capacity * sizeof(h264_nal_span_t));
+        }
+        k->au_nals[k->num_au_nals++] = nal;
+
+        switch ( nal_unit_type )
+        {
+            case NAL_UNIT_TYPE_CODED_SLICE_NON_IDR:
+            case NAL_UNIT_TYPE_CODED_SLICE_IDR:
+                if ( pps_id < 0 && slice.pic_parameter_set_id >= 0 )
+                {
+                    pps_id = slice.pic_parameter_set_id;
+                    idr_flag = ( nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_IDR );
+                }
+                after_vcl = 1;
+                break;
+
+            case NAL_UNIT_TYPE_SPS:
+                // seq_parameter_set_id follows profile_idc, the constraint flags and level_idc
+                if ( h264_peek_ue(nal.buf, nal.size, 4, &id, 1) == 0 && id < 32 ) { keyframes_keep_ps(k, &k->sps[id], &k->sps_size[id], &nal); }
+                break;
+
+            case NAL_UNIT_TYPE_PPS:
+                if ( h264_peek_ue(nal.buf, nal.size, 1, &id, 1) == 0 && id < 256 ) { keyframes_keep_ps(k, &k->pps[id], &k->pps_size[id], &nal); }
+                break;
+
+            case NAL_UNIT_TYPE_SEI:
+            {
+                int types[1] = { SEI_TYPE_RECOVERY_POINT };
+                sei_filter_t filter = { types, 1, NULL, 0 };
+                sei_view_t view;
+                uint8_t scratch[16];
+                if ( sei_find_payloads(nal.buf, nal.size, &filter, &view, 1, scratch, sizeof(scratch)) > 0 && view.data != NULL )
+                {
+                    bs_t b;
+                    bs_init(&b, (uint8_t*)view.data, view.payloadSize);
+                    recovery_frame_cnt = bs_read_ue(&b);
+                    if ( bs_overrun(&b) ) { recovery_frame_cnt = 0; }
+                }
+                break;
+            }
+
+            default:
+                if ( nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION || nal_unit_type == 21 ) { after_vcl = 1; }
+                break;
+        }
+    }
+
+    if ( end_of_stream )
+    {
+        if ( au_start >= 0 ) { keyframes_end_au(k, k->offset + au_start, size - au_start, idr_flag, recovery_frame_cnt, pps_id); }
+        consumed = size;
+    }
+    else if ( au_start >= 0 )
+    {
+        consumed = au_start;
+    }
+    k->num_au_nals = 0;
+    k->offset += consumed;
+    return consumed;
+}
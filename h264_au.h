@@ -0,0 +1,117 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _H264_AU_H
+#define _H264_AU_H        1
+
+#include <stdint.h>
+
+#include "h264_stream.h"
+#include "h264_avcc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// flags for h264_au_splice_sei
+#define H264_SEI_SPLICE_INSERT   0  // add the messages, keep all existing SEI
+#define H264_SEI_SPLICE_REPLACE  1  // also remove existing messages of the same payload types
+
+int h264_au_splice_sei(h264_stream_t* h, const h264_nal_span_t* nals, int num_nals, sei_t** seis, int num_seis, int flags,
+                       uint8_t* buf, int buf_size, h264_iovec_t* iov, int max_iov);
+
+// flags for h264_convert_new
+#define H264_CONVERT_STRIP_PS    1  // drop SPS and PPS NALs (e.g. when they are in the avcC record)
+#define H264_CONVERT_INJECT_PS   2  // put the SPS and PPS of the avcC record before IDR pictures
+
+/**
+   Converter between Annex B and length-prefixed (AVCC) framing
+   @see h264_convert
+*/
+typedef struct
+{
+    int in_length_size;   // 0 for Annex B, otherwise 1 to 4
+    int out_length_size;
+    int flags;
+    avcc_t* avcc;
+
+    h264_iovec_t* iov;    // output of the last h264_convert
+    int num_iov;
+    int iov_capacity;
+
+    h264_nal_span_t* nals;
+    int num_nals;
+    int nals_capacity;
+    uint8_t* prefixes;
+    int prefixes_capacity;
+} h264_convert_t;
+
+h264_convert_t* h264_convert_new(int in_length_size, int out_length_size, int flags, avcc_t* avcc);
+void h264_convert_free(h264_convert_t* c);
+int h264_convert(h264_convert_t* c, const uint8_t* buf, int size, int end_of_stream);
+
+/**
+   A keyframe access unit found by h264_extract_keyframes, as a byte range of the input
+*/
+typedef struct
+{
+    int64_t offset;               // in the whole input, of the first byte after the access unit before it
+    int size;                     // up to the first byte after it, start codes included
+    int idr_flag;                 // 1 for an IDR picture, 0 for a recovery point
+    int recovery_frame_cnt;       // of the recovery point SEI, 0 for an IDR picture without one
+} h264_keyframe_t;
+
+/**
+   Extractor of the keyframes of an Annex B stream: access units with an IDR picture or a recovery point SEI
+   @see h264_extract_keyframes
+*/
+typedef struct
+{
+    int64_t offset;               // in the whole input, of the buffer of the next call
+    int access_units;             // number of access units with a picture seen so far
+
+    // the parameter sets last seen, as NALs, for the keyframes which do not have them
+    uint8_t* sps[32];
+    int sps_size[32];
+    uint8_t* pps[256];
+    int pps_size[256];
+    uint8_t** retired;            // replaced parameter sets, which the output may still refer to until the next call
+    int num_retired;
+    int retired_capacity;
+
+    h264_nal_span_t* au_nals;     // of the access unit being looked at
+    int num_au_nals;
+    int au_nals_capacity;
+
+    h264_keyframe_t* keyframes;   // output of the last h264_extract_keyframes
+    int num_keyframes;
+    int keyframes_capacity;
+    h264_iovec_t* iov;            // the keyframes as an Annex B stream, with their parameter sets
+    int num_iov;
+    int iov_capacity;
+} h264_keyframes_t;
+
+h264_keyframes_t* h264_keyframes_new();
+void h264_keyframes_free(h264_keyframes_t* k);
+int h264_extract_keyframes(h264_keyframes_t* k, const uint8_t* buf, int size, int end_of_stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 #include "h264_avcc.h"
@@ -10,62 +11,203 @@
 avcc_t* avcc_new()
 {
   avcc_t* avcc = (avcc_t*)calloc(1, sizeof(avcc_t));
-  avcc->sps_table = NULL;
-  avcc->pps_table = NULL;
   return avcc;
 }
 
+static void avcc_release(avcc_t* avcc)
+{
+  for (int i = 0; i < avcc->numOfSequenceParameterSets; i++) { h264_ps_release(avcc->sps_table[i].sps); }
+  for (int i = 0; i < avcc->numOfPictureParameterSets; i++) { h264_ps_release(avcc->pps_table[i].pps); }
+  avcc->numOfSequenceParameterSets = 0;
+  avcc->numOfPictureParameterSets = 0;
+  avcc->numOfSequenceParameterSetExt = 0;
+  avcc->has_high_profile_ext = 0;
+}
+
 void avcc_free(avcc_t* avcc)
 {
-  if (avcc->sps_table != NULL) { free(avcc->sps_table); }
-  if (avcc->pps_table != NULL) { free(avcc->pps_table); }
+  avcc_release(avcc);
+  free(avcc->buf);
+  free(avcc->rbsp_buf);
   free(avcc);
 }
 
-int read_avcc(avcc_t* avcc, h264_stream_t* h, bs_t* b)
+static int is_high_profile(int profile_idc)
 {
-  avcc->configurationVersion = bs_read_u8(b);
-  avcc->AVCProfileIndication = bs_read_u8(b);
-  avcc->profile_compatibility = bs_read_u8(b);
-  avcc->AVCLevelIndication = bs_read_u8(b);
-  /* int reserved = */ bs_read_u(b, 6); // '111111'b;
-  avcc->lengthSizeMinusOne = bs_read_u(b, 2);
-  /* int reserved = */ bs_read_u(b, 3); // '111'b;
-
-  avcc->numOfSequenceParameterSets = bs_read_u(b, 5);
-  avcc->sps_table = (sps_t**)calloc(avcc->numOfSequenceParameterSets, sizeof(sps_t*));
-  for (int i = 0; i < avcc->numOfSequenceParameterSets; i++)
+  return (profile_idc == 100 || profile_idc == 110 || profile_idc == 122 || profile_idc == 144);
+}
+
+// size of the record at the start of buf, from the length fields only; -1 if it is truncated
+static int avcc_size(const uint8_t* buf, int size)
+{
+  if (size < 6) { return -1; }
+  int profile = buf[1];
+  int pos = 6;
+  int count = buf[5] & 0x1F;
+  for (int n = 0; n < 2; n++)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      if (pos + 2 > size) { return -1; }
+      pos += 2 + ((buf[pos] << 8) | buf[pos + 1]);
+    }
+    if (n == 0)
+    {
+      if (pos + 1 > size) { return -1; }
+      count = buf[pos];
+      pos++;
+    }
+  }
+  if (pos > size) { return -1; }
+
+  if (is_high_profile(profile) && pos + 4 <= size)
   {
-    int sequenceParameterSetLength = bs_read_u(b, 16);
-    int len = sequenceParameterSetLength;
-    uint8_t* buf = (uint8_t*)malloc(len);
-    len = bs_read_bytes(b, buf, len);
-    int rc = read_nal_unit(h, buf, len);
-    free(buf);
-    if (h->nal->nal_unit_type != NAL_UNIT_TYPE_SPS) { continue; } // TODO report errors
-    if (rc < 0) { continue; }
-    avcc->sps_table[i] = h->sps; // TODO copy data?
+    count = buf[pos + 3];
+    pos += 4;
+    for (int i = 0; i < count; i++)
+    {
+      if (pos + 2 > size) { return -1; }
+      pos += 2 + ((buf[pos] << 8) | buf[pos + 1]);
+    }
+    if (pos > size) { return -1; }
   }
+  return pos;
+}
+
+// parse a parameter set of the record; the tables of h keep one snapshot per distinct content, which the record retains
+static void* read_ps(avcc_t* avcc, h264_stream_t* h, uint8_t* nal, int size, int nal_unit_type)
+{
+  if (size < 1 || (nal[0] & 0x1F) != nal_unit_type) { return NULL; } // TODO report errors
+  if (read_nal_unit_with_rbsp(h, nal, size, avcc->rbsp_buf, avcc->buf_capacity) < 0) { return NULL; }
+  if (nal_unit_type == NAL_UNIT_TYPE_SPS) { return h264_ps_retain(h->sps_refs[h->sps->seq_parameter_set_id]); }
+  return h264_ps_retain(h->pps_refs[h->pps->pic_parameter_set_id]);
+}
 
-  avcc->numOfPictureParameterSets = bs_read_u(b, 8);
-  avcc->pps_table = (pps_t**)calloc(avcc->numOfSequenceParameterSets, sizeof(pps_t*));
+// put the parameter sets of the record back into the tables of h, which may be another stream than they were parsed with,
+// or may have read other parameter sets with the same ids since
+static void restore_ps(avcc_t* avcc, h264_stream_t* h)
+{
+  for (int i = 0; i < avcc->numOfSequenceParameterSets; i++)
+  {
+    h264_sps_ref_t* ref = avcc->sps_table[i].sps;
+    if (ref == NULL) { continue; }
+    int id = ref->sps.seq_parameter_set_id;
+    if (h->sps_refs[id] == ref) { continue; }
+    memcpy(h->sps_table[id], &ref->sps, sizeof(sps_t));
+    h264_ps_release(h->sps_refs[id]);
+    h->sps_refs[id] = (h264_sps_ref_t*)h264_ps_retain(ref);
+  }
   for (int i = 0; i < avcc->numOfPictureParameterSets; i++)
   {
-    int pictureParameterSetLength = bs_read_u(b, 16);
-    int len = pictureParameterSetLength;
-    uint8_t* buf = (uint8_t*)malloc(len);
-    len = bs_read_bytes(b, buf, len);
-    int rc = read_nal_unit(h, buf, len);
-    free(buf);
-    if (h->nal->nal_unit_type != NAL_UNIT_TYPE_PPS) { continue; } // TODO report errors
-    if (rc < 0) { continue; }
-    avcc->pps_table[i] = h->pps; // TODO copy data?
+    h264_pps_ref_t* ref = avcc->pps_table[i].pps;
+    if (ref == NULL) { continue; }
+    int id = ref->pps.pic_parameter_set_id;
+    if (h->pps_refs[id] == ref) { continue; }
+    memcpy(h->pps_table[id], &ref->pps, sizeof(pps_t));
+    h264_ps_release(h->pps_refs[id]);
+    h->pps_refs[id] = (h264_pps_ref_t*)h264_ps_retain(ref);
+  }
+}
+
+int read_avcc(avcc_t* avcc, h264_stream_t* h, bs_t* b)
+{
+  int len = avcc_size(b->p, b->end - b->p);
+  if (len < 0) { return -1; }
+
+  // the same record as last time: the parameter sets are already parsed, h only needs them in its tables
+  if (len == avcc->buf_size && memcmp(b->p, avcc->buf, len) == 0)
+  {
+    restore_ps(avcc, h);
+    bs_skip_bytes(b, len);
+    return bs_pos(b);
+  }
+
+  avcc_release(avcc);
+  if (avcc->buf_capacity < len)
+  {
+    avcc->buf = (uint8_t*)realloc(avcc->buf, len);
+    avcc->rbsp_buf = (uint8_t*)realloc(avcc->rbsp_buf, len);
+    avcc->buf_capacity = len;
+  }
+  avcc->buf_size = len;
+  bs_read_bytes(b, avcc->buf, len);
+
+  // all entries point into the copy, and are unescaped into rbsp_buf to be parsed
+  bs_t r;
+  bs_init(&r, avcc->buf, len);
+  avcc->configurationVersion = bs_read_u8(&r);
+  avcc->AVCProfileIndication = bs_read_u8(&r);
+  avcc->profile_compatibility = bs_read_u8(&r);
+  avcc->AVCLevelIndication = bs_read_u8(&r);
+  /* int reserved = */ bs_read_u(&r, 6); // '111111'b;
+  avcc->lengthSizeMinusOne = bs_read_u(&r, 2);
+  /* int reserved = */ bs_read_u(&r, 3); // '111'b;
+
+  int numOfSequenceParameterSets = bs_read_u(&r, 5);
+  for (int i = 0; i < numOfSequenceParameterSets; i++)
+  {
+    avcc_sps_t* e = &avcc->sps_table[i];
+    int sequenceParameterSetLength = bs_read_u(&r, 16);
+    e->nal = r.p;
+    e->size = bs_skip_bytes(&r, sequenceParameterSetLength);
+    e->sps = (h264_sps_ref_t*)read_ps(avcc, h, e->nal, e->size, NAL_UNIT_TYPE_SPS);
+    avcc->numOfSequenceParameterSets++;
+  }
+
+  int numOfPictureParameterSets = bs_read_u(&r, 8);
+  for (int i = 0; i < numOfPictureParameterSets; i++)
+  {
+    avcc_pps_t* e = &avcc->pps_table[i];
+    int pictureParameterSetLength = bs_read_u(&r, 16);
+    e->nal = r.p;
+    e->size = bs_skip_bytes(&r, pictureParameterSetLength);
+    e->pps = (h264_pps_ref_t*)read_ps(avcc, h, e->nal, e->size, NAL_UNIT_TYPE_PPS);
+    avcc->numOfPictureParameterSets++;
+  }
+
+  if (is_high_profile(avcc->AVCProfileIndication) && r.end - r.p >= 4)
+  {
+    avcc->has_high_profile_ext = 1;
+    /* int reserved = */ bs_read_u(&r, 6); // '111111'b;
+    avcc->chroma_format = bs_read_u(&r, 2);
+    /* int reserved = */ bs_read_u(&r, 5); // '11111'b;
+    avcc->bit_depth_luma_minus8 = bs_read_u(&r, 3);
+    /* int reserved = */ bs_read_u(&r, 5); // '11111'b;
+    avcc->bit_depth_chroma_minus8 = bs_read_u(&r, 3);
+    avcc->numOfSequenceParameterSetExt = bs_read_u(&r, 8);
+    for (int i = 0; i < avcc->numOfSequenceParameterSetExt; i++)
+    {
+      int sequenceParameterSetExtLength = bs_read_u(&r, 16);
+      avcc->sps_ext_table[i].buf = r.p;
+      avcc->sps_ext_table[i].size = bs_skip_bytes(&r, sequenceParameterSetExtLength);
+    }
   }
 
-  if (bs_overrun(b)) { return -1; }
   return bs_pos(b);
 }
 
+// write a parameter set from its bytes, or encode it from its snapshot if there are none
+static void write_ps(h264_stream_t* h, bs_t* b, const uint8_t* nal, int size, sps_t* sps, pps_t* pps)
+{
+  uint8_t buf[4096];
+  if (nal == NULL)
+  {
+    sps_t* h_sps = h->sps;
+    pps_t* h_pps = h->pps;
+    h->nal->nal_ref_idc = NAL_REF_IDC_PRIORITY_HIGHEST;
+    h->nal->nal_unit_type = (sps != NULL) ? NAL_UNIT_TYPE_SPS : NAL_UNIT_TYPE_PPS;
+    if (sps != NULL) { h->sps = sps; } else { h->pps = pps; }
+    size = write_nal_unit(h, buf, sizeof(buf));
+    h->sps = h_sps;
+    h->pps = h_pps;
+    // write_nal_unit leaves a zero byte before the NAL
+    nal = buf + 1;
+    size -= 1;
+  }
+  if (size < 0) { size = 0; } // TODO report errors
+  bs_write_u(b, 16, size);
+  bs_write_bytes(b, (uint8_t*)nal, size);
+}
 
 int write_avcc(avcc_t* avcc, h264_stream_t* h, bs_t* b)
 {
@@ -80,63 +222,70 @@ int write_avcc(avcc_t* avcc, h264_stream_t* h, bs_t* b)
   bs_write_u(b, 5, avcc->numOfSequenceParameterSets);
   for (int i = 0; i < avcc->numOfSequenceParameterSets; i++)
   {
-    int max_len = 1024; // FIXME
-    uint8_t* buf = (uint8_t*)malloc(max_len);
-    h->nal->nal_ref_idc = 3; // NAL_REF_IDC_PRIORITY_HIGHEST;
-    h->nal->nal_unit_type = NAL_UNIT_TYPE_SPS;
-    h->sps = avcc->sps_table[i];
-    int len = write_nal_unit(h, buf, max_len);
-    if (len < 0) { free(buf); continue; } // TODO report errors
-    int sequenceParameterSetLength = len;
-    bs_write_u(b, 16, sequenceParameterSetLength);
-    bs_write_bytes(b, buf, len);
-    free(buf);
+    avcc_sps_t* e = &avcc->sps_table[i];
+    write_ps(h, b, e->nal, e->size, (e->sps != NULL) ? &e->sps->sps : NULL, NULL);
   }
 
   bs_write_u(b, 8, avcc->numOfPictureParameterSets);
   for (int i = 0; i < avcc->numOfPictureParameterSets; i++)
   {
-    int max_len = 1024; // FIXME
-    uint8_t* buf = (uint8_t*)malloc(max_len);
-    h->nal->nal_ref_idc = 3; // NAL_REF_IDC_PRIORITY_HIGHEST;
-    h->nal->nal_unit_type = NAL_UNIT_TYPE_PPS;
-    h->pps = avcc->pps_table[i];
-    int len = write_nal_unit(h, buf, max_len);
-    if (len < 0) { free(buf); continue; } // TODO report errors
-    int pictureParameterSetLength = len;
-    bs_write_u(b, 16, pictureParameterSetLength);
-    bs_write_bytes(b, buf, len);
-    free(buf);
+    avcc_pps_t* e = &avcc->pps_table[i];
+    write_ps(h, b, e->nal, e->size, NULL, (e->pps != NULL) ? &e->pps->pps : NULL);
+  }
+
+  if (avcc->has_high_profile_ext)
+  {
+    bs_write_u(b, 6, 0x3F); // reserved = '111111'b;
+    bs_write_u(b, 2, avcc->chroma_format);
+    bs_write_u(b, 5, 0x1F); // reserved = '11111'b;
+    bs_write_u(b, 3, avcc->bit_depth_luma_minus8);
+    bs_write_u(b, 5, 0x1F); // reserved = '11111'b;
+    bs_write_u(b, 3, avcc->bit_depth_chroma_minus8);
+    bs_write_u8(b, avcc->numOfSequenceParameterSetExt);
+    for (int i = 0; i < avcc->numOfSequenceParameterSetExt; i++)
+    {
+      bs_write_u(b, 16, avcc->sps_ext_table[i].size);
+      bs_write_bytes(b, (uint8_t*)avcc->sps_ext_table[i].buf, avcc->sps_ext_table[i].size);
+    }
   }
 
   if (bs_overrun(b)) { return -1; }
   return bs_pos(b);
 }
 
-void debug_avcc(avcc_t* avcc)
+void debug_avcc(avcc_t* avcc, h264_stream_t* h)
 {
-  printf("======= AVC Decoder Configuration Record =======\n");
-  printf(" configurationVersion: %d\n", avcc->configurationVersion );
-  printf(" AVCProfileIndication: %d\n", avcc->AVCProfileIndication );
-  printf(" profile_compatibility: %d\n", avcc->profile_compatibility );
-  printf(" AVCLevelIndication: %d\n", avcc->AVCLevelIndication );
-  printf(" lengthSizeMinusOne: %d\n", avcc->lengthSizeMinusOne );
-
-  printf("\n");
-  printf(" numOfSequenceParameterSets: %d\n", avcc->numOfSequenceParameterSets );
+  h264_dbg_printf(h, "======= AVC Decoder Configuration Record =======\n");
+  h264_dbg_printf(h, " configurationVersion: %d\n", avcc->configurationVersion );
+  h264_dbg_printf(h, " AVCProfileIndication: %d\n", avcc->AVCProfileIndication );
+  h264_dbg_printf(h, " profile_compatibility: %d\n", avcc->profile_compatibility );
+  h264_dbg_printf(h, " AVCLevelIndication: %d\n", avcc->AVCLevelIndication );
+  h264_dbg_printf(h, " lengthSizeMinusOne: %d\n", avcc->lengthSizeMinusOne );
+
+  h264_dbg_printf(h, "\n");
+  h264_dbg_printf(h, " numOfSequenceParameterSets: %d\n", avcc->numOfSequenceParameterSets );
   for (int i = 0; i < avcc->numOfSequenceParameterSets; i++)
   {
-    //printf(" sequenceParameterSetLength\n", avcc->sequenceParameterSetLength );
-    if (avcc->sps_table[i] == NULL) { printf(" null sps\n"); continue; }
-    debug_sps(avcc->sps_table[i]);
+    h264_dbg_printf(h, " sequenceParameterSetLength: %d\n", avcc->sps_table[i].size );
+    if (avcc->sps_table[i].sps == NULL || avcc->sps_table[i].nal == NULL) { h264_dbg_printf(h, " null sps\n"); continue; }
+    read_debug_nal_unit(h, avcc->sps_table[i].nal, avcc->sps_table[i].size);
   }
 
-  printf("\n");
-  printf(" numOfPictureParameterSets: %d\n", avcc->numOfPictureParameterSets );
+  h264_dbg_printf(h, "\n");
+  h264_dbg_printf(h, " numOfPictureParameterSets: %d\n", avcc->numOfPictureParameterSets );
   for (int i = 0; i < avcc->numOfPictureParameterSets; i++)
   {
-    //printf(" pictureParameterSetLength\n", avcc->pictureParameterSetLength );
-    if (avcc->pps_table[i] == NULL) { printf(" null pps\n"); continue; }
-    debug_pps(avcc->pps_table[i]);
+    h264_dbg_printf(h, " pictureParameterSetLength: %d\n", avcc->pps_table[i].size );
+    if (avcc->pps_table[i].pps == NULL || avcc->pps_table[i].nal == NULL) { h264_dbg_printf(h, " null pps\n"); continue; }
+    read_debug_nal_unit(h, avcc->pps_table[i].nal, avcc->pps_table[i].size);
+  }
+
+  if (avcc->has_high_profile_ext)
+  {
+    h264_dbg_printf(h, "\n");
+    h264_dbg_printf(h, " chroma_format: %d\n", avcc->chroma_format );
+    h264_dbg_printf(h, " bit_depth_luma_minus8: %d\n", avcc->bit_depth_luma_minus8 );
+    h264_dbg_printf(h, " bit_depth_chroma_minus8: %d\n", avcc->bit_depth_chroma_minus8 );
+    h264_dbg_printf(h, " numOfSequenceParameterSetExt: %d\n", avcc->numOfSequenceParameterSetExt );
   }
 }
@@ -11,10 +11,32 @@
 extern "C" {
 #endif
 
+/**
+   A parameter set NAL of an avcC record: its bytes (in the record's own copy) and the parsed snapshot.
+   Identical parameter sets share one snapshot; the record holds a reference to it.
+*/
+typedef struct
+{
+  uint8_t* nal;
+  int size;
+  h264_sps_ref_t* sps;
+} avcc_sps_t;
+
+typedef struct
+{
+  uint8_t* nal;
+  int size;
+  h264_pps_ref_t* pps;
+} avcc_pps_t;
+
 /**
    AVC decoder configuration record, ISO/IEC 14496-15:2004(E), Section 5.2.4.1
-   Seen in seen in mp4 files as 'avcC' atom 
+   Seen in seen in mp4 files as 'avcC' atom
    Seen in flv files as AVCVIDEOPACKET with AVCPacketType == 0
+   The record keeps a copy of its bytes; reading the same bytes again (e.g. the same avcC in every fragment) does not parse anything,
+   the parameter sets parsed before are only put into the tables of the stream passed in.
+   A new record is parsed in the copy and in an rbsp buffer of the record, which are only reallocated to grow; the stream allocates
+   a snapshot for each parameter set whose content differs from the one it had with that id.
 */
 typedef struct
 {
@@ -26,16 +48,32 @@ typedef struct
   int lengthSizeMinusOne;
   // bit(3) reserved = '111'b;
   int numOfSequenceParameterSets;
-  sps_t** sps_table;
+  avcc_sps_t sps_table[32];
   int numOfPictureParameterSets;
-  pps_t** pps_table;
+  avcc_pps_t pps_table[256];
+
+  // present for AVCProfileIndication 100, 110, 122 and 144, if the record is long enough (older writers leave it out)
+  int has_high_profile_ext;
+  // bit(6) reserved = '111111'b;
+  int chroma_format;
+  // bit(5) reserved = '11111'b;
+  int bit_depth_luma_minus8;
+  // bit(5) reserved = '11111'b;
+  int bit_depth_chroma_minus8;
+  int numOfSequenceParameterSetExt;
+  h264_nal_span_t sps_ext_table[256];
+
+  uint8_t* buf;   // copy of the record last read
+  int buf_size;
+  int buf_capacity;
+  uint8_t* rbsp_buf;  // the parameter sets are unescaped into this, one at a time, buf_capacity bytes
 } avcc_t;
 
 avcc_t* avcc_new();
 void avcc_free(avcc_t* avcc);
 int read_avcc(avcc_t* avcc, h264_stream_t* h, bs_t* b);
 int write_avcc(avcc_t* avcc, h264_stream_t* h, bs_t* b);
-void debug_avcc(avcc_t* avcc);
+void debug_avcc(avcc_t* avcc, h264_stream_t* h);
 
 #ifdef __cplusplus
 }
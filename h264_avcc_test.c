@@ -0,0 +1,209 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+// Checks of read_avcc on a record made of the first SPS and PPS of each input file, the SPS listed twice: both entries have to
+// share one snapshot, and reading the same record again must keep the snapshots parsed the first time. Read into a new stream
+// for every fragment, or into one which has read another PPS with the same id since, the record has to put its parameter sets
+// back into the tables of the stream, so that the first slice of the file reads the same as with the parameter sets themselves.
+// A record with a changed PPS is parsed anew, and keeps the snapshot of the unchanged SPS.
+
+#include "h264_stream.h"
+#include "h264_avcc.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+static int put_ps(uint8_t* p, const uint8_t* nal, int size)
+{
+    p[0] = size >> 8;
+    p[1] = size & 0xFF;
+    memcpy(p + 2, nal, size);
+    return size + 2;
+}
+
+// an avcC record with the sps twice and the pps
+static int make_avcc(uint8_t* buf, const uint8_t* sps, int sps_size, const uint8_t* pps, int pps_size)
+{
+    int n = 0;
+    buf[n++] = 1;
+    buf[n++] = sps[1];
+    buf[n++] = sps[2];
+    buf[n++] = sps[3];
+    buf[n++] = 0xFF;       // lengthSizeMinusOne 3
+    buf[n++] = 0xE0 | 2;
+    n += put_ps(buf + n, sps, sps_size);
+    n += put_ps(buf + n, sps, sps_size);
+    buf[n++] = 1;
+    n += put_ps(buf + n, pps, pps_size);
+    return n;
+}
+
+// the parameter sets of the record are the ones in the tables of h
+static int in_tables(avcc_t* avcc, h264_stream_t* h)
+{
+    h264_sps_ref_t* sps = avcc->sps_table[0].sps;
+    h264_pps_ref_t* pps = avcc->pps_table[0].pps;
+    int sps_id = sps->sps.seq_parameter_set_id;
+    int pps_id = pps->pps.pic_parameter_set_id;
+    return ( h->sps_refs[sps_id] == sps && memcmp(h->sps_table[sps_id], &sps->sps, sizeof(sps_t)) == 0 &&
+             h->pps_refs[pps_id] == pps && memcmp(h->pps_table[pps_id], &pps->pps, sizeof(pps_t)) == 0 );
+}
+
+static int read_record(avcc_t* avcc, h264_stream_t* h, uint8_t* buf, int size)
+{
+    bs_t b;
+    bs_init(&b, buf, size);
+    return read_avcc(avcc, h, &b);
+}
+
+// the first slice reads the same in h as in the stream which read the parameter sets themselves
+static int same_slice(h264_stream_t* h, h264_stream_t* ref, uint8_t* slice, int slice_size)
+{
+    if (read_nal_unit(h, slice, slice_size) < 0) { return 0; }
+    slice_header_t sh = *h->sh;
+    int bit_size = h->slice_data->bit_size;
+    if (read_nal_unit(ref, slice, slice_size) < 0) { return 0; }
+    return ( sh.slice_type == ref->sh->slice_type && sh.frame_num == ref->sh->frame_num && sh.slice_qp_delta == ref->sh->slice_qp_delta &&
+             bit_size == ref->slice_data->bit_size );
+}
+
+static int check_file(const char* name)
+{
+    FILE* f = fopen(name, "rb");
+    if (f == NULL) { fprintf( stderr, "!! Error: could not open file: %s: %s \n", name, strerror(errno)); return 1; }
+    fseek(f, 0, SEEK_END);
+    int size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = (uint8_t*)malloc(size);
+    if (fread(buf, 1, size, f) != (size_t)size) { fprintf( stderr, "!! Error: read failed: %s \n", name); fclose(f); free(buf); return 1; }
+    fclose(f);
+
+    // the first SPS, the first PPS and the first slice after them
+    h264_nal_span_t sps = { NULL, 0 }, pps = { NULL, 0 }, slice = { NULL, 0 };
+    h264_nal_iter_t it;
+    h264_nal_span_t nal;
+    h264_nal_iter_init(&it, buf, size, 0);
+    while (h264_nal_iter_next(&it, &nal) != 0 && slice.buf == NULL)
+    {
+        if (nal.size < 1) { continue; }
+        int nal_unit_type = nal.buf[0] & 0x1F;
+        if (nal_unit_type == NAL_UNIT_TYPE_SPS && sps.buf == NULL) { sps = nal; }
+        if (nal_unit_type == NAL_UNIT_TYPE_PPS && pps.buf == NULL) { pps = nal; }
+        if ((nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_IDR || nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_NON_IDR) && pps.buf != NULL) { slice = nal; }
+    }
+    if (slice.buf == NULL) { printf("%s: no SPS, PPS and slice \n", name); free(buf); return 1; }
+
+    h264_stream_t* ref = h264_new();
+    read_nal_unit(ref, (uint8_t*)sps.buf, sps.size);
+    read_nal_unit(ref, (uint8_t*)pps.buf, pps.size);
+
+    // the same PPS with another pic_init_qp
+    h264_stream_t* h = h264_new();
+    uint8_t other_pps[512];
+    read_nal_unit(h, (uint8_t*)sps.buf, sps.size);
+    read_nal_unit(h, (uint8_t*)pps.buf, pps.size);
+    h->pps->pic_init_qp_minus26 += 1;
+    int other_pps_size = write_nal_unit(h, other_pps, sizeof(other_pps)) - 1;
+    h264_free(h);
+
+    int record_capacity = 16 + 3 * sps.size + 2 * pps.size + other_pps_size;
+    uint8_t* record = (uint8_t*)malloc(record_capacity);
+    uint8_t* other_record = (uint8_t*)malloc(record_capacity);
+    int record_size = make_avcc(record, sps.buf, sps.size, pps.buf, pps.size);
+    int other_record_size = make_avcc(other_record, sps.buf, sps.size, other_pps + 1, other_pps_size);
+
+    avcc_t* avcc = avcc_new();
+    int failures = 0;
+
+    h = h264_new();
+    if (read_record(avcc, h, record, record_size) != record_size || avcc->numOfSequenceParameterSets != 2 || avcc->numOfPictureParameterSets != 1 ||
+        avcc->sps_table[0].sps == NULL || avcc->pps_table[0].pps == NULL)
+    {
+        printf("%s: record not read \n", name);
+        h264_free(h);
+        avcc_free(avcc);
+        free(other_record);
+        free(record);
+        h264_free(ref);
+        free(buf);
+        return 1;
+    }
+    h264_sps_ref_t* sps_ref = avcc->sps_table[0].sps;
+    h264_pps_ref_t* pps_ref = avcc->pps_table[0].pps;
+    if (avcc->sps_table[1].sps != sps_ref) { printf("%s: the same SPS twice has two snapshots \n", name); failures++; }
+    if (!in_tables(avcc, h)) { printf("%s: parameter sets not in the tables of the stream \n", name); failures++; }
+
+    // the same record again: nothing parsed
+    read_record(avcc, h, record, record_size);
+    if (avcc->sps_table[0].sps != sps_ref || avcc->pps_table[0].pps != pps_ref) { printf("%s: the same record parsed again \n", name); failures++; }
+
+    // another PPS with the same id read since
+    read_nal_unit(h, other_pps + 1, other_pps_size);
+    if (h->pps_refs[pps_ref->pps.pic_parameter_set_id] == pps_ref) { printf("%s: other PPS not read \n", name); failures++; }
+    read_record(avcc, h, record, record_size);
+    if (!in_tables(avcc, h) || avcc->pps_table[0].pps != pps_ref) { printf("%s: parameter sets not put back after another PPS \n", name); failures++; }
+    if (!same_slice(h, ref, (uint8_t*)slice.buf, slice.size)) { printf("%s: slice reads differently after another PPS \n", name); failures++; }
+    h264_free(h);
+
+    // a new stream for every fragment, the record outlives them
+    for (int i = 0; i < 3; i++)
+    {
+        h = h264_new();
+        read_record(avcc, h, record, record_size);
+        if (avcc->sps_table[0].sps != sps_ref || avcc->pps_table[0].pps != pps_ref || !in_tables(avcc, h))
+        {
+            printf("%s: parameter sets not put into the stream of fragment %d \n", name, i);
+            failures++;
+        }
+        if (!same_slice(h, ref, (uint8_t*)slice.buf, slice.size)) { printf("%s: slice of fragment %d reads differently \n", name, i); failures++; }
+        h264_free(h);
+    }
+
+    // a changed record is parsed, the unchanged SPS keeps its snapshot in the stream which has it
+    int pic_init_qp_minus26 = pps_ref->pps.pic_init_qp_minus26;
+    h = h264_new();
+    read_record(avcc, h, record, record_size);
+    read_record(avcc, h, other_record, other_record_size);
+    if (avcc->sps_table[0].sps != sps_ref || avcc->pps_table[0].pps == pps_ref || !in_tables(avcc, h) ||
+        avcc->pps_table[0].pps->pps.pic_init_qp_minus26 != pic_init_qp_minus26 + 1)
+    {
+        printf("%s: changed record not read \n", name);
+        failures++;
+    }
+    h264_free(h);
+
+    avcc_free(avcc);
+    free(other_record);
+    free(record);
+    h264_free(ref);
+    free(buf);
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    int failures = 0;
+
+    for (int i = 1; i < argc; i++) { failures += check_file(argv[i]); }
+
+    printf("avcC records read: %d, mismatches: %d\n", argc - 1, failures);
+    return (failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
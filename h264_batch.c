@@ -0,0 +1,344 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef H264_NO_THREADS
+#include <pthread.h>
+#endif
+
+#include "h264_stream.h"
+#include "h264_batch.h"
+
+static int is_param_set(int nal_unit_type)
+{
+    return (nal_unit_type == NAL_UNIT_TYPE_SPS || nal_unit_type == NAL_UNIT_TYPE_PPS || nal_unit_type == NAL_UNIT_TYPE_SUBSET_SPS);
+}
+
+// the parameter set snapshots in effect at some point of the stream
+typedef struct
+{
+    h264_sps_ref_t* sps[32];
+    h264_sps_subset_ref_t* sps_subset[64];
+    h264_pps_ref_t* pps[256];
+} ps_snapshot_t;
+
+static ps_snapshot_t* snapshot_new(const h264_stream_t* h)
+{
+    ps_snapshot_t* snap = (ps_snapshot_t*)malloc(sizeof(ps_snapshot_t));
+    for ( int i = 0; i < 32; i++ ) { snap->sps[i] = (h264_sps_ref_t*)h264_ps_retain(h->sps_refs[i]); }
+    for ( int i = 0; i < 64; i++ ) { snap->sps_subset[i] = (h264_sps_subset_ref_t*)h264_ps_retain(h->sps_subset_refs[i]); }
+    for ( int i = 0; i < 256; i++ ) { snap->pps[i] = (h264_pps_ref_t*)h264_ps_retain(h->pps_refs[i]); }
+    return snap;
+}
+
+static void snapshot_free(ps_snapshot_t* snap)
+{
+    for ( int i = 0; i < 32; i++ ) { h264_ps_release(snap->sps[i]); }
+    for ( int i = 0; i < 64; i++ ) { h264_ps_release(snap->sps_subset[i]); }
+    for ( int i = 0; i < 256; i++ ) { h264_ps_release(snap->pps[i]); }
+    free(snap);
+}
+
+// make the parameter set tables of h those of the snapshot, copying only the entries which differ
+static void snapshot_load(h264_stream_t* h, const ps_snapshot_t* snap)
+{
+    for ( int i = 0; i < 32; i++ )
+    {
+        if (h->sps_refs[i] == snap->sps[i]) { continue; }
+        h264_ps_release(h->sps_refs[i]);
+        h->sps_refs[i] = (h264_sps_ref_t*)h264_ps_retain(snap->sps[i]);
+        if (snap->sps[i] != NULL) { memcpy(h->sps_table[i], &snap->sps[i]->sps, sizeof(sps_t)); }
+        else { memset(h->sps_table[i], 0, sizeof(sps_t)); }
+    }
+    for ( int i = 0; i < 64; i++ )
+    {
+        if (h->sps_subset_refs[i] == snap->sps_subset[i]) { continue; }
+        h264_ps_release(h->sps_subset_refs[i]);
+        h->sps_subset_refs[i] = (h264_sps_subset_ref_t*)h264_ps_retain(snap->sps_subset[i]);
+        if (snap->sps_subset[i] != NULL)
+        {
+            memcpy(h->sps_subset_table[i]->sps, &snap->sps_subset[i]->sps, sizeof(sps_t));
+            memcpy(h->sps_subset_table[i]->sps_svc_ext, &snap->sps_subset[i]->sps_svc_ext, sizeof(sps_svc_ext_t));
+            h->sps_subset_table[i]->additional_extension2_flag = snap->sps_subset[i]->additional_extension2_flag;
+        }
+        else
+        {
+            memset(h->sps_subset_table[i]->sps, 0, sizeof(sps_t));
+            memset(h->sps_subset_table[i]->sps_svc_ext, 0, sizeof(sps_svc_ext_t));
+            h->sps_subset_table[i]->additional_extension2_flag = 0;
+        }
+    }
+    for ( int i = 0; i < 256; i++ )
+    {
+        if (h->pps_refs[i] == snap->pps[i]) { continue; }
+        h264_ps_release(h->pps_refs[i]);
+        h->pps_refs[i] = (h264_pps_ref_t*)h264_ps_retain(snap->pps[i]);
+        if (snap->pps[i] != NULL) { memcpy(h->pps_table[i], &snap->pps[i]->pps, sizeof(pps_t)); }
+        else { memset(h->pps_table[i], 0, sizeof(pps_t)); }
+    }
+}
+
+static void fill_record(h264_nal_record_t* r, const h264_nal_span_t* nal, const h264_stream_t* h, int status)
+{
+    r->status = status;
+    r->seq_parameter_set_id = -1;
+    if (nal->size < 1) { r->status = -1; return; }
+    r->nal_unit_type = nal->buf[0] & 0x1F;
+    r->nal_ref_idc = (nal->buf[0] >> 5) & 0x03;
+    if (status < 0) { return; }
+
+    switch (h->nal->nal_unit_type)
+    {
+        case NAL_UNIT_TYPE_SPS:
+            r->seq_parameter_set_id = h->sps->seq_parameter_set_id;
+            r->sps = (h264_sps_ref_t*)h264_ps_retain(h->sps_refs[h->sps->seq_parameter_set_id]);
+            break;
+        case NAL_UNIT_TYPE_SUBSET_SPS:
+            r->seq_parameter_set_id = h->sps_subset->sps->seq_parameter_set_id;
+            r->sps_subset = (h264_sps_subset_ref_t*)h264_ps_retain(h->sps_subset_refs[h->sps_subset->sps->seq_parameter_set_id]);
+            break;
+        case NAL_UNIT_TYPE_PPS:
+            r->pic_parameter_set_id = h->pps->pic_parameter_set_id;
+            r->seq_parameter_set_id = h->pps->seq_parameter_set_id;
+            r->pps = (h264_pps_ref_t*)h264_ps_retain(h->pps_refs[h->pps->pic_parameter_set_id]);
+            break;
+        case NAL_UNIT_TYPE_CODED_SLICE_IDR:
+        case NAL_UNIT_TYPE_CODED_SLICE_NON_IDR:
+        case NAL_UNIT_TYPE_CODED_SLICE_AUX:
+        case NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION:
+            r->slice_type = h->sh->slice_type;
+            r->pic_parameter_set_id = h->sh->pic_parameter_set_id;
+            r->seq_parameter_set_id = h->pps->seq_parameter_set_id;
+            r->slice_qp_delta = h->sh->slice_qp_delta;
+            r->first_mb_in_slice = h->sh->first_mb_in_slice;
+            r->frame_num = h->sh->frame_num;
+            r->idr_pic_id = h->sh->idr_pic_id;
+            r->pic_order_cnt_lsb = h->sh->pic_order_cnt_lsb;
+            r->sps = (h264_sps_ref_t*)h264_ps_retain(h->sps_ref);
+            r->sps_subset = (h264_sps_subset_ref_t*)h264_ps_retain(h->sps_subset_ref);
+            r->pps = (h264_pps_ref_t*)h264_ps_retain(h->pps_ref);
+            break;
+    }
+}
+
+typedef struct
+{
+    const h264_nal_span_t* nals;
+    h264_nal_record_t* records;
+    int* tasks;                 // indexes of the nals which are parsed in parallel
+    ps_snapshot_t** snapshots;  // parameter sets as of each generation
+} batch_t;
+
+// range of tasks [next, end) owned by a worker; the owner takes from the front, thieves take the back half
+typedef struct
+{
+    batch_t* batch;
+    int next;
+    int end;
+#ifndef H264_NO_THREADS
+    pthread_mutex_t lock;
+    pthread_t thread;
+#endif
+    int num_workers;
+    int id;
+} worker_t;
+
+static void parse_task(batch_t* batch, h264_stream_t* h, uint32_t* generation, int task)
+{
+    int n = batch->tasks[task];
+    h264_nal_record_t* r = &batch->records[n];
+
+    if (r->generation != *generation)
+    {
+        snapshot_load(h, batch->snapshots[r->generation]);
+        *generation = r->generation;
+    }
+    // read_nal_unit does not modify its input, it converts it to rbsp in a buffer of its own
+    int status = -1;
+    if (batch->nals[n].size > 0) { status = read_nal_unit(h, (uint8_t*)batch->nals[n].buf, batch->nals[n].size); }
+    fill_record(r, &batch->nals[n], h, status);
+}
+
+#ifndef H264_NO_THREADS
+
+static int take_task(worker_t* w)
+{
+    int task = -1;
+    pthread_mutex_lock(&w->lock);
+    if (w->next < w->end) { task = w->next++; }
+    pthread_mutex_unlock(&w->lock);
+    return task;
+}
+
+// move the back half of another worker's range into w, return 0 if there is nothing left to steal
+static int steal_tasks(worker_t* w, worker_t* workers)
+{
+    for (int i = 1; i < w->num_workers; i++)
+    {
+        worker_t* v = &workers[(w->id + i) % w->num_workers];
+        int begin = -1, end = -1;
+
+        pthread_mutex_lock(&v->lock);
+        if (v->next < v->end)
+        {
+            begin = v->next + (v->end - v->next) / 2;
+            end = v->end;
+            v->end = begin;
+        }
+        pthread_mutex_unlock(&v->lock);
+
+        if (begin >= 0)
+        {
+            pthread_mutex_lock(&w->lock);
+            w->next = begin;
+            w->end = end;
+            pthread_mutex_unlock(&w->lock);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void* worker_main(void* arg)
+{
+    worker_t* w = (worker_t*)arg;
+    worker_t* workers = w - w->id;
+    h264_stream_t* h = h264_new();
+    uint32_t generation = 0;
+    int task;
+
+    while (1)
+    {
+        while ((task = take_task(w)) >= 0) { parse_task(w->batch, h, &generation, task); }
+        if (!steal_tasks(w, workers)) { break; }
+    }
+
+    h264_free(h);
+    return NULL;
+}
+
+#endif
+
+/**
+ Parse many NAL units, using several threads.
+ Parameter sets (SPS, subset SPS, PPS) are parsed first, serially and in order, and every change of their content
+ starts a new generation; all other NALs are then parsed in parallel, each against the parameter set snapshots
+ in effect at its position in the input.  A worker only copies the parameter sets which differ when the generation
+ changes, so this is cheap for the usual case of parameter sets which are sent once or repeated unchanged.
+ NALs which depend on state other than the parameter sets (e.g. SVC slices on the preceding prefix NAL) are parsed
+ without it.
+ @param[in]  nals         the NAL units, in stream order
+ @param[in]  num_nals     number of NAL units
+ @param[out] records      array of num_nals records, filled in with the results in the same order as nals
+ @param[in]  num_threads  number of threads to use, 1 to parse on the calling thread only
+ @return     number of NAL units which could not be parsed (status -1)
+ */
+int h264_parse_nals(const h264_nal_span_t* nals, int num_nals, h264_nal_record_t* records, int num_threads)
+{
+    batch_t batch;
+    int num_tasks = 0;
+    int num_snapshots = 1;
+    int errors = 0;
+
+    memset(records, 0, num_nals * sizeof(h264_nal_record_t));
+    batch.nals = nals;
+    batch.records = records;
+    batch.tasks = (int*)malloc(num_nals * sizeof(int));
+    // serial pass: parameter sets, which define the state the rest is parsed against
+    h264_stream_t* h = h264_new();
+    batch.snapshots = (ps_snapshot_t**)malloc(sizeof(ps_snapshot_t*));
+    batch.snapshots[0] = snapshot_new(h);
+
+    for (int n = 0; n < num_nals; n++)
+    {
+        if (nals[n].size < 1 || !is_param_set(nals[n].buf[0] & 0x1F))
+        {
+            records[n].generation = num_snapshots - 1;
+            batch.tasks[num_tasks++] = n;
+            continue;
+        }
+
+        int status = read_nal_unit(h, (uint8_t*)nals[n].buf, nals[n].size);
+        if (h->ps_generation != (uint32_t)(num_snapshots - 1))
+        {
+            batch.snapshots = (ps_snapshot_t**)realloc(batch.snapshots, (num_snapshots + 1) * sizeof(ps_snapshot_t*));
+            batch.snapshots[num_snapshots] = snapshot_new(h);
+            num_snapshots++;
+        }
+        fill_record(&records[n], &nals[n], h, status);
+        records[n].generation = num_snapshots - 1;
+    }
+    h264_free(h);
+
+    // parallel pass
+#ifndef H264_NO_THREADS
+    if (num_threads > num_tasks) { num_threads = num_tasks; }
+    if (num_threads > 1)
+    {
+        worker_t* workers = (worker_t*)calloc(num_threads, sizeof(worker_t));
+        for (int i = 0; i < num_threads; i++)
+        {
+            // contiguous ranges, so a worker mostly sees a single generation
+            workers[i].batch = &batch;
+            workers[i].next = (int)((int64_t)num_tasks * i / num_threads);
+            workers[i].end = (int)((int64_t)num_tasks * (i + 1) / num_threads);
+            workers[i].num_workers = num_threads;
+            workers[i].id = i;
+            pthread_mutex_init(&workers[i].lock, NULL);
+        }
+        for (int i = 0; i < num_threads; i++) { pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]); }
+        for (int i = 0; i < num_threads; i++) { pthread_join(workers[i].thread, NULL); }
+        for (int i = 0; i < num_threads; i++) { pthread_mutex_destroy(&workers[i].lock); }
+        free(workers);
+    }
+    else
+#endif
+    {
+        h = h264_new();
+        uint32_t generation = 0;
+        for (int task = 0; task < num_tasks; task++) { parse_task(&batch, h, &generation, task); }
+        h264_free(h);
+    }
+
+    for (int n = 0; n < num_nals; n++) { if (records[n].status < 0) { errors++; } }
+    for (int i = 0; i < num_snapshots; i++) { snapshot_free(batch.snapshots[i]); }
+    free(batch.snapshots);
+    free(batch.tasks);
+
+    return errors;
+}
+
+/**
+ Release the parameter set snapshots referenced by records filled in by h264_parse_nals.
+ */
+void h264_nal_records_release(h264_nal_record_t* records, int num_records)
+{
+    for (int n = 0; n < num_records; n++)
+    {
+        h264_ps_release(records[n].sps);
+        h264_ps_release(records[n].sps_subset);
+        h264_ps_release(records[n].pps);
+        records[n].sps = NULL;
+        records[n].sps_subset = NULL;
+        records[n].pps = NULL;
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _H264_BATCH_H
+#define _H264_BATCH_H        1
+
+#include <stdint.h>
+
+#include "h264_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+   Compact result of parsing one NAL unit with h264_parse_nals.
+   The parameter set snapshots are references owned by the record, release them with h264_nal_records_release.
+*/
+typedef struct
+{
+    int status;                 // return value of read_nal_unit, -1 on error
+    uint8_t nal_unit_type;
+    uint8_t nal_ref_idc;
+    uint8_t slice_type;         // slices only
+    uint8_t pic_parameter_set_id; // PPS and slices
+    int16_t seq_parameter_set_id; // SPS, subset SPS, PPS and slices; -1 otherwise
+    int16_t slice_qp_delta;
+    uint32_t generation;        // parameter set generation the NAL was parsed against, increases with every change of SPS/PPS content
+    int first_mb_in_slice;
+    int frame_num;
+    int idr_pic_id;
+    int pic_order_cnt_lsb;
+    h264_sps_ref_t* sps;        // SPS of a SPS record or of an AVC slice
+    h264_sps_subset_ref_t* sps_subset; // subset SPS of a subset SPS record or of an SVC slice
+    h264_pps_ref_t* pps;        // PPS of a PPS record or of a slice
+} h264_nal_record_t;
+
+int h264_parse_nals(const h264_nal_span_t* nals, int num_nals, h264_nal_record_t* records, int num_threads);
+void h264_nal_records_release(h264_nal_record_t* records, int num_records);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
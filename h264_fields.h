@@ -0,0 +1,402 @@
+/* generated by process.pl --fields from h264_stream.in.c h264_sei.in.c h264_slice_data.in.c, do not edit */
+
+#ifndef _H264_FIELDS_H
+#define _H264_FIELDS_H        1
+
+// X(id, name) for every syntax element printed by read_debug_*, in order of first appearance
+#define H264_FIELDS(X) \
+    X( H264_FIELD_FORBIDDEN_ZERO_BIT, "forbidden_zero_bit" ) \
+    X( H264_FIELD_NAL_NAL_REF_IDC, "nal->nal_ref_idc" ) \
+    X( H264_FIELD_NAL_NAL_UNIT_TYPE, "nal->nal_unit_type" ) \
+    X( H264_FIELD_NAL_SVC_EXTENSION_FLAG, "nal->svc_extension_flag" ) \
+    X( H264_FIELD_NAL_AVC_3D_EXTENSION_FLAG, "nal->avc_3d_extension_flag" ) \
+    X( H264_FIELD_NAL_SVC_EXT_IDR_FLAG, "nal_svc_ext->idr_flag" ) \
+    X( H264_FIELD_NAL_SVC_EXT_PRIORITY_ID, "nal_svc_ext->priority_id" ) \
+    X( H264_FIELD_NAL_SVC_EXT_NO_INTER_LAYER_PRED_FLAG, "nal_svc_ext->no_inter_layer_pred_flag" ) \
+    X( H264_FIELD_NAL_SVC_EXT_DEPENDENCY_ID, "nal_svc_ext->dependency_id" ) \
+    X( H264_FIELD_NAL_SVC_EXT_QUALITY_ID, "nal_svc_ext->quality_id" ) \
+    X( H264_FIELD_NAL_SVC_EXT_TEMPORAL_ID, "nal_svc_ext->temporal_id" ) \
+    X( H264_FIELD_NAL_SVC_EXT_USE_REF_BASE_PIC_FLAG, "nal_svc_ext->use_ref_base_pic_flag" ) \
+    X( H264_FIELD_NAL_SVC_EXT_DISCARDABLE_FLAG, "nal_svc_ext->discardable_flag" ) \
+    X( H264_FIELD_NAL_SVC_EXT_OUTPUT_FLAG, "nal_svc_ext->output_flag" ) \
+    X( H264_FIELD_NAL_SVC_EXT_RESERVED_THREE_2BITS, "nal_svc_ext->reserved_three_2bits" ) \
+    X( H264_FIELD_NAL_PREFIX_NAL_SVC_STORE_REF_BASE_PIC_FLAG, "nal->prefix_nal_svc->store_ref_base_pic_flag" ) \
+    X( H264_FIELD_NAL_PREFIX_NAL_SVC_ADDITIONAL_PREFIX_NAL_UNIT_EXTENSION_FLAG, "nal->prefix_nal_svc->additional_prefix_nal_unit_extension_flag" ) \
+    X( H264_FIELD_NAL_PREFIX_NAL_SVC_ADDITIONAL_PREFIX_NAL_UNIT_EXTENSION_DATA_FLAG, "nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag" ) \
+    X( H264_FIELD_SPS_PROFILE_IDC, "sps->profile_idc" ) \
+    X( H264_FIELD_SPS_CONSTRAINT_SET0_FLAG, "sps->constraint_set0_flag" ) \
+    X( H264_FIELD_SPS_CONSTRAINT_SET1_FLAG, "sps->constraint_set1_flag" ) \
+    X( H264_FIELD_SPS_CONSTRAINT_SET2_FLAG, "sps->constraint_set2_flag" ) \
+    X( H264_FIELD_SPS_CONSTRAINT_SET3_FLAG, "sps->constraint_set3_flag" ) \
+    X( H264_FIELD_SPS_CONSTRAINT_SET4_FLAG, "sps->constraint_set4_flag" ) \
+    X( H264_FIELD_SPS_CONSTRAINT_SET5_FLAG, "sps->constraint_set5_flag" ) \
+    X( H264_FIELD_RESERVED_ZERO_2BITS, "reserved_zero_2bits" ) \
+    X( H264_FIELD_SPS_LEVEL_IDC, "sps->level_idc" ) \
+    X( H264_FIELD_SPS_SEQ_PARAMETER_SET_ID, "sps->seq_parameter_set_id" ) \
+    X( H264_FIELD_SPS_CHROMA_FORMAT_IDC, "sps->chroma_format_idc" ) \
+    X( H264_FIELD_SPS_RESIDUAL_COLOUR_TRANSFORM_FLAG, "sps->residual_colour_transform_flag" ) \
+    X( H264_FIELD_SPS_BIT_DEPTH_LUMA_MINUS8, "sps->bit_depth_luma_minus8" ) \
+    X( H264_FIELD_SPS_BIT_DEPTH_CHROMA_MINUS8, "sps->bit_depth_chroma_minus8" ) \
+    X( H264_FIELD_SPS_QPPRIME_Y_ZERO_TRANSFORM_BYPASS_FLAG, "sps->qpprime_y_zero_transform_bypass_flag" ) \
+    X( H264_FIELD_SPS_SEQ_SCALING_MATRIX_PRESENT_FLAG, "sps->seq_scaling_matrix_present_flag" ) \
+    X( H264_FIELD_SPS_SEQ_SCALING_LIST_PRESENT_FLAG_I, "sps->seq_scaling_list_present_flag[ i ]" ) \
+    X( H264_FIELD_SPS_LOG2_MAX_FRAME_NUM_MINUS4, "sps->log2_max_frame_num_minus4" ) \
+    X( H264_FIELD_SPS_PIC_ORDER_CNT_TYPE, "sps->pic_order_cnt_type" ) \
+    X( H264_FIELD_SPS_LOG2_MAX_PIC_ORDER_CNT_LSB_MINUS4, "sps->log2_max_pic_order_cnt_lsb_minus4" ) \
+    X( H264_FIELD_SPS_DELTA_PIC_ORDER_ALWAYS_ZERO_FLAG, "sps->delta_pic_order_always_zero_flag" ) \
+    X( H264_FIELD_SPS_OFFSET_FOR_NON_REF_PIC, "sps->offset_for_non_ref_pic" ) \
+    X( H264_FIELD_SPS_OFFSET_FOR_TOP_TO_BOTTOM_FIELD, "sps->offset_for_top_to_bottom_field" ) \
+    X( H264_FIELD_SPS_NUM_REF_FRAMES_IN_PIC_ORDER_CNT_CYCLE, "sps->num_ref_frames_in_pic_order_cnt_cycle" ) \
+    X( H264_FIELD_SPS_OFFSET_FOR_REF_FRAME_I, "sps->offset_for_ref_frame[ i ]" ) \
+    X( H264_FIELD_SPS_NUM_REF_FRAMES, "sps->num_ref_frames" ) \
+    X( H264_FIELD_SPS_GAPS_IN_FRAME_NUM_VALUE_ALLOWED_FLAG, "sps->gaps_in_frame_num_value_allowed_flag" ) \
+    X( H264_FIELD_SPS_PIC_WIDTH_IN_MBS_MINUS1, "sps->pic_width_in_mbs_minus1" ) \
+    X( H264_FIELD_SPS_PIC_HEIGHT_IN_MAP_UNITS_MINUS1, "sps->pic_height_in_map_units_minus1" ) \
+    X( H264_FIELD_SPS_FRAME_MBS_ONLY_FLAG, "sps->frame_mbs_only_flag" ) \
+    X( H264_FIELD_SPS_MB_ADAPTIVE_FRAME_FIELD_FLAG, "sps->mb_adaptive_frame_field_flag" ) \
+    X( H264_FIELD_SPS_DIRECT_8X8_INFERENCE_FLAG, "sps->direct_8x8_inference_flag" ) \
+    X( H264_FIELD_SPS_FRAME_CROPPING_FLAG, "sps->frame_cropping_flag" ) \
+    X( H264_FIELD_SPS_FRAME_CROP_LEFT_OFFSET, "sps->frame_crop_left_offset" ) \
+    X( H264_FIELD_SPS_FRAME_CROP_RIGHT_OFFSET, "sps->frame_crop_right_offset" ) \
+    X( H264_FIELD_SPS_FRAME_CROP_TOP_OFFSET, "sps->frame_crop_top_offset" ) \
+    X( H264_FIELD_SPS_FRAME_CROP_BOTTOM_OFFSET, "sps->frame_crop_bottom_offset" ) \
+    X( H264_FIELD_SPS_VUI_PARAMETERS_PRESENT_FLAG, "sps->vui_parameters_present_flag" ) \
+    X( H264_FIELD_DELTA_SCALE, "delta_scale" ) \
+    X( H264_FIELD_SPS_SVC_EXT_SVC_VUI_PARAMETERS_PRESENT_FLAG, "sps_svc_ext->svc_vui_parameters_present_flag" ) \
+    X( H264_FIELD_SPS_SUBSET_ADDITIONAL_EXTENSION2_FLAG, "sps_subset->additional_extension2_flag" ) \
+    X( H264_FIELD_SPS_SVC_EXT_INTER_LAYER_DEBLOCKING_FILTER_CONTROL_PRESENT_FLAG, "sps_svc_ext->inter_layer_deblocking_filter_control_present_flag" ) \
+    X( H264_FIELD_SPS_SVC_EXT_EXTENDED_SPATIAL_SCALABILITY_IDC, "sps_svc_ext->extended_spatial_scalability_idc" ) \
+    X( H264_FIELD_SPS_SVC_EXT_CHROMA_PHASE_X_PLUS1_FLAG, "sps_svc_ext->chroma_phase_x_plus1_flag" ) \
+    X( H264_FIELD_SPS_SVC_EXT_CHROMA_PHASE_Y_PLUS1, "sps_svc_ext->chroma_phase_y_plus1" ) \
+    X( H264_FIELD_SPS_SVC_EXT_SEQ_REF_LAYER_CHROMA_PHASE_X_PLUS1_FLAG, "sps_svc_ext->seq_ref_layer_chroma_phase_x_plus1_flag" ) \
+    X( H264_FIELD_SPS_SVC_EXT_SEQ_REF_LAYER_CHROMA_PHASE_Y_PLUS1, "sps_svc_ext->seq_ref_layer_chroma_phase_y_plus1" ) \
+    X( H264_FIELD_SPS_SVC_EXT_SEQ_SCALED_REF_LAYER_LEFT_OFFSET, "sps_svc_ext->seq_scaled_ref_layer_left_offset" ) \
+    X( H264_FIELD_SPS_SVC_EXT_SEQ_SCALED_REF_LAYER_TOP_OFFSET, "sps_svc_ext->seq_scaled_ref_layer_top_offset" ) \
+    X( H264_FIELD_SPS_SVC_EXT_SEQ_SCALED_REF_LAYER_RIGHT_OFFSET, "sps_svc_ext->seq_scaled_ref_layer_right_offset" ) \
+    X( H264_FIELD_SPS_SVC_EXT_SEQ_SCALED_REF_LAYER_BOTTOM_OFFSET, "sps_svc_ext->seq_scaled_ref_layer_bottom_offset" ) \
+    X( H264_FIELD_SPS_SVC_EXT_SEQ_TCOEFF_LEVEL_PREDICTION_FLAG, "sps_svc_ext->seq_tcoeff_level_prediction_flag" ) \
+    X( H264_FIELD_SPS_SVC_EXT_ADAPTIVE_TCOEFF_LEVEL_PREDICTION_FLAG, "sps_svc_ext->adaptive_tcoeff_level_prediction_flag" ) \
+    X( H264_FIELD_SPS_SVC_EXT_SLICE_HEADER_RESTRICTION_FLAG, "sps_svc_ext->slice_header_restriction_flag" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_NUM_ENTRIES_MINUS1, "sps_svc_ext->vui.vui_ext_num_entries_minus1" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_DEPENDENCY_ID_I, "sps_svc_ext->vui.vui_ext_dependency_id[i]" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_QUALITY_ID_I, "sps_svc_ext->vui.vui_ext_quality_id[i]" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_TEMPORAL_ID_I, "sps_svc_ext->vui.vui_ext_temporal_id[i]" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_TIMING_INFO_PRESENT_FLAG_I, "sps_svc_ext->vui.vui_ext_timing_info_present_flag[i]" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_NUM_UNITS_IN_TICK_I, "sps_svc_ext->vui.vui_ext_num_units_in_tick[i]" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_TIME_SCALE_I, "sps_svc_ext->vui.vui_ext_time_scale[i]" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_FIXED_FRAME_RATE_FLAG_I, "sps_svc_ext->vui.vui_ext_fixed_frame_rate_flag[i]" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_NAL_HRD_PARAMETERS_PRESENT_FLAG_I, "sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i]" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_VCL_HRD_PARAMETERS_PRESENT_FLAG_I, "sps_svc_ext->vui.vui_ext_vcl_hrd_parameters_present_flag[i]" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_LOW_DELAY_HRD_FLAG_I, "sps_svc_ext->vui.vui_ext_low_delay_hrd_flag[i]" ) \
+    X( H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_PIC_STRUCT_PRESENT_FLAG_I, "sps_svc_ext->vui.vui_ext_pic_struct_present_flag[i]" ) \
+    X( H264_FIELD_SPS_VUI_ASPECT_RATIO_INFO_PRESENT_FLAG, "sps->vui.aspect_ratio_info_present_flag" ) \
+    X( H264_FIELD_SPS_VUI_ASPECT_RATIO_IDC, "sps->vui.aspect_ratio_idc" ) \
+    X( H264_FIELD_SPS_VUI_SAR_WIDTH, "sps->vui.sar_width" ) \
+    X( H264_FIELD_SPS_VUI_SAR_HEIGHT, "sps->vui.sar_height" ) \
+    X( H264_FIELD_SPS_VUI_OVERSCAN_INFO_PRESENT_FLAG, "sps->vui.overscan_info_present_flag" ) \
+    X( H264_FIELD_SPS_VUI_OVERSCAN_APPROPRIATE_FLAG, "sps->vui.overscan_appropriate_flag" ) \
+    X( H264_FIELD_SPS_VUI_VIDEO_SIGNAL_TYPE_PRESENT_FLAG, "sps->vui.video_signal_type_present_flag" ) \
+    X( H264_FIELD_SPS_VUI_VIDEO_FORMAT, "sps->vui.video_format" ) \
+    X( H264_FIELD_SPS_VUI_VIDEO_FULL_RANGE_FLAG, "sps->vui.video_full_range_flag" ) \
+    X( H264_FIELD_SPS_VUI_COLOUR_DESCRIPTION_PRESENT_FLAG, "sps->vui.colour_description_present_flag" ) \
+    X( H264_FIELD_SPS_VUI_COLOUR_PRIMARIES, "sps->vui.colour_primaries" ) \
+    X( H264_FIELD_SPS_VUI_TRANSFER_CHARACTERISTICS, "sps->vui.transfer_characteristics" ) \
+    X( H264_FIELD_SPS_VUI_MATRIX_COEFFICIENTS, "sps->vui.matrix_coefficients" ) \
+    X( H264_FIELD_SPS_VUI_CHROMA_LOC_INFO_PRESENT_FLAG, "sps->vui.chroma_loc_info_present_flag" ) \
+    X( H264_FIELD_SPS_VUI_CHROMA_SAMPLE_LOC_TYPE_TOP_FIELD, "sps->vui.chroma_sample_loc_type_top_field" ) \
+    X( H264_FIELD_SPS_VUI_CHROMA_SAMPLE_LOC_TYPE_BOTTOM_FIELD, "sps->vui.chroma_sample_loc_type_bottom_field" ) \
+    X( H264_FIELD_SPS_VUI_TIMING_INFO_PRESENT_FLAG, "sps->vui.timing_info_present_flag" ) \
+    X( H264_FIELD_SPS_VUI_NUM_UNITS_IN_TICK, "sps->vui.num_units_in_tick" ) \
+    X( H264_FIELD_SPS_VUI_TIME_SCALE, "sps->vui.time_scale" ) \
+    X( H264_FIELD_SPS_VUI_FIXED_FRAME_RATE_FLAG, "sps->vui.fixed_frame_rate_flag" ) \
+    X( H264_FIELD_SPS_VUI_NAL_HRD_PARAMETERS_PRESENT_FLAG, "sps->vui.nal_hrd_parameters_present_flag" ) \
+    X( H264_FIELD_SPS_VUI_VCL_HRD_PARAMETERS_PRESENT_FLAG, "sps->vui.vcl_hrd_parameters_present_flag" ) \
+    X( H264_FIELD_SPS_VUI_LOW_DELAY_HRD_FLAG, "sps->vui.low_delay_hrd_flag" ) \
+    X( H264_FIELD_SPS_VUI_PIC_STRUCT_PRESENT_FLAG, "sps->vui.pic_struct_present_flag" ) \
+    X( H264_FIELD_SPS_VUI_BITSTREAM_RESTRICTION_FLAG, "sps->vui.bitstream_restriction_flag" ) \
+    X( H264_FIELD_SPS_VUI_MOTION_VECTORS_OVER_PIC_BOUNDARIES_FLAG, "sps->vui.motion_vectors_over_pic_boundaries_flag" ) \
+    X( H264_FIELD_SPS_VUI_MAX_BYTES_PER_PIC_DENOM, "sps->vui.max_bytes_per_pic_denom" ) \
+    X( H264_FIELD_SPS_VUI_MAX_BITS_PER_MB_DENOM, "sps->vui.max_bits_per_mb_denom" ) \
+    X( H264_FIELD_SPS_VUI_LOG2_MAX_MV_LENGTH_HORIZONTAL, "sps->vui.log2_max_mv_length_horizontal" ) \
+    X( H264_FIELD_SPS_VUI_LOG2_MAX_MV_LENGTH_VERTICAL, "sps->vui.log2_max_mv_length_vertical" ) \
+    X( H264_FIELD_SPS_VUI_NUM_REORDER_FRAMES, "sps->vui.num_reorder_frames" ) \
+    X( H264_FIELD_SPS_VUI_MAX_DEC_FRAME_BUFFERING, "sps->vui.max_dec_frame_buffering" ) \
+    X( H264_FIELD_HRD_CPB_CNT_MINUS1, "hrd->cpb_cnt_minus1" ) \
+    X( H264_FIELD_HRD_BIT_RATE_SCALE, "hrd->bit_rate_scale" ) \
+    X( H264_FIELD_HRD_CPB_SIZE_SCALE, "hrd->cpb_size_scale" ) \
+    X( H264_FIELD_HRD_BIT_RATE_VALUE_MINUS1_SCHEDSELIDX, "hrd->bit_rate_value_minus1[ SchedSelIdx ]" ) \
+    X( H264_FIELD_HRD_CPB_SIZE_VALUE_MINUS1_SCHEDSELIDX, "hrd->cpb_size_value_minus1[ SchedSelIdx ]" ) \
+    X( H264_FIELD_HRD_CBR_FLAG_SCHEDSELIDX, "hrd->cbr_flag[ SchedSelIdx ]" ) \
+    X( H264_FIELD_HRD_INITIAL_CPB_REMOVAL_DELAY_LENGTH_MINUS1, "hrd->initial_cpb_removal_delay_length_minus1" ) \
+    X( H264_FIELD_HRD_CPB_REMOVAL_DELAY_LENGTH_MINUS1, "hrd->cpb_removal_delay_length_minus1" ) \
+    X( H264_FIELD_HRD_DPB_OUTPUT_DELAY_LENGTH_MINUS1, "hrd->dpb_output_delay_length_minus1" ) \
+    X( H264_FIELD_HRD_TIME_OFFSET_LENGTH, "hrd->time_offset_length" ) \
+    X( H264_FIELD_SEQ_PARAMETER_SET_ID, "seq_parameter_set_id" ) \
+    X( H264_FIELD_AUX_FORMAT_IDC, "aux_format_idc" ) \
+    X( H264_FIELD_BIT_DEPTH_AUX_MINUS8, "bit_depth_aux_minus8" ) \
+    X( H264_FIELD_ALPHA_INCR_FLAG, "alpha_incr_flag" ) \
+    X( H264_FIELD_ADDITIONAL_EXTENSION_FLAG, "additional_extension_flag" ) \
+    X( H264_FIELD_PPS_PIC_PARAMETER_SET_ID, "pps->pic_parameter_set_id" ) \
+    X( H264_FIELD_PPS_SEQ_PARAMETER_SET_ID, "pps->seq_parameter_set_id" ) \
+    X( H264_FIELD_PPS_ENTROPY_CODING_MODE_FLAG, "pps->entropy_coding_mode_flag" ) \
+    X( H264_FIELD_PPS_PIC_ORDER_PRESENT_FLAG, "pps->pic_order_present_flag" ) \
+    X( H264_FIELD_PPS_NUM_SLICE_GROUPS_MINUS1, "pps->num_slice_groups_minus1" ) \
+    X( H264_FIELD_PPS_SLICE_GROUP_MAP_TYPE, "pps->slice_group_map_type" ) \
+    X( H264_FIELD_PPS_RUN_LENGTH_MINUS1_I_GROUP, "pps->run_length_minus1[ i_group ]" ) \
+    X( H264_FIELD_PPS_TOP_LEFT_I_GROUP, "pps->top_left[ i_group ]" ) \
+    X( H264_FIELD_PPS_BOTTOM_RIGHT_I_GROUP, "pps->bottom_right[ i_group ]" ) \
+    X( H264_FIELD_PPS_SLICE_GROUP_CHANGE_DIRECTION_FLAG, "pps->slice_group_change_direction_flag" ) \
+    X( H264_FIELD_PPS_SLICE_GROUP_CHANGE_RATE_MINUS1, "pps->slice_group_change_rate_minus1" ) \
+    X( H264_FIELD_PPS_PIC_SIZE_IN_MAP_UNITS_MINUS1, "pps->pic_size_in_map_units_minus1" ) \
+    X( H264_FIELD_PPS_SLICE_GROUP_ID_I, "pps->slice_group_id[ i ]" ) \
+    X( H264_FIELD_PPS_NUM_REF_IDX_L0_ACTIVE_MINUS1, "pps->num_ref_idx_l0_active_minus1" ) \
+    X( H264_FIELD_PPS_NUM_REF_IDX_L1_ACTIVE_MINUS1, "pps->num_ref_idx_l1_active_minus1" ) \
+    X( H264_FIELD_PPS_WEIGHTED_PRED_FLAG, "pps->weighted_pred_flag" ) \
+    X( H264_FIELD_PPS_WEIGHTED_BIPRED_IDC, "pps->weighted_bipred_idc" ) \
+    X( H264_FIELD_PPS_PIC_INIT_QP_MINUS26, "pps->pic_init_qp_minus26" ) \
+    X( H264_FIELD_PPS_PIC_INIT_QS_MINUS26, "pps->pic_init_qs_minus26" ) \
+    X( H264_FIELD_PPS_CHROMA_QP_INDEX_OFFSET, "pps->chroma_qp_index_offset" ) \
+    X( H264_FIELD_PPS_DEBLOCKING_FILTER_CONTROL_PRESENT_FLAG, "pps->deblocking_filter_control_present_flag" ) \
+    X( H264_FIELD_PPS_CONSTRAINED_INTRA_PRED_FLAG, "pps->constrained_intra_pred_flag" ) \
+    X( H264_FIELD_PPS_REDUNDANT_PIC_CNT_PRESENT_FLAG, "pps->redundant_pic_cnt_present_flag" ) \
+    X( H264_FIELD_PPS_TRANSFORM_8X8_MODE_FLAG, "pps->transform_8x8_mode_flag" ) \
+    X( H264_FIELD_PPS_PIC_SCALING_MATRIX_PRESENT_FLAG, "pps->pic_scaling_matrix_present_flag" ) \
+    X( H264_FIELD_PPS_PIC_SCALING_LIST_PRESENT_FLAG_I, "pps->pic_scaling_list_present_flag[ i ]" ) \
+    X( H264_FIELD_PPS_SECOND_CHROMA_QP_INDEX_OFFSET, "pps->second_chroma_qp_index_offset" ) \
+    X( H264_FIELD_H_AUD_PRIMARY_PIC_TYPE, "h->aud->primary_pic_type" ) \
+    X( H264_FIELD_FF_BYTE, "ff_byte" ) \
+    X( H264_FIELD_SLICE_ID, "slice_id" ) \
+    X( H264_FIELD_REDUNDANT_PIC_CNT, "redundant_pic_cnt" ) \
+    X( H264_FIELD_CABAC_ZERO_WORD, "cabac_zero_word" ) \
+    X( H264_FIELD_RBSP_STOP_ONE_BIT, "rbsp_stop_one_bit" ) \
+    X( H264_FIELD_RBSP_ALIGNMENT_ZERO_BIT, "rbsp_alignment_zero_bit" ) \
+    X( H264_FIELD_SH_FIRST_MB_IN_SLICE, "sh->first_mb_in_slice" ) \
+    X( H264_FIELD_SH_SLICE_TYPE, "sh->slice_type" ) \
+    X( H264_FIELD_SH_PIC_PARAMETER_SET_ID, "sh->pic_parameter_set_id" ) \
+    X( H264_FIELD_SH_COLOUR_PLANE_ID, "sh->colour_plane_id" ) \
+    X( H264_FIELD_SH_FRAME_NUM, "sh->frame_num" ) \
+    X( H264_FIELD_SH_FIELD_PIC_FLAG, "sh->field_pic_flag" ) \
+    X( H264_FIELD_SH_BOTTOM_FIELD_FLAG, "sh->bottom_field_flag" ) \
+    X( H264_FIELD_SH_IDR_PIC_ID, "sh->idr_pic_id" ) \
+    X( H264_FIELD_SH_PIC_ORDER_CNT_LSB, "sh->pic_order_cnt_lsb" ) \
+    X( H264_FIELD_SH_DELTA_PIC_ORDER_CNT_BOTTOM, "sh->delta_pic_order_cnt_bottom" ) \
+    X( H264_FIELD_SH_DELTA_PIC_ORDER_CNT_0, "sh->delta_pic_order_cnt[ 0 ]" ) \
+    X( H264_FIELD_SH_DELTA_PIC_ORDER_CNT_1, "sh->delta_pic_order_cnt[ 1 ]" ) \
+    X( H264_FIELD_SH_REDUNDANT_PIC_CNT, "sh->redundant_pic_cnt" ) \
+    X( H264_FIELD_SH_DIRECT_SPATIAL_MV_PRED_FLAG, "sh->direct_spatial_mv_pred_flag" ) \
+    X( H264_FIELD_SH_NUM_REF_IDX_ACTIVE_OVERRIDE_FLAG, "sh->num_ref_idx_active_override_flag" ) \
+    X( H264_FIELD_SH_NUM_REF_IDX_L0_ACTIVE_MINUS1, "sh->num_ref_idx_l0_active_minus1" ) \
+    X( H264_FIELD_SH_NUM_REF_IDX_L1_ACTIVE_MINUS1, "sh->num_ref_idx_l1_active_minus1" ) \
+    X( H264_FIELD_SH_CABAC_INIT_IDC, "sh->cabac_init_idc" ) \
+    X( H264_FIELD_SH_SLICE_QP_DELTA, "sh->slice_qp_delta" ) \
+    X( H264_FIELD_SH_SP_FOR_SWITCH_FLAG, "sh->sp_for_switch_flag" ) \
+    X( H264_FIELD_SH_SLICE_QS_DELTA, "sh->slice_qs_delta" ) \
+    X( H264_FIELD_SH_DISABLE_DEBLOCKING_FILTER_IDC, "sh->disable_deblocking_filter_idc" ) \
+    X( H264_FIELD_SH_SLICE_ALPHA_C0_OFFSET_DIV2, "sh->slice_alpha_c0_offset_div2" ) \
+    X( H264_FIELD_SH_SLICE_BETA_OFFSET_DIV2, "sh->slice_beta_offset_div2" ) \
+    X( H264_FIELD_SH_SLICE_GROUP_CHANGE_CYCLE, "sh->slice_group_change_cycle" ) \
+    X( H264_FIELD_SH_RPLR_REF_PIC_LIST_REORDERING_FLAG_L0, "sh->rplr.ref_pic_list_reordering_flag_l0" ) \
+    X( H264_FIELD_SH_RPLR_REORDER_L0_REORDERING_OF_PIC_NUMS_IDC_N, "sh->rplr.reorder_l0.reordering_of_pic_nums_idc[ n ]" ) \
+    X( H264_FIELD_SH_RPLR_REORDER_L0_ABS_DIFF_PIC_NUM_MINUS1_N, "sh->rplr.reorder_l0.abs_diff_pic_num_minus1[ n ]" ) \
+    X( H264_FIELD_SH_RPLR_REORDER_L0_LONG_TERM_PIC_NUM_N, "sh->rplr.reorder_l0.long_term_pic_num[ n ]" ) \
+    X( H264_FIELD_SH_RPLR_REF_PIC_LIST_REORDERING_FLAG_L1, "sh->rplr.ref_pic_list_reordering_flag_l1" ) \
+    X( H264_FIELD_SH_RPLR_REORDER_L1_REORDERING_OF_PIC_NUMS_IDC_N, "sh->rplr.reorder_l1.reordering_of_pic_nums_idc[ n ]" ) \
+    X( H264_FIELD_SH_RPLR_REORDER_L1_ABS_DIFF_PIC_NUM_MINUS1_N, "sh->rplr.reorder_l1.abs_diff_pic_num_minus1[ n ]" ) \
+    X( H264_FIELD_SH_RPLR_REORDER_L1_LONG_TERM_PIC_NUM_N, "sh->rplr.reorder_l1.long_term_pic_num[ n ]" ) \
+    X( H264_FIELD_SH_PWT_LUMA_LOG2_WEIGHT_DENOM, "sh->pwt.luma_log2_weight_denom" ) \
+    X( H264_FIELD_SH_PWT_CHROMA_LOG2_WEIGHT_DENOM, "sh->pwt.chroma_log2_weight_denom" ) \
+    X( H264_FIELD_SH_PWT_LUMA_WEIGHT_L0_FLAG_I, "sh->pwt.luma_weight_l0_flag[i]" ) \
+    X( H264_FIELD_SH_PWT_LUMA_WEIGHT_L0_I, "sh->pwt.luma_weight_l0[ i ]" ) \
+    X( H264_FIELD_SH_PWT_LUMA_OFFSET_L0_I, "sh->pwt.luma_offset_l0[ i ]" ) \
+    X( H264_FIELD_SH_PWT_CHROMA_WEIGHT_L0_FLAG_I, "sh->pwt.chroma_weight_l0_flag[i]" ) \
+    X( H264_FIELD_SH_PWT_CHROMA_WEIGHT_L0_I_J, "sh->pwt.chroma_weight_l0[ i ][ j ]" ) \
+    X( H264_FIELD_SH_PWT_CHROMA_OFFSET_L0_I_J, "sh->pwt.chroma_offset_l0[ i ][ j ]" ) \
+    X( H264_FIELD_SH_PWT_LUMA_WEIGHT_L1_FLAG_I, "sh->pwt.luma_weight_l1_flag[i]" ) \
+    X( H264_FIELD_SH_PWT_LUMA_WEIGHT_L1_I, "sh->pwt.luma_weight_l1[ i ]" ) \
+    X( H264_FIELD_SH_PWT_LUMA_OFFSET_L1_I, "sh->pwt.luma_offset_l1[ i ]" ) \
+    X( H264_FIELD_SH_PWT_CHROMA_WEIGHT_L1_FLAG_I, "sh->pwt.chroma_weight_l1_flag[i]" ) \
+    X( H264_FIELD_SH_PWT_CHROMA_WEIGHT_L1_I_J, "sh->pwt.chroma_weight_l1[ i ][ j ]" ) \
+    X( H264_FIELD_SH_PWT_CHROMA_OFFSET_L1_I_J, "sh->pwt.chroma_offset_l1[ i ][ j ]" ) \
+    X( H264_FIELD_SH_DRPM_NO_OUTPUT_OF_PRIOR_PICS_FLAG, "sh->drpm.no_output_of_prior_pics_flag" ) \
+    X( H264_FIELD_SH_DRPM_LONG_TERM_REFERENCE_FLAG, "sh->drpm.long_term_reference_flag" ) \
+    X( H264_FIELD_SH_DRPM_ADAPTIVE_REF_PIC_MARKING_MODE_FLAG, "sh->drpm.adaptive_ref_pic_marking_mode_flag" ) \
+    X( H264_FIELD_SH_DRPM_MEMORY_MANAGEMENT_CONTROL_OPERATION_N, "sh->drpm.memory_management_control_operation[ n ]" ) \
+    X( H264_FIELD_SH_DRPM_DIFFERENCE_OF_PIC_NUMS_MINUS1_N, "sh->drpm.difference_of_pic_nums_minus1[ n ]" ) \
+    X( H264_FIELD_SH_DRPM_LONG_TERM_PIC_NUM_N, "sh->drpm.long_term_pic_num[ n ]" ) \
+    X( H264_FIELD_SH_DRPM_LONG_TERM_FRAME_IDX_N, "sh->drpm.long_term_frame_idx[ n ]" ) \
+    X( H264_FIELD_SH_DRPM_MAX_LONG_TERM_FRAME_IDX_PLUS1_N, "sh->drpm.max_long_term_frame_idx_plus1[ n ]" ) \
+    X( H264_FIELD_SH_SVC_EXT_BASE_PRED_WEIGHT_TABLE_FLAG, "sh_svc_ext->base_pred_weight_table_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_STORE_REF_BASE_PIC_FLAG, "sh_svc_ext->store_ref_base_pic_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_REF_LAYER_DQ_ID, "sh_svc_ext->ref_layer_dq_id" ) \
+    X( H264_FIELD_SH_SVC_EXT_DISABLE_INTER_LAYER_DEBLOCKING_FILTER_IDC, "sh_svc_ext->disable_inter_layer_deblocking_filter_idc" ) \
+    X( H264_FIELD_SH_SVC_EXT_INTER_LAYER_SLICE_ALPHA_C0_OFFSET_DIV2, "sh_svc_ext->inter_layer_slice_alpha_c0_offset_div2" ) \
+    X( H264_FIELD_SH_SVC_EXT_INTER_LAYER_SLICE_BETA_OFFSET_DIV2, "sh_svc_ext->inter_layer_slice_beta_offset_div2" ) \
+    X( H264_FIELD_SH_SVC_EXT_CONSTRAINED_INTRA_RESAMPLING_FLAG, "sh_svc_ext->constrained_intra_resampling_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_REF_LAYER_CHROMA_PHASE_X_PLUS1_FLAG, "sh_svc_ext->ref_layer_chroma_phase_x_plus1_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_REF_LAYER_CHROMA_PHASE_Y_PLUS1, "sh_svc_ext->ref_layer_chroma_phase_y_plus1" ) \
+    X( H264_FIELD_SH_SVC_EXT_SCALED_REF_LAYER_LEFT_OFFSET, "sh_svc_ext->scaled_ref_layer_left_offset" ) \
+    X( H264_FIELD_SH_SVC_EXT_SCALED_REF_LAYER_TOP_OFFSET, "sh_svc_ext->scaled_ref_layer_top_offset" ) \
+    X( H264_FIELD_SH_SVC_EXT_SCALED_REF_LAYER_RIGHT_OFFSET, "sh_svc_ext->scaled_ref_layer_right_offset" ) \
+    X( H264_FIELD_SH_SVC_EXT_SCALED_REF_LAYER_BOTTOM_OFFSET, "sh_svc_ext->scaled_ref_layer_bottom_offset" ) \
+    X( H264_FIELD_SH_SVC_EXT_SLICE_SKIP_FLAG, "sh_svc_ext->slice_skip_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_NUM_MBS_IN_SLICE_MINUS1, "sh_svc_ext->num_mbs_in_slice_minus1" ) \
+    X( H264_FIELD_SH_SVC_EXT_ADAPTIVE_BASE_MODE_FLAG, "sh_svc_ext->adaptive_base_mode_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_DEFAULT_BASE_MODE_FLAG, "sh_svc_ext->default_base_mode_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_ADAPTIVE_MOTION_PREDICTION_FLAG, "sh_svc_ext->adaptive_motion_prediction_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_DEFAULT_MOTION_PREDICTION_FLAG, "sh_svc_ext->default_motion_prediction_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_ADAPTIVE_RESIDUAL_PREDICTION_FLAG, "sh_svc_ext->adaptive_residual_prediction_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_DEFAULT_RESIDUAL_PREDICTION_FLAG, "sh_svc_ext->default_residual_prediction_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_TCOEFF_LEVEL_PREDICTION_FLAG, "sh_svc_ext->tcoeff_level_prediction_flag" ) \
+    X( H264_FIELD_SH_SVC_EXT_SCAN_IDX_START, "sh_svc_ext->scan_idx_start" ) \
+    X( H264_FIELD_SH_SVC_EXT_SCAN_IDX_END, "sh_svc_ext->scan_idx_end" ) \
+    X( H264_FIELD_NAL_PREFIX_NAL_SVC_ADAPTIVE_REF_BASE_PIC_MARKING_MODE_FLAG, "nal->prefix_nal_svc->adaptive_ref_base_pic_marking_mode_flag" ) \
+    X( H264_FIELD_NAL_PREFIX_NAL_SVC_MEMORY_MANAGEMENT_BASE_CONTROL_OPERATION, "nal->prefix_nal_svc->memory_management_base_control_operation" ) \
+    X( H264_FIELD_NAL_PREFIX_NAL_SVC_DIFFERENCE_OF_BASE_PIC_NUMS_MINUS1, "nal->prefix_nal_svc->difference_of_base_pic_nums_minus1" ) \
+    X( H264_FIELD_NAL_PREFIX_NAL_SVC_LONG_TERM_BASE_PIC_NUM, "nal->prefix_nal_svc->long_term_base_pic_num" ) \
+    X( H264_FIELD_SEI_SVC_TEMPORAL_ID_NESTING_FLAG, "sei_svc->temporal_id_nesting_flag" ) \
+    X( H264_FIELD_SEI_SVC_PRIORITY_LAYER_INFO_PRESENT_FLAG, "sei_svc->priority_layer_info_present_flag" ) \
+    X( H264_FIELD_SEI_SVC_PRIORITY_ID_SETTING_FLAG, "sei_svc->priority_id_setting_flag" ) \
+    X( H264_FIELD_SEI_SVC_NUM_LAYERS_MINUS1, "sei_svc->num_layers_minus1" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_LAYER_ID, "sei_svc->layers[i].layer_id" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_PRIORITY_ID, "sei_svc->layers[i].priority_id" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_DISCARDABLE_FLAG, "sei_svc->layers[i].discardable_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_DEPENDENCY_ID, "sei_svc->layers[i].dependency_id" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_QUALITY_ID, "sei_svc->layers[i].quality_id" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_TEMPORAL_ID, "sei_svc->layers[i].temporal_id" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_SUB_PIC_LAYER_FLAG, "sei_svc->layers[i].sub_pic_layer_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_SUB_REGION_LAYER_FLAG, "sei_svc->layers[i].sub_region_layer_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_IROI_DIVISION_INFO_PRESENT_FLAG, "sei_svc->layers[i].iroi_division_info_present_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_PROFILE_LEVEL_INFO_PRESENT_FLAG, "sei_svc->layers[i].profile_level_info_present_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_BITRATE_INFO_PRESENT_FLAG, "sei_svc->layers[i].bitrate_info_present_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_FRM_RATE_INFO_PRESENT_FLAG, "sei_svc->layers[i].frm_rate_info_present_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_FRM_SIZE_INFO_PRESENT_FLAG, "sei_svc->layers[i].frm_size_info_present_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_LAYER_DEPENDENCY_INFO_PRESENT_FLAG, "sei_svc->layers[i].layer_dependency_info_present_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_PARAMETER_SETS_INFO_PRESENT_FLAG, "sei_svc->layers[i].parameter_sets_info_present_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_BITSTREAM_RESTRICTION_INFO_PRESENT_FLAG, "sei_svc->layers[i].bitstream_restriction_info_present_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_EXACT_INTER_LAYER_PRED_FLAG, "sei_svc->layers[i].exact_inter_layer_pred_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_EXACT_SAMPLE_VALUE_MATCH_FLAG, "sei_svc->layers[i].exact_sample_value_match_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_LAYER_CONVERSION_FLAG, "sei_svc->layers[i].layer_conversion_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_LAYER_OUTPUT_FLAG, "sei_svc->layers[i].layer_output_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_LAYER_PROFILE_LEVEL_IDC, "sei_svc->layers[i].layer_profile_level_idc" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_AVG_BITRATE, "sei_svc->layers[i].avg_bitrate" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_MAX_BITRATE_LAYER, "sei_svc->layers[i].max_bitrate_layer" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_MAX_BITRATE_LAYER_REPRESENTATION, "sei_svc->layers[i].max_bitrate_layer_representation" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_MAX_BITRATE_CALC_WINDOW, "sei_svc->layers[i].max_bitrate_calc_window" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_CONSTANT_FRM_RATE_IDC, "sei_svc->layers[i].constant_frm_rate_idc" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_AVG_FRM_RATE, "sei_svc->layers[i].avg_frm_rate" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_FRM_WIDTH_IN_MBS_MINUS1, "sei_svc->layers[i].frm_width_in_mbs_minus1" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_FRM_HEIGHT_IN_MBS_MINUS1, "sei_svc->layers[i].frm_height_in_mbs_minus1" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_BASE_REGION_LAYER_ID, "sei_svc->layers[i].base_region_layer_id" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_DYNAMIC_RECT_FLAG, "sei_svc->layers[i].dynamic_rect_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_HORIZONTAL_OFFSET, "sei_svc->layers[i].horizontal_offset" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_VERTICAL_OFFSET, "sei_svc->layers[i].vertical_offset" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_REGION_WIDTH, "sei_svc->layers[i].region_width" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_REGION_HEIGHT, "sei_svc->layers[i].region_height" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_ROI_ID, "sei_svc->layers[i].roi_id" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_IROI_GRID_FLAG, "sei_svc->layers[i].iroi_grid_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_GRID_WIDTH_IN_MBS_MINUS1, "sei_svc->layers[i].grid_width_in_mbs_minus1" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_GRID_HEIGHT_IN_MBS_MINUS1, "sei_svc->layers[i].grid_height_in_mbs_minus1" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_NUM_ROIS_MINUS1, "sei_svc->layers[i].num_rois_minus1" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_ROI_J_FIRST_MB_IN_ROI, "sei_svc->layers[i].roi[j].first_mb_in_roi" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_ROI_J_ROI_WIDTH_IN_MBS_MINUS1, "sei_svc->layers[i].roi[j].roi_width_in_mbs_minus1" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_ROI_J_ROI_HEIGHT_IN_MBS_MINUS1, "sei_svc->layers[i].roi[j].roi_height_in_mbs_minus1" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_NUM_DIRECTLY_DEPENDENT_LAYERS, "sei_svc->layers[i].num_directly_dependent_layers" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_DIRECTLY_DEPENDENT_LAYER_ID_DELTA_MINUS1_J, "sei_svc->layers[i].directly_dependent_layer_id_delta_minus1[j]" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_LAYER_DEPENDENCY_INFO_SRC_LAYER_ID_DELTA, "sei_svc->layers[i].layer_dependency_info_src_layer_id_delta" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_NUM_SEQ_PARAMETER_SETS, "sei_svc->layers[i].num_seq_parameter_sets" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_SEQ_PARAMETER_SET_ID_DELTA_J, "sei_svc->layers[i].seq_parameter_set_id_delta[j]" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_NUM_SUBSET_SEQ_PARAMETER_SETS, "sei_svc->layers[i].num_subset_seq_parameter_sets" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_SUBSET_SEQ_PARAMETER_SET_ID_DELTA_J, "sei_svc->layers[i].subset_seq_parameter_set_id_delta[j]" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_NUM_PIC_PARAMETER_SETS_MINUS1, "sei_svc->layers[i].num_pic_parameter_sets_minus1" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_PIC_PARAMETER_SET_ID_DELTA_J, "sei_svc->layers[i].pic_parameter_set_id_delta[j]" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_PARAMETER_SETS_INFO_SRC_LAYER_ID_DELTA, "sei_svc->layers[i].parameter_sets_info_src_layer_id_delta" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_MOTION_VECTORS_OVER_PIC_BOUNDARIES_FLAG, "sei_svc->layers[i].motion_vectors_over_pic_boundaries_flag" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_MAX_BYTES_PER_PIC_DENOM, "sei_svc->layers[i].max_bytes_per_pic_denom" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_MAX_BITS_PER_MB_DENOM, "sei_svc->layers[i].max_bits_per_mb_denom" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_LOG2_MAX_MV_LENGTH_HORIZONTAL, "sei_svc->layers[i].log2_max_mv_length_horizontal" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_LOG2_MAX_MV_LENGTH_VERTICAL, "sei_svc->layers[i].log2_max_mv_length_vertical" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_MAX_NUM_REORDER_FRAMES, "sei_svc->layers[i].max_num_reorder_frames" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_MAX_DEC_FRAME_BUFFERING, "sei_svc->layers[i].max_dec_frame_buffering" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_CONVERSION_TYPE_IDC, "sei_svc->layers[i].conversion_type_idc" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_REWRITING_INFO_FLAG_J, "sei_svc->layers[i].rewriting_info_flag[j]" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_REWRITING_PROFILE_LEVEL_IDC_J, "sei_svc->layers[i].rewriting_profile_level_idc[j]" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_REWRITING_AVG_BITRATE_J, "sei_svc->layers[i].rewriting_avg_bitrate[j]" ) \
+    X( H264_FIELD_SEI_SVC_LAYERS_I_REWRITING_MAX_BITRATE_J, "sei_svc->layers[i].rewriting_max_bitrate[j]" ) \
+    X( H264_FIELD_SEI_SVC_PR_NUM_DIDS_MINUS1, "sei_svc->pr_num_dIds_minus1" ) \
+    X( H264_FIELD_SEI_SVC_PR_I_PR_DEPENDENCY_ID, "sei_svc->pr[i].pr_dependency_id" ) \
+    X( H264_FIELD_SEI_SVC_PR_I_PR_NUM_MINUS1, "sei_svc->pr[i].pr_num_minus1" ) \
+    X( H264_FIELD_SEI_SVC_PR_I_PR_INFO_J_PR_ID, "sei_svc->pr[i].pr_info[j].pr_id" ) \
+    X( H264_FIELD_SEI_SVC_PR_I_PR_INFO_J_PR_PROFILE_LEVEL_IDC, "sei_svc->pr[i].pr_info[j].pr_profile_level_idc" ) \
+    X( H264_FIELD_SEI_SVC_PR_I_PR_INFO_J_PR_AVG_BITRATE, "sei_svc->pr[i].pr_info[j].pr_avg_bitrate" ) \
+    X( H264_FIELD_SEI_SVC_PR_I_PR_INFO_J_PR_MAX_BITRATE, "sei_svc->pr[i].pr_info[j].pr_max_bitrate" ) \
+    X( H264_FIELD_BP_SEQ_PARAMETER_SET_ID, "bp->seq_parameter_set_id" ) \
+    X( H264_FIELD_BP_NAL_SCHEDSELIDX_INITIAL_CPB_REMOVAL_DELAY, "bp->nal[SchedSelIdx].initial_cpb_removal_delay" ) \
+    X( H264_FIELD_BP_NAL_SCHEDSELIDX_INITIAL_CPB_REMOVAL_DELAY_OFFSET, "bp->nal[SchedSelIdx].initial_cpb_removal_delay_offset" ) \
+    X( H264_FIELD_BP_VCL_SCHEDSELIDX_INITIAL_CPB_REMOVAL_DELAY, "bp->vcl[SchedSelIdx].initial_cpb_removal_delay" ) \
+    X( H264_FIELD_BP_VCL_SCHEDSELIDX_INITIAL_CPB_REMOVAL_DELAY_OFFSET, "bp->vcl[SchedSelIdx].initial_cpb_removal_delay_offset" ) \
+    X( H264_FIELD_PT_CPB_REMOVAL_DELAY, "pt->cpb_removal_delay" ) \
+    X( H264_FIELD_PT_DPB_OUTPUT_DELAY, "pt->dpb_output_delay" ) \
+    X( H264_FIELD_PT_PIC_STRUCT, "pt->pic_struct" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_CLOCK_TIMESTAMP_FLAG, "pt->clock_timestamps[i].clock_timestamp_flag" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_CT_TYPE, "pt->clock_timestamps[i].ct_type" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_NUIT_FIELD_BASED_FLAG, "pt->clock_timestamps[i].nuit_field_based_flag" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_COUNTING_TYPE, "pt->clock_timestamps[i].counting_type" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_FULL_TIMESTAMP_FLAG, "pt->clock_timestamps[i].full_timestamp_flag" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_DISCONTINUITY_FLAG, "pt->clock_timestamps[i].discontinuity_flag" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_CNT_DROPPED_FLAG, "pt->clock_timestamps[i].cnt_dropped_flag" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_N_FRAMES, "pt->clock_timestamps[i].n_frames" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_SECONDS_VALUE, "pt->clock_timestamps[i].seconds_value" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_MINUTES_VALUE, "pt->clock_timestamps[i].minutes_value" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_HOURS_VALUE, "pt->clock_timestamps[i].hours_value" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_SECONDS_FLAG, "pt->clock_timestamps[i].seconds_flag" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_MINUTES_FLAG, "pt->clock_timestamps[i].minutes_flag" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_HOURS_FLAG, "pt->clock_timestamps[i].hours_flag" ) \
+    X( H264_FIELD_PT_CLOCK_TIMESTAMPS_I_TIME_OFFSET, "pt->clock_timestamps[i].time_offset" ) \
+    X( H264_FIELD_RP_RECOVERY_FRAME_CNT, "rp->recovery_frame_cnt" ) \
+    X( H264_FIELD_RP_EXACT_MATCH_FLAG, "rp->exact_match_flag" ) \
+    X( H264_FIELD_RP_BROKEN_LINK_FLAG, "rp->broken_link_flag" ) \
+    X( H264_FIELD_RP_CHANGING_SLICE_GROUP_IDC, "rp->changing_slice_group_idc" ) \
+    X( H264_FIELD_S_DATA_I, "s->data[i]" ) \
+    X( H264_FIELD_CABAC_ALIGNMENT_ONE_BIT, "cabac_alignment_one_bit" ) \
+    X( H264_FIELD_MB_SKIP_RUN, "mb_skip_run" ) \
+    X( H264_FIELD_MB_SKIP_FLAG, "mb_skip_flag" ) \
+    X( H264_FIELD_MB_MB_FIELD_DECODING_FLAG, "mb->mb_field_decoding_flag" ) \
+    X( H264_FIELD_END_OF_SLICE_FLAG, "end_of_slice_flag" ) \
+    X( H264_FIELD_MB_MB_TYPE, "mb->mb_type" ) \
+    X( H264_FIELD_PCM_ALIGNMENT_ZERO_BIT, "pcm_alignment_zero_bit" ) \
+    X( H264_FIELD_MB_PCM_SAMPLE_LUMA_I, "mb->pcm_sample_luma[ i ]" ) \
+    X( H264_FIELD_MB_PCM_SAMPLE_CHROMA_I, "mb->pcm_sample_chroma[ i ]" ) \
+    X( H264_FIELD_MB_TRANSFORM_SIZE_8X8_FLAG, "mb->transform_size_8x8_flag" ) \
+    X( H264_FIELD_MB_CODED_BLOCK_PATTERN, "mb->coded_block_pattern" ) \
+    X( H264_FIELD_MB_MB_QP_DELTA, "mb->mb_qp_delta" ) \
+    X( H264_FIELD_MB_PREV_INTRA4X4_PRED_MODE_FLAG_LUMA4X4BLKIDX, "mb->prev_intra4x4_pred_mode_flag[ luma4x4BlkIdx ]" ) \
+    X( H264_FIELD_MB_REM_INTRA4X4_PRED_MODE_LUMA4X4BLKIDX, "mb->rem_intra4x4_pred_mode[ luma4x4BlkIdx ]" ) \
+    X( H264_FIELD_MB_PREV_INTRA8X8_PRED_MODE_FLAG_LUMA8X8BLKIDX, "mb->prev_intra8x8_pred_mode_flag[ luma8x8BlkIdx ]" ) \
+    X( H264_FIELD_MB_REM_INTRA8X8_PRED_MODE_LUMA8X8BLKIDX, "mb->rem_intra8x8_pred_mode[ luma8x8BlkIdx ]" ) \
+    X( H264_FIELD_MB_INTRA_CHROMA_PRED_MODE, "mb->intra_chroma_pred_mode" ) \
+    X( H264_FIELD_MB_REF_IDX_L0_MBPARTIDX, "mb->ref_idx_l0[ mbPartIdx ]" ) \
+    X( H264_FIELD_MB_REF_IDX_L1_MBPARTIDX, "mb->ref_idx_l1[ mbPartIdx ]" ) \
+    X( H264_FIELD_MB_MVD_L0_MBPARTIDX_0_COMPIDX, "mb->mvd_l0[ mbPartIdx ][ 0 ][ compIdx ]" ) \
+    X( H264_FIELD_MB_MVD_L1_MBPARTIDX_0_COMPIDX, "mb->mvd_l1[ mbPartIdx ][ 0 ][ compIdx ]" ) \
+    X( H264_FIELD_MB_SUB_MB_TYPE_MBPARTIDX, "mb->sub_mb_type[ mbPartIdx ]" ) \
+    X( H264_FIELD_MB_MVD_L0_MBPARTIDX_SUBMBPARTIDX_COMPIDX, "mb->mvd_l0[ mbPartIdx ][ subMbPartIdx ][ compIdx ]" ) \
+    X( H264_FIELD_MB_MVD_L1_MBPARTIDX_SUBMBPARTIDX_COMPIDX, "mb->mvd_l1[ mbPartIdx ][ subMbPartIdx ][ compIdx ]" ) \
+    X( H264_FIELD_COEFF_TOKEN, "coeff_token" ) \
+    X( H264_FIELD_TRAILING_ONES_SIGN_FLAG, "trailing_ones_sign_flag" ) \
+    X( H264_FIELD_LEVEL_PREFIX, "level_prefix" ) \
+    X( H264_FIELD_LEVEL_SUFFIX, "level_suffix" ) \
+    X( H264_FIELD_TOTAL_ZEROS, "total_zeros" ) \
+    X( H264_FIELD_RUN_BEFORE, "run_before" ) \
+    X( H264_FIELD_CODED_BLOCK_FLAG, "coded_block_flag" ) \
+    X( H264_FIELD_SIGNIFICANT_COEFF_FLAG_I, "significant_coeff_flag[ i ]" ) \
+    X( H264_FIELD_LAST_SIGNIFICANT_COEFF_FLAG_I, "last_significant_coeff_flag[ i ]" ) \
+    X( H264_FIELD_COEFF_ABS_LEVEL_MINUS1_NUMCOEFF_1, "coeff_abs_level_minus1[ numCoeff - 1 ]" ) \
+    X( H264_FIELD_COEFF_SIGN_FLAG_NUMCOEFF_1, "coeff_sign_flag[ numCoeff - 1 ]" ) \
+    X( H264_FIELD_COEFF_ABS_LEVEL_MINUS1_I, "coeff_abs_level_minus1[ i ]" ) \
+    X( H264_FIELD_COEFF_SIGN_FLAG_I, "coeff_sign_flag[ i ]" ) \
+
+#define H264_FIELD_ENUM(id, name) id,
+enum { H264_FIELDS(H264_FIELD_ENUM) H264_FIELD_COUNT };
+#undef H264_FIELD_ENUM
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "h264_stream.h"
+#include "h264_filter.h"
+
+/**
+ Read the SVC extension of a NAL unit header, without parsing the rest of the NAL.
+ @param[in]  nal          the NAL, starting with its header byte
+ @param[in]  size         size of the NAL
+ @param[out] nal_svc_ext  the fields of nal_unit_header_svc_extension(), if there is one
+ @return     1 for a prefix NAL or a slice in scalable extension with an SVC extension header, otherwise 0
+ */
+int h264_peek_nal_svc_ext(const uint8_t* nal, int size, nal_svc_ext_t* nal_svc_ext)
+{
+    if ( size < 4 ) { return 0; }
+    int nal_unit_type = nal[0] & 0x1F;
+    if ( nal_unit_type != NAL_UNIT_TYPE_PREFIX_NAL && nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION ) { return 0; }
+    if ( !(nal[1] & 0x80) ) { return 0; } // svc_extension_flag, otherwise an MVC extension
+
+    nal_svc_ext->idr_flag = (nal[1] >> 6) & 0x01;
+    nal_svc_ext->priority_id = nal[1] & 0x3F;
+    nal_svc_ext->no_inter_layer_pred_flag = nal[2] >> 7;
+    nal_svc_ext->dependency_id = (nal[2] >> 4) & 0x07;
+    nal_svc_ext->quality_id = nal[2] & 0x0F;
+    nal_svc_ext->temporal_id = nal[3] >> 5;
+    nal_svc_ext->use_ref_base_pic_flag = (nal[3] >> 4) & 0x01;
+    nal_svc_ext->discardable_flag = (nal[3] >> 3) & 0x01;
+    nal_svc_ext->output_flag = (nal[3] >> 2) & 0x01;
+    nal_svc_ext->reserved_three_2bits = nal[3] & 0x03;
+    return 1;
+}
+
+/**
+ Create a NAL unit filter.
+ @param[in]  flags            H264_FILTER_DROP_NON_REF, or 0
+ @param[in]  max_temporal_id  highest temporal layer to keep, 7 for all
+ */
+h264_nal_filter_t* h264_nal_filter_new(int flags, int max_temporal_id)
+{
+    h264_nal_filter_t* f = (h264_nal_filter_t*)calloc(1, sizeof(h264_nal_filter_t));
+    f->flags = flags;
+    f->max_temporal_id = max_temporal_id;
+    f->prefix = -1;
+    return f;
+}
+
+void h264_nal_filter_free(h264_nal_filter_t* f)
+{
+    if ( f == NULL ) { return; }
+    free(f->nals);
+    free(f);
+}
+
+/**
+ Decide whether to keep a NAL unit, from its header byte and the SVC or MVC extension of the header where there is one;
+ slice headers are not parsed.  A base layer slice of an SVC stream is decided on by the prefix NAL before it, so NALs have
+ to be passed in stream order.  Parameter sets, SEI and all other NALs which are not part of a picture are kept.
+ @param[in]  f     the filter
+ @param[in]  nal   the NAL, starting with its header byte
+ @param[in]  size  size of the NAL
+ @return     1 to keep the NAL, 0 to drop it
+ */
+int h264_nal_filter_keep(h264_nal_filter_t* f, const uint8_t* nal, int size)
+{
+    if ( size < 1 ) { return 1; }
+    int nal_ref_idc = (nal[0] >> 5) & 0x03;
+    int nal_unit_type = nal[0] & 0x1F;
+    int keep = 1;
+    nal_svc_ext_t nal_svc_ext;
+
+    switch ( nal_unit_type )
+    {
+        case NAL_UNIT_TYPE_CODED_SLICE_NON_IDR:
+        case NAL_UNIT_TYPE_CODED_SLICE_IDR:
+        case NAL_UNIT_TYPE_CODED_SLICE_DATA_PARTITION_A:
+        case NAL_UNIT_TYPE_CODED_SLICE_DATA_PARTITION_B:
+        case NAL_UNIT_TYPE_CODED_SLICE_DATA_PARTITION_C:
+            if ( f->prefix >= 0 )
+            {
+                keep = f->prefix;
+                f->prefix = -1;
+            }
+            else if ( (f->flags & H264_FILTER_DROP_NON_REF) && nal_ref_idc == 0 )
+            {
+                keep = 0;
+            }
+            break;
+
+        case NAL_UNIT_TYPE_PREFIX_NAL:
+        case NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION:
+            if ( h264_peek_nal_svc_ext(nal, size, &nal_svc_ext) )
+            {
+                // inter-layer prediction may refer to a non-reference picture, unless it is discardable
+                if ( nal_svc_ext.temporal_id > f->max_temporal_id ) { keep = 0; }
+                if ( (f->flags & H264_FILTER_DROP_NON_REF) && nal_ref_idc == 0 && nal_svc_ext.discardable_flag ) { keep = 0; }
+            }
+            else if ( size >= 4 )
+            {
+                // nal_unit_header_mvc_extension(): temporal_id follows non_idr_flag, priority_id and view_id, then anchor_pic_flag
+                // and inter_view_flag; other views may predict from a non-reference picture with inter_view_flag
+                if ( ((nal[3] >> 3) & 0x07) > f->max_temporal_id ) { keep = 0; }
+                if ( (f->flags & H264_FILTER_DROP_NON_REF) && nal_ref_idc == 0 && !((nal[3] >> 1) & 0x01) ) { keep = 0; }
+            }
+            if ( nal_unit_type == NAL_UNIT_TYPE_PREFIX_NAL ) { f->prefix = keep; }
+            break;
+
+        default:
+            break;
+    }
+
+    if ( keep ) { f->kept++; } else { f->dropped++; }
+    return keep;
+}
+
+/**
+ Filter an array of NAL units, in stream order.
+ The NALs kept are in f->nals[0 .. f->num_nals - 1], which refer to the input; nothing is copied.
+ @return     the number of NALs kept
+ */
+int h264_nal_filter(h264_nal_filter_t* f, const h264_nal_span_t* nals, int num_nals)
+{
+    if ( f->nals_capacity < num_nals )
+    {
+        f->nals_capacity = num_nals;
+        f->nals = (h264_nal_span_t*)realloc(f->nals, num_nals * sizeof(h264_nal_span_t));
+    }
+    f->num_nals = 0;
+    for ( int i = 0; i < num_nals; i++ )
+    {
+        if ( h264_nal_filter_keep(f, nals[i].buf, nals[i].size) ) { f->nals[f->num_nals++] = nals[i]; }
+    }
+    return f->num_nals;
+}
@@ -0,0 +1,62 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _H264_FILTER_H
+#define _H264_FILTER_H        1
+
+#include <stdint.h>
+
+#include "h264_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int h264_peek_nal_svc_ext(const uint8_t* nal, int size, nal_svc_ext_t* nal_svc_ext);
+
+// flags for h264_nal_filter_new
+#define H264_FILTER_DROP_NON_REF   1  // drop non-reference pictures: nal_ref_idc 0, and in SVC streams also discardable_flag 1, in MVC streams inter_view_flag 0
+
+/**
+   Filter deciding for each NAL unit from its header whether to keep it, e.g. for trick play or a lower frame rate
+   @see h264_nal_filter
+*/
+typedef struct
+{
+    int flags;
+    int max_temporal_id;          // NALs of higher temporal layers are dropped; 7 keeps them all
+    int prefix;                   // whether to keep the base layer slice after the last prefix NAL: 1, 0, or -1 if there is none
+
+    int kept;
+    int dropped;
+
+    h264_nal_span_t* nals;        // output of the last h264_nal_filter
+    int num_nals;
+    int nals_capacity;
+} h264_nal_filter_t;
+
+h264_nal_filter_t* h264_nal_filter_new(int flags, int max_temporal_id);
+void h264_nal_filter_free(h264_nal_filter_t* f);
+int h264_nal_filter_keep(h264_nal_filter_t* f, const uint8_t* nal, int size);
+int h264_nal_filter(h264_nal_filter_t* f, const h264_nal_span_t* nals, int num_nals);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,469 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bs.h"
+#include "h264_stream.h"
+#include "h264_avcc.h"
+#include "h264_mp4.h"
+
+// ISO/IEC 14496-12 boxes; the size of a box is filled in when it ends
+static uint8_t* box_start(bs_t* b, const char* type)
+{
+    uint8_t* start = b->p;
+    bs_write_u(b, 32, 0);
+    for ( int i = 0; i < 4; i++ ) { bs_write_u8(b, type[i]); }
+    return start;
+}
+
+static uint8_t* full_box_start(bs_t* b, const char* type, int version, uint32_t flags)
+{
+    uint8_t* start = box_start(b, type);
+    bs_write_u8(b, version);
+    bs_write_u(b, 24, flags);
+    return start;
+}
+
+static void box_end(bs_t* b, uint8_t* start)
+{
+    if ( b->p > b->end ) { return; } // did not fit, reported by bs_overrun
+    uint32_t size = b->p - start;
+    start[0] = size >> 24;
+    start[1] = size >> 16;
+    start[2] = size >> 8;
+    start[3] = size;
+}
+
+static void write_u64(bs_t* b, uint64_t v)
+{
+    bs_write_u(b, 32, (uint32_t)(v >> 32));
+    bs_write_u(b, 32, (uint32_t)v);
+}
+
+static void write_zeros(bs_t* b, int n)
+{
+    for ( int i = 0; i < n; i++ ) { bs_write_u8(b, 0); }
+}
+
+static void write_matrix(bs_t* b)
+{
+    static const uint32_t unity[9] = { 0x00010000, 0, 0, 0, 0x00010000, 0, 0, 0, 0x40000000 };
+    for ( int i = 0; i < 9; i++ ) { bs_write_u(b, 32, unity[i]); }
+}
+
+h264_mp4_t* h264_mp4_new(uint32_t timescale, uint32_t sample_duration)
+{
+    h264_mp4_t* m = (h264_mp4_t*)calloc(1, sizeof(h264_mp4_t));
+    m->track_id = 1;
+    m->timescale = timescale;
+    m->sample_duration = sample_duration;
+    m->sequence_number = 1;
+    return m;
+}
+
+void h264_mp4_free(h264_mp4_t* m)
+{
+    free(m);
+}
+
+// 7.4.2.1.1 frame cropping, in luma samples
+static void picture_size(const sps_t* sps, int* width, int* height)
+{
+    int crop_unit_x = 1;
+    int crop_unit_y = 2 - sps->frame_mbs_only_flag;
+    if ( sps->chroma_format_idc == 1 ) { crop_unit_x = 2; crop_unit_y *= 2; }
+    else if ( sps->chroma_format_idc == 2 ) { crop_unit_x = 2; }
+
+    *width = ( sps->pic_width_in_mbs_minus1 + 1 ) * 16;
+    *height = ( 2 - sps->frame_mbs_only_flag ) * ( sps->pic_height_in_map_units_minus1 + 1 ) * 16;
+    if ( sps->frame_cropping_flag )
+    {
+        *width -= crop_unit_x * ( sps->frame_crop_left_offset + sps->frame_crop_right_offset );
+        *height -= crop_unit_y * ( sps->frame_crop_top_offset + sps->frame_crop_bottom_offset );
+    }
+}
+
+/**
+ Write the init segment: ftyp and moov with one avc1 track described by the avcC record.
+ @param[in]  m     the writer
+ @param[in]  avcc  the decoder configuration; the picture size is taken from its first SPS
+ @param[in]  h     stream used to encode parameter sets which the record only has parsed (see write_avcc)
+ @param[out] buf   the buffer
+ @param[in]  size  the size of the buffer
+ @return     bytes written, or -1 if the buffer was too small
+ */
+int h264_mp4_write_init(h264_mp4_t* m, avcc_t* avcc, h264_stream_t* h, uint8_t* buf, int size)
+{
+    int width = 0;
+    int height = 0;
+    if ( avcc->numOfSequenceParameterSets > 0 && avcc->sps_table[0].sps != NULL ) { picture_size(&avcc->sps_table[0].sps->sps, &width, &height); }
+
+    bs_t bs;
+    bs_t* b = &bs;
+    bs_init(b, buf, size);
+
+    uint8_t* ftyp = box_start(b, "ftyp");
+    bs_write_u(b, 32, 0x69736f36); // major_brand 'iso6'
+    bs_write_u(b, 32, 0);          // minor_version
+    bs_write_u(b, 32, 0x69736f36); // 'iso6'
+    bs_write_u(b, 32, 0x636d6663); // 'cmfc'
+    bs_write_u(b, 32, 0x61766331); // 'avc1'
+    box_end(b, ftyp);
+
+    uint8_t* moov = box_start(b, "moov");
+
+    uint8_t* mvhd = full_box_start(b, "mvhd", 0, 0);
+    bs_write_u(b, 32, 0);          // creation_time
+    bs_write_u(b, 32, 0);          // modification_time
+    bs_write_u(b, 32, m->timescale);
+    bs_write_u(b, 32, 0);          // duration, unknown for fragments
+    bs_write_u(b, 32, 0x00010000); // rate 1.0
+    bs_write_u(b, 16, 0x0100);     // volume 1.0
+    write_zeros(b, 10);            // reserved
+    write_matrix(b);
+    write_zeros(b, 24);            // pre_defined
+    bs_write_u(b, 32, m->track_id + 1); // next_track_ID
+    box_end(b, mvhd);
+
+    uint8_t* trak = box_start(b, "trak");
+    uint8_t* tkhd = full_box_start(b, "tkhd", 0, 0x000003); // track_enabled | track_in_movie
+    bs_write_u(b, 32, 0);          // creation_time
+    bs_write_u(b, 32, 0);          // modification_time
+    bs_write_u(b, 32, m->track_id);
+    bs_write_u(b, 32, 0);          // reserved
+    bs_write_u(b, 32, 0);          // duration
+    write_zeros(b, 8);             // reserved
+    bs_write_u(b, 16, 0);          // layer
+    bs_write_u(b, 16, 0);          // alternate_group
+    bs_write_u(b, 16, 0);          // volume
+    bs_write_u(b, 16, 0);          // reserved
+    write_matrix(b);
+    bs_write_u(b, 32, width << 16);
+    bs_write_u(b, 32, height << 16);
+    box_end(b, tkhd);
+
+    uint8_t* mdia = box_start(b, "mdia");
+    uint8_t* mdhd = full_box_start(b, "mdhd", 0, 0);
+    bs_write_u(b, 32, 0);          // creation_time
+    bs_write_u(b, 32, 0);          // modification_time
+    bs_write_u(b, 32, m->timescale);
+    bs_write_u(b, 32, 0);          // duration
+    bs_write_u(b, 16, 0x55c4);     // language 'und'
+    bs_write_u(b, 16, 0);          // pre_defined
+    box_end(b, mdhd);
+
+    uint8_t* hdlr = full_box_start(b, "hdlr", 0, 0);
+    bs_write_u(b, 32, 0);          // pre_defined
+    bs_write_u(b, 32, 0x76696465); // handler_type 'vide'
+    write_zeros(b, 12);            // reserved
+    bs_write_bytes(b, (uint8_t*)"VideoHandler", 13);
+    box_end(b, hdlr);
+
+    uint8_t* minf = box_start(b, "minf");
+    uint8_t* vmhd = full_box_start(b, "vmhd", 0, 1);
+    write_zeros(b, 8);             // graphicsmode, opcolor
+    box_end(b, vmhd);
+
+    uint8_t* dinf = box_start(b, "dinf");
+    uint8_t* dref = full_box_start(b, "dref", 0, 0);
+    bs_write_u(b, 32, 1);          // entry_count
+    uint8_t* url = full_box_start(b, "url ", 0, 1); // media is in this file
+    box_end(b, url);
+    box_end(b, dref);
+    box_end(b, dinf);
+
+    uint8_t* stbl = box_start(b, "stbl");
+    uint8_t* stsd = full_box_start(b, "stsd", 0, 0);
+    bs_write_u(b, 32, 1);          // entry_count
+    uint8_t* avc1 = box_start(b, "avc1");
+    write_zeros(b, 6);             // reserved
+    bs_write_u(b, 16, 1);          // data_reference_index
+    write_zeros(b, 16);            // pre_defined, reserved
+    bs_write_u(b, 16, width);
+    bs_write_u(b, 16, height);
+    bs_write_u(b, 32, 0x00480000); // horizresolution 72 dpi
+    bs_write_u(b, 32, 0x00480000); // vertresolution 72 dpi
+    bs_write_u(b, 32, 0);          // reserved
+    bs_write_u(b, 16, 1);          // frame_count
+    write_zeros(b, 32);            // compressorname
+    bs_write_u(b, 16, 0x0018);     // depth
+    bs_write_u(b, 16, 0xffff);     // pre_defined = -1
+    uint8_t* avcC = box_start(b, "avcC");
+    write_avcc(avcc, h, b);
+    box_end(b, avcC);
+    box_end(b, avc1);
+    box_end(b, stsd);
+
+    // the samples are all in fragments, these tables are empty
+    uint8_t* stts = full_box_start(b, "stts", 0, 0);
+    bs_write_u(b, 32, 0);
+    box_end(b, stts);
+    uint8_t* stsc = full_box_start(b, "stsc", 0, 0);
+    bs_write_u(b, 32, 0);
+    box_end(b, stsc);
+    uint8_t* stsz = full_box_start(b, "stsz", 0, 0);
+    bs_write_u(b, 32, 0);          // sample_size
+    bs_write_u(b, 32, 0);          // sample_count
+    box_end(b, stsz);
+    uint8_t* stco = full_box_start(b, "stco", 0, 0);
+    bs_write_u(b, 32, 0);
+    box_end(b, stco);
+    box_end(b, stbl);
+    box_end(b, minf);
+    box_end(b, mdia);
+    box_end(b, trak);
+
+    uint8_t* mvex = box_start(b, "mvex");
+    uint8_t* trex = full_box_start(b, "trex", 0, 0);
+    bs_write_u(b, 32, m->track_id);
+    bs_write_u(b, 32, 1);          // default_sample_description_index
+    bs_write_u(b, 32, m->sample_duration);
+    bs_write_u(b, 32, 0);          // default_sample_size
+    bs_write_u(b, 32, 0);          // default_sample_flags
+    box_end(b, trex);
+    box_end(b, mvex);
+
+    box_end(b, moov);
+
+    if ( bs_overrun(b) ) { return -1; }
+    return bs_pos(b);
+}
+
+// 8.2.1 picture order count of the picture whose first slice has just been read into h; for a frame the smaller of its
+// field order counts.  The state in m is updated as for the next picture.
+static int picture_order_count(h264_mp4_t* m, h264_stream_t* h, int idr, int mmco5)
+{
+    slice_header_t* sh = h->sh;
+    sps_t* sps = h->sps;
+    int ref = ( h->nal->nal_ref_idc != 0 );
+    int top = 0;
+    int bottom = 0;
+
+    if ( idr )
+    {
+        m->prev_poc_msb = 0;
+        m->prev_poc_lsb = 0;
+        m->prev_frame_num_offset = 0;
+        m->prev_frame_num = 0;
+    }
+
+    if ( sps->pic_order_cnt_type == 0 )
+    {
+        // 8.2.1.1 Decoding process for picture order count type 0
+        int max_lsb = 1 << ( sps->log2_max_pic_order_cnt_lsb_minus4 + 4 );
+        int lsb = sh->pic_order_cnt_lsb;
+        int msb = m->prev_poc_msb;
+        if ( lsb < m->prev_poc_lsb && m->prev_poc_lsb - lsb >= max_lsb / 2 ) { msb += max_lsb; }
+        else if ( lsb > m->prev_poc_lsb && lsb - m->prev_poc_lsb > max_lsb / 2 ) { msb -= max_lsb; }
+        top = msb + lsb;
+        bottom = sh->field_pic_flag ? top : top + sh->delta_pic_order_cnt_bottom;
+
+        if ( ref )
+        {
+            m->prev_poc_msb = msb;
+            m->prev_poc_lsb = lsb;
+        }
+    }
+    else
+    {
+        int max_frame_num = 1 << ( sps->log2_max_frame_num_minus4 + 4 );
+        int frame_num_offset = m->prev_frame_num_offset;
+        if ( !idr && m->prev_frame_num > sh->frame_num ) { frame_num_offset += max_frame_num; }
+
+        if ( sps->pic_order_cnt_type == 1 )
+        {
+            // 8.2.1.2 Decoding process for picture order count type 1
+            int cycle = sps->num_ref_frames_in_pic_order_cnt_cycle;
+            int abs_frame_num = ( cycle != 0 ) ? frame_num_offset + sh->frame_num : 0;
+            if ( !ref && abs_frame_num > 0 ) { abs_frame_num--; }
+            int expected = 0;
+            if ( abs_frame_num > 0 )
+            {
+                int delta_per_cycle = 0;
+                for ( int i = 0; i < cycle; i++ ) { delta_per_cycle += sps->offset_for_ref_frame[i]; }
+                expected = ( ( abs_frame_num - 1 ) / cycle ) * delta_per_cycle;
+                for ( int i = 0; i <= ( abs_frame_num - 1 ) % cycle; i++ ) { expected += sps->offset_for_ref_frame[i]; }
+            }
+            if ( !ref ) { expected += sps->offset_for_non_ref_pic; }
+
+            if ( !sh->field_pic_flag )
+            {
+                top = expected + sh->delta_pic_order_cnt[0];
+                bottom = top + sps->offset_for_top_to_bottom_field + sh->delta_pic_order_cnt[1];
+            }
+            else if ( !sh->bottom_field_flag ) { top = bottom = expected + sh->delta_pic_order_cnt[0]; }
+            else { top = bottom = expected + sps->offset_for_top_to_bottom_field + sh->delta_pic_order_cnt[0]; }
+        }
+        else
+        {
+            // 8.2.1.3 Decoding process for picture order count type 2
+            top = bottom = idr ? 0 : 2 * ( frame_num_offset + sh->frame_num ) - !ref;
+        }
+
+        m->prev_frame_num_offset = frame_num_offset;
+        m->prev_frame_num = sh->frame_num;
+    }
+
+    int poc = ( top < bottom ) ? top : bottom;
+
+    // after a memory_management_control_operation 5 the picture counts as the first of a new sequence (8.2.1)
+    if ( mmco5 )
+    {
+        m->prev_poc_msb = 0;
+        m->prev_poc_lsb = ( sh->field_pic_flag && sh->bottom_field_flag ) ? 0 : top - poc;
+        m->prev_frame_num_offset = 0;
+        m->prev_frame_num = 0;
+        poc = 0;
+    }
+    return poc;
+}
+
+/**
+ Fill in the duration, sync flag and picture order count of a sample from the first slice of its access unit, just read into h.
+ Call it for every access unit, in decode order; the composition offsets follow from the picture order counts of a whole
+ fragment (see h264_mp4_composition_offsets).  The size of the sample is left to the caller.
+ @param[in,out]  m  the writer, which keeps the picture order count state
+ @param[in]      h  stream which has just read the first slice of the access unit
+ @param[out]     s  the sample
+ */
+void h264_mp4_sample_from_slice(h264_mp4_t* m, h264_stream_t* h, h264_mp4_sample_t* s)
+{
+    slice_header_t* sh = h->sh;
+    int idr = ( h->nal->nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_IDR );
+    int mmco5 = 0;
+
+    if ( !idr && sh->drpm.adaptive_ref_pic_marking_mode_flag )
+    {
+        for ( int n = 0; n < 64 && sh->drpm.memory_management_control_operation[n] != 0; n++ )
+        {
+            if ( sh->drpm.memory_management_control_operation[n] == 5 ) { mmco5 = 1; break; }
+        }
+    }
+
+    s->duration = m->sample_duration;
+    s->is_sync = idr;
+    s->composition_offset = 0;
+    s->poc = picture_order_count(m, h, idr, mmco5);
+    s->poc_reset = idr || mmco5;
+}
+
+/**
+ Set the composition offsets of the samples of a fragment from their picture order counts.  Within each sequence of samples
+ started by a reset (an IDR or memory_management_control_operation 5) the samples are presented in picture order count order,
+ each at the decode time of the sample in its place, so no particular step between picture order counts is assumed.
+ A fragment should start at a reset, as pictures are not reordered across fragments.
+ @param[in,out]  samples      the samples of a fragment, in decode order
+ @param[in]      num_samples  number of samples
+ */
+void h264_mp4_composition_offsets(h264_mp4_sample_t* samples, int num_samples)
+{
+    for ( int start = 0; start < num_samples; )
+    {
+        int end = start + 1;
+        while ( end < num_samples && !samples[end].poc_reset ) { end++; }
+
+        for ( int i = start; i < end; i++ )
+        {
+            int rank = start;
+            for ( int j = start; j < end; j++ )
+            {
+                if ( samples[j].poc < samples[i].poc || ( samples[j].poc == samples[i].poc && j < i ) ) { rank++; }
+            }
+            int64_t offset = 0;
+            for ( int j = i; j < rank; j++ ) { offset += samples[j].duration; }
+            for ( int j = rank; j < i; j++ ) { offset -= samples[j].duration; }
+            samples[i].composition_offset = (int32_t)offset;
+        }
+        start = end;
+    }
+}
+
+/**
+ Write the moof of a fragment and the header of its mdat.  The sample data, NALs with length prefixes, has to follow right after
+ (for example the iovecs of h264_convert); it is not copied here.
+ @param[in,out]  m            the writer; its sequence number and decode time are advanced
+ @param[in]      samples      the samples of the fragment, in decode order
+ @param[in]      num_samples  number of samples
+ @param[out]     buf          the buffer
+ @param[in]      size         the size of the buffer
+ @return         bytes written, or -1 if the buffer was too small
+ */
+int h264_mp4_write_fragment(h264_mp4_t* m, const h264_mp4_sample_t* samples, int num_samples, uint8_t* buf, int size)
+{
+    bs_t bs;
+    bs_t* b = &bs;
+    bs_init(b, buf, size);
+
+    uint8_t* moof = box_start(b, "moof");
+    uint8_t* mfhd = full_box_start(b, "mfhd", 0, 0);
+    bs_write_u(b, 32, m->sequence_number);
+    box_end(b, mfhd);
+
+    uint8_t* traf = box_start(b, "traf");
+    uint8_t* tfhd = full_box_start(b, "tfhd", 0, 0x020000); // default-base-is-moof
+    bs_write_u(b, 32, m->track_id);
+    box_end(b, tfhd);
+
+    uint8_t* tfdt = full_box_start(b, "tfdt", 1, 0);
+    write_u64(b, m->base_media_decode_time);
+    box_end(b, tfdt);
+
+    // version 1: signed composition offsets
+    uint8_t* trun = full_box_start(b, "trun", 1, 0x000001 | 0x000100 | 0x000200 | 0x000400 | 0x000800);
+    bs_write_u(b, 32, num_samples);
+    uint8_t* data_offset = b->p;
+    bs_write_u(b, 32, 0);
+    uint64_t duration = 0;
+    uint32_t mdat_size = 8;
+    for ( int i = 0; i < num_samples; i++ )
+    {
+        bs_write_u(b, 32, samples[i].duration);
+        bs_write_u(b, 32, samples[i].size);
+        // sample_depends_on 2 for sync samples; otherwise sample_depends_on 1 and sample_is_non_sync_sample
+        bs_write_u(b, 32, samples[i].is_sync ? 0x02000000 : 0x01010000);
+        bs_write_u(b, 32, (uint32_t)samples[i].composition_offset);
+        duration += samples[i].duration;
+        mdat_size += samples[i].size;
+    }
+    box_end(b, trun);
+    box_end(b, traf);
+    box_end(b, moof);
+
+    // the data starts after the mdat header
+    uint32_t offset = ( b->p - moof ) + 8;
+    if ( b->p <= b->end )
+    {
+        data_offset[0] = offset >> 24;
+        data_offset[1] = offset >> 16;
+        data_offset[2] = offset >> 8;
+        data_offset[3] = offset;
+    }
+
+    bs_write_u(b, 32, mdat_size);
+    bs_write_u(b, 32, 0x6d646174); // 'mdat'
+
+    if ( bs_overrun(b) ) { return -1; }
+
+    m->sequence_number++;
+    m->base_media_decode_time += duration;
+    return bs_pos(b);
+}
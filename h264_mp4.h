@@ -0,0 +1,73 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _H264_MP4_H
+#define _H264_MP4_H        1
+
+#include <stdint.h>
+
+#include "h264_stream.h"
+#include "h264_avcc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+   One sample (access unit) of a fragment
+*/
+typedef struct
+{
+    uint32_t size;                // bytes of the sample in the mdat: its NALs with length prefixes of the avcC lengthSizeMinusOne + 1
+    uint32_t duration;
+    int is_sync;                  // IDR access unit
+    int32_t composition_offset;   // presentation time - decode time, may be negative; see h264_mp4_composition_offsets
+    int poc;                      // picture order count, in the sequence started by the last reset
+    int poc_reset;                // the picture order count starts again here (IDR or memory_management_control_operation 5)
+} h264_mp4_sample_t;
+
+/**
+   Writer of a single-track fragmented MP4 (CMAF) video stream: an init segment (ftyp, moov) and fragments (moof, mdat)
+*/
+typedef struct
+{
+    uint32_t track_id;
+    uint32_t timescale;
+    uint32_t sample_duration;     // default duration of a sample, in timescale units
+    uint32_t sequence_number;     // of the next fragment
+    uint64_t base_media_decode_time; // of the next fragment
+
+    // picture order count state (8.2.1) for composition offsets
+    int prev_poc_msb;
+    int prev_poc_lsb;
+    int prev_frame_num;
+    int prev_frame_num_offset;
+} h264_mp4_t;
+
+h264_mp4_t* h264_mp4_new(uint32_t timescale, uint32_t sample_duration);
+void h264_mp4_free(h264_mp4_t* m);
+int h264_mp4_write_init(h264_mp4_t* m, avcc_t* avcc, h264_stream_t* h, uint8_t* buf, int size);
+void h264_mp4_sample_from_slice(h264_mp4_t* m, h264_stream_t* h, h264_mp4_sample_t* s);
+void h264_mp4_composition_offsets(h264_mp4_sample_t* samples, int num_samples);
+int h264_mp4_write_fragment(h264_mp4_t* m, const h264_mp4_sample_t* samples, int num_samples, uint8_t* buf, int size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
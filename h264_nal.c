@@ -23,6 +23,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "bs.h"
 #include "h264_stream.h"
@@ -63,6 +64,9 @@ h264_stream_t* h264_new()
     h->sh_svc_ext = (slice_header_svc_ext_t*) calloc(1, sizeof(slice_header_svc_ext_t));
     h->slice_data = (slice_data_rbsp_t*)calloc(1, sizeof(slice_data_rbsp_t));
 
+    h->dbg.callback = h264_debug_print_field;
+    h->dbg.opaque = h;
+
     return h;
 }
 
@@ -92,7 +96,7 @@ void h264_free(h264_stream_t* h)
     free(h->aud);
     if(h->seis != NULL)
     {
-        for( int i = 0; i < h->num_seis; i++ )
+        for( int i = 0; i < h->num_seis || i < h->seis_capacity; i++ )
         {
             sei_t* sei = h->seis[i];
             sei_free(sei);
@@ -119,9 +123,98 @@ void h264_free(h264_stream_t* h)
     free(h->sps_subset->sps_svc_ext);
     free(h->sps_subset);
 
+    for ( int i = 0; i < 32; i++ ) { h264_ps_release( h->sps_refs[i] ); }
+    for ( int i = 0; i < 64; i++ ) { h264_ps_release( h->sps_subset_refs[i] ); }
+    for ( int i = 0; i < 256; i++ ) { h264_ps_release( h->pps_refs[i] ); }
+
+    h264_dbg_flush(h);
+    free(h->dbg.buf);
+
     free(h);
 }
 
+#if defined(__GNUC__)
+#define H264_ATOMIC_ADD(p, v) __sync_add_and_fetch((p), (v))
+#else
+// FIXME not atomic: snapshots must not be retained or released from several threads at once with this compiler
+#define H264_ATOMIC_ADD(p, v) (*(p) += (v))
+#endif
+
+/**
+ Take a reference to a parameter set snapshot.  May be called from any thread.
+ @param[in] ps   a h264_sps_ref_t, h264_sps_subset_ref_t or h264_pps_ref_t, or NULL
+ @return    ps
+ */
+void* h264_ps_retain(void* ps)
+{
+    if (ps != NULL) { H264_ATOMIC_ADD(&((h264_ps_ref_t*)ps)->refcount, 1); }
+    return ps;
+}
+
+/**
+ Drop a reference to a parameter set snapshot, freeing it when it was the last.  May be called from any thread.
+ @param[in] ps   a h264_sps_ref_t, h264_sps_subset_ref_t or h264_pps_ref_t, or NULL
+ */
+void h264_ps_release(void* ps)
+{
+    if (ps != NULL && H264_ATOMIC_ADD(&((h264_ps_ref_t*)ps)->refcount, -1) == 0) { free(ps); }
+}
+
+static void* new_ps_ref(h264_stream_t* h, size_t size)
+{
+    h264_ps_ref_t* ref = (h264_ps_ref_t*)calloc(1, size);
+    ref->refcount = 1;
+    ref->generation = ++h->ps_generation;
+    return ref;
+}
+
+/**
+ Update the snapshot of a SPS after it was read into h->sps_table[id].
+ Called by read_nal_unit.  Snapshots still referenced elsewhere are not affected.
+ */
+void h264_update_sps_ref(h264_stream_t* h, int id)
+{
+    h264_sps_ref_t* old = h->sps_refs[id];
+    if (old != NULL && memcmp(&old->sps, h->sps_table[id], sizeof(sps_t)) == 0) { return; }
+
+    h->sps_refs[id] = (h264_sps_ref_t*)new_ps_ref(h, sizeof(h264_sps_ref_t));
+    memcpy(&h->sps_refs[id]->sps, h->sps_table[id], sizeof(sps_t));
+    h264_ps_release(old);
+}
+
+/**
+ Update the snapshot of a subset SPS after it was read into h->sps_subset_table[id].
+ Called by read_nal_unit.  Snapshots still referenced elsewhere are not affected.
+ */
+void h264_update_sps_subset_ref(h264_stream_t* h, int id)
+{
+    h264_sps_subset_ref_t* old = h->sps_subset_refs[id];
+    sps_subset_t* sps_subset = h->sps_subset_table[id];
+    if (old != NULL && memcmp(&old->sps, sps_subset->sps, sizeof(sps_t)) == 0 &&
+        memcmp(&old->sps_svc_ext, sps_subset->sps_svc_ext, sizeof(sps_svc_ext_t)) == 0 &&
+        old->additional_extension2_flag == sps_subset->additional_extension2_flag) { return; }
+
+    h->sps_subset_refs[id] = (h264_sps_subset_ref_t*)new_ps_ref(h, sizeof(h264_sps_subset_ref_t));
+    memcpy(&h->sps_subset_refs[id]->sps, sps_subset->sps, sizeof(sps_t));
+    memcpy(&h->sps_subset_refs[id]->sps_svc_ext, sps_subset->sps_svc_ext, sizeof(sps_svc_ext_t));
+    h->sps_subset_refs[id]->additional_extension2_flag = sps_subset->additional_extension2_flag;
+    h264_ps_release(old);
+}
+
+/**
+ Update the snapshot of a PPS after it was read into h->pps_table[id].
+ Called by read_nal_unit.  Snapshots still referenced elsewhere are not affected.
+ */
+void h264_update_pps_ref(h264_stream_t* h, int id)
+{
+    h264_pps_ref_t* old = h->pps_refs[id];
+    if (old != NULL && memcmp(&old->pps, h->pps_table[id], sizeof(pps_t)) == 0) { return; }
+
+    h->pps_refs[id] = (h264_pps_ref_t*)new_ps_ref(h, sizeof(h264_pps_ref_t));
+    memcpy(&h->pps_refs[id]->pps, h->pps_table[id], sizeof(pps_t));
+    h264_ps_release(old);
+}
+
 /**
  Find the beginning and end of a NAL (Network Abstraction Layer) unit in a byte buffer containing H264 bitstream data.
  @param[in]   buf        the buffer
@@ -171,6 +264,95 @@ int find_nal_unit(uint8_t* buf, int size, int* nal_start, int* nal_end)
     return (*nal_end - *nal_start);
 }
 
+/**
+ Find a NAL unit in a buffer of length-prefixed NAL units (AVCC / MP4 sample format), the counterpart of find_nal_unit.
+ Only the length prefix is read, the NAL itself is not scanned.
+ @param[in]   buf          the buffer
+ @param[in]   size         the size of the buffer
+ @param[in]   length_size  size of the length prefix, 1 to 4 bytes (avcc->lengthSizeMinusOne + 1)
+ @param[out]  nal_start    the beginning offset of the nal
+ @param[out]  nal_end      the end offset of the nal
+ @return                   the length of the nal, or 0 if there is no nal, or -1 if the nal or its prefix is cut off by the end of the buffer (nal_end is then size)
+ */
+int find_nal_unit_length_prefixed(const uint8_t* buf, int size, int length_size, int* nal_start, int* nal_end)
+{
+    *nal_start = 0;
+    *nal_end = 0;
+    if (length_size < 1 || length_size > 4 || size <= 0) { return 0; }
+    if (size < length_size) { *nal_start = size; *nal_end = size; return -1; } // truncated length prefix
+
+    uint32_t len = 0;
+    for (int i = 0; i < length_size; i++) { len = (len << 8) | buf[i]; }
+
+    *nal_start = length_size;
+    if (len > (uint32_t)(size - length_size)) { *nal_end = size; return -1; }
+    *nal_end = length_size + (int)len;
+    return (int)len;
+}
+
+// the first three bytes 00 00 01 in [p, end), or with any_end also 00 00 00, where a NAL ends; NULL if there are none.
+// Unlike find_nal_unit, nothing past end is looked at.
+static const uint8_t* find_start_code(const uint8_t* p, const uint8_t* end, int any_end)
+{
+    while (end - p >= 3)
+    {
+        const uint8_t* z = (const uint8_t*)memchr(p, 0x00, end - p - 2);
+        if (z == NULL) { return NULL; }
+        if (z[1] == 0x00 && (z[2] == 0x01 || (any_end && z[2] == 0x00))) { return z; }
+        p = z + 1;
+    }
+    return NULL;
+}
+
+/**
+ Start iterating over the NAL units in a buffer.
+ @param[out]  it           the iterator
+ @param[in]   buf          the buffer
+ @param[in]   size         the size of the buffer
+ @param[in]   length_size  size of the length prefixes, 1 to 4 bytes; 0 for Annex B start codes
+ */
+void h264_nal_iter_init(h264_nal_iter_t* it, const uint8_t* buf, int size, int length_size)
+{
+    it->p = buf;
+    it->end = buf + size;
+    it->length_size = length_size;
+}
+
+/**
+ Get the next NAL unit.
+ With length prefixes this is O(1) per NAL, the data is never looked at.
+ @param[in,out]  it   the iterator
+ @param[out]     nal  the NAL unit, starting at its header byte
+ @return         1 if a NAL was found, 0 at the end of the buffer, -1 if the NAL may be incomplete: with length prefixes it is shorter
+                 than its length, with Annex B no start code follows it (the normal case for the last NAL of a complete buffer)
+ */
+int h264_nal_iter_next(h264_nal_iter_t* it, h264_nal_span_t* nal)
+{
+    int nal_start, nal_end;
+    int size = it->end - it->p;
+    int rc;
+
+    if (it->length_size > 0) { rc = find_nal_unit_length_prefixed(it->p, size, it->length_size, &nal_start, &nal_end); }
+    else
+    {
+        // the same NALs as find_nal_unit finds, but without reading past the end of the buffer
+        const uint8_t* start = find_start_code(it->p, it->end, 0);
+        if (start == NULL) { rc = 0; nal_end = 0; }
+        else
+        {
+            const uint8_t* end = find_start_code(start + 3, it->end, 1);
+            nal_start = (start + 3) - it->p;
+            nal_end = (end != NULL) ? end - it->p : size;
+            rc = (end != NULL) ? 1 : -1;
+        }
+    }
+
+    if (rc == 0 && nal_end == 0) { it->p = it->end; return 0; }
+    nal->buf = it->p + nal_start;
+    nal->size = nal_end - nal_start;
+    it->p += nal_end;
+    return (rc < 0) ? -1 : 1;
+}
 
 /**
    Convert RBSP data to NAL data (Annex B format).
@@ -293,6 +475,29 @@ int nal_to_rbsp(const uint8_t* nal_buf, int* nal_size, uint8_t* rbsp_buf, int* r
     return j;
 }
 
+/**
+ Read the first exp-Golomb codes of a NAL, such as the ids of a parameter set or the first fields of a slice header, without
+ reading the rest of it; only the first 16 bytes of the NAL are unescaped, on the stack.
+ @param[in]  nal         the NAL, starting with its header byte
+ @param[in]  size        size of the NAL
+ @param[in]  skip        bytes of the rbsp before the codes (1 for the NAL header)
+ @param[out] values      the codes read
+ @param[in]  num_values  how many codes to read
+ @return     0, or -1 if the NAL is broken or too short for them
+ */
+int h264_peek_ue(const uint8_t* nal, int size, int skip, uint32_t* values, int num_values)
+{
+    uint8_t rbsp[16];
+    int nal_size = ( size < 16 ) ? size : 16;
+    int rbsp_size = sizeof(rbsp);
+    if ( nal_to_rbsp(nal, &nal_size, rbsp, &rbsp_size) < 0 || rbsp_size <= skip ) { return -1; }
+
+    bs_t b;
+    bs_init(&b, rbsp + skip, rbsp_size - skip);
+    for ( int i = 0; i < num_values; i++ ) { values[i] = bs_read_ue(&b); }
+    return bs_overrun(&b) ? -1 : 0;
+}
+
 
 /**
  Read only the NAL headers (enough to determine unit type) from a byte buffer.
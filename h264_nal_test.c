@@ -0,0 +1,298 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+// Checks of h264_nal_iter_next on buffers of exactly the size of their data, which are put right before an inaccessible
+// page, so that reading a byte past the end crashes the test.
+// Small hand-made streams are checked against the NALs they have; each input file against the NALs find_nal_unit finds
+// in a padded copy of it.
+// sei_find_payloads is checked the same way on a hand-made SEI NAL, through type and uuid filters, with payloads which have to
+// be unescaped into scratch, and with a scratch and views too small for all of them.
+// h264_nal_filter_keep is checked on sequences of NAL headers, for its decisions by nal_ref_idc, temporal_id, discardable_flag
+// and inter_view_flag, and for base layer slices, which go with the prefix NAL before them.
+
+#define _DEFAULT_SOURCE
+
+#include "h264_stream.h"
+#include "h264_sei.h"
+#include "h264_filter.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+typedef struct
+{
+    const char* name;
+    uint8_t data[16];
+    int size;
+    int num_nals;
+    int nals[4][3];     // offset, size and return value of each NAL
+} case_t;
+
+static const case_t cases[] =
+{
+    { "one NAL", { 0x00, 0x00, 0x01, 0x09 }, 4, 1, { { 3, 1, -1 } } },
+    { "two NALs", { 0x00, 0x00, 0x00, 0x01, 0x09, 0xF0, 0x00, 0x00, 0x01, 0x68, 0xCE }, 11, 2, { { 4, 2, 1 }, { 9, 2, -1 } } },
+    { "trailing zeros", { 0x00, 0x00, 0x01, 0x09, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x01, 0x41 }, 11, 2, { { 3, 2, 1 }, { 10, 1, -1 } } },
+    { "start code only", { 0x00, 0x00, 0x01 }, 3, 1, { { 3, 0, -1 } } },
+    { "no start code", { 0x00, 0x00, 0x02, 0x00, 0x00 }, 5, 0, { { 0 } } },
+    { "empty", { 0 }, 0, 0, { { 0 } } },
+};
+
+// a copy of data which ends right before an inaccessible page
+static uint8_t* guarded_copy(const uint8_t* data, int size, uint8_t** map, size_t* map_size)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    *map_size = ((size + page - 1) / page + 1) * page;
+    *map = (uint8_t*)mmap(NULL, *map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (*map == MAP_FAILED) { fprintf( stderr, "!! Error: mmap failed: %s \n", strerror(errno)); exit(EXIT_FAILURE); }
+    mprotect(*map + *map_size - page, page, PROT_NONE);
+    uint8_t* buf = *map + *map_size - page - size;
+    memcpy(buf, data, size);
+    return buf;
+}
+
+static int check_case(const case_t* c)
+{
+    uint8_t* map;
+    size_t map_size;
+    uint8_t* buf = guarded_copy(c->data, c->size, &map, &map_size);
+    h264_nal_iter_t it;
+    h264_nal_span_t nal;
+    int rc;
+    int n = 0;
+    int failures = 0;
+
+    h264_nal_iter_init(&it, buf, c->size, 0);
+    while ((rc = h264_nal_iter_next(&it, &nal)) != 0)
+    {
+        if (n >= c->num_nals || nal.buf - buf != c->nals[n][0] || nal.size != c->nals[n][1] || rc != c->nals[n][2])
+        {
+            printf("%s: NAL %d at offset %d, size %d, returned %d \n", c->name, n, (int)(nal.buf - buf), nal.size, rc);
+            failures++;
+        }
+        n++;
+    }
+    if (n != c->num_nals) { printf("%s: %d NALs instead of %d \n", c->name, n, c->num_nals); failures++; }
+
+    munmap(map, map_size);
+    return failures;
+}
+
+static int check_file(const char* name)
+{
+    FILE* f = fopen(name, "rb");
+    if (f == NULL) { fprintf( stderr, "!! Error: could not open file: %s: %s \n", name, strerror(errno)); return 1; }
+    fseek(f, 0, SEEK_END);
+    int size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* padded = (uint8_t*)calloc(size + 4, 1); // find_nal_unit may look a few bytes past the end
+    if (fread(padded, 1, size, f) != (size_t)size) { fprintf( stderr, "!! Error: read failed: %s \n", name); fclose(f); free(padded); return 1; }
+    fclose(f);
+
+    uint8_t* map;
+    size_t map_size;
+    uint8_t* buf = guarded_copy(padded, size, &map, &map_size);
+    h264_nal_iter_t it;
+    h264_nal_span_t nal;
+    uint8_t* p = padded;
+    int sz = size;
+    int nal_start, nal_end;
+    int n = 0;
+    int failures = 0;
+
+    // find_nal_unit finds all but the last NAL, which has no start code after it
+    h264_nal_iter_init(&it, buf, size, 0);
+    while (find_nal_unit(p, sz, &nal_start, &nal_end) > 0)
+    {
+        int rc = h264_nal_iter_next(&it, &nal);
+        if (rc != 1 || nal.buf - buf != (p - padded) + nal_start || nal.size != nal_end - nal_start)
+        {
+            printf("%s: NAL %d at offset %d, size %d, returned %d \n", name, n, (int)(nal.buf - buf), nal.size, rc);
+            failures++;
+        }
+        n++;
+        p += nal_end;
+        sz -= nal_end;
+    }
+    if (h264_nal_iter_next(&it, &nal) != -1 || nal.buf + nal.size != buf + size) { printf("%s: last NAL not found \n", name); failures++; }
+    if (h264_nal_iter_next(&it, &nal) != 0) { printf("%s: more than %d NALs \n", name, n + 1); failures++; }
+
+    munmap(map, map_size);
+    free(padded);
+    return failures;
+}
+
+// user data unregistered, user data registered and recovery point payloads; the first two have emulation prevention bytes
+static const uint8_t sei_nal[] =
+{
+    0x06,
+    0x05, 0x14, 0xDC, 0x45, 0xE9, 0xBD, 0xE6, 0xD9, 0x48, 0xB7, 0x96, 0x2C, 0xD8, 0x20, 0xD9, 0x23, 0xEE, 0xEF, 'a', 0x00, 0x00, 0x03, 0x00,
+    0x04, 0x06, 0xB5, 0x00, 0x31, 0x00, 0x00, 0x03, 0x01,
+    0x06, 0x01, 0xC4,
+    0x80
+};
+static const uint8_t sei_uuid[16] = { 0xDC, 0x45, 0xE9, 0xBD, 0xE6, 0xD9, 0x48, 0xB7, 0x96, 0x2C, 0xD8, 0x20, 0xD9, 0x23, 0xEE, 0xEF };
+static const uint8_t sei_other_uuid[16] = { 0x01 };
+static const uint8_t sei_unregistered[20] = { 0xDC, 0x45, 0xE9, 0xBD, 0xE6, 0xD9, 0x48, 0xB7, 0x96, 0x2C, 0xD8, 0x20, 0xD9, 0x23, 0xEE, 0xEF,
+                                              'a', 0x00, 0x00, 0x00 };
+static const uint8_t sei_registered[6] = { 0xB5, 0x00, 0x31, 0x00, 0x00, 0x01 };
+static const uint8_t sei_recovery_point[1] = { 0xC4 };
+
+enum { IN_NAL, IN_SCRATCH, NOT_RETURNED };
+
+typedef struct
+{
+    const char* name;
+    int types[2];
+    int num_types;
+    const uint8_t* uuid;
+    int max_views;
+    int scratch_size;
+    int found;          // the return value
+    int views[3][2];    // payload type and where its data is, of the views filled in
+} sei_case_t;
+
+static const sei_case_t sei_cases[] =
+{
+    { "all", { 0 }, 0, NULL, 3, 64, 3, { { 5, IN_SCRATCH }, { 4, IN_SCRATCH }, { 6, IN_NAL } } },
+    { "recovery point", { 6 }, 1, NULL, 3, 64, 1, { { 6, IN_NAL } } },
+    { "registered", { 4, 1 }, 2, NULL, 3, 64, 1, { { 4, IN_SCRATCH } } },
+    { "uuid", { 5 }, 1, sei_uuid, 3, 64, 1, { { 5, IN_SCRATCH } } },
+    { "other uuid", { 0 }, 0, sei_other_uuid, 3, 64, 2, { { 4, IN_SCRATCH }, { 6, IN_NAL } } },
+    { "scratch too small", { 0 }, 0, NULL, 3, 10, 3, { { 5, NOT_RETURNED }, { 4, IN_SCRATCH }, { 6, IN_NAL } } },
+    { "no scratch", { 0 }, 0, NULL, 3, 0, 3, { { 5, NOT_RETURNED }, { 4, NOT_RETURNED }, { 6, IN_NAL } } },
+    { "one view", { 0 }, 0, NULL, 1, 64, 3, { { 5, IN_SCRATCH } } },
+};
+
+static int check_sei_case(const sei_case_t* c)
+{
+    uint8_t* map;
+    size_t map_size;
+    uint8_t* buf = guarded_copy(sei_nal, sizeof(sei_nal), &map, &map_size);
+    uint8_t scratch[64];
+    sei_view_t views[3];
+    sei_filter_t filter;
+    memset(&filter, 0, sizeof(filter));
+    filter.types = c->types;
+    filter.num_types = c->num_types;
+    filter.uuids = c->uuid;
+    filter.num_uuids = (c->uuid != NULL) ? 1 : 0;
+    int failures = 0;
+
+    int found = sei_find_payloads(buf, sizeof(sei_nal), &filter, views, c->max_views, (c->scratch_size > 0) ? scratch : NULL, c->scratch_size);
+    if (found != c->found) { printf("sei %s: %d payloads found instead of %d \n", c->name, found, c->found); failures++; }
+
+    for (int i = 0; i < found && i < c->max_views && i < c->found; i++)
+    {
+        sei_view_t* v = &views[i];
+        const uint8_t* raw = (v->payloadType == 5) ? sei_unregistered : (v->payloadType == 4) ? sei_registered : sei_recovery_point;
+        int raw_size = (v->payloadType == 5) ? (int)sizeof(sei_unregistered) : (v->payloadType == 4) ? (int)sizeof(sei_registered) : (int)sizeof(sei_recovery_point);
+        int where = (v->data == NULL) ? NOT_RETURNED : (v->data >= buf && v->data < buf + sizeof(sei_nal)) ? IN_NAL :
+                    (v->data >= scratch && v->data + v->payloadSize <= scratch + c->scratch_size) ? IN_SCRATCH : -1;
+        if (v->payloadType != c->views[i][0] || v->payloadSize != raw_size || where != c->views[i][1] ||
+            (v->data != NULL && memcmp(v->data, raw, raw_size) != 0))
+        {
+            printf("sei %s: payload %d of type %d, size %d, %s \n", c->name, i, v->payloadType, v->payloadSize,
+                   (where == IN_NAL) ? "in the NAL" : (where == IN_SCRATCH) ? "in scratch" : (where == NOT_RETURNED) ? "not returned" : "elsewhere");
+            failures++;
+        }
+    }
+
+    munmap(map, map_size);
+    return failures;
+}
+
+// SVC extension: svc_extension_flag, idr_flag 0, priority_id 0; dependency_id 1 for slices; temporal_id, discardable_flag, output_flag 1
+#define SVC_PREFIX(ref, tid, disc)  { ( (ref) << 5 ) | 14, 0x80, 0x00, ( (tid) << 5 ) | ( (disc) << 3 ) | 0x07 }
+#define SVC_SLICE(ref, tid, disc)   { ( (ref) << 5 ) | 20, 0x80, 0x10, ( (tid) << 5 ) | ( (disc) << 3 ) | 0x07 }
+// MVC extension: non_idr_flag 1, view_id 1, temporal_id, anchor_pic_flag 0, inter_view_flag
+#define MVC_PREFIX(ref, tid, iv)    { ( (ref) << 5 ) | 14, 0x40, 0x00, 0x40 | ( (tid) << 3 ) | ( (iv) << 1 ) | 0x01 }
+#define MVC_SLICE(ref, tid, iv)     { ( (ref) << 5 ) | 20, 0x40, 0x00, 0x40 | ( (tid) << 3 ) | ( (iv) << 1 ) | 0x01 }
+
+typedef struct
+{
+    const char* name;
+    int flags;
+    int max_temporal_id;
+    int num_nals;
+    uint8_t nals[8][4];
+    int keep[8];
+} filter_case_t;
+
+static const filter_case_t filter_cases[] =
+{
+    { "non-reference", H264_FILTER_DROP_NON_REF, 7, 7,
+      { { 0x01 }, { 0x41 }, { 0x65 }, { 0x06 }, { 0x67 }, { 0x68 }, { 0x09 } }, { 0, 1, 1, 1, 1, 1, 1 } },
+    { "non-reference kept", 0, 7, 2, { { 0x01 }, { 0x21 } }, { 1, 1 } },
+    { "temporal id", 0, 1, 5,
+      { SVC_PREFIX(3, 2, 0), { 0x41 }, SVC_SLICE(3, 1, 0), SVC_SLICE(3, 2, 0), { 0x41 } }, { 0, 0, 1, 0, 1 } },
+    { "discardable", H264_FILTER_DROP_NON_REF, 7, 4,
+      { SVC_SLICE(0, 0, 1), SVC_SLICE(0, 0, 0), SVC_SLICE(2, 0, 1), SVC_SLICE(0, 3, 1) }, { 0, 1, 1, 0 } },
+    { "prefix carry-over", H264_FILTER_DROP_NON_REF, 7, 6,
+      { SVC_PREFIX(0, 0, 1), { 0x41 }, SVC_PREFIX(0, 0, 0), { 0x01 }, { 0x01 }, { 0x41 } }, { 0, 0, 1, 1, 0, 1 } },
+    { "inter-view", H264_FILTER_DROP_NON_REF, 7, 5,
+      { MVC_SLICE(0, 0, 1), MVC_SLICE(0, 0, 0), MVC_SLICE(1, 0, 0), MVC_PREFIX(0, 0, 0), { 0x61 } }, { 1, 0, 1, 0, 0 } },
+    { "MVC temporal id", 0, 0, 4, { MVC_PREFIX(3, 1, 1), { 0x65 }, MVC_SLICE(3, 0, 1), MVC_SLICE(3, 1, 1) }, { 0, 0, 1, 0 } },
+};
+
+static int check_filter_case(const filter_case_t* c)
+{
+    h264_nal_filter_t* f = h264_nal_filter_new(c->flags, c->max_temporal_id);
+    int kept = 0;
+    int failures = 0;
+
+    for (int i = 0; i < c->num_nals; i++)
+    {
+        int keep = h264_nal_filter_keep(f, c->nals[i], sizeof(c->nals[i]));
+        if (keep != c->keep[i]) { printf("filter %s: NAL %d (%02X) %s \n", c->name, i, c->nals[i][0], keep ? "kept" : "dropped"); failures++; }
+        kept += c->keep[i];
+    }
+    if (f->kept != kept || f->dropped != c->num_nals - kept) { printf("filter %s: counted %d kept, %d dropped \n", c->name, f->kept, f->dropped); failures++; }
+
+    h264_nal_filter_free(f);
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    int failures = 0;
+
+    for (int i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++) { failures += check_case(&cases[i]); }
+    for (int i = 1; i < argc; i++) { failures += check_file(argv[i]); }
+
+    printf("h264_nal_iter_next on %d buffers: %d mismatches\n", (int)(sizeof(cases) / sizeof(cases[0])) + argc - 1, failures);
+
+    int sei_failures = 0;
+    for (int i = 0; i < (int)(sizeof(sei_cases) / sizeof(sei_cases[0])); i++) { sei_failures += check_sei_case(&sei_cases[i]); }
+    uint8_t aud[2] = { 0x09, 0xF0 };
+    sei_view_t view;
+    if (sei_find_payloads(aud, sizeof(aud), NULL, &view, 1, NULL, 0) != -1) { printf("sei: an AUD taken for a SEI NAL \n"); sei_failures++; }
+    printf("sei_find_payloads on %d filters: %d mismatches\n", (int)(sizeof(sei_cases) / sizeof(sei_cases[0])), sei_failures);
+    failures += sei_failures;
+
+    int filter_failures = 0;
+    for (int i = 0; i < (int)(sizeof(filter_cases) / sizeof(filter_cases[0])); i++) { filter_failures += check_filter_case(&filter_cases[i]); }
+    printf("h264_nal_filter_keep on %d sequences: %d mismatches\n", (int)(sizeof(filter_cases) / sizeof(filter_cases[0])), filter_failures);
+    failures += filter_failures;
+    return (failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
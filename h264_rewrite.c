@@ -0,0 +1,483 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bs.h"
+#include "h264_stream.h"
+#include "h264_rewrite.h"
+
+/**
+ Create a parameter set patcher.
+ @param[in]  sps_rule  changes the fields of each SPS, or NULL
+ @param[in]  pps_rule  changes the fields of each PPS, or NULL
+ @param[in]  opaque    passed to the rules
+ */
+h264_ps_patcher_t* h264_ps_patcher_new(h264_sps_rule_cb sps_rule, h264_pps_rule_cb pps_rule, void* opaque)
+{
+    h264_ps_patcher_t* p = (h264_ps_patcher_t*)calloc(1, sizeof(h264_ps_patcher_t));
+    p->sps_rule = sps_rule;
+    p->pps_rule = pps_rule;
+    p->opaque = opaque;
+    p->h = h264_new();
+    return p;
+}
+
+static void patch_free_retired(h264_ps_patcher_t* p)
+{
+    for ( int i = 0; i < p->num_retired; i++ ) { free(p->retired[i]); }
+    p->num_retired = 0;
+}
+
+static void patch_retire(h264_ps_patcher_t* p, h264_ps_patch_entry_t* e)
+{
+    if ( e->in == NULL ) { return; }
+    if ( p->num_retired == p->retired_capacity )
+    {
+        p->retired_capacity = ( p->retired_capacity > 0 ) ? p->retired_capacity * 2 : 16;
+        p->retired = (uint8_t**)realloc(p->retired, p->retired_capacity * sizeof(uint8_t*));
+    }
+    p->retired[p->num_retired++] = e->in;
+    e->in = NULL;
+    e->out = NULL;
+}
+
+void h264_ps_patcher_free(h264_ps_patcher_t* p)
+{
+    if ( p == NULL ) { return; }
+    for ( int i = 0; i < 32; i++ ) { free(p->sps_cache[i].in); }
+    for ( int i = 0; i < 256; i++ ) { free(p->pps_cache[i].in); }
+    patch_free_retired(p);
+    free(p->retired);
+    free(p->iov);
+    h264_free(p->h);
+    free(p);
+}
+
+static void patch_add_iov(h264_ps_patcher_t* p, const uint8_t* base, int len)
+{
+    if ( len <= 0 ) { return; }
+    if ( p->num_iov == p->iov_capacity )
+    {
+        p->iov_capacity = ( p->iov_capacity > 0 ) ? p->iov_capacity * 2 : 64;
+        p->iov = (h264_iovec_t*)realloc(p->iov, p->iov_capacity * sizeof(h264_iovec_t));
+    }
+    p->iov[p->num_iov].base = base;
+    p->iov[p->num_iov].len = len;
+    p->num_iov++;
+}
+
+// the rewritten parameter set, from the cache if the same bytes were rewritten before
+static h264_ps_patch_entry_t* patch_ps(h264_ps_patcher_t* p, const uint8_t* nal, int size, int nal_unit_type)
+{
+    h264_stream_t* h = p->h;
+    int is_sps = ( nal_unit_type == NAL_UNIT_TYPE_SPS );
+    h264_ps_patch_entry_t* cache = is_sps ? p->sps_cache : p->pps_cache;
+    int cache_size = is_sps ? 32 : 256;
+
+    for ( int i = 0; i < cache_size; i++ )
+    {
+        h264_ps_patch_entry_t* e = &cache[i];
+        if ( e->in != NULL && e->in_size == size && memcmp(e->in, nal, size) == 0 ) { return e; }
+    }
+
+    if ( read_nal_unit(h, (uint8_t*)nal, size) < 0 ) { return NULL; }
+
+    // write it from a copy, so that the rules do not change what later NALs are parsed against
+    uint8_t* buf = (uint8_t*)malloc(2 * size + 1024);
+    int len;
+    h264_ps_patch_entry_t* e;
+    if ( is_sps )
+    {
+        sps_t* h_sps = h->sps;
+        memcpy(&p->sps, h->sps, sizeof(sps_t));
+        p->sps_rule(p->opaque, &p->sps);
+        h->sps = &p->sps;
+        len = write_nal_unit(h, buf, 2 * size + 1024);
+        h->sps = h_sps;
+        e = &cache[h_sps->seq_parameter_set_id];
+
+        // a PPS is parsed against its SPS
+        for ( int i = 0; i < 256; i++ ) { patch_retire(p, &p->pps_cache[i]); }
+    }
+    else
+    {
+        pps_t* h_pps = h->pps;
+        memcpy(&p->pps, h->pps, sizeof(pps_t));
+        p->pps_rule(p->opaque, &p->pps);
+        h->pps = &p->pps;
+        len = write_nal_unit(h, buf, 2 * size + 1024);
+        h->pps = h_pps;
+        e = &cache[h_pps->pic_parameter_set_id];
+    }
+    // write_nal_unit leaves a zero byte before the NAL
+    len -= 1;
+    if ( len <= 0 ) { free(buf); return NULL; }
+
+    patch_retire(p, e);
+    e->in = (uint8_t*)malloc(size + len);
+    e->in_size = size;
+    e->out = e->in + size;
+    e->out_size = len;
+    memcpy(e->in, nal, size);
+    memcpy(e->out, buf + 1, len);
+    free(buf);
+    p->rewritten++;
+    return e;
+}
+
+/**
+ Rewrite the parameter sets in a piece of an Annex B stream.
+ Only SPS and PPS NALs are parsed, changed by the rules, and written again; each distinct parameter set is rewritten once and
+ then taken from a cache.  The output is p->iov[0 .. p->num_iov - 1]: the data between the parameter sets (start codes included)
+ in buf, as few pieces as possible, and the rewritten parameter sets.  It stays valid until the next call, as long as buf does.
+ @param[in]  p              the patcher
+ @param[in]  buf            the input
+ @param[in]  size           size of the input
+ @param[in]  end_of_stream  whether the input ends with the end of the stream
+ @return     number of bytes of buf consumed, the rest has to be passed again followed by more data; -1 if a parameter set could not be rewritten
+ */
+int h264_ps_patch(h264_ps_patcher_t* p, const uint8_t* buf, int size, int end_of_stream)
+{
+    const uint8_t* end = buf + size;
+    const uint8_t* region = buf;      // passes through, up to the next parameter set
+    const uint8_t* consumed = end;
+    h264_nal_iter_t it;
+    h264_nal_span_t nal;
+    int rc;
+
+    p->num_iov = 0;
+    patch_free_retired(p);
+
+    // a start code and NAL header might continue after the end of buf
+    if ( !end_of_stream ) { consumed = ( size > 3 ) ? end - 3 : buf; }
+
+    h264_nal_iter_init(&it, buf, size, 0);
+    while ( ( rc = h264_nal_iter_next(&it, &nal) ) != 0 )
+    {
+        if ( nal.size < 1 )
+        {
+            // a start code at the very end, the NAL header is in the next call
+            if ( !end_of_stream ) { consumed = nal.buf - 3; }
+            break;
+        }
+        int nal_unit_type = nal.buf[0] & 0x1F;
+        if ( !( nal_unit_type == NAL_UNIT_TYPE_SPS && p->sps_rule != NULL ) &&
+             !( nal_unit_type == NAL_UNIT_TYPE_PPS && p->pps_rule != NULL ) ) { continue; }
+
+        if ( rc < 0 && !end_of_stream )
+        {
+            // the parameter set may continue, it is done in the next call
+            consumed = nal.buf - 3;
+            break;
+        }
+        // the iterator leaves trailing zero bytes in a NAL only at the end of buf
+        const uint8_t* nal_end = nal.buf + nal.size;
+        while ( nal_end > nal.buf && nal_end[-1] == 0x00 ) { nal_end--; }
+
+        h264_ps_patch_entry_t* e = patch_ps(p, nal.buf, nal_end - nal.buf, nal_unit_type);
+        if ( e == NULL ) { p->num_iov = 0; return -1; }
+        patch_add_iov(p, region, nal.buf - region);
+        patch_add_iov(p, e->out, e->out_size);
+        region = nal_end;
+    }
+
+    if ( consumed < region ) { consumed = region; }
+    patch_add_iov(p, region, consumed - region);
+    return consumed - buf;
+}
+
+/**
+ Create a remapper of parameter set ids.
+ @param[in]  num_inputs  number of streams whose NALs are remapped
+ */
+h264_ps_remapper_t* h264_ps_remapper_new(int num_inputs)
+{
+    h264_ps_remapper_t* r = (h264_ps_remapper_t*)calloc(1, sizeof(h264_ps_remapper_t));
+    r->inputs = (h264_ps_remap_input_t*)malloc(num_inputs * sizeof(h264_ps_remap_input_t));
+    r->num_inputs = num_inputs;
+    for ( int i = 0; i < num_inputs; i++ )
+    {
+        for ( int j = 0; j < 32; j++ ) { r->inputs[i].sps_map[j] = -1; r->inputs[i].subset_sps[j] = 0; }
+        for ( int j = 0; j < 256; j++ ) { r->inputs[i].pps_map[j] = -1; r->inputs[i].pps_sps[j] = -1; }
+        r->inputs[i].h = h264_new();
+    }
+    r->h = h264_new();
+    return r;
+}
+
+void h264_ps_remapper_free(h264_ps_remapper_t* r)
+{
+    if ( r == NULL ) { return; }
+    for ( int i = 0; i < 32; i++ ) { free(r->sps[i].key); }
+    for ( int i = 0; i < 256; i++ ) { free(r->pps[i].key); }
+    for ( int i = 0; i < r->num_inputs; i++ ) { h264_free(r->inputs[i].h); }
+    free(r->inputs);
+    h264_free(r->h);
+    free(r->rbsp);
+    free(r->out);
+    free(r);
+}
+
+static void remap_reserve(uint8_t** buf, int* capacity, int size)
+{
+    if ( *capacity >= size ) { return; }
+    *capacity = size;
+    free(*buf);
+    *buf = (uint8_t*)malloc(size);
+}
+
+static uint32_t remap_hash(const uint8_t* buf, int size)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for ( int i = 0; i < size; i++ ) { hash = (hash ^ buf[i]) * 16777619u; }
+    return hash;
+}
+
+// number of bits of an rbsp before its rbsp_stop_one_bit, -1 if there is none
+static int remap_stop_bit(const uint8_t* rbsp, int size)
+{
+    while ( size > 0 && rbsp[size - 1] == 0x00 ) { size--; }
+    if ( size == 0 ) { return -1; }
+    int bits = size * 8 - 1;
+    for ( uint8_t last = rbsp[size - 1]; !(last & 0x01); last >>= 1 ) { bits--; }
+    return bits;
+}
+
+// the rbsp with other values for the exp-Golomb codes which follow its first prefix_size bytes and end at bit tail;
+// the bits from tail up to the rbsp_stop_one_bit are copied as they are, whatever they are shifted by
+static int remap_rbsp(const uint8_t* rbsp, int rbsp_size, int prefix_size, const uint32_t* values, int num_values,
+                      int tail, int stop, uint8_t* dst, int dst_size)
+{
+    bs_t b;
+    bs_init(&b, dst, dst_size);
+    bs_write_bytes(&b, (uint8_t*)rbsp, prefix_size);
+    for ( int i = 0; i < num_values; i++ ) { bs_write_ue(&b, values[i]); }
+    bs_write_bits(&b, rbsp, tail, stop - tail);
+
+    // rbsp_trailing_bits, and the cabac_zero_words after them
+    bs_write_u1(&b, 1);
+    while ( !bs_byte_aligned(&b) ) { bs_write_u1(&b, 0); }
+    for ( int i = (stop >> 3) + 1; i < rbsp_size; i++ ) { bs_write_u8(&b, 0x00); }
+    if ( bs_overrun(&b) ) { return -1; }
+    return bs_pos(&b);
+}
+
+// the NAL of an rbsp in r->out, after the zero byte rbsp_to_nal puts first
+static int remap_nal(h264_ps_remapper_t* r, const uint8_t* rbsp, int rbsp_size)
+{
+    int nal_size = r->out_capacity - 1;
+    if ( rbsp_to_nal(rbsp, &rbsp_size, r->out, &nal_size) < 0 ) { return -1; }
+    // a cabac_zero_word at the end is followed by 0x03, which is not in the rbsp
+    if ( nal_size > 2 && r->out[nal_size - 1] == 0x00 ) { r->out[nal_size++] = 0x03; }
+    return nal_size - 1;
+}
+
+// whether no input maps one of its parameter sets to the output id of entries any more
+static int remap_unused(h264_ps_remapper_t* r, const h264_ps_remap_entry_t* entries, int id)
+{
+    for ( int i = 0; i < r->num_inputs; i++ )
+    {
+        const int* map = ( entries == r->sps ) ? r->inputs[i].sps_map : r->inputs[i].pps_map;
+        int n = ( entries == r->sps ) ? 32 : 256;
+        for ( int j = 0; j < n; j++ ) { if ( map[j] == id ) { return 0; } }
+    }
+    return 1;
+}
+
+// the output id of a parameter set, which is added if no identical one was output before: with a free id, or one which no
+// input maps to any more; -1 if there is none
+static int remap_ps(h264_ps_remapper_t* r, h264_ps_remap_entry_t* entries, int num_entries,
+                    const uint8_t* rbsp, int rbsp_size, int prefix_size, uint32_t* values, int num_values, int tail, int stop)
+{
+    uint8_t* dst = r->rbsp + rbsp_size;
+    int dst_size = r->rbsp_capacity - rbsp_size;
+
+    // values[0] is the id of the parameter set itself
+    values[0] = 0;
+    int key_size = remap_rbsp(rbsp, rbsp_size, prefix_size, values, num_values, tail, stop, dst, dst_size);
+    if ( key_size < 0 ) { return -1; }
+    uint32_t hash = remap_hash(dst, key_size);
+
+    int id = -1;
+    for ( int i = 0; i < num_entries; i++ )
+    {
+        h264_ps_remap_entry_t* e = &entries[i];
+        if ( e->key == NULL ) { if ( id < 0 ) { id = i; } continue; }
+        if ( e->hash == hash && e->key_size == key_size && memcmp(e->key, dst, key_size) == 0 ) { return i; }
+    }
+    if ( id < 0 )
+    {
+        for ( int i = 0; i < num_entries && id < 0; i++ ) { if ( remap_unused(r, entries, i) ) { id = i; } }
+        if ( id < 0 ) { return -1; }
+        free(entries[id].key);
+        entries[id].key = NULL;
+    }
+
+    // the NAL with the new id, written after the key
+    values[0] = id;
+    int size = remap_rbsp(rbsp, rbsp_size, prefix_size, values, num_values, tail, stop, dst + key_size, dst_size - key_size);
+    int nal_size = ( size < 0 ) ? -1 : remap_nal(r, dst + key_size, size);
+    if ( nal_size <= 0 ) { return -1; }
+
+    h264_ps_remap_entry_t* e = &entries[id];
+    e->key = (uint8_t*)malloc(key_size + nal_size);
+    e->key_size = key_size;
+    e->hash = hash;
+    e->nal = e->key + key_size;
+    e->nal_size = nal_size;
+    memcpy(e->key, dst, key_size);
+    memcpy(e->nal, r->out + 1, nal_size);
+    if ( read_nal_unit(r->h, e->nal, nal_size) < 0 )
+    {
+        free(e->key);
+        e->key = NULL;
+        return -1;
+    }
+    return id;
+}
+
+/**
+ Remap the parameter set ids of a NAL unit of one of the inputs.
+ An SPS or PPS gets the output id of an identical parameter set output before, or a free one, and the rest of it is copied
+ bit for bit.  A slice gets the output id of its PPS: if that is a different id its header is written again, and the slice
+ data re-attached as it is, otherwise the slice is passed through without being parsed.
+ The ids of parameter sets which no input refers to any more (replaced by a different one with the same input id) are reused
+ when the ids run out.
+ SVC and MVC NAL units (subset SPS, slice extensions) are passed through as they are, as are PPSs which refer to a subset SPS
+ id for which the input has no SPS, and all other NALs: their ids are not remapped.
+ @param[in]  r      the remapper
+ @param[in]  input  index of the input the NAL is from
+ @param[in]  nal    the NAL, starting with its header byte
+ @param[in]  size   size of the NAL
+ @param[out] out    the remapped NAL: nal itself if nothing changed, otherwise valid until the next call
+ @return     0, or -1 if the NAL could not be remapped: it is broken, refers to a parameter set not seen yet, or all ids are in use
+ */
+int h264_ps_remap(h264_ps_remapper_t* r, int input, const uint8_t* nal, int size, h264_nal_span_t* out)
+{
+    h264_ps_remap_input_t* in = &r->inputs[input];
+    int nal_unit_type = ( size > 0 ) ? ( nal[0] & 0x1F ) : 0;
+    uint32_t values[3];
+    bs_t b;
+
+    out->buf = nal;
+    out->size = size;
+
+    if ( nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_NON_IDR && nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_IDR &&
+         nal_unit_type != NAL_UNIT_TYPE_SPS && nal_unit_type != NAL_UNIT_TYPE_PPS && nal_unit_type != NAL_UNIT_TYPE_SUBSET_SPS ) { return 0; }
+
+    int rbsp_size = size;
+    int nal_size = size;
+    remap_reserve(&r->rbsp, &r->rbsp_capacity, 3 * size + 128);
+    remap_reserve(&r->out, &r->out_capacity, (size + 64) * 3 / 2 + 2);
+
+    if ( nal_unit_type == NAL_UNIT_TYPE_SUBSET_SPS )
+    {
+        // passed through; only its seq_parameter_set_id, after profile_idc, the constraint flags and level_idc, is noted
+        int peek_size = ( size < 16 ) ? size : 16;
+        if ( nal_to_rbsp(nal, &peek_size, r->rbsp, &rbsp_size) < 0 || rbsp_size < 5 ) { return 0; }
+        bs_init(&b, r->rbsp + 4, rbsp_size - 4);
+        int sps_id = bs_read_ue(&b);
+        if ( !bs_overrun(&b) && sps_id <= 31 ) { in->subset_sps[sps_id] = 1; }
+        return 0;
+    }
+
+    if ( nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_NON_IDR || nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_IDR )
+    {
+        // the three exp-Golomb codes up to pic_parameter_set_id are in the first few bytes
+        int peek_size = ( size < 16 ) ? size : 16;
+        if ( nal_to_rbsp(nal, &peek_size, r->rbsp, &rbsp_size) < 0 ) { return -1; }
+        bs_init(&b, r->rbsp + 1, rbsp_size - 1);
+        values[0] = bs_read_ue(&b); // first_mb_in_slice
+        values[1] = bs_read_ue(&b); // slice_type
+        values[2] = bs_read_ue(&b); // pic_parameter_set_id
+        if ( bs_overrun(&b) || values[2] > 255 || in->pps_map[values[2]] < 0 ) { return -1; }
+
+        if ( in->pps_map[values[2]] == (int)values[2] ) { return 0; }
+
+        // the slice header is parsed to find where it ends, and written with the output parameter sets
+        h264_stream_t* h = r->h;
+        if ( read_nal_unit(in->h, (uint8_t*)nal, size) < 0 ) { return -1; }
+        h->nal->nal_ref_idc = in->h->nal->nal_ref_idc;
+        h->nal->nal_unit_type = nal_unit_type;
+        memcpy(h->sh, in->h->sh, sizeof(slice_header_t));
+        memcpy(h->slice_data, in->h->slice_data, sizeof(slice_data_rbsp_t));
+        h->sh->pic_parameter_set_id = in->pps_map[values[2]];
+        int len = write_nal_unit(h, r->out, r->out_capacity);
+        h->slice_data->rbsp_buf = NULL;
+        if ( len <= 1 ) { return -1; }
+
+        // write_nal_unit leaves a zero byte before the NAL
+        out->buf = r->out + 1;
+        out->size = len - 1;
+        r->remapped_slices++;
+        return 0;
+    }
+
+    if ( nal_to_rbsp(nal, &nal_size, r->rbsp, &rbsp_size) < 0 ) { return -1; }
+    int stop = remap_stop_bit(r->rbsp, rbsp_size);
+
+    if ( nal_unit_type == NAL_UNIT_TYPE_SPS )
+    {
+        // seq_parameter_set_id follows profile_idc, the constraint flags and level_idc
+        if ( rbsp_size < 5 ) { return -1; }
+        bs_init(&b, r->rbsp + 4, rbsp_size - 4);
+        int sps_id = bs_read_ue(&b);
+        int tail = 32 + bs_bit_pos(&b);
+        if ( bs_overrun(&b) || sps_id > 31 || stop < tail ) { return -1; }
+
+        int id = remap_ps(r, r->sps, 32, r->rbsp, rbsp_size, 4, values, 1, tail, stop);
+        if ( id < 0 || read_nal_unit(in->h, (uint8_t*)nal, size) < 0 ) { return -1; }
+        if ( in->sps_map[sps_id] != id )
+        {
+            // the PPSs which refer to the SPS it replaces have to come again
+            for ( int i = 0; i < 256; i++ ) { if ( in->pps_sps[i] == sps_id ) { in->pps_map[i] = -1; } }
+            in->sps_map[sps_id] = id;
+        }
+        out->buf = r->sps[id].nal;
+        out->size = r->sps[id].nal_size;
+    }
+    else
+    {
+        bs_init(&b, r->rbsp + 1, rbsp_size - 1);
+        int pps_id = bs_read_ue(&b);
+        int sps_id = bs_read_ue(&b);
+        int tail = 8 + bs_bit_pos(&b);
+        if ( bs_overrun(&b) || pps_id > 255 || sps_id > 31 || stop < tail ) { return -1; }
+        if ( in->sps_map[sps_id] < 0 && in->subset_sps[sps_id] )
+        {
+            // of an SVC or MVC layer, passed through; base layer slices cannot use it
+            in->pps_map[pps_id] = -1;
+            return 0;
+        }
+        if ( in->sps_map[sps_id] < 0 ) { return -1; }
+
+        values[1] = in->sps_map[sps_id];
+        int id = remap_ps(r, r->pps, 256, r->rbsp, rbsp_size, 1, values, 2, tail, stop);
+        if ( id < 0 || read_nal_unit(in->h, (uint8_t*)nal, size) < 0 ) { return -1; }
+        in->pps_map[pps_id] = id;
+        in->pps_sps[pps_id] = sps_id;
+        out->buf = r->pps[id].nal;
+        out->size = r->pps[id].nal_size;
+    }
+    return 0;
+}
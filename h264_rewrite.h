@@ -0,0 +1,135 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _H264_REWRITE_H
+#define _H264_REWRITE_H        1
+
+#include <stdint.h>
+
+#include "h264_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+   Rewrite rules: change the fields of a parameter set as parsed, before it is written again
+*/
+typedef void (*h264_sps_rule_cb)(void* opaque, sps_t* sps);
+typedef void (*h264_pps_rule_cb)(void* opaque, pps_t* pps);
+
+/**
+   A parameter set NAL as it came in, and as rewritten
+*/
+typedef struct
+{
+    uint8_t* in;                  // NULL for an empty entry
+    int in_size;
+    uint8_t* out;                 // in the same allocation as in
+    int out_size;
+} h264_ps_patch_entry_t;
+
+/**
+   Rewriter of the SPS and PPS NALs of an Annex B stream; everything else passes through by reference
+   @see h264_ps_patch
+*/
+typedef struct
+{
+    h264_sps_rule_cb sps_rule;    // NULL leaves SPS NALs as they are
+    h264_pps_rule_cb pps_rule;    // NULL leaves PPS NALs as they are
+    void* opaque;
+    h264_stream_t* h;             // parses the parameter sets
+
+    // by id, the last parameter set rewritten
+    h264_ps_patch_entry_t sps_cache[32];
+    h264_ps_patch_entry_t pps_cache[256];
+    int rewritten;                // number of parameter sets parsed and written, i.e. not found in the cache
+
+    sps_t sps;                    // the parameter set the rules change
+    pps_t pps;
+
+    uint8_t** retired;            // replaced cache entries, which the output may still refer to until the next call
+    int num_retired;
+    int retired_capacity;
+
+    h264_iovec_t* iov;            // output of the last h264_ps_patch
+    int num_iov;
+    int iov_capacity;
+} h264_ps_patcher_t;
+
+/**
+   A parameter set as output by the remapper
+*/
+typedef struct
+{
+    uint32_t hash;                // of key
+    uint8_t* key;                 // the rbsp with the id of the parameter set itself 0, what identical parameter sets have in common; NULL for an unused id
+    int key_size;
+    uint8_t* nal;                 // with the output id, in the same allocation as key
+    int nal_size;
+} h264_ps_remap_entry_t;
+
+/**
+   The ids of the parameter sets of one input, in the output
+*/
+typedef struct
+{
+    int sps_map[32];              // -1 for an SPS not seen yet
+    int pps_map[256];             // -1 for a PPS not seen yet, or whose SPS changed since
+    int pps_sps[256];             // the input SPS id each PPS refers to
+    int subset_sps[32];           // subset SPS ids seen; PPSs which refer to one of them and no SPS are passed through
+    h264_stream_t* h;             // parses the input, for the slice headers
+} h264_ps_remap_input_t;
+
+/**
+   Remapper of the parameter set ids of several inputs into one id space, e.g. to splice streams whose ids collide.
+   Only the ids are changed: parameter sets are copied bit for bit after their ids, slices get their header written again and
+   their slice data re-attached as it is.  Identical parameter sets get the same output id, and an output id is reused once no
+   input maps to it any more.
+   @see h264_ps_remap
+*/
+typedef struct
+{
+    h264_ps_remap_input_t* inputs;
+    int num_inputs;
+
+    // by output id
+    h264_ps_remap_entry_t sps[32];
+    h264_ps_remap_entry_t pps[256];
+    h264_stream_t* h;             // the output parameter sets, parsed into its sps_table and pps_table; writes the slices
+    int remapped_slices;          // slices whose pic_parameter_set_id changed
+
+    uint8_t* rbsp;                // the NAL being remapped
+    int rbsp_capacity;
+    uint8_t* out;                 // the output of the last h264_ps_remap, if it is not the input or a parameter set
+    int out_capacity;
+} h264_ps_remapper_t;
+
+h264_ps_patcher_t* h264_ps_patcher_new(h264_sps_rule_cb sps_rule, h264_pps_rule_cb pps_rule, void* opaque);
+void h264_ps_patcher_free(h264_ps_patcher_t* p);
+int h264_ps_patch(h264_ps_patcher_t* p, const uint8_t* buf, int size, int end_of_stream);
+
+h264_ps_remapper_t* h264_ps_remapper_new(int num_inputs);
+void h264_ps_remapper_free(h264_ps_remapper_t* r);
+int h264_ps_remap(h264_ps_remapper_t* r, int input, const uint8_t* nal, int size, h264_nal_span_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+// Checks of h264_ps_patch: each input file is passed through in pieces of 1, 7 and 4096 bytes and in one piece, with rules
+// which change nothing, and has to come out byte for byte as it went in; then with a rule which adds timing information to
+// the VUI of every SPS, after which every SPS has to read back with it and all other NALs have to be unchanged.
+
+#include "h264_stream.h"
+#include "h264_rewrite.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+static void same_sps(void* opaque, sps_t* sps) { }
+static void same_pps(void* opaque, pps_t* pps) { }
+
+static void set_timing(void* opaque, sps_t* sps)
+{
+    sps->vui_parameters_present_flag = 1;
+    sps->vui.timing_info_present_flag = 1;
+    sps->vui.num_units_in_tick = 1001;
+    sps->vui.time_scale = 60000;
+    sps->vui.fixed_frame_rate_flag = 1;
+}
+
+// the input through the patcher, chunk_size bytes at a time (all at once if 0); NULL if it failed
+static uint8_t* patch(h264_ps_patcher_t* p, const uint8_t* buf, int size, int chunk_size, int* out_size)
+{
+    uint8_t* out = (uint8_t*)malloc(2 * size + 4096);
+    uint8_t* pending = (uint8_t*)malloc(size);
+    int pending_size = 0;
+    int pos = 0;
+    *out_size = 0;
+
+    while (pos < size || pending_size > 0)
+    {
+        int n = (chunk_size > 0 && size - pos > chunk_size) ? chunk_size : size - pos;
+        memcpy(pending + pending_size, buf + pos, n);
+        pending_size += n;
+        pos += n;
+        int end_of_stream = (pos == size);
+
+        int used = h264_ps_patch(p, pending, pending_size, end_of_stream);
+        if (used < 0) { free(pending); free(out); return NULL; }
+        for (int i = 0; i < p->num_iov; i++)
+        {
+            if (*out_size + p->iov[i].len > 2 * size + 4096) { free(pending); free(out); return NULL; }
+            memcpy(out + *out_size, p->iov[i].base, p->iov[i].len);
+            *out_size += p->iov[i].len;
+        }
+        memmove(pending, pending + used, pending_size - used);
+        pending_size -= used;
+        if (end_of_stream && pending_size > 0) { free(pending); free(out); return NULL; }
+    }
+
+    free(pending);
+    return out;
+}
+
+static int check_vui(const char* name, const uint8_t* buf, int size, const uint8_t* out, int out_size)
+{
+    h264_stream_t* h = h264_new();
+    h264_nal_iter_t it, out_it;
+    h264_nal_span_t nal, out_nal;
+    int num_sps = 0;
+    int failures = 0;
+
+    h264_nal_iter_init(&it, buf, size, 0);
+    h264_nal_iter_init(&out_it, out, out_size, 0);
+    while (h264_nal_iter_next(&it, &nal) != 0)
+    {
+        if (h264_nal_iter_next(&out_it, &out_nal) == 0) { printf("%s: NALs missing from the output \n", name); failures++; break; }
+        if (nal.size > 0 && (nal.buf[0] & 0x1F) == NAL_UNIT_TYPE_SPS)
+        {
+            num_sps++;
+            if (read_nal_unit(h, (uint8_t*)out_nal.buf, out_nal.size) < 0 || !h->sps->vui_parameters_present_flag ||
+                !h->sps->vui.timing_info_present_flag || h->sps->vui.num_units_in_tick != 1001 || h->sps->vui.time_scale != 60000 ||
+                !h->sps->vui.fixed_frame_rate_flag)
+            {
+                printf("%s: SPS without the timing information of the rule \n", name);
+                failures++;
+            }
+        }
+        else if (out_nal.size != nal.size || memcmp(out_nal.buf, nal.buf, nal.size) != 0)
+        {
+            printf("%s: NAL of type %d changed by an SPS rule \n", name, (nal.size > 0) ? nal.buf[0] & 0x1F : -1);
+            failures++;
+        }
+    }
+    if (num_sps == 0) { printf("%s: no SPS \n", name); failures++; }
+
+    h264_free(h);
+    return failures;
+}
+
+static int check_file(const char* name)
+{
+    FILE* f = fopen(name, "rb");
+    if (f == NULL) { fprintf( stderr, "!! Error: could not open file: %s: %s \n", name, strerror(errno)); return 1; }
+    fseek(f, 0, SEEK_END);
+    int size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = (uint8_t*)malloc(size);
+    if (fread(buf, 1, size, f) != (size_t)size) { fprintf( stderr, "!! Error: read failed: %s \n", name); fclose(f); free(buf); return 1; }
+    fclose(f);
+
+    static const int chunk_sizes[] = { 1, 7, 4096, 0 };
+    int failures = 0;
+    int out_size;
+    uint8_t* out;
+
+    for (int i = 0; i < (int)(sizeof(chunk_sizes) / sizeof(chunk_sizes[0])); i++)
+    {
+        h264_ps_patcher_t* p = h264_ps_patcher_new(same_sps, same_pps, NULL);
+        out = patch(p, buf, size, chunk_sizes[i], &out_size);
+        if (out == NULL || out_size != size || memcmp(out, buf, size) != 0 || p->rewritten == 0)
+        {
+            printf("%s: not passed through unchanged in pieces of %d bytes \n", name, chunk_sizes[i]);
+            failures++;
+        }
+        free(out);
+        h264_ps_patcher_free(p);
+    }
+
+    h264_ps_patcher_t* p = h264_ps_patcher_new(set_timing, NULL, NULL);
+    out = patch(p, buf, size, 7, &out_size);
+    if (out == NULL) { printf("%s: SPS rule failed \n", name); failures++; }
+    else { failures += check_vui(name, buf, size, out, out_size); }
+    free(out);
+    h264_ps_patcher_free(p);
+
+    free(buf);
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    int failures = 0;
+
+    for (int i = 1; i < argc; i++) { failures += check_file(argv[i]); }
+
+    printf("parameter sets patched in %d files, mismatches: %d\n", argc - 1, failures);
+    return (failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,508 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "h264_stream.h"
+#include "h264_rtp.h"
+
+// RFC 3550 A.1: a larger jump forward, or back beyond MAX_MISORDER, is taken as the sender restarting
+#define MAX_DROPOUT 3000
+#define MAX_MISORDER 100
+
+/**
+ Create an RTP packetizer.
+ @param[in]  mtu              maximum size of a packet, RTP header included
+ @param[in]  payload_type     RTP payload type, usually dynamic (96-127)
+ @param[in]  ssrc             RTP synchronization source
+ @param[in]  sequence_number  of the first packet
+ */
+h264_rtp_packetizer_t* h264_rtp_packetizer_new(int mtu, int payload_type, uint32_t ssrc, uint16_t sequence_number)
+{
+    h264_rtp_packetizer_t* r = (h264_rtp_packetizer_t*)calloc(1, sizeof(h264_rtp_packetizer_t));
+    r->mtu = mtu;
+    r->payload_type = payload_type;
+    r->ssrc = ssrc;
+    r->sequence_number = sequence_number;
+    return r;
+}
+
+void h264_rtp_packetizer_free(h264_rtp_packetizer_t* r)
+{
+    if ( r == NULL ) { return; }
+    free(r->packets);
+    free(r->iov);
+    free(r->sizes);
+    free(r);
+}
+
+static h264_rtp_packet_t* rtp_add_packet(h264_rtp_packetizer_t* r, uint32_t timestamp)
+{
+    if ( r->num_packets == r->packets_capacity )
+    {
+        r->packets_capacity = ( r->packets_capacity > 0 ) ? r->packets_capacity * 2 : 64;
+        r->packets = (h264_rtp_packet_t*)realloc(r->packets, r->packets_capacity * sizeof(h264_rtp_packet_t));
+    }
+    h264_rtp_packet_t* pkt = &r->packets[r->num_packets++];
+    uint8_t* p = pkt->header;
+    uint16_t seq = r->sequence_number++;
+    p[0] = 0x80; // version 2, no padding, extension or CSRCs
+    p[1] = r->payload_type & 0x7F;
+    p[2] = seq >> 8;
+    p[3] = seq;
+    p[4] = timestamp >> 24;
+    p[5] = timestamp >> 16;
+    p[6] = timestamp >> 8;
+    p[7] = timestamp;
+    p[8] = r->ssrc >> 24;
+    p[9] = r->ssrc >> 16;
+    p[10] = r->ssrc >> 8;
+    p[11] = r->ssrc;
+    pkt->header_size = H264_RTP_HEADER_SIZE;
+    pkt->iov_start = r->num_iov;
+    pkt->num_iov = 0;
+    pkt->size = H264_RTP_HEADER_SIZE;
+    return pkt;
+}
+
+static void rtp_add_iov(h264_rtp_packetizer_t* r, h264_rtp_packet_t* pkt, const uint8_t* base, int len)
+{
+    if ( r->num_iov == r->iov_capacity )
+    {
+        r->iov_capacity = ( r->iov_capacity > 0 ) ? r->iov_capacity * 2 : 64;
+        r->iov = (h264_iovec_t*)realloc(r->iov, r->iov_capacity * sizeof(h264_iovec_t));
+    }
+    r->iov[r->num_iov].base = base;
+    r->iov[r->num_iov].len = len;
+    r->num_iov++;
+    pkt->num_iov++;
+    pkt->size += len;
+}
+
+/**
+ Packetize NAL units.
+ NALs which fit in a packet go in one by one, or together in a STAP-A when the next ones fit too (typically SPS, PPS and SEI);
+ larger NALs are split into FU-A packets.  The payload is not copied: r->packets[0 .. r->num_packets - 1] have their headers
+ in place and refer to the NAL bytes, which must stay valid as long as the packets are used, until the next call.
+ @param[in]  r          the packetizer
+ @param[in]  nals       NAL units, without start codes or length prefixes
+ @param[in]  num_nals   number of NAL units
+ @param[in]  timestamp  RTP timestamp (90 kHz) of the access unit the NALs belong to
+ @param[in]  end_of_au  whether the last NAL ends the access unit, which sets the marker bit of the last packet
+ @return     number of packets, or -1 if the MTU is too small for any payload
+ */
+int h264_rtp_packetize(h264_rtp_packetizer_t* r, const h264_nal_span_t* nals, int num_nals, uint32_t timestamp, int end_of_au)
+{
+    int max_payload = r->mtu - H264_RTP_HEADER_SIZE;
+    r->num_packets = 0;
+    r->num_iov = 0;
+    if ( max_payload < 3 ) { return -1; }
+
+    // the sizes are all written before the iovecs point at them, so allocate them in advance
+    if ( r->sizes_capacity < num_nals * 2 )
+    {
+        r->sizes_capacity = num_nals * 2;
+        r->sizes = (uint8_t*)realloc(r->sizes, r->sizes_capacity);
+    }
+    uint8_t* sizes = r->sizes;
+
+    int i = 0;
+    while ( i < num_nals )
+    {
+        const uint8_t* nal = nals[i].buf;
+        int size = nals[i].size;
+        if ( size < 1 ) { i++; continue; }
+
+        if ( size > max_payload )
+        {
+            // FU-A: the NAL header goes into the FU indicator and FU header, the rest is split
+            const uint8_t* p = nal + 1;
+            const uint8_t* end = nal + size;
+            int start = 1;
+            while ( p < end )
+            {
+                int len = ( end - p < max_payload - 2 ) ? (int)( end - p ) : max_payload - 2;
+                h264_rtp_packet_t* pkt = rtp_add_packet(r, timestamp);
+                pkt->header[pkt->header_size++] = ( nal[0] & 0xE0 ) | H264_RTP_FU_A;
+                pkt->header[pkt->header_size++] = ( start ? 0x80 : 0 ) | ( p + len == end ? 0x40 : 0 ) | ( nal[0] & 0x1F );
+                pkt->size += 2;
+                rtp_add_iov(r, pkt, p, len);
+                p += len;
+                start = 0;
+            }
+            i++;
+            continue;
+        }
+
+        // as many of the following NALs as fit with it in a STAP-A
+        int n = 1;
+        int stap_size = 1 + 2 + size;
+        while ( i + n < num_nals && stap_size + 2 + nals[i + n].size <= max_payload )
+        {
+            if ( nals[i + n].size < 1 ) { break; }
+            stap_size += 2 + nals[i + n].size;
+            n++;
+        }
+
+        h264_rtp_packet_t* pkt = rtp_add_packet(r, timestamp);
+        if ( n == 1 )
+        {
+            rtp_add_iov(r, pkt, nal, size);
+            i++;
+            continue;
+        }
+
+        // STAP-A: F is set if any NAL has it, NRI is the highest
+        uint8_t f = 0;
+        uint8_t nri = 0;
+        for ( int j = i; j < i + n; j++ )
+        {
+            f |= nals[j].buf[0] & 0x80;
+            if ( ( nals[j].buf[0] & 0x60 ) > nri ) { nri = nals[j].buf[0] & 0x60; }
+        }
+        pkt->header[pkt->header_size++] = f | nri | H264_RTP_STAP_A;
+        pkt->size += 1;
+        for ( int j = i; j < i + n; j++ )
+        {
+            sizes[0] = nals[j].size >> 8;
+            sizes[1] = nals[j].size;
+            rtp_add_iov(r, pkt, sizes, 2);
+            rtp_add_iov(r, pkt, nals[j].buf, nals[j].size);
+            sizes += 2;
+        }
+        i += n;
+    }
+
+    if ( end_of_au && r->num_packets > 0 ) { r->packets[r->num_packets - 1].header[1] |= 0x80; }
+    return r->num_packets;
+}
+
+/**
+ Create an RTP depacketizer.
+ @param[in]  window           number of packets to hold back for reordering; a missing packet is given up on when that many follow it
+ @param[in]  max_packet_size  larger packets are dropped
+ @param[in]  au_cb            receives the access units
+ @param[in]  opaque           passed to au_cb
+ */
+h264_rtp_depacketizer_t* h264_rtp_depacketizer_new(int window, int max_packet_size, h264_rtp_au_cb au_cb, void* opaque)
+{
+    h264_rtp_depacketizer_t* d = (h264_rtp_depacketizer_t*)calloc(1, sizeof(h264_rtp_depacketizer_t));
+    if ( window < 1 ) { window = 1; }
+    d->window = window;
+    d->max_packet_size = max_packet_size;
+    d->pool = (uint8_t*)malloc((size_t)window * max_packet_size);
+    d->slot_size = (int*)malloc(window * sizeof(int));
+    d->slot_seq = (uint16_t*)calloc(window, sizeof(uint16_t));
+    for ( int i = 0; i < window; i++ ) { d->slot_size[i] = -1; }
+    d->bad_seq = -1;
+    d->au_cb = au_cb;
+    d->opaque = opaque;
+    return d;
+}
+
+void h264_rtp_depacketizer_free(h264_rtp_depacketizer_t* d)
+{
+    if ( d == NULL ) { return; }
+    free(d->pool);
+    free(d->slot_size);
+    free(d->slot_seq);
+    free(d->buf);
+    free(d->nal_offsets);
+    free(d->nals);
+    free(d);
+}
+
+// drop a fragmented NAL which cannot be completed
+static void rtp_drop_fu(h264_rtp_depacketizer_t* d)
+{
+    if ( !d->in_fu ) { return; }
+    d->num_nals--;
+    d->buf_size = d->nal_offsets[d->num_nals];
+    d->in_fu = 0;
+    d->flags |= H264_RTP_AU_INCOMPLETE;
+}
+
+static void rtp_emit_au(h264_rtp_depacketizer_t* d)
+{
+    if ( !d->in_au ) { return; }
+    // the end of the last NAL is missing
+    rtp_drop_fu(d);
+
+    // buf does not move any more, the spans can point into it
+    for ( int i = 0; i < d->num_nals; i++ )
+    {
+        int end = ( i + 1 < d->num_nals ) ? d->nal_offsets[i + 1] : d->buf_size;
+        d->nals[i].buf = d->buf + d->nal_offsets[i];
+        d->nals[i].size = end - d->nal_offsets[i];
+    }
+    d->au_cb(d->opaque, d->nals, d->num_nals, d->timestamp, d->flags);
+
+    d->in_au = 0;
+    d->num_nals = 0;
+    d->buf_size = 0;
+    d->flags = 0;
+}
+
+static void rtp_begin_nal(h264_rtp_depacketizer_t* d)
+{
+    if ( d->num_nals == d->nals_capacity )
+    {
+        d->nals_capacity = ( d->nals_capacity > 0 ) ? d->nals_capacity * 2 : 64;
+        d->nal_offsets = (int*)realloc(d->nal_offsets, d->nals_capacity * sizeof(int));
+        d->nals = (h264_nal_span_t*)realloc(d->nals, d->nals_capacity * sizeof(h264_nal_span_t));
+    }
+    d->nal_offsets[d->num_nals++] = d->buf_size;
+}
+
+static void rtp_append(h264_rtp_depacketizer_t* d, const uint8_t* data, int len)
+{
+    if ( d->buf_size + len > d->buf_capacity )
+    {
+        d->buf_capacity = 2 * ( d->buf_size + len );
+        d->buf = (uint8_t*)realloc(d->buf, d->buf_capacity);
+    }
+    memcpy(d->buf + d->buf_size, data, len);
+    d->buf_size += len;
+}
+
+// use a packet, in sequence
+static void rtp_use_packet(h264_rtp_depacketizer_t* d, const uint8_t* pkt, int size)
+{
+    int csrc_count = pkt[0] & 0x0F;
+    int marker = pkt[1] >> 7;
+    uint32_t timestamp = ( (uint32_t)pkt[4] << 24 ) | ( pkt[5] << 16 ) | ( pkt[6] << 8 ) | pkt[7];
+    const uint8_t* p = pkt + H264_RTP_HEADER_SIZE + 4 * csrc_count;
+    const uint8_t* end = pkt + size;
+    if ( ( pkt[0] & 0x10 ) && end - p >= 4 ) { p += 4 + 4 * ( ( p[2] << 8 ) | p[3] ); } // header extension
+    if ( ( pkt[0] & 0x20 ) && end > p ) { end -= end[-1]; } // padding
+
+    if ( d->in_au && timestamp != d->timestamp )
+    {
+        // ended without its marker: the lost packets may have been its last ones
+        if ( d->lost > 0 ) { d->flags |= H264_RTP_AU_INCOMPLETE; }
+        rtp_emit_au(d);
+    }
+    if ( !d->in_au )
+    {
+        d->in_au = 1;
+        d->timestamp = timestamp;
+    }
+    // a packet lost since the last one was of this access unit, or of the one before if that has ended without its marker
+    if ( d->lost > 0 )
+    {
+        d->flags |= H264_RTP_AU_INCOMPLETE;
+        d->lost = 0;
+        rtp_drop_fu(d);
+    }
+
+    if ( end - p < 1 ) { d->flags |= H264_RTP_AU_INCOMPLETE; return; }
+    int type = p[0] & 0x1F;
+
+    // the end of the fragmented NAL did not come
+    if ( type != H264_RTP_FU_A ) { rtp_drop_fu(d); }
+
+    if ( type >= 1 && type <= 23 )
+    {
+        rtp_begin_nal(d);
+        rtp_append(d, p, end - p);
+    }
+    else if ( type == H264_RTP_STAP_A )
+    {
+        p++;
+        while ( end - p >= 2 )
+        {
+            int len = ( p[0] << 8 ) | p[1];
+            p += 2;
+            if ( len > end - p ) { d->flags |= H264_RTP_AU_INCOMPLETE; break; }
+            if ( len > 0 )
+            {
+                rtp_begin_nal(d);
+                rtp_append(d, p, len);
+            }
+            p += len;
+        }
+    }
+    else if ( type == H264_RTP_FU_A && end - p >= 2 )
+    {
+        uint8_t fu_header = p[1];
+        if ( fu_header & 0x80 )
+        {
+            rtp_drop_fu(d);
+            uint8_t nal_header = ( p[0] & 0xE0 ) | ( fu_header & 0x1F );
+            rtp_begin_nal(d);
+            rtp_append(d, &nal_header, 1);
+            d->in_fu = 1;
+        }
+        if ( d->in_fu )
+        {
+            rtp_append(d, p + 2, end - p - 2);
+            if ( fu_header & 0x40 ) { d->in_fu = 0; }
+        }
+        else
+        {
+            // the start of the fragmented NAL did not come
+            d->flags |= H264_RTP_AU_INCOMPLETE;
+        }
+    }
+    else
+    {
+        // interleaved mode payloads (STAP-B, MTAP, FU-B) are not supported
+        d->flags |= H264_RTP_AU_INCOMPLETE;
+    }
+
+    if ( marker ) { rtp_emit_au(d); }
+}
+
+// use the packets waiting in sequence from next_seq on
+static void rtp_drain(h264_rtp_depacketizer_t* d)
+{
+    while ( 1 )
+    {
+        int slot = d->head;
+        if ( d->slot_size[slot] < 0 || d->slot_seq[slot] != d->next_seq ) { return; }
+        rtp_use_packet(d, d->pool + (size_t)slot * d->max_packet_size, d->slot_size[slot]);
+        d->slot_size[slot] = -1;
+        d->next_seq++;
+        d->head = ( d->head + 1 ) % d->window;
+    }
+}
+
+// give up on the packet at next_seq
+static void rtp_skip(h264_rtp_depacketizer_t* d)
+{
+    d->lost++;
+    d->lost_packets++;
+    d->next_seq++;
+    d->head = ( d->head + 1 ) % d->window;
+    rtp_drain(d);
+}
+
+// use the packets still waiting, giving up on the missing ones
+static void rtp_skip_waiting(h264_rtp_depacketizer_t* d)
+{
+    for ( int i = 0; i < d->window; i++ )
+    {
+        int waiting = 0;
+        for ( int j = 0; j < d->window; j++ ) { if ( d->slot_size[j] >= 0 ) { waiting = 1; } }
+        if ( !waiting ) { break; }
+        rtp_skip(d);
+    }
+}
+
+// start again at seq, as a new stream; what is left of the old one is passed on
+static void rtp_restart(h264_rtp_depacketizer_t* d, uint16_t seq, uint32_t ssrc)
+{
+    if ( d->started )
+    {
+        rtp_skip_waiting(d);
+        rtp_emit_au(d);
+    }
+    d->started = 1;
+    d->ssrc = ssrc;
+    d->next_seq = seq;
+    d->lost = 0;
+    d->bad_seq = -1;
+}
+
+/**
+ Take an RTP packet.
+ Packets are used in sequence number order; the ones which arrive early are copied into the pool to wait for those before them.
+ A packet still missing when window packets after it have arrived is lost: the access unit it was part of is passed on with
+ H264_RTP_AU_INCOMPLETE, and so is the next one if it cannot be told which one the packet was part of.
+ Access units are passed on at their marker bit, or when a packet of the next one arrives.
+ As in RFC 3550 A.1, a jump of MAX_DROPOUT sequence numbers or more is not loss: when the packet after it follows in sequence,
+ the stream starts again there (the packet at the jump is dropped).  A new SSRC starts again at once.
+ @param[in]  d     the depacketizer
+ @param[in]  pkt   the RTP packet, header included
+ @param[in]  size  size of the packet
+ @return     0, or -1 if the packet is not an RTP packet or is larger than max_packet_size, and is dropped
+ */
+int h264_rtp_depacketize(h264_rtp_depacketizer_t* d, const uint8_t* pkt, int size)
+{
+    if ( size < H264_RTP_HEADER_SIZE || ( pkt[0] >> 6 ) != 2 || size < H264_RTP_HEADER_SIZE + 4 * ( pkt[0] & 0x0F ) ) { return -1; }
+    if ( size > d->max_packet_size ) { return -1; }
+
+    uint16_t seq = ( pkt[2] << 8 ) | pkt[3];
+    uint32_t ssrc = ( (uint32_t)pkt[8] << 24 ) | ( pkt[9] << 16 ) | ( pkt[10] << 8 ) | pkt[11];
+    if ( !d->started || ssrc != d->ssrc ) { rtp_restart(d, seq, ssrc); }
+
+    int ahead = (uint16_t)( seq - d->next_seq );
+    if ( ahead >= 65536 - MAX_MISORDER ) { d->late_packets++; return 0; }
+    if ( ahead >= MAX_DROPOUT )
+    {
+        if ( seq != d->bad_seq )
+        {
+            d->bad_seq = ( seq + 1 ) & 0xFFFF;
+            d->late_packets++;
+            return 0;
+        }
+        rtp_restart(d, seq, ssrc);
+        d->lost = 1; // the packet at the jump
+        ahead = 0;
+    }
+    d->bad_seq = -1;
+
+    if ( ahead >= d->window )
+    {
+        // the packets waiting are all before seq; once they are used the rest of the gap is lost at once
+        for ( int i = 0; i < d->window && ahead >= d->window; i++ )
+        {
+            rtp_skip(d);
+            ahead = (uint16_t)( seq - d->next_seq );
+        }
+        if ( ahead >= d->window )
+        {
+            int n = ahead - d->window + 1;
+            d->lost += n;
+            d->lost_packets += n;
+            d->next_seq += n;
+            d->head = ( d->head + n ) % d->window;
+            ahead = d->window - 1;
+        }
+    }
+
+    int slot = ( d->head + ahead ) % d->window;
+    if ( d->slot_size[slot] >= 0 && d->slot_seq[slot] == seq ) { d->late_packets++; return 0; }
+
+    // in sequence: used in place, without a copy
+    if ( ahead == 0 )
+    {
+        rtp_use_packet(d, pkt, size);
+        d->next_seq++;
+        d->head = ( d->head + 1 ) % d->window;
+        rtp_drain(d);
+        return 0;
+    }
+
+    memcpy(d->pool + (size_t)slot * d->max_packet_size, pkt, size);
+    d->slot_size[slot] = size;
+    d->slot_seq[slot] = seq;
+    return 0;
+}
+
+/**
+ Use the packets still waiting, giving up on the missing ones, and pass on the last access unit, at the end of the stream.
+ */
+void h264_rtp_depacketizer_flush(h264_rtp_depacketizer_t* d)
+{
+    rtp_skip_waiting(d);
+    rtp_emit_au(d);
+}
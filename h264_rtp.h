@@ -0,0 +1,131 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _H264_RTP_H
+#define _H264_RTP_H        1
+
+#include <stdint.h>
+
+#include "h264_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define H264_RTP_HEADER_SIZE     12
+
+// NAL unit types of RTP payloads, RFC 6184 5.2
+#define H264_RTP_STAP_A          24
+#define H264_RTP_FU_A            28
+
+/**
+   One RTP packet: the bytes of header, followed by the pieces iov[0 .. num_iov - 1] of the packetizer
+*/
+typedef struct
+{
+    uint8_t header[H264_RTP_HEADER_SIZE + 2]; // RTP header, then the STAP-A NAL header or the FU indicator and FU header
+    int header_size;
+    int iov_start;
+    int num_iov;
+    int size;                     // of the whole packet
+} h264_rtp_packet_t;
+
+/**
+   Packetizer of NAL units into RTP packets, RFC 6184 non-interleaved mode: single NAL unit, STAP-A and FU-A packets
+   @see h264_rtp_packetize
+*/
+typedef struct
+{
+    int mtu;                      // maximum size of a packet, RTP header included
+    int payload_type;
+    uint16_t sequence_number;     // of the next packet
+    uint32_t ssrc;
+
+    h264_rtp_packet_t* packets;   // output of the last h264_rtp_packetize
+    int num_packets;
+    int packets_capacity;
+
+    h264_iovec_t* iov;            // payload of the packets: NAL bytes in place, and the STAP-A NAL sizes
+    int num_iov;
+    int iov_capacity;
+
+    uint8_t* sizes;
+    int sizes_capacity;
+} h264_rtp_packetizer_t;
+
+// flags of h264_rtp_au_cb
+#define H264_RTP_AU_INCOMPLETE   1  // packets of the access unit were lost, or could not be used; NALs may be missing
+
+/**
+   Receives the access units put together by the depacketizer.
+   The NALs are only valid during the call.
+*/
+typedef void (*h264_rtp_au_cb)(void* opaque, const h264_nal_span_t* nals, int num_nals, uint32_t timestamp, int flags);
+
+/**
+   Depacketizer of RTP packets into access units, RFC 6184 non-interleaved mode: single NAL unit, STAP-A and FU-A packets
+   @see h264_rtp_depacketize
+*/
+typedef struct
+{
+    // reordering: packets wait in slots of a pool until the ones before them arrive, or the window is full
+    int window;                   // number of slots
+    int max_packet_size;          // size of a slot
+    uint8_t* pool;
+    int* slot_size;               // -1 for an empty slot
+    uint16_t* slot_seq;
+    uint16_t next_seq;            // sequence number of the next packet to use
+    int head;                     // its slot
+    int started;
+    uint32_t ssrc;                // of the stream being depacketized; another one starts again
+    int bad_seq;                  // after a jump in sequence numbers, the one which confirms the stream restarted, or -1
+    int lost;                     // packets lost since the last packet used
+    int lost_packets;             // in total
+    int late_packets;             // arrived after they were given up on, duplicates, or far out of sequence
+
+    // the access unit being put together: its NALs, one after the other, in buf
+    uint8_t* buf;
+    int buf_size;
+    int buf_capacity;
+    int* nal_offsets;
+    int num_nals;
+    int nals_capacity;
+    h264_nal_span_t* nals;        // passed to the callback
+    int in_au;
+    uint32_t timestamp;
+    int flags;
+    int in_fu;                    // the last NAL is a fragmentation unit still missing its end
+
+    h264_rtp_au_cb au_cb;
+    void* opaque;
+} h264_rtp_depacketizer_t;
+
+h264_rtp_packetizer_t* h264_rtp_packetizer_new(int mtu, int payload_type, uint32_t ssrc, uint16_t sequence_number);
+void h264_rtp_packetizer_free(h264_rtp_packetizer_t* r);
+int h264_rtp_packetize(h264_rtp_packetizer_t* r, const h264_nal_span_t* nals, int num_nals, uint32_t timestamp, int end_of_au);
+
+h264_rtp_depacketizer_t* h264_rtp_depacketizer_new(int window, int max_packet_size, h264_rtp_au_cb au_cb, void* opaque);
+void h264_rtp_depacketizer_free(h264_rtp_depacketizer_t* d);
+int h264_rtp_depacketize(h264_rtp_depacketizer_t* d, const uint8_t* pkt, int size);
+void h264_rtp_depacketizer_flush(h264_rtp_depacketizer_t* d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
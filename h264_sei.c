@@ -42,18 +42,300 @@ sei_t* sei_new()
     return s;
 }
 
-void sei_free(sei_t* s)
+static void sei_scalability_info_free(sei_scalability_info_t* sei_svc)
+{
+    for ( int i = 0; i < sei_svc->pr_capacity; i++ ) { free(sei_svc->pr[i].pr_info); }
+    free(sei_svc->pr);
+    free(sei_svc->layers);
+    free(sei_svc);
+}
+
+/**
+ Prepare a message for reuse: free its payload if it was set by the caller, keep the message's own storage.
+ */
+void sei_reset(sei_t* s)
 {
     switch( s->payloadType ) {
         case SEI_TYPE_SCALABILITY_INFO:
-            if ( s->sei_svc != NULL ) free(s->sei_svc);
+            if ( s->sei_svc != NULL && s->sei_svc != s->svc_buf ) sei_scalability_info_free(s->sei_svc);
             break;
         default:
-            if ( s->data != NULL ) free(s->data);
+            if ( s->data != NULL && s->data != s->data_buf ) free(s->data);
     }
+    s->data = NULL;
+    s->payloadType = 0;
+    s->payloadSize = 0;
+}
+
+void sei_free(sei_t* s)
+{
+    sei_reset(s);
+    if ( s->svc_buf != NULL ) sei_scalability_info_free(s->svc_buf);
+    free(s->data_buf);
     free(s);
 }
 
+// grow an array to hold at least n elements; new elements are zeroed
+static void* sei_reserve(void* p, int* capacity, int n, size_t elem_size)
+{
+    if ( n <= *capacity ) { return p; }
+    int new_capacity = (*capacity * 2 > n) ? *capacity * 2 : n;
+    p = realloc(p, new_capacity * elem_size);
+    memset((uint8_t*)p + *capacity * elem_size, 0, (new_capacity - *capacity) * elem_size);
+    *capacity = new_capacity;
+    return p;
+}
+
+/**
+ Get a buffer of at least size bytes for the payload of a message, reusing the message's own storage.
+ */
+uint8_t* sei_reserve_data(sei_t* s, int size)
+{
+    s->data_buf = (uint8_t*)sei_reserve(s->data_buf, &s->data_buf_size, (size > 0 ? size : 1), 1);
+    return s->data_buf;
+}
+
+/**
+ Get a cleared scalability information structure for a message, reusing the message's own storage.
+ */
+sei_scalability_info_t* sei_reserve_svc(sei_t* s)
+{
+    sei_scalability_info_t* sei_svc = s->svc_buf;
+    if ( sei_svc == NULL )
+    {
+        sei_svc = s->svc_buf = (sei_scalability_info_t*)calloc(1, sizeof(sei_scalability_info_t));
+    }
+    sei_svc->temporal_id_nesting_flag = 0;
+    sei_svc->priority_layer_info_present_flag = 0;
+    sei_svc->priority_id_setting_flag = 0;
+    sei_svc->num_layers_minus1 = 0;
+    sei_svc->pr_num_dIds_minus1 = 0;
+    return sei_svc;
+}
+
+/**
+ Make room for num_layers entries in sei_svc->layers, and clear them.
+ */
+void sei_scalability_info_reserve_layers(sei_scalability_info_t* sei_svc, int num_layers)
+{
+    sei_svc->layers = (sei_scalability_layer_info_t*)sei_reserve(sei_svc->layers, &sei_svc->layers_capacity, num_layers, sizeof(sei_scalability_layer_info_t));
+    memset(sei_svc->layers, 0, num_layers * sizeof(sei_scalability_layer_info_t));
+}
+
+/**
+ Make room for num_pr entries in sei_svc->pr, and clear them (keeping their pr_info storage).
+ */
+void sei_scalability_info_reserve_pr(sei_scalability_info_t* sei_svc, int num_pr)
+{
+    sei_svc->pr = (sei_scalability_pr_t*)sei_reserve(sei_svc->pr, &sei_svc->pr_capacity, num_pr, sizeof(sei_scalability_pr_t));
+    for ( int i = 0; i < num_pr; i++ )
+    {
+        sei_svc->pr[i].pr_dependency_id = 0;
+        sei_svc->pr[i].pr_num_minus1 = 0;
+        memset(sei_svc->pr[i].priority_id_setting_uri, 0, MAX_LENGTH);
+    }
+}
+
+/**
+ Make room for num_pr_info entries in pr->pr_info, and clear them.
+ */
+void sei_scalability_pr_reserve_pr_info(sei_scalability_pr_t* pr, int num_pr_info)
+{
+    pr->pr_info = (sei_scalability_pr_info_t*)sei_reserve(pr->pr_info, &pr->pr_info_capacity, num_pr_info, sizeof(sei_scalability_pr_info_t));
+    memset(pr->pr_info, 0, num_pr_info * sizeof(sei_scalability_pr_info_t));
+}
+
+// reads the bytes of an escaped nal (with emulation prevention bytes), as the unescaped rbsp bytes
+typedef struct
+{
+    const uint8_t* p;
+    const uint8_t* end;
+    int zeros;      // number of consecutive 0x00 bytes just read, up to 2
+    int epb;        // number of emulation prevention bytes skipped
+} sei_cursor_t;
+
+static int sei_cursor_byte(sei_cursor_t* c)
+{
+    if ( c->p < c->end && c->zeros >= 2 && *c->p == 0x03 ) { c->p++; c->zeros = 0; c->epb++; }
+    if ( c->p >= c->end ) { return -1; }
+    int v = *c->p++;
+    c->zeros = ( v == 0 ) ? ( c->zeros < 2 ? c->zeros + 1 : 2 ) : 0;
+    return v;
+}
+
+// skip n rbsp bytes; runs without an 0x03 byte are skipped at once
+static void sei_cursor_skip(sei_cursor_t* c, int n)
+{
+    while ( n > 0 && c->p < c->end )
+    {
+        int avail = ( c->end - c->p < n ) ? (int)( c->end - c->p ) : n;
+        const uint8_t* q = (const uint8_t*)memchr(c->p, 0x03, avail);
+        int k = ( q == NULL ) ? avail : (int)( q - c->p );
+        if ( k > 0 )
+        {
+            int z = 0;
+            while ( z < k && z < 2 && c->p[k - 1 - z] == 0 ) { z++; }
+            c->zeros = ( z == k ) ? ( c->zeros + z < 2 ? c->zeros + z : 2 ) : z;
+            c->p += k;
+            n -= k;
+        }
+        if ( q != NULL && n > 0 ) { sei_cursor_byte(c); n--; }
+    }
+}
+
+static int sei_cursor_ff_coded_number(sei_cursor_t* c)
+{
+    int n = 0;
+    int v;
+    do
+    {
+        v = sei_cursor_byte(c);
+        if ( v < 0 ) { return -1; }
+        n += v;
+    } while ( v == 0xFF );
+    return n;
+}
+
+/**
+ Check if a SEI payload passes a filter.
+ @param[in]  filter       the filter, NULL passes everything
+ @param[in]  payloadType  type of the payload
+ @param[in]  uuid         first 16 bytes of the payload, only used for user_data_unregistered; NULL if not available
+ @return     1 if the payload passes, 0 if not
+ */
+int sei_filter_accepts(const sei_filter_t* filter, int payloadType, const uint8_t* uuid)
+{
+    if ( filter == NULL ) { return 1; }
+
+    int i;
+    for ( i = 0; i < filter->num_types; i++ ) { if ( filter->types[i] == payloadType ) { break; } }
+    if ( filter->num_types > 0 && i == filter->num_types ) { return 0; }
+
+    if ( payloadType == SEI_TYPE_USER_DATA_UNREGISTERED && filter->num_uuids > 0 )
+    {
+        if ( uuid == NULL ) { return 0; }
+        for ( i = 0; i < filter->num_uuids; i++ ) { if ( memcmp(uuid, filter->uuids + 16 * i, 16) == 0 ) { return 1; } }
+        return 0;
+    }
+    return 1;
+}
+
+static int sei_filter_match(const sei_filter_t* filter, int payloadType, const sei_cursor_t* c)
+{
+    uint8_t uuid[16];
+    int have_uuid = 0;
+    if ( filter != NULL && payloadType == SEI_TYPE_USER_DATA_UNREGISTERED && filter->num_uuids > 0 )
+    {
+        sei_cursor_t tmp = *c;
+        for ( have_uuid = 0; have_uuid < 16; have_uuid++ )
+        {
+            int v = sei_cursor_byte(&tmp);
+            if ( v < 0 ) { break; }
+            uuid[have_uuid] = v;
+        }
+    }
+    return sei_filter_accepts(filter, payloadType, ( have_uuid == 16 ) ? uuid : NULL);
+}
+
+/**
+ Find SEI payloads in a SEI NAL without parsing, allocating or unescaping the rest of it.
+ Payloads which do not pass the filter are skipped by their size.  A returned payload points into the nal itself,
+ unless it contains emulation prevention bytes; then it is unescaped into scratch.
+ @param[in]  nal           the SEI NAL, starting with the NAL header byte
+ @param[in]  nal_size      size of the nal
+ @param[in]  filter        payload types (and uuids of user_data_unregistered) to return, NULL for all
+ @param[out] views         the payloads found
+ @param[in]  max_views     size of views
+ @param[in]  scratch       buffer for payloads which have to be unescaped, may be NULL
+ @param[in]  scratch_size  size of scratch
+ @return     number of payloads found, which may be more than max_views (only max_views are filled in), or -1 if this is not a SEI NAL.
+             A payload which did not fit into scratch is returned with data NULL.
+ */
+int sei_find_payloads(const uint8_t* nal, int nal_size, const sei_filter_t* filter, sei_view_t* views, int max_views, uint8_t* scratch, int scratch_size)
+{
+    if ( nal_size < 1 || ( nal[0] & 0x1F ) != NAL_UNIT_TYPE_SEI ) { return -1; }
+
+    sei_cursor_t c;
+    c.p = nal + 1;
+    c.end = nal + nal_size;
+    c.zeros = 0;
+    c.epb = 0;
+
+    int found = 0;
+    int scratch_used = 0;
+
+    // a message takes at least 2 bytes, the last byte is the rbsp trailing bits
+    while ( c.end - c.p >= 2 )
+    {
+        int payloadType = sei_cursor_ff_coded_number(&c);
+        int payloadSize = sei_cursor_ff_coded_number(&c);
+        if ( payloadType < 0 || payloadSize < 0 ) { break; }
+
+        if ( !sei_filter_match(filter, payloadType, &c) )
+        {
+            sei_cursor_skip(&c, payloadSize);
+            continue;
+        }
+
+        sei_cursor_t start = c;
+        sei_cursor_skip(&c, payloadSize);
+        if ( found < max_views )
+        {
+            sei_view_t* v = &views[found];
+            v->payloadType = payloadType;
+            v->payloadSize = payloadSize;
+            if ( c.epb == start.epb && !( start.zeros >= 2 && start.p < start.end && *start.p == 0x03 ) )
+            {
+                v->data = start.p;
+                if ( c.p - start.p < payloadSize ) { v->payloadSize = c.p - start.p; } // truncated nal
+            }
+            else if ( scratch != NULL && scratch_size - scratch_used >= payloadSize )
+            {
+                int i;
+                for ( i = 0; i < payloadSize; i++ )
+                {
+                    int b = sei_cursor_byte(&start);
+                    if ( b < 0 ) { break; }
+                    scratch[scratch_used + i] = b;
+                }
+                v->data = scratch + scratch_used;
+                v->payloadSize = i;
+                scratch_used += i;
+            }
+            else
+            {
+                v->data = NULL;
+            }
+        }
+        found++;
+    }
+
+    return found;
+}
+
+/**
+ Size of a SEI payload when written.  Raw payloads are their payloadSize, parsed payloads are sized with a dry run of the writer
+ (which uses the parameter sets of h, as writing does).
+ */
+int sei_payload_size(h264_stream_t* h, sei_t* s)
+{
+    int t = s->payloadType;
+    if( t != SEI_TYPE_BUFFERING_PERIOD && t != SEI_TYPE_PIC_TIMING && t != SEI_TYPE_RECOVERY_POINT && t != SEI_TYPE_SCALABILITY_INFO )
+    {
+        return s->payloadSize;
+    }
+
+    // writes past the end of a bitstream only advance the position
+    uint8_t tmp[1];
+    bs_t b;
+    bs_init(&b, tmp, 0);
+    sei_t* sei = h->sei;
+    h->sei = s;
+    write_sei_payload(h, &b);
+    h->sei = sei;
+    return b.p - b.start;
+}
+
 void read_sei_end_bits(h264_stream_t* h, bs_t* b )
 {
     // if the message doesn't end at a byte border
@@ -72,6 +354,9 @@ void read_sei_end_bits(h264_stream_t* h, bs_t* b )
 
 
 void read_sei_scalability_info( h264_stream_t* h, bs_t* b );
+void read_sei_buffering_period( h264_stream_t* h, bs_t* b );
+void read_sei_pic_timing( h264_stream_t* h, bs_t* b );
+void read_sei_recovery_point( h264_stream_t* h, bs_t* b );
 void read_sei_payload( h264_stream_t* h, bs_t* b );
 
 
@@ -84,6 +369,10 @@ void read_sei_scalability_info( h264_stream_t* h, bs_t* b )
     sei_svc->priority_layer_info_present_flag = bs_read_u1(b);
     sei_svc->priority_id_setting_flag = bs_read_u1(b);
     sei_svc->num_layers_minus1 = bs_read_ue(b);
+    if( 1 )
+    {
+        sei_scalability_info_reserve_layers( sei_svc, sei_svc->num_layers_minus1 + 1 );
+    }
     
     for( int i = 0; i <= sei_svc->num_layers_minus1; i++ ) {
         sei_svc->layers[i].layer_id = bs_read_ue(b);
@@ -231,10 +520,18 @@ void read_sei_scalability_info( h264_stream_t* h, bs_t* b )
     if( sei_svc->priority_layer_info_present_flag )
     {
         sei_svc->pr_num_dIds_minus1 = bs_read_ue(b);
+        if( 1 )
+        {
+            sei_scalability_info_reserve_pr( sei_svc, sei_svc->pr_num_dIds_minus1 + 1 );
+        }
         
         for( int i = 0; i <= sei_svc->pr_num_dIds_minus1; i++ ) {
             sei_svc->pr[i].pr_dependency_id = bs_read_u(b, 3);
             sei_svc->pr[i].pr_num_minus1 = bs_read_ue(b);
+            if( 1 )
+            {
+                sei_scalability_pr_reserve_pr_info( &sei_svc->pr[i], sei_svc->pr[i].pr_num_minus1 + 1 );
+            }
             for( int j = 0; j <= sei_svc->pr[i].pr_num_minus1; j++ )
             {
                 sei_svc->pr[i].pr_info[j].pr_id = bs_read_ue(b);
@@ -248,29 +545,176 @@ void read_sei_scalability_info( h264_stream_t* h, bs_t* b )
 
 }
 
+// D.1.1 Buffering period SEI message syntax
+void read_sei_buffering_period( h264_stream_t* h, bs_t* b )
+{
+    sei_buffering_t* bp = &h->sei->bp;
+
+    bp->seq_parameter_set_id = bs_read_ue(b);
+
+    sps_t* sps = h->sps_table[ bp->seq_parameter_set_id & 0x1F ];
+    if( sps->vui.nal_hrd_parameters_present_flag )
+    {
+        for( int SchedSelIdx = 0; SchedSelIdx <= sps->hrd_nal.cpb_cnt_minus1 && SchedSelIdx < 32; SchedSelIdx++ )
+        {
+            bp->nal[SchedSelIdx].initial_cpb_removal_delay = bs_read_u(b, sps->hrd_nal.initial_cpb_removal_delay_length_minus1 + 1);
+            bp->nal[SchedSelIdx].initial_cpb_removal_delay_offset = bs_read_u(b, sps->hrd_nal.initial_cpb_removal_delay_length_minus1 + 1);
+        }
+    }
+    if( sps->vui.vcl_hrd_parameters_present_flag )
+    {
+        for( int SchedSelIdx = 0; SchedSelIdx <= sps->hrd_vcl.cpb_cnt_minus1 && SchedSelIdx < 32; SchedSelIdx++ )
+        {
+            bp->vcl[SchedSelIdx].initial_cpb_removal_delay = bs_read_u(b, sps->hrd_vcl.initial_cpb_removal_delay_length_minus1 + 1);
+            bp->vcl[SchedSelIdx].initial_cpb_removal_delay_offset = bs_read_u(b, sps->hrd_vcl.initial_cpb_removal_delay_length_minus1 + 1);
+        }
+    }
+}
+
+// D.1.2 Picture timing SEI message syntax
+void read_sei_pic_timing( h264_stream_t* h, bs_t* b )
+{
+    // Table D-1, NumClockTS by pic_struct
+    static const int num_clock_ts_table[16] = { 1, 1, 1, 2, 2, 3, 3, 2, 3, 0, 0, 0, 0, 0, 0, 0 };
+    sei_picture_timing_t* pt = &h->sei->pt;
+    sps_t* sps = h->sps;
+    // the lengths come from the nal hrd parameters if present, else from the vcl ones (they must be equal if both are present)
+    hrd_t* hrd = sps->vui.nal_hrd_parameters_present_flag ? &sps->hrd_nal : &sps->hrd_vcl;
+    // without hrd parameters time_offset_length is inferred to be 24 (E.2.2)
+    int time_offset_length = ( sps->vui.nal_hrd_parameters_present_flag || sps->vui.vcl_hrd_parameters_present_flag ) ? hrd->time_offset_length : 24;
+
+    if( sps->vui.nal_hrd_parameters_present_flag || sps->vui.vcl_hrd_parameters_present_flag )
+    {
+        pt->cpb_removal_delay = bs_read_u(b, hrd->cpb_removal_delay_length_minus1 + 1);
+        pt->dpb_output_delay = bs_read_u(b, hrd->dpb_output_delay_length_minus1 + 1);
+    }
+    if( sps->vui.pic_struct_present_flag )
+    {
+        pt->pic_struct = bs_read_u(b, 4);
+        for( int i = 0; i < num_clock_ts_table[ pt->pic_struct & 0x0F ]; i++ )
+        {
+            pt->clock_timestamps[i].clock_timestamp_flag = bs_read_u1(b);
+            if( pt->clock_timestamps[i].clock_timestamp_flag )
+            {
+                pt->clock_timestamps[i].ct_type = bs_read_u(b, 2);
+                pt->clock_timestamps[i].nuit_field_based_flag = bs_read_u1(b);
+                pt->clock_timestamps[i].counting_type = bs_read_u(b, 5);
+                pt->clock_timestamps[i].full_timestamp_flag = bs_read_u1(b);
+                pt->clock_timestamps[i].discontinuity_flag = bs_read_u1(b);
+                pt->clock_timestamps[i].cnt_dropped_flag = bs_read_u1(b);
+                pt->clock_timestamps[i].n_frames = bs_read_u8(b);
+                if( pt->clock_timestamps[i].full_timestamp_flag )
+                {
+                    pt->clock_timestamps[i].seconds_value = bs_read_u(b, 6);
+                    pt->clock_timestamps[i].minutes_value = bs_read_u(b, 6);
+                    pt->clock_timestamps[i].hours_value = bs_read_u(b, 5);
+                }
+                else
+                {
+                    pt->clock_timestamps[i].seconds_flag = bs_read_u1(b);
+                    if( pt->clock_timestamps[i].seconds_flag )
+                    {
+                        pt->clock_timestamps[i].seconds_value = bs_read_u(b, 6);
+                        pt->clock_timestamps[i].minutes_flag = bs_read_u1(b);
+                        if( pt->clock_timestamps[i].minutes_flag )
+                        {
+                            pt->clock_timestamps[i].minutes_value = bs_read_u(b, 6);
+                            pt->clock_timestamps[i].hours_flag = bs_read_u1(b);
+                            if( pt->clock_timestamps[i].hours_flag )
+                            {
+                                pt->clock_timestamps[i].hours_value = bs_read_u(b, 5);
+                            }
+                        }
+                    }
+                }
+                if( time_offset_length > 0 )
+                {
+                    // i(v), two's complement
+                    pt->clock_timestamps[i].time_offset = bs_read_u(b, time_offset_length);
+                    if( 1 && time_offset_length < 32 && ( pt->clock_timestamps[i].time_offset >> ( time_offset_length - 1 ) ) )
+                    {
+                        pt->clock_timestamps[i].time_offset = (int)( (uint32_t)pt->clock_timestamps[i].time_offset | ~( ( 1u << time_offset_length ) - 1 ) );
+                    }
+                }
+            }
+        }
+    }
+}
+
+// D.1.7 Recovery point SEI message syntax
+void read_sei_recovery_point( h264_stream_t* h, bs_t* b )
+{
+    sei_recovery_point_t* rp = &h->sei->rp;
+
+    rp->recovery_frame_cnt = bs_read_ue(b);
+    rp->exact_match_flag = bs_read_u1(b);
+    rp->broken_link_flag = bs_read_u1(b);
+    rp->changing_slice_group_idc = bs_read_u(b, 2);
+}
+
 // D.1 SEI payload syntax
 void read_sei_payload( h264_stream_t* h, bs_t* b )
 {
     sei_t* s = h->sei;
+    uint8_t* payload_start = b->p; // payloads start byte aligned
     
     int i;
     switch( s->payloadType )
     {
+        case SEI_TYPE_BUFFERING_PERIOD:
+            if( 1 ) { memset( &s->bp, 0, sizeof(sei_buffering_t) ); }
+            read_sei_buffering_period( h, b );
+            break;
+        case SEI_TYPE_PIC_TIMING:
+            if( 1 ) { memset( &s->pt, 0, sizeof(sei_picture_timing_t) ); }
+            read_sei_pic_timing( h, b );
+            break;
+        case SEI_TYPE_RECOVERY_POINT:
+            if( 1 ) { memset( &s->rp, 0, sizeof(sei_recovery_point_t) ); }
+            read_sei_recovery_point( h, b );
+            break;
         case SEI_TYPE_SCALABILITY_INFO:
             if( 1 )
             {
-                s->sei_svc = (sei_scalability_info_t*)calloc( 1, sizeof(sei_scalability_info_t) );
+                s->sei_svc = sei_reserve_svc( s );
             }
             read_sei_scalability_info( h, b );
             break;
         default:
             if( 1 )
             {
-                s->data = (uint8_t*)calloc(1, s->payloadSize);
+                s->data = sei_reserve_data( s, s->payloadSize );
             }
             
-            for ( i = 0; i < s->payloadSize; i++ )
-                s->data[i] = bs_read_u8(b);
+            // raw payloads start byte aligned, copy them in one go; the debug reader prints every byte
+            if( 1 && !0 && bs_byte_aligned(b) )
+            {
+                int n = bs_read_bytes( b, s->data, s->payloadSize );
+                if( n < s->payloadSize ) { memset( s->data + n, 0, s->payloadSize - n ); }
+            }
+            else if( 0 && bs_byte_aligned(b) )
+            {
+                bs_write_bytes( b, s->data, s->payloadSize );
+            }
+            else
+            {
+                for ( i = 0; i < s->payloadSize; i++ )
+                    s->data[i] = bs_read_u8(b);
+            }
+            return;
+    }
+
+    // parsed payloads: skip any reserved or extension bits up to the signalled size,
+    // or when writing, end the payload at a byte border with bit_equal_to_one and bit_equal_to_zero
+    if( 1 )
+    {
+        b->p = ( s->payloadSize < b->end - payload_start ) ? payload_start + s->payloadSize : b->end;
+        b->bits_left = 8;
+    }
+    if( 0 && !bs_byte_aligned(b) )
+    {
+        bs_write_u1(b, 1);
+        while( !bs_byte_aligned(b) ) { bs_write_u1(b, 0); }
     }
     
     //if( 1 )
@@ -279,6 +723,9 @@ void read_sei_payload( h264_stream_t* h, bs_t* b )
 
 
 void write_sei_scalability_info( h264_stream_t* h, bs_t* b );
+void write_sei_buffering_period( h264_stream_t* h, bs_t* b );
+void write_sei_pic_timing( h264_stream_t* h, bs_t* b );
+void write_sei_recovery_point( h264_stream_t* h, bs_t* b );
 void write_sei_payload( h264_stream_t* h, bs_t* b );
 
 
@@ -291,6 +738,10 @@ void write_sei_scalability_info( h264_stream_t* h, bs_t* b )
     bs_write_u1(b, sei_svc->priority_layer_info_present_flag);
     bs_write_u1(b, sei_svc->priority_id_setting_flag);
     bs_write_ue(b, sei_svc->num_layers_minus1);
+    if( 0 )
+    {
+        sei_scalability_info_reserve_layers( sei_svc, sei_svc->num_layers_minus1 + 1 );
+    }
     
     for( int i = 0; i <= sei_svc->num_layers_minus1; i++ ) {
         bs_write_ue(b, sei_svc->layers[i].layer_id);
@@ -438,10 +889,18 @@ void write_sei_scalability_info( h264_stream_t* h, bs_t* b )
     if( sei_svc->priority_layer_info_present_flag )
     {
         bs_write_ue(b, sei_svc->pr_num_dIds_minus1);
+        if( 0 )
+        {
+            sei_scalability_info_reserve_pr( sei_svc, sei_svc->pr_num_dIds_minus1 + 1 );
+        }
         
         for( int i = 0; i <= sei_svc->pr_num_dIds_minus1; i++ ) {
             bs_write_u(b, 3, sei_svc->pr[i].pr_dependency_id);
             bs_write_ue(b, sei_svc->pr[i].pr_num_minus1);
+            if( 0 )
+            {
+                sei_scalability_pr_reserve_pr_info( &sei_svc->pr[i], sei_svc->pr[i].pr_num_minus1 + 1 );
+            }
             for( int j = 0; j <= sei_svc->pr[i].pr_num_minus1; j++ )
             {
                 bs_write_ue(b, sei_svc->pr[i].pr_info[j].pr_id);
@@ -455,29 +914,176 @@ void write_sei_scalability_info( h264_stream_t* h, bs_t* b )
 
 }
 
+// D.1.1 Buffering period SEI message syntax
+void write_sei_buffering_period( h264_stream_t* h, bs_t* b )
+{
+    sei_buffering_t* bp = &h->sei->bp;
+
+    bs_write_ue(b, bp->seq_parameter_set_id);
+
+    sps_t* sps = h->sps_table[ bp->seq_parameter_set_id & 0x1F ];
+    if( sps->vui.nal_hrd_parameters_present_flag )
+    {
+        for( int SchedSelIdx = 0; SchedSelIdx <= sps->hrd_nal.cpb_cnt_minus1 && SchedSelIdx < 32; SchedSelIdx++ )
+        {
+            bs_write_u(b, sps->hrd_nal.initial_cpb_removal_delay_length_minus1 + 1, bp->nal[SchedSelIdx].initial_cpb_removal_delay);
+            bs_write_u(b, sps->hrd_nal.initial_cpb_removal_delay_length_minus1 + 1, bp->nal[SchedSelIdx].initial_cpb_removal_delay_offset);
+        }
+    }
+    if( sps->vui.vcl_hrd_parameters_present_flag )
+    {
+        for( int SchedSelIdx = 0; SchedSelIdx <= sps->hrd_vcl.cpb_cnt_minus1 && SchedSelIdx < 32; SchedSelIdx++ )
+        {
+            bs_write_u(b, sps->hrd_vcl.initial_cpb_removal_delay_length_minus1 + 1, bp->vcl[SchedSelIdx].initial_cpb_removal_delay);
+            bs_write_u(b, sps->hrd_vcl.initial_cpb_removal_delay_length_minus1 + 1, bp->vcl[SchedSelIdx].initial_cpb_removal_delay_offset);
+        }
+    }
+}
+
+// D.1.2 Picture timing SEI message syntax
+void write_sei_pic_timing( h264_stream_t* h, bs_t* b )
+{
+    // Table D-1, NumClockTS by pic_struct
+    static const int num_clock_ts_table[16] = { 1, 1, 1, 2, 2, 3, 3, 2, 3, 0, 0, 0, 0, 0, 0, 0 };
+    sei_picture_timing_t* pt = &h->sei->pt;
+    sps_t* sps = h->sps;
+    // the lengths come from the nal hrd parameters if present, else from the vcl ones (they must be equal if both are present)
+    hrd_t* hrd = sps->vui.nal_hrd_parameters_present_flag ? &sps->hrd_nal : &sps->hrd_vcl;
+    // without hrd parameters time_offset_length is inferred to be 24 (E.2.2)
+    int time_offset_length = ( sps->vui.nal_hrd_parameters_present_flag || sps->vui.vcl_hrd_parameters_present_flag ) ? hrd->time_offset_length : 24;
+
+    if( sps->vui.nal_hrd_parameters_present_flag || sps->vui.vcl_hrd_parameters_present_flag )
+    {
+        bs_write_u(b, hrd->cpb_removal_delay_length_minus1 + 1, pt->cpb_removal_delay);
+        bs_write_u(b, hrd->dpb_output_delay_length_minus1 + 1, pt->dpb_output_delay);
+    }
+    if( sps->vui.pic_struct_present_flag )
+    {
+        bs_write_u(b, 4, pt->pic_struct);
+        for( int i = 0; i < num_clock_ts_table[ pt->pic_struct & 0x0F ]; i++ )
+        {
+            bs_write_u1(b, pt->clock_timestamps[i].clock_timestamp_flag);
+            if( pt->clock_timestamps[i].clock_timestamp_flag )
+            {
+                bs_write_u(b, 2, pt->clock_timestamps[i].ct_type);
+                bs_write_u1(b, pt->clock_timestamps[i].nuit_field_based_flag);
+                bs_write_u(b, 5, pt->clock_timestamps[i].counting_type);
+                bs_write_u1(b, pt->clock_timestamps[i].full_timestamp_flag);
+                bs_write_u1(b, pt->clock_timestamps[i].discontinuity_flag);
+                bs_write_u1(b, pt->clock_timestamps[i].cnt_dropped_flag);
+                bs_write_u8(b, pt->clock_timestamps[i].n_frames);
+                if( pt->clock_timestamps[i].full_timestamp_flag )
+                {
+                    bs_write_u(b, 6, pt->clock_timestamps[i].seconds_value);
+                    bs_write_u(b, 6, pt->clock_timestamps[i].minutes_value);
+                    bs_write_u(b, 5, pt->clock_timestamps[i].hours_value);
+                }
+                else
+                {
+                    bs_write_u1(b, pt->clock_timestamps[i].seconds_flag);
+                    if( pt->clock_timestamps[i].seconds_flag )
+                    {
+                        bs_write_u(b, 6, pt->clock_timestamps[i].seconds_value);
+                        bs_write_u1(b, pt->clock_timestamps[i].minutes_flag);
+                        if( pt->clock_timestamps[i].minutes_flag )
+                        {
+                            bs_write_u(b, 6, pt->clock_timestamps[i].minutes_value);
+                            bs_write_u1(b, pt->clock_timestamps[i].hours_flag);
+                            if( pt->clock_timestamps[i].hours_flag )
+                            {
+                                bs_write_u(b, 5, pt->clock_timestamps[i].hours_value);
+                            }
+                        }
+                    }
+                }
+                if( time_offset_length > 0 )
+                {
+                    // i(v), two's complement
+                    bs_write_u(b, time_offset_length, pt->clock_timestamps[i].time_offset);
+                    if( 0 && time_offset_length < 32 && ( pt->clock_timestamps[i].time_offset >> ( time_offset_length - 1 ) ) )
+                    {
+                        pt->clock_timestamps[i].time_offset = (int)( (uint32_t)pt->clock_timestamps[i].time_offset | ~( ( 1u << time_offset_length ) - 1 ) );
+                    }
+                }
+            }
+        }
+    }
+}
+
+// D.1.7 Recovery point SEI message syntax
+void write_sei_recovery_point( h264_stream_t* h, bs_t* b )
+{
+    sei_recovery_point_t* rp = &h->sei->rp;
+
+    bs_write_ue(b, rp->recovery_frame_cnt);
+    bs_write_u1(b, rp->exact_match_flag);
+    bs_write_u1(b, rp->broken_link_flag);
+    bs_write_u(b, 2, rp->changing_slice_group_idc);
+}
+
 // D.1 SEI payload syntax
 void write_sei_payload( h264_stream_t* h, bs_t* b )
 {
     sei_t* s = h->sei;
+    uint8_t* payload_start = b->p; // payloads start byte aligned
     
     int i;
     switch( s->payloadType )
     {
+        case SEI_TYPE_BUFFERING_PERIOD:
+            if( 0 ) { memset( &s->bp, 0, sizeof(sei_buffering_t) ); }
+            write_sei_buffering_period( h, b );
+            break;
+        case SEI_TYPE_PIC_TIMING:
+            if( 0 ) { memset( &s->pt, 0, sizeof(sei_picture_timing_t) ); }
+            write_sei_pic_timing( h, b );
+            break;
+        case SEI_TYPE_RECOVERY_POINT:
+            if( 0 ) { memset( &s->rp, 0, sizeof(sei_recovery_point_t) ); }
+            write_sei_recovery_point( h, b );
+            break;
         case SEI_TYPE_SCALABILITY_INFO:
             if( 0 )
             {
-                s->sei_svc = (sei_scalability_info_t*)calloc( 1, sizeof(sei_scalability_info_t) );
+                s->sei_svc = sei_reserve_svc( s );
             }
             write_sei_scalability_info( h, b );
             break;
         default:
             if( 0 )
             {
-                s->data = (uint8_t*)calloc(1, s->payloadSize);
+                s->data = sei_reserve_data( s, s->payloadSize );
             }
             
-            for ( i = 0; i < s->payloadSize; i++ )
-                bs_write_u8(b, s->data[i]);
+            // raw payloads start byte aligned, copy them in one go; the debug reader prints every byte
+            if( 0 && !0 && bs_byte_aligned(b) )
+            {
+                int n = bs_read_bytes( b, s->data, s->payloadSize );
+                if( n < s->payloadSize ) { memset( s->data + n, 0, s->payloadSize - n ); }
+            }
+            else if( 1 && bs_byte_aligned(b) )
+            {
+                bs_write_bytes( b, s->data, s->payloadSize );
+            }
+            else
+            {
+                for ( i = 0; i < s->payloadSize; i++ )
+                    bs_write_u8(b, s->data[i]);
+            }
+            return;
+    }
+
+    // parsed payloads: skip any reserved or extension bits up to the signalled size,
+    // or when writing, end the payload at a byte border with bit_equal_to_one and bit_equal_to_zero
+    if( 0 )
+    {
+        b->p = ( s->payloadSize < b->end - payload_start ) ? payload_start + s->payloadSize : b->end;
+        b->bits_left = 8;
+    }
+    if( 1 && !bs_byte_aligned(b) )
+    {
+        bs_write_u1(b, 1);
+        while( !bs_byte_aligned(b) ) { bs_write_u1(b, 0); }
     }
     
     //if( 0 )
@@ -486,6 +1092,9 @@ void write_sei_payload( h264_stream_t* h, bs_t* b )
 
 
 void read_debug_sei_scalability_info( h264_stream_t* h, bs_t* b );
+void read_debug_sei_buffering_period( h264_stream_t* h, bs_t* b );
+void read_debug_sei_pic_timing( h264_stream_t* h, bs_t* b );
+void read_debug_sei_recovery_point( h264_stream_t* h, bs_t* b );
 void read_debug_sei_payload( h264_stream_t* h, bs_t* b );
 
 
@@ -494,149 +1103,153 @@ void read_debug_sei_scalability_info( h264_stream_t* h, bs_t* b )
 {
     sei_scalability_info_t* sei_svc = h->sei->sei_svc;
     
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->temporal_id_nesting_flag = bs_read_u1(b); printf("sei_svc->temporal_id_nesting_flag: %d \n", sei_svc->temporal_id_nesting_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->priority_layer_info_present_flag = bs_read_u1(b); printf("sei_svc->priority_layer_info_present_flag: %d \n", sei_svc->priority_layer_info_present_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->priority_id_setting_flag = bs_read_u1(b); printf("sei_svc->priority_id_setting_flag: %d \n", sei_svc->priority_id_setting_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->num_layers_minus1 = bs_read_ue(b); printf("sei_svc->num_layers_minus1: %d \n", sei_svc->num_layers_minus1); 
+    { int _pos = bs_bit_pos(b); sei_svc->temporal_id_nesting_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_TEMPORAL_ID_NESTING_FLAG, _pos, sei_svc->temporal_id_nesting_flag); }
+    { int _pos = bs_bit_pos(b); sei_svc->priority_layer_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_PRIORITY_LAYER_INFO_PRESENT_FLAG, _pos, sei_svc->priority_layer_info_present_flag); }
+    { int _pos = bs_bit_pos(b); sei_svc->priority_id_setting_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_PRIORITY_ID_SETTING_FLAG, _pos, sei_svc->priority_id_setting_flag); }
+    { int _pos = bs_bit_pos(b); sei_svc->num_layers_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_NUM_LAYERS_MINUS1, _pos, sei_svc->num_layers_minus1); }
+    if( 1 )
+    {
+        sei_scalability_info_reserve_layers( sei_svc, sei_svc->num_layers_minus1 + 1 );
+    }
     
     for( int i = 0; i <= sei_svc->num_layers_minus1; i++ ) {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].layer_id = bs_read_ue(b); printf("sei_svc->layers[i].layer_id: %d \n", sei_svc->layers[i].layer_id); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].priority_id = bs_read_u(b, 6); printf("sei_svc->layers[i].priority_id: %d \n", sei_svc->layers[i].priority_id); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].discardable_flag = bs_read_u1(b); printf("sei_svc->layers[i].discardable_flag: %d \n", sei_svc->layers[i].discardable_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].dependency_id = bs_read_u(b, 3); printf("sei_svc->layers[i].dependency_id: %d \n", sei_svc->layers[i].dependency_id); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].quality_id = bs_read_u(b, 4); printf("sei_svc->layers[i].quality_id: %d \n", sei_svc->layers[i].quality_id); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].temporal_id = bs_read_u(b, 3); printf("sei_svc->layers[i].temporal_id: %d \n", sei_svc->layers[i].temporal_id); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].sub_pic_layer_flag = bs_read_u1(b); printf("sei_svc->layers[i].sub_pic_layer_flag: %d \n", sei_svc->layers[i].sub_pic_layer_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].sub_region_layer_flag = bs_read_u1(b); printf("sei_svc->layers[i].sub_region_layer_flag: %d \n", sei_svc->layers[i].sub_region_layer_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].iroi_division_info_present_flag = bs_read_u1(b); printf("sei_svc->layers[i].iroi_division_info_present_flag: %d \n", sei_svc->layers[i].iroi_division_info_present_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].profile_level_info_present_flag = bs_read_u1(b); printf("sei_svc->layers[i].profile_level_info_present_flag: %d \n", sei_svc->layers[i].profile_level_info_present_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].bitrate_info_present_flag = bs_read_u1(b); printf("sei_svc->layers[i].bitrate_info_present_flag: %d \n", sei_svc->layers[i].bitrate_info_present_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].frm_rate_info_present_flag = bs_read_u1(b); printf("sei_svc->layers[i].frm_rate_info_present_flag: %d \n", sei_svc->layers[i].frm_rate_info_present_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].frm_size_info_present_flag = bs_read_u1(b); printf("sei_svc->layers[i].frm_size_info_present_flag: %d \n", sei_svc->layers[i].frm_size_info_present_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].layer_dependency_info_present_flag = bs_read_u1(b); printf("sei_svc->layers[i].layer_dependency_info_present_flag: %d \n", sei_svc->layers[i].layer_dependency_info_present_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].parameter_sets_info_present_flag = bs_read_u1(b); printf("sei_svc->layers[i].parameter_sets_info_present_flag: %d \n", sei_svc->layers[i].parameter_sets_info_present_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].bitstream_restriction_info_present_flag = bs_read_u1(b); printf("sei_svc->layers[i].bitstream_restriction_info_present_flag: %d \n", sei_svc->layers[i].bitstream_restriction_info_present_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].exact_inter_layer_pred_flag = bs_read_u1(b); printf("sei_svc->layers[i].exact_inter_layer_pred_flag: %d \n", sei_svc->layers[i].exact_inter_layer_pred_flag); 
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].layer_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_LAYER_ID, _pos, sei_svc->layers[i].layer_id); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].priority_id = bs_read_u(b, 6); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_PRIORITY_ID, _pos, sei_svc->layers[i].priority_id); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].discardable_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_DISCARDABLE_FLAG, _pos, sei_svc->layers[i].discardable_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].dependency_id = bs_read_u(b, 3); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_DEPENDENCY_ID, _pos, sei_svc->layers[i].dependency_id); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].quality_id = bs_read_u(b, 4); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_QUALITY_ID, _pos, sei_svc->layers[i].quality_id); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].temporal_id = bs_read_u(b, 3); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_TEMPORAL_ID, _pos, sei_svc->layers[i].temporal_id); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].sub_pic_layer_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_SUB_PIC_LAYER_FLAG, _pos, sei_svc->layers[i].sub_pic_layer_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].sub_region_layer_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_SUB_REGION_LAYER_FLAG, _pos, sei_svc->layers[i].sub_region_layer_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].iroi_division_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_IROI_DIVISION_INFO_PRESENT_FLAG, _pos, sei_svc->layers[i].iroi_division_info_present_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].profile_level_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_PROFILE_LEVEL_INFO_PRESENT_FLAG, _pos, sei_svc->layers[i].profile_level_info_present_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].bitrate_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_BITRATE_INFO_PRESENT_FLAG, _pos, sei_svc->layers[i].bitrate_info_present_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].frm_rate_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_FRM_RATE_INFO_PRESENT_FLAG, _pos, sei_svc->layers[i].frm_rate_info_present_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].frm_size_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_FRM_SIZE_INFO_PRESENT_FLAG, _pos, sei_svc->layers[i].frm_size_info_present_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].layer_dependency_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_LAYER_DEPENDENCY_INFO_PRESENT_FLAG, _pos, sei_svc->layers[i].layer_dependency_info_present_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].parameter_sets_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_PARAMETER_SETS_INFO_PRESENT_FLAG, _pos, sei_svc->layers[i].parameter_sets_info_present_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].bitstream_restriction_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_BITSTREAM_RESTRICTION_INFO_PRESENT_FLAG, _pos, sei_svc->layers[i].bitstream_restriction_info_present_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].exact_inter_layer_pred_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_EXACT_INTER_LAYER_PRED_FLAG, _pos, sei_svc->layers[i].exact_inter_layer_pred_flag); }
         if( sei_svc->layers[i].sub_pic_layer_flag ||
             sei_svc->layers[i].iroi_division_info_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].exact_sample_value_match_flag = bs_read_u1(b); printf("sei_svc->layers[i].exact_sample_value_match_flag: %d \n", sei_svc->layers[i].exact_sample_value_match_flag); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].exact_sample_value_match_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_EXACT_SAMPLE_VALUE_MATCH_FLAG, _pos, sei_svc->layers[i].exact_sample_value_match_flag); }
         }
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].layer_conversion_flag = bs_read_u1(b); printf("sei_svc->layers[i].layer_conversion_flag: %d \n", sei_svc->layers[i].layer_conversion_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].layer_output_flag = bs_read_u1(b); printf("sei_svc->layers[i].layer_output_flag: %d \n", sei_svc->layers[i].layer_output_flag); 
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].layer_conversion_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_LAYER_CONVERSION_FLAG, _pos, sei_svc->layers[i].layer_conversion_flag); }
+        { int _pos = bs_bit_pos(b); sei_svc->layers[i].layer_output_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_LAYER_OUTPUT_FLAG, _pos, sei_svc->layers[i].layer_output_flag); }
         if( sei_svc->layers[i].profile_level_info_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].layer_profile_level_idc = bs_read_u(b, 24); printf("sei_svc->layers[i].layer_profile_level_idc: %d \n", sei_svc->layers[i].layer_profile_level_idc); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].layer_profile_level_idc = bs_read_u(b, 24); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_LAYER_PROFILE_LEVEL_IDC, _pos, sei_svc->layers[i].layer_profile_level_idc); }
         }
         if( sei_svc->layers[i].bitrate_info_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].avg_bitrate = bs_read_u(b, 16); printf("sei_svc->layers[i].avg_bitrate: %d \n", sei_svc->layers[i].avg_bitrate); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].max_bitrate_layer = bs_read_u(b, 16); printf("sei_svc->layers[i].max_bitrate_layer: %d \n", sei_svc->layers[i].max_bitrate_layer); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].max_bitrate_layer_representation = bs_read_u(b, 16); printf("sei_svc->layers[i].max_bitrate_layer_representation: %d \n", sei_svc->layers[i].max_bitrate_layer_representation); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].max_bitrate_calc_window = bs_read_u(b, 16); printf("sei_svc->layers[i].max_bitrate_calc_window: %d \n", sei_svc->layers[i].max_bitrate_calc_window); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].avg_bitrate = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_AVG_BITRATE, _pos, sei_svc->layers[i].avg_bitrate); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].max_bitrate_layer = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_MAX_BITRATE_LAYER, _pos, sei_svc->layers[i].max_bitrate_layer); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].max_bitrate_layer_representation = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_MAX_BITRATE_LAYER_REPRESENTATION, _pos, sei_svc->layers[i].max_bitrate_layer_representation); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].max_bitrate_calc_window = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_MAX_BITRATE_CALC_WINDOW, _pos, sei_svc->layers[i].max_bitrate_calc_window); }
         }
         if( sei_svc->layers[i].frm_rate_info_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].constant_frm_rate_idc = bs_read_u(b, 2); printf("sei_svc->layers[i].constant_frm_rate_idc: %d \n", sei_svc->layers[i].constant_frm_rate_idc); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].avg_frm_rate = bs_read_u(b, 16); printf("sei_svc->layers[i].avg_frm_rate: %d \n", sei_svc->layers[i].avg_frm_rate); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].constant_frm_rate_idc = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_CONSTANT_FRM_RATE_IDC, _pos, sei_svc->layers[i].constant_frm_rate_idc); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].avg_frm_rate = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_AVG_FRM_RATE, _pos, sei_svc->layers[i].avg_frm_rate); }
         }
         if( sei_svc->layers[i].frm_size_info_present_flag ||
             sei_svc->layers[i].iroi_division_info_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].frm_width_in_mbs_minus1 = bs_read_ue(b); printf("sei_svc->layers[i].frm_width_in_mbs_minus1: %d \n", sei_svc->layers[i].frm_width_in_mbs_minus1); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].frm_height_in_mbs_minus1 = bs_read_ue(b); printf("sei_svc->layers[i].frm_height_in_mbs_minus1: %d \n", sei_svc->layers[i].frm_height_in_mbs_minus1); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].frm_width_in_mbs_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_FRM_WIDTH_IN_MBS_MINUS1, _pos, sei_svc->layers[i].frm_width_in_mbs_minus1); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].frm_height_in_mbs_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_FRM_HEIGHT_IN_MBS_MINUS1, _pos, sei_svc->layers[i].frm_height_in_mbs_minus1); }
         }
         if( sei_svc->layers[i].sub_region_layer_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].base_region_layer_id = bs_read_ue(b); printf("sei_svc->layers[i].base_region_layer_id: %d \n", sei_svc->layers[i].base_region_layer_id); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].dynamic_rect_flag = bs_read_u1(b); printf("sei_svc->layers[i].dynamic_rect_flag: %d \n", sei_svc->layers[i].dynamic_rect_flag); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].base_region_layer_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_BASE_REGION_LAYER_ID, _pos, sei_svc->layers[i].base_region_layer_id); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].dynamic_rect_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_DYNAMIC_RECT_FLAG, _pos, sei_svc->layers[i].dynamic_rect_flag); }
             if( sei_svc->layers[i].dynamic_rect_flag )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].horizontal_offset = bs_read_u(b, 16); printf("sei_svc->layers[i].horizontal_offset: %d \n", sei_svc->layers[i].horizontal_offset); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].vertical_offset = bs_read_u(b, 16); printf("sei_svc->layers[i].vertical_offset: %d \n", sei_svc->layers[i].vertical_offset); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].region_width = bs_read_u(b, 16); printf("sei_svc->layers[i].region_width: %d \n", sei_svc->layers[i].region_width); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].region_height = bs_read_u(b, 16); printf("sei_svc->layers[i].region_height: %d \n", sei_svc->layers[i].region_height); 
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].horizontal_offset = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_HORIZONTAL_OFFSET, _pos, sei_svc->layers[i].horizontal_offset); }
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].vertical_offset = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_VERTICAL_OFFSET, _pos, sei_svc->layers[i].vertical_offset); }
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].region_width = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_REGION_WIDTH, _pos, sei_svc->layers[i].region_width); }
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].region_height = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_REGION_HEIGHT, _pos, sei_svc->layers[i].region_height); }
             }
         }
         if( sei_svc->layers[i].sub_pic_layer_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].roi_id = bs_read_ue(b); printf("sei_svc->layers[i].roi_id: %d \n", sei_svc->layers[i].roi_id); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].roi_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_ROI_ID, _pos, sei_svc->layers[i].roi_id); }
         }
         if( sei_svc->layers[i].iroi_division_info_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].iroi_grid_flag = bs_read_u1(b); printf("sei_svc->layers[i].iroi_grid_flag: %d \n", sei_svc->layers[i].iroi_grid_flag); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].iroi_grid_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_IROI_GRID_FLAG, _pos, sei_svc->layers[i].iroi_grid_flag); }
             if( sei_svc->layers[i].iroi_grid_flag )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].grid_width_in_mbs_minus1 = bs_read_ue(b); printf("sei_svc->layers[i].grid_width_in_mbs_minus1: %d \n", sei_svc->layers[i].grid_width_in_mbs_minus1); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].grid_height_in_mbs_minus1 = bs_read_ue(b); printf("sei_svc->layers[i].grid_height_in_mbs_minus1: %d \n", sei_svc->layers[i].grid_height_in_mbs_minus1); 
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].grid_width_in_mbs_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_GRID_WIDTH_IN_MBS_MINUS1, _pos, sei_svc->layers[i].grid_width_in_mbs_minus1); }
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].grid_height_in_mbs_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_GRID_HEIGHT_IN_MBS_MINUS1, _pos, sei_svc->layers[i].grid_height_in_mbs_minus1); }
             }
             else
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].num_rois_minus1 = bs_read_ue(b); printf("sei_svc->layers[i].num_rois_minus1: %d \n", sei_svc->layers[i].num_rois_minus1); 
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].num_rois_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_NUM_ROIS_MINUS1, _pos, sei_svc->layers[i].num_rois_minus1); }
                 
                 for( int j = 0; j <= sei_svc->layers[i].num_rois_minus1; j++ )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].roi[j].first_mb_in_roi = bs_read_ue(b); printf("sei_svc->layers[i].roi[j].first_mb_in_roi: %d \n", sei_svc->layers[i].roi[j].first_mb_in_roi); 
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].roi[j].roi_width_in_mbs_minus1 = bs_read_ue(b); printf("sei_svc->layers[i].roi[j].roi_width_in_mbs_minus1: %d \n", sei_svc->layers[i].roi[j].roi_width_in_mbs_minus1); 
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].roi[j].roi_height_in_mbs_minus1 = bs_read_ue(b); printf("sei_svc->layers[i].roi[j].roi_height_in_mbs_minus1: %d \n", sei_svc->layers[i].roi[j].roi_height_in_mbs_minus1); 
+                    { int _pos = bs_bit_pos(b); sei_svc->layers[i].roi[j].first_mb_in_roi = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_ROI_J_FIRST_MB_IN_ROI, _pos, sei_svc->layers[i].roi[j].first_mb_in_roi); }
+                    { int _pos = bs_bit_pos(b); sei_svc->layers[i].roi[j].roi_width_in_mbs_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_ROI_J_ROI_WIDTH_IN_MBS_MINUS1, _pos, sei_svc->layers[i].roi[j].roi_width_in_mbs_minus1); }
+                    { int _pos = bs_bit_pos(b); sei_svc->layers[i].roi[j].roi_height_in_mbs_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_ROI_J_ROI_HEIGHT_IN_MBS_MINUS1, _pos, sei_svc->layers[i].roi[j].roi_height_in_mbs_minus1); }
                 }
             }
         }
         if( sei_svc->layers[i].layer_dependency_info_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].num_directly_dependent_layers = bs_read_ue(b); printf("sei_svc->layers[i].num_directly_dependent_layers: %d \n", sei_svc->layers[i].num_directly_dependent_layers); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].num_directly_dependent_layers = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_NUM_DIRECTLY_DEPENDENT_LAYERS, _pos, sei_svc->layers[i].num_directly_dependent_layers); }
             for( int j = 0; j < sei_svc->layers[i].num_directly_dependent_layers; j++ )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].directly_dependent_layer_id_delta_minus1[j] = bs_read_ue(b); printf("sei_svc->layers[i].directly_dependent_layer_id_delta_minus1[j]: %d \n", sei_svc->layers[i].directly_dependent_layer_id_delta_minus1[j]); 
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].directly_dependent_layer_id_delta_minus1[j] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_DIRECTLY_DEPENDENT_LAYER_ID_DELTA_MINUS1_J, _pos, sei_svc->layers[i].directly_dependent_layer_id_delta_minus1[j]); }
             }
         }
         else
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].layer_dependency_info_src_layer_id_delta = bs_read_ue(b); printf("sei_svc->layers[i].layer_dependency_info_src_layer_id_delta: %d \n", sei_svc->layers[i].layer_dependency_info_src_layer_id_delta); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].layer_dependency_info_src_layer_id_delta = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_LAYER_DEPENDENCY_INFO_SRC_LAYER_ID_DELTA, _pos, sei_svc->layers[i].layer_dependency_info_src_layer_id_delta); }
         }
         if( sei_svc->layers[i].parameter_sets_info_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].num_seq_parameter_sets = bs_read_ue(b); printf("sei_svc->layers[i].num_seq_parameter_sets: %d \n", sei_svc->layers[i].num_seq_parameter_sets); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].num_seq_parameter_sets = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_NUM_SEQ_PARAMETER_SETS, _pos, sei_svc->layers[i].num_seq_parameter_sets); }
             for( int j = 0; j < sei_svc->layers[i].num_seq_parameter_sets; j++ )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].seq_parameter_set_id_delta[j] = bs_read_ue(b); printf("sei_svc->layers[i].seq_parameter_set_id_delta[j]: %d \n", sei_svc->layers[i].seq_parameter_set_id_delta[j]); 
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].seq_parameter_set_id_delta[j] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_SEQ_PARAMETER_SET_ID_DELTA_J, _pos, sei_svc->layers[i].seq_parameter_set_id_delta[j]); }
             }
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].num_subset_seq_parameter_sets = bs_read_ue(b); printf("sei_svc->layers[i].num_subset_seq_parameter_sets: %d \n", sei_svc->layers[i].num_subset_seq_parameter_sets); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].num_subset_seq_parameter_sets = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_NUM_SUBSET_SEQ_PARAMETER_SETS, _pos, sei_svc->layers[i].num_subset_seq_parameter_sets); }
             for( int j = 0; j < sei_svc->layers[i].num_subset_seq_parameter_sets; j++ )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].subset_seq_parameter_set_id_delta[j] = bs_read_ue(b); printf("sei_svc->layers[i].subset_seq_parameter_set_id_delta[j]: %d \n", sei_svc->layers[i].subset_seq_parameter_set_id_delta[j]); 
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].subset_seq_parameter_set_id_delta[j] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_SUBSET_SEQ_PARAMETER_SET_ID_DELTA_J, _pos, sei_svc->layers[i].subset_seq_parameter_set_id_delta[j]); }
             }
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].num_pic_parameter_sets_minus1 = bs_read_ue(b); printf("sei_svc->layers[i].num_pic_parameter_sets_minus1: %d \n", sei_svc->layers[i].num_pic_parameter_sets_minus1); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].num_pic_parameter_sets_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_NUM_PIC_PARAMETER_SETS_MINUS1, _pos, sei_svc->layers[i].num_pic_parameter_sets_minus1); }
             for( int j = 0; j < sei_svc->layers[i].num_pic_parameter_sets_minus1; j++ )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].pic_parameter_set_id_delta[j] = bs_read_ue(b); printf("sei_svc->layers[i].pic_parameter_set_id_delta[j]: %d \n", sei_svc->layers[i].pic_parameter_set_id_delta[j]); 
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].pic_parameter_set_id_delta[j] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_PIC_PARAMETER_SET_ID_DELTA_J, _pos, sei_svc->layers[i].pic_parameter_set_id_delta[j]); }
             }
         }
         else
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].parameter_sets_info_src_layer_id_delta = bs_read_ue(b); printf("sei_svc->layers[i].parameter_sets_info_src_layer_id_delta: %d \n", sei_svc->layers[i].parameter_sets_info_src_layer_id_delta); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].parameter_sets_info_src_layer_id_delta = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_PARAMETER_SETS_INFO_SRC_LAYER_ID_DELTA, _pos, sei_svc->layers[i].parameter_sets_info_src_layer_id_delta); }
         }
         if( sei_svc->layers[i].bitstream_restriction_info_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].motion_vectors_over_pic_boundaries_flag = bs_read_u1(b); printf("sei_svc->layers[i].motion_vectors_over_pic_boundaries_flag: %d \n", sei_svc->layers[i].motion_vectors_over_pic_boundaries_flag); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].max_bytes_per_pic_denom = bs_read_ue(b); printf("sei_svc->layers[i].max_bytes_per_pic_denom: %d \n", sei_svc->layers[i].max_bytes_per_pic_denom); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].max_bits_per_mb_denom = bs_read_ue(b); printf("sei_svc->layers[i].max_bits_per_mb_denom: %d \n", sei_svc->layers[i].max_bits_per_mb_denom); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].log2_max_mv_length_horizontal = bs_read_ue(b); printf("sei_svc->layers[i].log2_max_mv_length_horizontal: %d \n", sei_svc->layers[i].log2_max_mv_length_horizontal); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].log2_max_mv_length_vertical = bs_read_ue(b); printf("sei_svc->layers[i].log2_max_mv_length_vertical: %d \n", sei_svc->layers[i].log2_max_mv_length_vertical); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].max_num_reorder_frames = bs_read_ue(b); printf("sei_svc->layers[i].max_num_reorder_frames: %d \n", sei_svc->layers[i].max_num_reorder_frames); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].max_dec_frame_buffering = bs_read_ue(b); printf("sei_svc->layers[i].max_dec_frame_buffering: %d \n", sei_svc->layers[i].max_dec_frame_buffering); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].motion_vectors_over_pic_boundaries_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_MOTION_VECTORS_OVER_PIC_BOUNDARIES_FLAG, _pos, sei_svc->layers[i].motion_vectors_over_pic_boundaries_flag); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].max_bytes_per_pic_denom = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_MAX_BYTES_PER_PIC_DENOM, _pos, sei_svc->layers[i].max_bytes_per_pic_denom); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].max_bits_per_mb_denom = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_MAX_BITS_PER_MB_DENOM, _pos, sei_svc->layers[i].max_bits_per_mb_denom); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].log2_max_mv_length_horizontal = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_LOG2_MAX_MV_LENGTH_HORIZONTAL, _pos, sei_svc->layers[i].log2_max_mv_length_horizontal); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].log2_max_mv_length_vertical = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_LOG2_MAX_MV_LENGTH_VERTICAL, _pos, sei_svc->layers[i].log2_max_mv_length_vertical); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].max_num_reorder_frames = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_MAX_NUM_REORDER_FRAMES, _pos, sei_svc->layers[i].max_num_reorder_frames); }
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].max_dec_frame_buffering = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_MAX_DEC_FRAME_BUFFERING, _pos, sei_svc->layers[i].max_dec_frame_buffering); }
         }
         if( sei_svc->layers[i].layer_conversion_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].conversion_type_idc = bs_read_ue(b); printf("sei_svc->layers[i].conversion_type_idc: %d \n", sei_svc->layers[i].conversion_type_idc); 
+            { int _pos = bs_bit_pos(b); sei_svc->layers[i].conversion_type_idc = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_CONVERSION_TYPE_IDC, _pos, sei_svc->layers[i].conversion_type_idc); }
             for( int j = 0; j < 2; j++ )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].rewriting_info_flag[j] = bs_read_u(b, 1); printf("sei_svc->layers[i].rewriting_info_flag[j]: %d \n", sei_svc->layers[i].rewriting_info_flag[j]); 
+                { int _pos = bs_bit_pos(b); sei_svc->layers[i].rewriting_info_flag[j] = bs_read_u(b, 1); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_REWRITING_INFO_FLAG_J, _pos, sei_svc->layers[i].rewriting_info_flag[j]); }
                 if( sei_svc->layers[i].rewriting_info_flag[j] )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].rewriting_profile_level_idc[j] = bs_read_u(b, 24); printf("sei_svc->layers[i].rewriting_profile_level_idc[j]: %d \n", sei_svc->layers[i].rewriting_profile_level_idc[j]); 
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].rewriting_avg_bitrate[j] = bs_read_u(b, 16); printf("sei_svc->layers[i].rewriting_avg_bitrate[j]: %d \n", sei_svc->layers[i].rewriting_avg_bitrate[j]); 
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->layers[i].rewriting_max_bitrate[j] = bs_read_u(b, 16); printf("sei_svc->layers[i].rewriting_max_bitrate[j]: %d \n", sei_svc->layers[i].rewriting_max_bitrate[j]); 
+                    { int _pos = bs_bit_pos(b); sei_svc->layers[i].rewriting_profile_level_idc[j] = bs_read_u(b, 24); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_REWRITING_PROFILE_LEVEL_IDC_J, _pos, sei_svc->layers[i].rewriting_profile_level_idc[j]); }
+                    { int _pos = bs_bit_pos(b); sei_svc->layers[i].rewriting_avg_bitrate[j] = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_REWRITING_AVG_BITRATE_J, _pos, sei_svc->layers[i].rewriting_avg_bitrate[j]); }
+                    { int _pos = bs_bit_pos(b); sei_svc->layers[i].rewriting_max_bitrate[j] = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_LAYERS_I_REWRITING_MAX_BITRATE_J, _pos, sei_svc->layers[i].rewriting_max_bitrate[j]); }
                 }
             }
         }
@@ -644,17 +1257,25 @@ void read_debug_sei_scalability_info( h264_stream_t* h, bs_t* b )
 
     if( sei_svc->priority_layer_info_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->pr_num_dIds_minus1 = bs_read_ue(b); printf("sei_svc->pr_num_dIds_minus1: %d \n", sei_svc->pr_num_dIds_minus1); 
+        { int _pos = bs_bit_pos(b); sei_svc->pr_num_dIds_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_PR_NUM_DIDS_MINUS1, _pos, sei_svc->pr_num_dIds_minus1); }
+        if( 1 )
+        {
+            sei_scalability_info_reserve_pr( sei_svc, sei_svc->pr_num_dIds_minus1 + 1 );
+        }
         
         for( int i = 0; i <= sei_svc->pr_num_dIds_minus1; i++ ) {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->pr[i].pr_dependency_id = bs_read_u(b, 3); printf("sei_svc->pr[i].pr_dependency_id: %d \n", sei_svc->pr[i].pr_dependency_id); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->pr[i].pr_num_minus1 = bs_read_ue(b); printf("sei_svc->pr[i].pr_num_minus1: %d \n", sei_svc->pr[i].pr_num_minus1); 
+            { int _pos = bs_bit_pos(b); sei_svc->pr[i].pr_dependency_id = bs_read_u(b, 3); h264_debug_field(b, H264_FIELD_SEI_SVC_PR_I_PR_DEPENDENCY_ID, _pos, sei_svc->pr[i].pr_dependency_id); }
+            { int _pos = bs_bit_pos(b); sei_svc->pr[i].pr_num_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_PR_I_PR_NUM_MINUS1, _pos, sei_svc->pr[i].pr_num_minus1); }
+            if( 1 )
+            {
+                sei_scalability_pr_reserve_pr_info( &sei_svc->pr[i], sei_svc->pr[i].pr_num_minus1 + 1 );
+            }
             for( int j = 0; j <= sei_svc->pr[i].pr_num_minus1; j++ )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->pr[i].pr_info[j].pr_id = bs_read_ue(b); printf("sei_svc->pr[i].pr_info[j].pr_id: %d \n", sei_svc->pr[i].pr_info[j].pr_id); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->pr[i].pr_info[j].pr_profile_level_idc = bs_read_u(b, 24); printf("sei_svc->pr[i].pr_info[j].pr_profile_level_idc: %d \n", sei_svc->pr[i].pr_info[j].pr_profile_level_idc); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->pr[i].pr_info[j].pr_avg_bitrate = bs_read_u(b, 16); printf("sei_svc->pr[i].pr_info[j].pr_avg_bitrate: %d \n", sei_svc->pr[i].pr_info[j].pr_avg_bitrate); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sei_svc->pr[i].pr_info[j].pr_max_bitrate = bs_read_u(b, 16); printf("sei_svc->pr[i].pr_info[j].pr_max_bitrate: %d \n", sei_svc->pr[i].pr_info[j].pr_max_bitrate); 
+                { int _pos = bs_bit_pos(b); sei_svc->pr[i].pr_info[j].pr_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEI_SVC_PR_I_PR_INFO_J_PR_ID, _pos, sei_svc->pr[i].pr_info[j].pr_id); }
+                { int _pos = bs_bit_pos(b); sei_svc->pr[i].pr_info[j].pr_profile_level_idc = bs_read_u(b, 24); h264_debug_field(b, H264_FIELD_SEI_SVC_PR_I_PR_INFO_J_PR_PROFILE_LEVEL_IDC, _pos, sei_svc->pr[i].pr_info[j].pr_profile_level_idc); }
+                { int _pos = bs_bit_pos(b); sei_svc->pr[i].pr_info[j].pr_avg_bitrate = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_PR_I_PR_INFO_J_PR_AVG_BITRATE, _pos, sei_svc->pr[i].pr_info[j].pr_avg_bitrate); }
+                { int _pos = bs_bit_pos(b); sei_svc->pr[i].pr_info[j].pr_max_bitrate = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SEI_SVC_PR_I_PR_INFO_J_PR_MAX_BITRATE, _pos, sei_svc->pr[i].pr_info[j].pr_max_bitrate); }
             }
         }
         
@@ -662,29 +1283,176 @@ void read_debug_sei_scalability_info( h264_stream_t* h, bs_t* b )
 
 }
 
+// D.1.1 Buffering period SEI message syntax
+void read_debug_sei_buffering_period( h264_stream_t* h, bs_t* b )
+{
+    sei_buffering_t* bp = &h->sei->bp;
+
+    { int _pos = bs_bit_pos(b); bp->seq_parameter_set_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_BP_SEQ_PARAMETER_SET_ID, _pos, bp->seq_parameter_set_id); }
+
+    sps_t* sps = h->sps_table[ bp->seq_parameter_set_id & 0x1F ];
+    if( sps->vui.nal_hrd_parameters_present_flag )
+    {
+        for( int SchedSelIdx = 0; SchedSelIdx <= sps->hrd_nal.cpb_cnt_minus1 && SchedSelIdx < 32; SchedSelIdx++ )
+        {
+            { int _pos = bs_bit_pos(b); bp->nal[SchedSelIdx].initial_cpb_removal_delay = bs_read_u(b, sps->hrd_nal.initial_cpb_removal_delay_length_minus1 + 1); h264_debug_field(b, H264_FIELD_BP_NAL_SCHEDSELIDX_INITIAL_CPB_REMOVAL_DELAY, _pos, bp->nal[SchedSelIdx].initial_cpb_removal_delay); }
+            { int _pos = bs_bit_pos(b); bp->nal[SchedSelIdx].initial_cpb_removal_delay_offset = bs_read_u(b, sps->hrd_nal.initial_cpb_removal_delay_length_minus1 + 1); h264_debug_field(b, H264_FIELD_BP_NAL_SCHEDSELIDX_INITIAL_CPB_REMOVAL_DELAY_OFFSET, _pos, bp->nal[SchedSelIdx].initial_cpb_removal_delay_offset); }
+        }
+    }
+    if( sps->vui.vcl_hrd_parameters_present_flag )
+    {
+        for( int SchedSelIdx = 0; SchedSelIdx <= sps->hrd_vcl.cpb_cnt_minus1 && SchedSelIdx < 32; SchedSelIdx++ )
+        {
+            { int _pos = bs_bit_pos(b); bp->vcl[SchedSelIdx].initial_cpb_removal_delay = bs_read_u(b, sps->hrd_vcl.initial_cpb_removal_delay_length_minus1 + 1); h264_debug_field(b, H264_FIELD_BP_VCL_SCHEDSELIDX_INITIAL_CPB_REMOVAL_DELAY, _pos, bp->vcl[SchedSelIdx].initial_cpb_removal_delay); }
+            { int _pos = bs_bit_pos(b); bp->vcl[SchedSelIdx].initial_cpb_removal_delay_offset = bs_read_u(b, sps->hrd_vcl.initial_cpb_removal_delay_length_minus1 + 1); h264_debug_field(b, H264_FIELD_BP_VCL_SCHEDSELIDX_INITIAL_CPB_REMOVAL_DELAY_OFFSET, _pos, bp->vcl[SchedSelIdx].initial_cpb_removal_delay_offset); }
+        }
+    }
+}
+
+// D.1.2 Picture timing SEI message syntax
+void read_debug_sei_pic_timing( h264_stream_t* h, bs_t* b )
+{
+    // Table D-1, NumClockTS by pic_struct
+    static const int num_clock_ts_table[16] = { 1, 1, 1, 2, 2, 3, 3, 2, 3, 0, 0, 0, 0, 0, 0, 0 };
+    sei_picture_timing_t* pt = &h->sei->pt;
+    sps_t* sps = h->sps;
+    // the lengths come from the nal hrd parameters if present, else from the vcl ones (they must be equal if both are present)
+    hrd_t* hrd = sps->vui.nal_hrd_parameters_present_flag ? &sps->hrd_nal : &sps->hrd_vcl;
+    // without hrd parameters time_offset_length is inferred to be 24 (E.2.2)
+    int time_offset_length = ( sps->vui.nal_hrd_parameters_present_flag || sps->vui.vcl_hrd_parameters_present_flag ) ? hrd->time_offset_length : 24;
+
+    if( sps->vui.nal_hrd_parameters_present_flag || sps->vui.vcl_hrd_parameters_present_flag )
+    {
+        { int _pos = bs_bit_pos(b); pt->cpb_removal_delay = bs_read_u(b, hrd->cpb_removal_delay_length_minus1 + 1); h264_debug_field(b, H264_FIELD_PT_CPB_REMOVAL_DELAY, _pos, pt->cpb_removal_delay); }
+        { int _pos = bs_bit_pos(b); pt->dpb_output_delay = bs_read_u(b, hrd->dpb_output_delay_length_minus1 + 1); h264_debug_field(b, H264_FIELD_PT_DPB_OUTPUT_DELAY, _pos, pt->dpb_output_delay); }
+    }
+    if( sps->vui.pic_struct_present_flag )
+    {
+        { int _pos = bs_bit_pos(b); pt->pic_struct = bs_read_u(b, 4); h264_debug_field(b, H264_FIELD_PT_PIC_STRUCT, _pos, pt->pic_struct); }
+        for( int i = 0; i < num_clock_ts_table[ pt->pic_struct & 0x0F ]; i++ )
+        {
+            { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].clock_timestamp_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_CLOCK_TIMESTAMP_FLAG, _pos, pt->clock_timestamps[i].clock_timestamp_flag); }
+            if( pt->clock_timestamps[i].clock_timestamp_flag )
+            {
+                { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].ct_type = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_CT_TYPE, _pos, pt->clock_timestamps[i].ct_type); }
+                { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].nuit_field_based_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_NUIT_FIELD_BASED_FLAG, _pos, pt->clock_timestamps[i].nuit_field_based_flag); }
+                { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].counting_type = bs_read_u(b, 5); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_COUNTING_TYPE, _pos, pt->clock_timestamps[i].counting_type); }
+                { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].full_timestamp_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_FULL_TIMESTAMP_FLAG, _pos, pt->clock_timestamps[i].full_timestamp_flag); }
+                { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].discontinuity_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_DISCONTINUITY_FLAG, _pos, pt->clock_timestamps[i].discontinuity_flag); }
+                { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].cnt_dropped_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_CNT_DROPPED_FLAG, _pos, pt->clock_timestamps[i].cnt_dropped_flag); }
+                { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].n_frames = bs_read_u8(b); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_N_FRAMES, _pos, pt->clock_timestamps[i].n_frames); }
+                if( pt->clock_timestamps[i].full_timestamp_flag )
+                {
+                    { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].seconds_value = bs_read_u(b, 6); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_SECONDS_VALUE, _pos, pt->clock_timestamps[i].seconds_value); }
+                    { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].minutes_value = bs_read_u(b, 6); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_MINUTES_VALUE, _pos, pt->clock_timestamps[i].minutes_value); }
+                    { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].hours_value = bs_read_u(b, 5); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_HOURS_VALUE, _pos, pt->clock_timestamps[i].hours_value); }
+                }
+                else
+                {
+                    { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].seconds_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_SECONDS_FLAG, _pos, pt->clock_timestamps[i].seconds_flag); }
+                    if( pt->clock_timestamps[i].seconds_flag )
+                    {
+                        { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].seconds_value = bs_read_u(b, 6); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_SECONDS_VALUE, _pos, pt->clock_timestamps[i].seconds_value); }
+                        { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].minutes_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_MINUTES_FLAG, _pos, pt->clock_timestamps[i].minutes_flag); }
+                        if( pt->clock_timestamps[i].minutes_flag )
+                        {
+                            { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].minutes_value = bs_read_u(b, 6); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_MINUTES_VALUE, _pos, pt->clock_timestamps[i].minutes_value); }
+                            { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].hours_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_HOURS_FLAG, _pos, pt->clock_timestamps[i].hours_flag); }
+                            if( pt->clock_timestamps[i].hours_flag )
+                            {
+                                { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].hours_value = bs_read_u(b, 5); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_HOURS_VALUE, _pos, pt->clock_timestamps[i].hours_value); }
+                            }
+                        }
+                    }
+                }
+                if( time_offset_length > 0 )
+                {
+                    // i(v), two's complement
+                    { int _pos = bs_bit_pos(b); pt->clock_timestamps[i].time_offset = bs_read_u(b, time_offset_length); h264_debug_field(b, H264_FIELD_PT_CLOCK_TIMESTAMPS_I_TIME_OFFSET, _pos, pt->clock_timestamps[i].time_offset); }
+                    if( 1 && time_offset_length < 32 && ( pt->clock_timestamps[i].time_offset >> ( time_offset_length - 1 ) ) )
+                    {
+                        pt->clock_timestamps[i].time_offset = (int)( (uint32_t)pt->clock_timestamps[i].time_offset | ~( ( 1u << time_offset_length ) - 1 ) );
+                    }
+                }
+            }
+        }
+    }
+}
+
+// D.1.7 Recovery point SEI message syntax
+void read_debug_sei_recovery_point( h264_stream_t* h, bs_t* b )
+{
+    sei_recovery_point_t* rp = &h->sei->rp;
+
+    { int _pos = bs_bit_pos(b); rp->recovery_frame_cnt = bs_read_ue(b); h264_debug_field(b, H264_FIELD_RP_RECOVERY_FRAME_CNT, _pos, rp->recovery_frame_cnt); }
+    { int _pos = bs_bit_pos(b); rp->exact_match_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_RP_EXACT_MATCH_FLAG, _pos, rp->exact_match_flag); }
+    { int _pos = bs_bit_pos(b); rp->broken_link_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_RP_BROKEN_LINK_FLAG, _pos, rp->broken_link_flag); }
+    { int _pos = bs_bit_pos(b); rp->changing_slice_group_idc = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_RP_CHANGING_SLICE_GROUP_IDC, _pos, rp->changing_slice_group_idc); }
+}
+
 // D.1 SEI payload syntax
 void read_debug_sei_payload( h264_stream_t* h, bs_t* b )
 {
     sei_t* s = h->sei;
+    uint8_t* payload_start = b->p; // payloads start byte aligned
     
     int i;
     switch( s->payloadType )
     {
+        case SEI_TYPE_BUFFERING_PERIOD:
+            if( 1 ) { memset( &s->bp, 0, sizeof(sei_buffering_t) ); }
+            read_debug_sei_buffering_period( h, b );
+            break;
+        case SEI_TYPE_PIC_TIMING:
+            if( 1 ) { memset( &s->pt, 0, sizeof(sei_picture_timing_t) ); }
+            read_debug_sei_pic_timing( h, b );
+            break;
+        case SEI_TYPE_RECOVERY_POINT:
+            if( 1 ) { memset( &s->rp, 0, sizeof(sei_recovery_point_t) ); }
+            read_debug_sei_recovery_point( h, b );
+            break;
         case SEI_TYPE_SCALABILITY_INFO:
             if( 1 )
             {
-                s->sei_svc = (sei_scalability_info_t*)calloc( 1, sizeof(sei_scalability_info_t) );
+                s->sei_svc = sei_reserve_svc( s );
             }
             read_debug_sei_scalability_info( h, b );
             break;
         default:
             if( 1 )
             {
-                s->data = (uint8_t*)calloc(1, s->payloadSize);
+                s->data = sei_reserve_data( s, s->payloadSize );
             }
             
-            for ( i = 0; i < s->payloadSize; i++ )
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); s->data[i] = bs_read_u8(b); printf("s->data[i]: %d \n", s->data[i]); 
+            // raw payloads start byte aligned, copy them in one go; the debug reader prints every byte
+            if( 1 && !1 && bs_byte_aligned(b) )
+            {
+                int n = bs_read_bytes( b, s->data, s->payloadSize );
+                if( n < s->payloadSize ) { memset( s->data + n, 0, s->payloadSize - n ); }
+            }
+            else if( 0 && bs_byte_aligned(b) )
+            {
+                bs_write_bytes( b, s->data, s->payloadSize );
+            }
+            else
+            {
+                for ( i = 0; i < s->payloadSize; i++ )
+                    { int _pos = bs_bit_pos(b); s->data[i] = bs_read_u8(b); h264_debug_field(b, H264_FIELD_S_DATA_I, _pos, s->data[i]); }
+            }
+            return;
+    }
+
+    // parsed payloads: skip any reserved or extension bits up to the signalled size,
+    // or when writing, end the payload at a byte border with bit_equal_to_one and bit_equal_to_zero
+    if( 1 )
+    {
+        b->p = ( s->payloadSize < b->end - payload_start ) ? payload_start + s->payloadSize : b->end;
+        b->bits_left = 8;
+    }
+    if( 0 && !bs_byte_aligned(b) )
+    {
+        bs_write_u1(b, 1);
+        while( !bs_byte_aligned(b) ) { bs_write_u1(b, 0); }
     }
     
     //if( 1 )
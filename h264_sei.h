@@ -110,29 +110,108 @@ typedef struct
 
 #define MAX_LENGTH 128
 
+typedef struct
+{
+    unsigned short pr_id;
+    int pr_profile_level_idc;
+    unsigned short pr_avg_bitrate;
+    unsigned short pr_max_bitrate;
+} sei_scalability_pr_info_t;
+
+typedef struct
+{
+    unsigned char pr_dependency_id;
+    unsigned short pr_num_minus1;
+    sei_scalability_pr_info_t* pr_info; // pr_num_minus1 + 1 entries
+    int pr_info_capacity;
+    unsigned char priority_id_setting_uri[MAX_LENGTH];
+} sei_scalability_pr_t;
+
+/**
+   Scalability information SEI, G.13.1.1
+   The layers and pr arrays are allocated for the number of entries actually present, and grown as needed when
+   the message is reused for reading; see sei_scalability_info_reserve_layers and sei_scalability_info_reserve_pr.
+*/
 typedef struct
 {
     bool temporal_id_nesting_flag;
     bool priority_layer_info_present_flag;
     bool priority_id_setting_flag;
     unsigned short num_layers_minus1;
-    sei_scalability_layer_info_t layers[MAX_J];
+    sei_scalability_layer_info_t* layers; // num_layers_minus1 + 1 entries
+    int layers_capacity;
     unsigned short pr_num_dIds_minus1;
-    struct
-    {
-        unsigned char pr_dependency_id;
-        unsigned short pr_num_minus1;
-        struct
-        {
-            unsigned short pr_id;
-            int pr_profile_level_idc;
-            unsigned short pr_avg_bitrate;
-            unsigned short pr_max_bitrate;
-        } pr_info[MAX_J];
-        unsigned char priority_id_setting_uri[MAX_LENGTH];
-    } pr[MAX_J];
+    sei_scalability_pr_t* pr; // pr_num_dIds_minus1 + 1 entries
+    int pr_capacity;
 } sei_scalability_info_t;
     
+/**
+   Buffering period SEI
+   @see D.1.1 Buffering period SEI message syntax
+*/
+typedef struct
+{
+    int seq_parameter_set_id;
+    struct
+    {
+        int initial_cpb_removal_delay;
+        int initial_cpb_removal_delay_offset;
+    } nal[32], vcl[32]; // up to cpb_cnt_minus1 of the nal/vcl hrd parameters of the sps
+} sei_buffering_t;
+
+typedef struct
+{
+    int clock_timestamp_flag;
+    int ct_type;
+    int nuit_field_based_flag;
+    int counting_type;
+    int full_timestamp_flag;
+    int discontinuity_flag;
+    int cnt_dropped_flag;
+    int n_frames;
+
+    int seconds_value;
+    int minutes_value;
+    int hours_value;
+
+    int seconds_flag;
+    int minutes_flag;
+    int hours_flag;
+
+    int time_offset;
+} picture_timestamp_t;
+
+/**
+   Picture timing SEI
+   Which fields are present depends on the hrd and vui of the active sps, which is taken to be h->sps
+   @see D.1.2 Picture timing SEI message syntax
+*/
+typedef struct
+{
+    int cpb_removal_delay;
+    int dpb_output_delay;
+    int pic_struct;
+    picture_timestamp_t clock_timestamps[3]; // 3 is the maximum possible value
+} sei_picture_timing_t;
+
+/**
+   Recovery point SEI
+   @see D.1.7 Recovery point SEI message syntax
+*/
+typedef struct
+{
+    int recovery_frame_cnt;
+    int exact_match_flag;
+    int broken_link_flag;
+    int changing_slice_group_idc;
+} sei_recovery_point_t;
+
+/**
+   SEI message.
+   Buffering period, picture timing and recovery point payloads are parsed into bp, pt and rp;
+   scalability information into sei_svc; all other payloads are kept as raw bytes in data.
+   When writing, payloadSize is computed for the parsed payload types, and must be set by the caller for the others.
+*/
 typedef struct
 {
     int payloadType;
@@ -143,10 +222,49 @@ typedef struct
         sei_scalability_info_t* sei_svc;
         uint8_t* data;
     };
+
+    // storage kept across reads when the message is recycled by read_sei_rbsp, owned by the sei_t
+    uint8_t* data_buf;
+    int data_buf_size;
+    sei_scalability_info_t* svc_buf;
+
+    sei_buffering_t bp;
+    sei_picture_timing_t pt;
+    sei_recovery_point_t rp;
 } sei_t;
 
+/**
+   Selects SEI payloads for sei_find_payloads
+*/
+typedef struct
+{
+    const int* types;       // payload types to return; if num_types is 0, all types
+    int num_types;
+    const uint8_t* uuids;   // num_uuids 16-byte uuid_iso_iec_11578 values of user_data_unregistered payloads to return; if num_uuids is 0, all
+    int num_uuids;
+} sei_filter_t;
+
+/**
+   A SEI payload found by sei_find_payloads, not copied unless it had to be unescaped
+*/
+typedef struct
+{
+    int payloadType;
+    int payloadSize;
+    const uint8_t* data;    // payloadSize bytes of payload; for user_data_unregistered the first 16 are the uuid
+} sei_view_t;
+
+int sei_filter_accepts(const sei_filter_t* filter, int payloadType, const uint8_t* uuid);
+int sei_find_payloads(const uint8_t* nal, int nal_size, const sei_filter_t* filter, sei_view_t* views, int max_views, uint8_t* scratch, int scratch_size);
+
 sei_t* sei_new();
 void sei_free(sei_t* s);
+void sei_reset(sei_t* s);
+uint8_t* sei_reserve_data(sei_t* s, int size);
+sei_scalability_info_t* sei_reserve_svc(sei_t* s);
+void sei_scalability_info_reserve_layers(sei_scalability_info_t* sei_svc, int num_layers);
+void sei_scalability_info_reserve_pr(sei_scalability_info_t* sei_svc, int num_pr);
+void sei_scalability_pr_reserve_pr_info(sei_scalability_pr_t* pr, int num_pr_info);
 
 //D.1 SEI payload syntax
 #define SEI_TYPE_BUFFERING_PERIOD 0
@@ -42,18 +42,300 @@ sei_t* sei_new()
     return s;
 }
 
-void sei_free(sei_t* s)
+static void sei_scalability_info_free(sei_scalability_info_t* sei_svc)
+{
+    for ( int i = 0; i < sei_svc->pr_capacity; i++ ) { free(sei_svc->pr[i].pr_info); }
+    free(sei_svc->pr);
+    free(sei_svc->layers);
+    free(sei_svc);
+}
+
+/**
+ Prepare a message for reuse: free its payload if it was set by the caller, keep the message's own storage.
+ */
+void sei_reset(sei_t* s)
 {
     switch( s->payloadType ) {
         case SEI_TYPE_SCALABILITY_INFO:
-            if ( s->sei_svc != NULL ) free(s->sei_svc);
+            if ( s->sei_svc != NULL && s->sei_svc != s->svc_buf ) sei_scalability_info_free(s->sei_svc);
             break;
         default:
-            if ( s->data != NULL ) free(s->data);
+            if ( s->data != NULL && s->data != s->data_buf ) free(s->data);
     }
+    s->data = NULL;
+    s->payloadType = 0;
+    s->payloadSize = 0;
+}
+
+void sei_free(sei_t* s)
+{
+    sei_reset(s);
+    if ( s->svc_buf != NULL ) sei_scalability_info_free(s->svc_buf);
+    free(s->data_buf);
     free(s);
 }
 
+// grow an array to hold at least n elements; new elements are zeroed
+static void* sei_reserve(void* p, int* capacity, int n, size_t elem_size)
+{
+    if ( n <= *capacity ) { return p; }
+    int new_capacity = (*capacity * 2 > n) ? *capacity * 2 : n;
+    p = realloc(p, new_capacity * elem_size);
+    memset((uint8_t*)p + *capacity * elem_size, 0, (new_capacity - *capacity) * elem_size);
+    *capacity = new_capacity;
+    return p;
+}
+
+/**
+ Get a buffer of at least size bytes for the payload of a message, reusing the message's own storage.
+ */
+uint8_t* sei_reserve_data(sei_t* s, int size)
+{
+    s->data_buf = (uint8_t*)sei_reserve(s->data_buf, &s->data_buf_size, (size > 0 ? size : 1), 1);
+    return s->data_buf;
+}
+
+/**
+ Get a cleared scalability information structure for a message, reusing the message's own storage.
+ */
+sei_scalability_info_t* sei_reserve_svc(sei_t* s)
+{
+    sei_scalability_info_t* sei_svc = s->svc_buf;
+    if ( sei_svc == NULL )
+    {
+        sei_svc = s->svc_buf = (sei_scalability_info_t*)calloc(1, sizeof(sei_scalability_info_t));
+    }
+    sei_svc->temporal_id_nesting_flag = 0;
+    sei_svc->priority_layer_info_present_flag = 0;
+    sei_svc->priority_id_setting_flag = 0;
+    sei_svc->num_layers_minus1 = 0;
+    sei_svc->pr_num_dIds_minus1 = 0;
+    return sei_svc;
+}
+
+/**
+ Make room for num_layers entries in sei_svc->layers, and clear them.
+ */
+void sei_scalability_info_reserve_layers(sei_scalability_info_t* sei_svc, int num_layers)
+{
+    sei_svc->layers = (sei_scalability_layer_info_t*)sei_reserve(sei_svc->layers, &sei_svc->layers_capacity, num_layers, sizeof(sei_scalability_layer_info_t));
+    memset(sei_svc->layers, 0, num_layers * sizeof(sei_scalability_layer_info_t));
+}
+
+/**
+ Make room for num_pr entries in sei_svc->pr, and clear them (keeping their pr_info storage).
+ */
+void sei_scalability_info_reserve_pr(sei_scalability_info_t* sei_svc, int num_pr)
+{
+    sei_svc->pr = (sei_scalability_pr_t*)sei_reserve(sei_svc->pr, &sei_svc->pr_capacity, num_pr, sizeof(sei_scalability_pr_t));
+    for ( int i = 0; i < num_pr; i++ )
+    {
+        sei_svc->pr[i].pr_dependency_id = 0;
+        sei_svc->pr[i].pr_num_minus1 = 0;
+        memset(sei_svc->pr[i].priority_id_setting_uri, 0, MAX_LENGTH);
+    }
+}
+
+/**
+ Make room for num_pr_info entries in pr->pr_info, and clear them.
+ */
+void sei_scalability_pr_reserve_pr_info(sei_scalability_pr_t* pr, int num_pr_info)
+{
+    pr->pr_info = (sei_scalability_pr_info_t*)sei_reserve(pr->pr_info, &pr->pr_info_capacity, num_pr_info, sizeof(sei_scalability_pr_info_t));
+    memset(pr->pr_info, 0, num_pr_info * sizeof(sei_scalability_pr_info_t));
+}
+
+// reads the bytes of an escaped nal (with emulation prevention bytes), as the unescaped rbsp bytes
+typedef struct
+{
+    const uint8_t* p;
+    const uint8_t* end;
+    int zeros;      // number of consecutive 0x00 bytes just read, up to 2
+    int epb;        // number of emulation prevention bytes skipped
+} sei_cursor_t;
+
+static int sei_cursor_byte(sei_cursor_t* c)
+{
+    if ( c->p < c->end && c->zeros >= 2 && *c->p == 0x03 ) { c->p++; c->zeros = 0; c->epb++; }
+    if ( c->p >= c->end ) { return -1; }
+    int v = *c->p++;
+    c->zeros = ( v == 0 ) ? ( c->zeros < 2 ? c->zeros + 1 : 2 ) : 0;
+    return v;
+}
+
+// skip n rbsp bytes; runs without an 0x03 byte are skipped at once
+static void sei_cursor_skip(sei_cursor_t* c, int n)
+{
+    while ( n > 0 && c->p < c->end )
+    {
+        int avail = ( c->end - c->p < n ) ? (int)( c->end - c->p ) : n;
+        const uint8_t* q = (const uint8_t*)memchr(c->p, 0x03, avail);
+        int k = ( q == NULL ) ? avail : (int)( q - c->p );
+        if ( k > 0 )
+        {
+            int z = 0;
+            while ( z < k && z < 2 && c->p[k - 1 - z] == 0 ) { z++; }
+            c->zeros = ( z == k ) ? ( c->zeros + z < 2 ? c->zeros + z : 2 ) : z;
+            c->p += k;
+            n -= k;
+        }
+        if ( q != NULL && n > 0 ) { sei_cursor_byte(c); n--; }
+    }
+}
+
+static int sei_cursor_ff_coded_number(sei_cursor_t* c)
+{
+    int n = 0;
+    int v;
+    do
+    {
+        v = sei_cursor_byte(c);
+        if ( v < 0 ) { return -1; }
+        n += v;
+    } while ( v == 0xFF );
+    return n;
+}
+
+/**
+ Check if a SEI payload passes a filter.
+ @param[in]  filter       the filter, NULL passes everything
+ @param[in]  payloadType  type of the payload
+ @param[in]  uuid         first 16 bytes of the payload, only used for user_data_unregistered; NULL if not available
+ @return     1 if the payload passes, 0 if not
+ */
+int sei_filter_accepts(const sei_filter_t* filter, int payloadType, const uint8_t* uuid)
+{
+    if ( filter == NULL ) { return 1; }
+
+    int i;
+    for ( i = 0; i < filter->num_types; i++ ) { if ( filter->types[i] == payloadType ) { break; } }
+    if ( filter->num_types > 0 && i == filter->num_types ) { return 0; }
+
+    if ( payloadType == SEI_TYPE_USER_DATA_UNREGISTERED && filter->num_uuids > 0 )
+    {
+        if ( uuid == NULL ) { return 0; }
+        for ( i = 0; i < filter->num_uuids; i++ ) { if ( memcmp(uuid, filter->uuids + 16 * i, 16) == 0 ) { return 1; } }
+        return 0;
+    }
+    return 1;
+}
+
+static int sei_filter_match(const sei_filter_t* filter, int payloadType, const sei_cursor_t* c)
+{
+    uint8_t uuid[16];
+    int have_uuid = 0;
+    if ( filter != NULL && payloadType == SEI_TYPE_USER_DATA_UNREGISTERED && filter->num_uuids > 0 )
+    {
+        sei_cursor_t tmp = *c;
+        for ( have_uuid = 0; have_uuid < 16; have_uuid++ )
+        {
+            int v = sei_cursor_byte(&tmp);
+            if ( v < 0 ) { break; }
+            uuid[have_uuid] = v;
+        }
+    }
+    return sei_filter_accepts(filter, payloadType, ( have_uuid == 16 ) ? uuid : NULL);
+}
+
+/**
+ Find SEI payloads in a SEI NAL without parsing, allocating or unescaping the rest of it.
+ Payloads which do not pass the filter are skipped by their size.  A returned payload points into the nal itself,
+ unless it contains emulation prevention bytes; then it is unescaped into scratch.
+ @param[in]  nal           the SEI NAL, starting with the NAL header byte
+ @param[in]  nal_size      size of the nal
+ @param[in]  filter        payload types (and uuids of user_data_unregistered) to return, NULL for all
+ @param[out] views         the payloads found
+ @param[in]  max_views     size of views
+ @param[in]  scratch       buffer for payloads which have to be unescaped, may be NULL
+ @param[in]  scratch_size  size of scratch
+ @return     number of payloads found, which may be more than max_views (only max_views are filled in), or -1 if this is not a SEI NAL.
+             A payload which did not fit into scratch is returned with data NULL.
+ */
+int sei_find_payloads(const uint8_t* nal, int nal_size, const sei_filter_t* filter, sei_view_t* views, int max_views, uint8_t* scratch, int scratch_size)
+{
+    if ( nal_size < 1 || ( nal[0] & 0x1F ) != NAL_UNIT_TYPE_SEI ) { return -1; }
+
+    sei_cursor_t c;
+    c.p = nal + 1;
+    c.end = nal + nal_size;
+    c.zeros = 0;
+    c.epb = 0;
+
+    int found = 0;
+    int scratch_used = 0;
+
+    // a message takes at least 2 bytes, the last byte is the rbsp trailing bits
+    while ( c.end - c.p >= 2 )
+    {
+        int payloadType = sei_cursor_ff_coded_number(&c);
+        int payloadSize = sei_cursor_ff_coded_number(&c);
+        if ( payloadType < 0 || payloadSize < 0 ) { break; }
+
+        if ( !sei_filter_match(filter, payloadType, &c) )
+        {
+            sei_cursor_skip(&c, payloadSize);
+            continue;
+        }
+
+        sei_cursor_t start = c;
+        sei_cursor_skip(&c, payloadSize);
+        if ( found < max_views )
+        {
+            sei_view_t* v = &views[found];
+            v->payloadType = payloadType;
+            v->payloadSize = payloadSize;
+            if ( c.epb == start.epb && !( start.zeros >= 2 && start.p < start.end && *start.p == 0x03 ) )
+            {
+                v->data = start.p;
+                if ( c.p - start.p < payloadSize ) { v->payloadSize = c.p - start.p; } // truncated nal
+            }
+            else if ( scratch != NULL && scratch_size - scratch_used >= payloadSize )
+            {
+                int i;
+                for ( i = 0; i < payloadSize; i++ )
+                {
+                    int b = sei_cursor_byte(&start);
+                    if ( b < 0 ) { break; }
+                    scratch[scratch_used + i] = b;
+                }
+                v->data = scratch + scratch_used;
+                v->payloadSize = i;
+                scratch_used += i;
+            }
+            else
+            {
+                v->data = NULL;
+            }
+        }
+        found++;
+    }
+
+    return found;
+}
+
+/**
+ Size of a SEI payload when written.  Raw payloads are their payloadSize, parsed payloads are sized with a dry run of the writer
+ (which uses the parameter sets of h, as writing does).
+ */
+int sei_payload_size(h264_stream_t* h, sei_t* s)
+{
+    int t = s->payloadType;
+    if( t != SEI_TYPE_BUFFERING_PERIOD && t != SEI_TYPE_PIC_TIMING && t != SEI_TYPE_RECOVERY_POINT && t != SEI_TYPE_SCALABILITY_INFO )
+    {
+        return s->payloadSize;
+    }
+
+    // writes past the end of a bitstream only advance the position
+    uint8_t tmp[1];
+    bs_t b;
+    bs_init(&b, tmp, 0);
+    sei_t* sei = h->sei;
+    h->sei = s;
+    write_sei_payload(h, &b);
+    h->sei = sei;
+    return b.p - b.start;
+}
+
 void read_sei_end_bits(h264_stream_t* h, bs_t* b )
 {
     // if the message doesn't end at a byte border
@@ -82,6 +364,10 @@ void structure(sei_scalability_info)( h264_stream_t* h, bs_t* b )
     value( sei_svc->priority_layer_info_present_flag, u1 );
     value( sei_svc->priority_id_setting_flag, u1 );
     value( sei_svc->num_layers_minus1, ue );
+    if( is_reading )
+    {
+        sei_scalability_info_reserve_layers( sei_svc, sei_svc->num_layers_minus1 + 1 );
+    }
     
     for( int i = 0; i <= sei_svc->num_layers_minus1; i++ ) {
         value( sei_svc->layers[i].layer_id, ue );
@@ -229,10 +515,18 @@ void structure(sei_scalability_info)( h264_stream_t* h, bs_t* b )
     if( sei_svc->priority_layer_info_present_flag )
     {
         value( sei_svc->pr_num_dIds_minus1, ue );
+        if( is_reading )
+        {
+            sei_scalability_info_reserve_pr( sei_svc, sei_svc->pr_num_dIds_minus1 + 1 );
+        }
         
         for( int i = 0; i <= sei_svc->pr_num_dIds_minus1; i++ ) {
             value( sei_svc->pr[i].pr_dependency_id, u(3) );
             value( sei_svc->pr[i].pr_num_minus1, ue );
+            if( is_reading )
+            {
+                sei_scalability_pr_reserve_pr_info( &sei_svc->pr[i], sei_svc->pr[i].pr_num_minus1 + 1 );
+            }
             for( int j = 0; j <= sei_svc->pr[i].pr_num_minus1; j++ )
             {
                 value( sei_svc->pr[i].pr_info[j].pr_id, ue );
@@ -246,29 +540,176 @@ void structure(sei_scalability_info)( h264_stream_t* h, bs_t* b )
 
 }
 
+// D.1.1 Buffering period SEI message syntax
+void structure(sei_buffering_period)( h264_stream_t* h, bs_t* b )
+{
+    sei_buffering_t* bp = &h->sei->bp;
+
+    value( bp->seq_parameter_set_id, ue );
+
+    sps_t* sps = h->sps_table[ bp->seq_parameter_set_id & 0x1F ];
+    if( sps->vui.nal_hrd_parameters_present_flag )
+    {
+        for( int SchedSelIdx = 0; SchedSelIdx <= sps->hrd_nal.cpb_cnt_minus1 && SchedSelIdx < 32; SchedSelIdx++ )
+        {
+            value( bp->nal[SchedSelIdx].initial_cpb_removal_delay, u(sps->hrd_nal.initial_cpb_removal_delay_length_minus1 + 1) );
+            value( bp->nal[SchedSelIdx].initial_cpb_removal_delay_offset, u(sps->hrd_nal.initial_cpb_removal_delay_length_minus1 + 1) );
+        }
+    }
+    if( sps->vui.vcl_hrd_parameters_present_flag )
+    {
+        for( int SchedSelIdx = 0; SchedSelIdx <= sps->hrd_vcl.cpb_cnt_minus1 && SchedSelIdx < 32; SchedSelIdx++ )
+        {
+            value( bp->vcl[SchedSelIdx].initial_cpb_removal_delay, u(sps->hrd_vcl.initial_cpb_removal_delay_length_minus1 + 1) );
+            value( bp->vcl[SchedSelIdx].initial_cpb_removal_delay_offset, u(sps->hrd_vcl.initial_cpb_removal_delay_length_minus1 + 1) );
+        }
+    }
+}
+
+// D.1.2 Picture timing SEI message syntax
+void structure(sei_pic_timing)( h264_stream_t* h, bs_t* b )
+{
+    // Table D-1, NumClockTS by pic_struct
+    static const int num_clock_ts_table[16] = { 1, 1, 1, 2, 2, 3, 3, 2, 3, 0, 0, 0, 0, 0, 0, 0 };
+    sei_picture_timing_t* pt = &h->sei->pt;
+    sps_t* sps = h->sps;
+    // the lengths come from the nal hrd parameters if present, else from the vcl ones (they must be equal if both are present)
+    hrd_t* hrd = sps->vui.nal_hrd_parameters_present_flag ? &sps->hrd_nal : &sps->hrd_vcl;
+    // without hrd parameters time_offset_length is inferred to be 24 (E.2.2)
+    int time_offset_length = ( sps->vui.nal_hrd_parameters_present_flag || sps->vui.vcl_hrd_parameters_present_flag ) ? hrd->time_offset_length : 24;
+
+    if( sps->vui.nal_hrd_parameters_present_flag || sps->vui.vcl_hrd_parameters_present_flag )
+    {
+        value( pt->cpb_removal_delay, u(hrd->cpb_removal_delay_length_minus1 + 1) );
+        value( pt->dpb_output_delay, u(hrd->dpb_output_delay_length_minus1 + 1) );
+    }
+    if( sps->vui.pic_struct_present_flag )
+    {
+        value( pt->pic_struct, u(4) );
+        for( int i = 0; i < num_clock_ts_table[ pt->pic_struct & 0x0F ]; i++ )
+        {
+            value( pt->clock_timestamps[i].clock_timestamp_flag, u1 );
+            if( pt->clock_timestamps[i].clock_timestamp_flag )
+            {
+                value( pt->clock_timestamps[i].ct_type, u(2) );
+                value( pt->clock_timestamps[i].nuit_field_based_flag, u1 );
+                value( pt->clock_timestamps[i].counting_type, u(5) );
+                value( pt->clock_timestamps[i].full_timestamp_flag, u1 );
+                value( pt->clock_timestamps[i].discontinuity_flag, u1 );
+                value( pt->clock_timestamps[i].cnt_dropped_flag, u1 );
+                value( pt->clock_timestamps[i].n_frames, u8 );
+                if( pt->clock_timestamps[i].full_timestamp_flag )
+                {
+                    value( pt->clock_timestamps[i].seconds_value, u(6) );
+                    value( pt->clock_timestamps[i].minutes_value, u(6) );
+                    value( pt->clock_timestamps[i].hours_value, u(5) );
+                }
+                else
+                {
+                    value( pt->clock_timestamps[i].seconds_flag, u1 );
+                    if( pt->clock_timestamps[i].seconds_flag )
+                    {
+                        value( pt->clock_timestamps[i].seconds_value, u(6) );
+                        value( pt->clock_timestamps[i].minutes_flag, u1 );
+                        if( pt->clock_timestamps[i].minutes_flag )
+                        {
+                            value( pt->clock_timestamps[i].minutes_value, u(6) );
+                            value( pt->clock_timestamps[i].hours_flag, u1 );
+                            if( pt->clock_timestamps[i].hours_flag )
+                            {
+                                value( pt->clock_timestamps[i].hours_value, u(5) );
+                            }
+                        }
+                    }
+                }
+                if( time_offset_length > 0 )
+                {
+                    // i(v), two's complement
+                    value( pt->clock_timestamps[i].time_offset, u(time_offset_length) );
+                    if( is_reading && time_offset_length < 32 && ( pt->clock_timestamps[i].time_offset >> ( time_offset_length - 1 ) ) )
+                    {
+                        pt->clock_timestamps[i].time_offset = (int)( (uint32_t)pt->clock_timestamps[i].time_offset | ~( ( 1u << time_offset_length ) - 1 ) );
+                    }
+                }
+            }
+        }
+    }
+}
+
+// D.1.7 Recovery point SEI message syntax
+void structure(sei_recovery_point)( h264_stream_t* h, bs_t* b )
+{
+    sei_recovery_point_t* rp = &h->sei->rp;
+
+    value( rp->recovery_frame_cnt, ue );
+    value( rp->exact_match_flag, u1 );
+    value( rp->broken_link_flag, u1 );
+    value( rp->changing_slice_group_idc, u(2) );
+}
+
 // D.1 SEI payload syntax
 void structure(sei_payload)( h264_stream_t* h, bs_t* b )
 {
     sei_t* s = h->sei;
+    uint8_t* payload_start = b->p; // payloads start byte aligned
     
     int i;
     switch( s->payloadType )
     {
+        case SEI_TYPE_BUFFERING_PERIOD:
+            if( is_reading ) { memset( &s->bp, 0, sizeof(sei_buffering_t) ); }
+            structure(sei_buffering_period)( h, b );
+            break;
+        case SEI_TYPE_PIC_TIMING:
+            if( is_reading ) { memset( &s->pt, 0, sizeof(sei_picture_timing_t) ); }
+            structure(sei_pic_timing)( h, b );
+            break;
+        case SEI_TYPE_RECOVERY_POINT:
+            if( is_reading ) { memset( &s->rp, 0, sizeof(sei_recovery_point_t) ); }
+            structure(sei_recovery_point)( h, b );
+            break;
         case SEI_TYPE_SCALABILITY_INFO:
             if( is_reading )
             {
-                s->sei_svc = (uint8_t*)calloc( 1, sizeof(sei_scalability_info_t) );
+                s->sei_svc = sei_reserve_svc( s );
             }
             structure(sei_scalability_info)( h, b );
             break;
         default:
             if( is_reading )
             {
-                s->data = (uint8_t*)calloc(1, s->payloadSize);
+                s->data = sei_reserve_data( s, s->payloadSize );
             }
             
-            for ( i = 0; i < s->payloadSize; i++ )
-                value( s->data[i], u8 );
+            // raw payloads start byte aligned, copy them in one go; the debug reader prints every byte
+            if( is_reading && !is_debug && bs_byte_aligned(b) )
+            {
+                int n = bs_read_bytes( b, s->data, s->payloadSize );
+                if( n < s->payloadSize ) { memset( s->data + n, 0, s->payloadSize - n ); }
+            }
+            else if( is_writing && bs_byte_aligned(b) )
+            {
+                bs_write_bytes( b, s->data, s->payloadSize );
+            }
+            else
+            {
+                for ( i = 0; i < s->payloadSize; i++ )
+                    value( s->data[i], u8 );
+            }
+            return;
+    }
+
+    // parsed payloads: skip any reserved or extension bits up to the signalled size,
+    // or when writing, end the payload at a byte border with bit_equal_to_one and bit_equal_to_zero
+    if( is_reading )
+    {
+        b->p = ( s->payloadSize < b->end - payload_start ) ? payload_start + s->payloadSize : b->end;
+        b->bits_left = 8;
+    }
+    if( is_writing && !bs_byte_aligned(b) )
+    {
+        bs_write_u1(b, 1);
+        while( !bs_byte_aligned(b) ) { bs_write_u1(b, 0); }
     }
     
     //if( is_reading )
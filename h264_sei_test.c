@@ -0,0 +1,501 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+// Checks of reading SEI NALs with read_nal_unit: a hand-made SEI NAL is read through several filters, each of which has to
+// keep exactly the payloads it selects, the raw ones byte for byte as they were before emulation prevention.
+// The first SEI NAL of each input file is read twice on one stream, with the hand-made one in between: the second read has
+// to give the same messages, in the message objects and storage of the first.
+// Buffering period, picture timing and recovery point messages are written, read back and written again, under an SPS with
+// nal and vcl HRD parameters and pic_struct_present_flag, and under one without HRD parameters (time_offset_length 24).
+// h264_au_splice_sei inserts messages into hand-made access units, or replaces some of their messages: the new SEI NAL has to
+// be where it belongs and read back with the messages it should have, and the untouched NALs come out as references to the input.
+
+#include "h264_stream.h"
+#include "h264_sei.h"
+#include "h264_au.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const uint8_t uuid[16] = { 0xDC, 0x45, 0xE9, 0xBD, 0xE6, 0xD9, 0x48, 0xB7, 0x96, 0x2C, 0xD8, 0x20, 0xD9, 0x23, 0xEE, 0xEF };
+static const uint8_t other_uuid[16] = { 0x01 };
+
+// the raw payloads have zero bytes which get emulation prevention bytes in the NAL
+static const uint8_t registered[6] = { 0xB5, 0x00, 0x31, 0x00, 0x00, 0x01 };
+static const uint8_t unregistered[20] = { 0xDC, 0x45, 0xE9, 0xBD, 0xE6, 0xD9, 0x48, 0xB7, 0x96, 0x2C, 0xD8, 0x20, 0xD9, 0x23, 0xEE, 0xEF,
+                                          'a', 0x00, 0x00, 0x00 };
+
+// an SEI NAL of a registered, an unregistered and a recovery point payload
+static int make_sei_nal(uint8_t* nal, int nal_capacity)
+{
+    uint8_t rbsp[64];
+    int n = 0;
+    rbsp[n++] = NAL_UNIT_TYPE_SEI;
+    rbsp[n++] = SEI_TYPE_USER_DATA_REGISTERED_ITU_T_T35;
+    rbsp[n++] = sizeof(registered);
+    memcpy(rbsp + n, registered, sizeof(registered));
+    n += sizeof(registered);
+    rbsp[n++] = SEI_TYPE_USER_DATA_UNREGISTERED;
+    rbsp[n++] = sizeof(unregistered);
+    memcpy(rbsp + n, unregistered, sizeof(unregistered));
+    n += sizeof(unregistered);
+    rbsp[n++] = SEI_TYPE_RECOVERY_POINT;
+    rbsp[n++] = 1;
+    rbsp[n++] = 0xC4;   // recovery_frame_cnt 0, exact_match_flag 1, broken_link_flag 0, changing_slice_group_idc 0
+    rbsp[n++] = 0x80;   // rbsp_trailing_bits
+
+    int nal_size = nal_capacity;
+    if (rbsp_to_nal(rbsp, &n, nal, &nal_size) < 0) { return -1; }
+    memmove(nal, nal + 1, nal_size - 1);  // rbsp_to_nal puts a zero byte first
+    return nal_size - 1;
+}
+
+typedef struct
+{
+    const char* name;
+    int types[3];
+    int num_types;
+    const uint8_t* uuid;
+    int kept[3];        // payload types which have to be kept, in order
+    int num_kept;
+} filter_case_t;
+
+static const filter_case_t filter_cases[] =
+{
+    { "all", { 0 }, 0, NULL, { 4, 5, 6 }, 3 },
+    { "unregistered", { 5 }, 1, NULL, { 5 }, 1 },
+    { "registered and recovery point", { 4, 6 }, 2, NULL, { 4, 6 }, 2 },
+    { "uuid", { 0 }, 0, uuid, { 4, 5, 6 }, 3 },
+    { "other uuid", { 0 }, 0, other_uuid, { 4, 6 }, 2 },
+    { "none", { 1 }, 1, NULL, { 0 }, 0 },
+};
+
+static int check_filter(h264_stream_t* h, const filter_case_t* c, uint8_t* nal, int size)
+{
+    sei_filter_t filter;
+    memset(&filter, 0, sizeof(filter));
+    filter.types = c->types;
+    filter.num_types = c->num_types;
+    filter.uuids = c->uuid;
+    filter.num_uuids = (c->uuid != NULL) ? 1 : 0;
+    h->sei_filter = &filter;
+
+    int failures = 0;
+    if (read_nal_unit(h, nal, size) < 0) { printf("filter %s: SEI not read \n", c->name); h->sei_filter = NULL; return 1; }
+    if (h->num_seis != c->num_kept) { printf("filter %s: %d payloads kept instead of %d \n", c->name, h->num_seis, c->num_kept); failures++; }
+
+    for (int i = 0; i < h->num_seis && i < c->num_kept; i++)
+    {
+        sei_t* s = h->seis[i];
+        if (s->payloadType != c->kept[i]) { printf("filter %s: payload %d has type %d instead of %d \n", c->name, i, s->payloadType, c->kept[i]); failures++; continue; }
+
+        const uint8_t* raw = (s->payloadType == SEI_TYPE_USER_DATA_REGISTERED_ITU_T_T35) ? registered : unregistered;
+        int raw_size = (s->payloadType == SEI_TYPE_USER_DATA_REGISTERED_ITU_T_T35) ? (int)sizeof(registered) : (int)sizeof(unregistered);
+        if (s->payloadType == SEI_TYPE_RECOVERY_POINT)
+        {
+            if (s->rp.recovery_frame_cnt != 0 || s->rp.exact_match_flag != 1 || s->rp.broken_link_flag != 0)
+            {
+                printf("filter %s: recovery point read wrong \n", c->name);
+                failures++;
+            }
+        }
+        else if (s->payloadSize != raw_size || memcmp(s->data, raw, raw_size) != 0)
+        {
+            printf("filter %s: payload of type %d not copied as it was \n", c->name, s->payloadType);
+            failures++;
+        }
+    }
+    h->sei_filter = NULL;
+    return failures;
+}
+
+static int check_reread(const char* name, uint8_t* other, int other_size)
+{
+    FILE* f = fopen(name, "rb");
+    if (f == NULL) { fprintf( stderr, "!! Error: could not open file: %s \n", name); return 1; }
+    fseek(f, 0, SEEK_END);
+    int size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = (uint8_t*)malloc(size);
+    if (fread(buf, 1, size, f) != (size_t)size) { fprintf( stderr, "!! Error: read failed: %s \n", name); fclose(f); free(buf); return 1; }
+    fclose(f);
+
+    h264_nal_iter_t it;
+    h264_nal_span_t nal;
+    h264_nal_iter_init(&it, buf, size, 0);
+    while (h264_nal_iter_next(&it, &nal) != 0 && (nal.size < 1 || (nal.buf[0] & 0x1F) != NAL_UNIT_TYPE_SEI)) { }
+    if (nal.size < 1 || (nal.buf[0] & 0x1F) != NAL_UNIT_TYPE_SEI) { printf("%s: no SEI \n", name); free(buf); return 1; }
+
+    sei_filter_t all;
+    memset(&all, 0, sizeof(all));
+    h264_stream_t* h = h264_new();
+    h->sei_filter = &all;
+    int failures = 0;
+
+    // a copy of what the first read gave
+    read_nal_unit(h, (uint8_t*)nal.buf, nal.size);
+    int num_seis = h->num_seis;
+    sei_t** seis = (sei_t**)malloc(num_seis * sizeof(sei_t*));
+    sei_t* first = (sei_t*)malloc(num_seis * sizeof(sei_t));
+    sei_scalability_info_t* svc = (sei_scalability_info_t*)calloc(num_seis, sizeof(sei_scalability_info_t));
+    sei_scalability_layer_info_t** layers = (sei_scalability_layer_info_t**)calloc(num_seis, sizeof(sei_scalability_layer_info_t*));
+    for (int i = 0; i < num_seis; i++)
+    {
+        seis[i] = h->seis[i];
+        first[i] = *h->seis[i];
+        if (first[i].payloadType == SEI_TYPE_SCALABILITY_INFO)
+        {
+            svc[i] = *first[i].sei_svc;
+            int n = svc[i].num_layers_minus1 + 1;
+            layers[i] = (sei_scalability_layer_info_t*)malloc(n * sizeof(sei_scalability_layer_info_t));
+            memcpy(layers[i], svc[i].layers, n * sizeof(sei_scalability_layer_info_t));
+        }
+    }
+
+    read_nal_unit(h, other, other_size);
+    read_nal_unit(h, (uint8_t*)nal.buf, nal.size);
+
+    if (h->num_seis != num_seis) { printf("%s: %d messages read again instead of %d \n", name, h->num_seis, num_seis); failures++; }
+    for (int i = 0; i < num_seis && i < h->num_seis; i++)
+    {
+        sei_t* s = h->seis[i];
+        if (s != seis[i]) { printf("%s: message %d not reused \n", name, i); failures++; }
+        if (s->payloadType != first[i].payloadType || s->payloadSize != first[i].payloadSize)
+        {
+            printf("%s: message %d has type %d, size %d instead of type %d, size %d \n", name, i, s->payloadType, s->payloadSize,
+                   first[i].payloadType, first[i].payloadSize);
+            failures++;
+            continue;
+        }
+        if (s->payloadType == SEI_TYPE_SCALABILITY_INFO)
+        {
+            int n = svc[i].num_layers_minus1 + 1;
+            if (s->sei_svc != first[i].sei_svc || s->sei_svc->layers != svc[i].layers || s->sei_svc->layers_capacity != svc[i].layers_capacity)
+            {
+                printf("%s: scalability information of message %d not read into the same storage \n", name, i);
+                failures++;
+            }
+            if (s->sei_svc->layers_capacity < n) { printf("%s: room for %d layers, not %d \n", name, s->sei_svc->layers_capacity, n); failures++; }
+            if (s->sei_svc->num_layers_minus1 != svc[i].num_layers_minus1 ||
+                memcmp(s->sei_svc->layers, layers[i], n * sizeof(sei_scalability_layer_info_t)) != 0)
+            {
+                printf("%s: scalability information of message %d read differently \n", name, i);
+                failures++;
+            }
+        }
+        else if (s->payloadType != SEI_TYPE_BUFFERING_PERIOD && s->payloadType != SEI_TYPE_PIC_TIMING &&
+                 s->payloadType != SEI_TYPE_RECOVERY_POINT && s->data != s->data_buf)
+        {
+            printf("%s: payload of message %d not read into the message's own storage \n", name, i);
+            failures++;
+        }
+    }
+
+    for (int i = 0; i < num_seis; i++) { free(layers[i]); }
+    free(layers);
+    free(svc);
+    free(first);
+    free(seis);
+    h->sei_filter = NULL;
+    h264_free(h);
+    free(buf);
+    return failures;
+}
+
+// an SPS with or without HRD parameters, written and read back into both streams
+static void set_sps(h264_stream_t* h, h264_stream_t* h2, int id, int with_hrd)
+{
+    uint8_t buf[256];
+    memset(h->sps, 0, sizeof(sps_t));
+    sps_t* sps = h->sps;
+    sps->profile_idc = 77;
+    sps->level_idc = 30;
+    sps->seq_parameter_set_id = id;
+    sps->chroma_format_idc = 1;
+    sps->pic_order_cnt_type = 2;
+    sps->num_ref_frames = 1;
+    sps->pic_width_in_mbs_minus1 = 19;
+    sps->pic_height_in_map_units_minus1 = 14;
+    sps->frame_mbs_only_flag = 1;
+    sps->vui_parameters_present_flag = 1;
+    sps->vui.pic_struct_present_flag = 1;
+    if (with_hrd)
+    {
+        sps->vui.nal_hrd_parameters_present_flag = 1;
+        sps->hrd_nal.cpb_cnt_minus1 = 1;
+        sps->hrd_nal.initial_cpb_removal_delay_length_minus1 = 17;
+        sps->hrd_nal.cpb_removal_delay_length_minus1 = 9;
+        sps->hrd_nal.dpb_output_delay_length_minus1 = 5;
+        sps->hrd_nal.time_offset_length = 11;
+        sps->vui.vcl_hrd_parameters_present_flag = 1;
+        sps->hrd_vcl = sps->hrd_nal;
+        sps->hrd_vcl.cpb_cnt_minus1 = 0;
+        sps->hrd_vcl.initial_cpb_removal_delay_length_minus1 = 23;
+    }
+    h->nal->nal_ref_idc = 3;
+    h->nal->nal_unit_type = NAL_UNIT_TYPE_SPS;
+    int n = write_nal_unit(h, buf, sizeof(buf)) - 1;
+    read_nal_unit(h, buf + 1, n);
+    read_nal_unit(h2, buf + 1, n);
+}
+
+static int check_timing(h264_stream_t* h, h264_stream_t* h2, const char* name)
+{
+    sei_filter_t all;
+    memset(&all, 0, sizeof(all));
+    uint8_t buf[256];
+    uint8_t buf2[256];
+    int failures = 0;
+
+    h->nal->nal_ref_idc = 0;
+    h->nal->nal_unit_type = NAL_UNIT_TYPE_SEI;
+    int n = write_nal_unit(h, buf, sizeof(buf)) - 1;
+    h2->sei_filter = &all;
+    if (read_nal_unit(h2, buf + 1, n) < 0 || h2->num_seis != h->num_seis) { printf("%s: SEI not read back \n", name); h2->sei_filter = NULL; return 1; }
+    h2->sei_filter = NULL;
+
+    for (int i = 0; i < h->num_seis; i++)
+    {
+        sei_t* s = h->seis[i];
+        sei_t* s2 = h2->seis[i];
+        int same = ( s2->payloadType == s->payloadType && s2->payloadSize == s->payloadSize );
+        if (same && s->payloadType == SEI_TYPE_BUFFERING_PERIOD) { same = ( memcmp(&s2->bp, &s->bp, sizeof(s->bp)) == 0 ); }
+        if (same && s->payloadType == SEI_TYPE_PIC_TIMING) { same = ( memcmp(&s2->pt, &s->pt, sizeof(s->pt)) == 0 ); }
+        if (same && s->payloadType == SEI_TYPE_RECOVERY_POINT) { same = ( memcmp(&s2->rp, &s->rp, sizeof(s->rp)) == 0 ); }
+        if (!same) { printf("%s: message %d of type %d read back differently \n", name, i, s->payloadType); failures++; }
+    }
+
+    int n2 = write_nal_unit(h2, buf2, sizeof(buf2)) - 1;
+    if (n2 != n || memcmp(buf2, buf, n + 1) != 0) { printf("%s: SEI written again as %d bytes instead of %d, or differs \n", name, n2, n); failures++; }
+    return failures;
+}
+
+static int check_timing_round_trip()
+{
+    h264_stream_t* h = h264_new();
+    h264_stream_t* h2 = h264_new();
+    int failures = 0;
+
+    h->seis = (sei_t**)malloc(3 * sizeof(sei_t*));
+    for (int i = 0; i < 3; i++) { h->seis[i] = sei_new(); }
+    h->seis_capacity = 3;
+    h->num_seis = 3;
+    sei_t* bp = h->seis[0];
+    sei_t* pt = h->seis[1];
+    sei_t* rp = h->seis[2];
+    bp->payloadType = SEI_TYPE_BUFFERING_PERIOD;
+    pt->payloadType = SEI_TYPE_PIC_TIMING;
+    rp->payloadType = SEI_TYPE_RECOVERY_POINT;
+
+    // with HRD parameters: two nal and one vcl schedules, and delays and a time offset of the lengths they give
+    set_sps(h, h2, 0, 1);
+    bp->bp.seq_parameter_set_id = 0;
+    bp->bp.nal[0].initial_cpb_removal_delay = 90000;
+    bp->bp.nal[0].initial_cpb_removal_delay_offset = 3;
+    bp->bp.nal[1].initial_cpb_removal_delay = 131071;
+    bp->bp.nal[1].initial_cpb_removal_delay_offset = 0;
+    bp->bp.vcl[0].initial_cpb_removal_delay = 8388607;
+    bp->bp.vcl[0].initial_cpb_removal_delay_offset = 1;
+    pt->pt.cpb_removal_delay = 1000;
+    pt->pt.dpb_output_delay = 33;
+    pt->pt.pic_struct = 4;  // top field, bottom field: two clock timestamps
+    picture_timestamp_t* ct = &pt->pt.clock_timestamps[0];
+    ct->clock_timestamp_flag = 1;
+    ct->ct_type = 1;
+    ct->counting_type = 4;
+    ct->full_timestamp_flag = 1;
+    ct->n_frames = 24;
+    ct->seconds_value = 59;
+    ct->minutes_value = 7;
+    ct->hours_value = 23;
+    ct->time_offset = -5;
+    ct = &pt->pt.clock_timestamps[1];
+    ct->clock_timestamp_flag = 1;
+    ct->nuit_field_based_flag = 1;
+    ct->discontinuity_flag = 1;
+    ct->n_frames = 255;
+    ct->seconds_flag = 1;
+    ct->seconds_value = 1;
+    ct->minutes_flag = 1;
+    ct->minutes_value = 2;
+    ct->time_offset = 1023;
+    rp->rp.recovery_frame_cnt = 12;
+    rp->rp.broken_link_flag = 1;
+    rp->rp.changing_slice_group_idc = 2;
+    failures += check_timing(h, h2, "with HRD");
+
+    // without HRD parameters: no delays, an empty buffering period, and 24 bit time offsets
+    set_sps(h, h2, 1, 0);
+    memset(&bp->bp, 0, sizeof(bp->bp));
+    bp->bp.seq_parameter_set_id = 1;
+    memset(&pt->pt, 0, sizeof(pt->pt));
+    pt->pt.pic_struct = 8;  // frame tripling: three clock timestamps
+    ct = &pt->pt.clock_timestamps[0];
+    ct->clock_timestamp_flag = 1;
+    ct->seconds_flag = 1;
+    ct->seconds_value = 30;
+    ct->time_offset = -8388608;
+    ct = &pt->pt.clock_timestamps[2];
+    ct->clock_timestamp_flag = 1;
+    ct->full_timestamp_flag = 1;
+    ct->cnt_dropped_flag = 1;
+    ct->time_offset = 8388607;
+    memset(&rp->rp, 0, sizeof(rp->rp));
+    rp->rp.exact_match_flag = 1;
+    failures += check_timing(h, h2, "without HRD");
+
+    h264_free(h2);
+    h264_free(h);
+    return failures;
+}
+
+typedef struct
+{
+    const char* name;
+    int flags;
+    int num_nals;
+    int nals[5];        // which of the au_nals of the access unit
+    int num_out;
+    int out[6];         // which of nals come out, in order, -1 for the new SEI NAL
+    int num_types;
+    int types[4];       // payload types of the new SEI NAL
+} splice_case_t;
+
+enum { AUD, SPS, PPS, SEI, IDR };
+
+static const splice_case_t splice_cases[] =
+{
+    { "insert after AUD, SPS and PPS", H264_SEI_SPLICE_INSERT, 4, { AUD, SPS, PPS, IDR }, 5, { 0, 1, 2, -1, 3 }, 1, { 6 } },
+    { "insert after SEI", H264_SEI_SPLICE_INSERT, 5, { AUD, SPS, PPS, SEI, IDR }, 6, { 0, 1, 2, 3, -1, 4 }, 1, { 6 } },
+    { "insert buffering period before SEI", H264_SEI_SPLICE_INSERT, 5, { AUD, SPS, PPS, SEI, IDR }, 6, { 0, 1, 2, -1, 3, 4 }, 2, { 0, 6 } },
+    { "replace recovery point", H264_SEI_SPLICE_REPLACE, 5, { AUD, SPS, PPS, SEI, IDR }, 5, { 0, 1, 2, -1, 4 }, 3, { 6, 4, 5 } },
+    { "replace without SEI", H264_SEI_SPLICE_REPLACE, 3, { AUD, PPS, IDR }, 4, { 0, 1, -1, 2 }, 1, { 6 } },
+    { "replace at the start", H264_SEI_SPLICE_REPLACE, 2, { SEI, IDR }, 2, { -1, 1 }, 3, { 6, 4, 5 } },
+};
+
+// inserts the recovery point rp, and the buffering period bp after it if the case expects one, which has to come out first
+static int check_splice(h264_stream_t* h, h264_stream_t* h2, const splice_case_t* c, const h264_nal_span_t* au_nals, sei_t* rp, sei_t* bp)
+{
+    h264_nal_span_t nals[5];
+    for (int i = 0; i < c->num_nals; i++) { nals[i] = au_nals[c->nals[i]]; }
+    sei_t* inserted[2] = { rp, bp };
+    int num_seis = (c->types[0] == SEI_TYPE_BUFFERING_PERIOD) ? 2 : 1;
+    uint8_t buf[128];
+    h264_iovec_t iov[12];
+    int failures = 0;
+
+    int n = h264_au_splice_sei(h, nals, c->num_nals, inserted, num_seis, c->flags, buf, sizeof(buf), iov, 12);
+    if (n != 2 * c->num_out) { printf("splice %s: %d pieces instead of %d \n", c->name, n, 2 * c->num_out); return 1; }
+
+    for (int i = 0; i < c->num_out; i++)
+    {
+        const h264_iovec_t* sc = &iov[2 * i];
+        const h264_iovec_t* v = &iov[2 * i + 1];
+        if (sc->len != 4 || memcmp(sc->base, "\0\0\0\1", 4) != 0) { printf("splice %s: no start code before NAL %d \n", c->name, i); failures++; }
+        if (c->out[i] >= 0)
+        {
+            // untouched, the NAL of the input itself
+            if (v->base != nals[c->out[i]].buf || v->len != nals[c->out[i]].size) { printf("splice %s: NAL %d is not NAL %d of the input \n", c->name, i, c->out[i]); failures++; }
+            continue;
+        }
+        if (v->base < buf || v->base + v->len > buf + sizeof(buf)) { printf("splice %s: NAL %d is not the new SEI \n", c->name, i); failures++; continue; }
+
+        sei_filter_t all;
+        memset(&all, 0, sizeof(all));
+        h2->sei_filter = &all;
+        int rc = read_nal_unit(h2, (uint8_t*)v->base, v->len);
+        h2->sei_filter = NULL;
+        int same = ( rc >= 0 && h2->num_seis == c->num_types );
+        for (int j = 0; same && j < c->num_types; j++)
+        {
+            sei_t* s = h2->seis[j];
+            if (s->payloadType != c->types[j]) { same = 0; }
+            else if (s->payloadType == SEI_TYPE_RECOVERY_POINT) { same = ( memcmp(&s->rp, &rp->rp, sizeof(s->rp)) == 0 ); }
+            else if (s->payloadType == SEI_TYPE_BUFFERING_PERIOD) { same = ( s->bp.seq_parameter_set_id == bp->bp.seq_parameter_set_id ); }
+            else if (s->payloadType == SEI_TYPE_USER_DATA_REGISTERED_ITU_T_T35) { same = ( s->payloadSize == sizeof(registered) && memcmp(s->data, registered, sizeof(registered)) == 0 ); }
+            else if (s->payloadType == SEI_TYPE_USER_DATA_UNREGISTERED) { same = ( s->payloadSize == sizeof(unregistered) && memcmp(s->data, unregistered, sizeof(unregistered)) == 0 ); }
+        }
+        if (!same) { printf("splice %s: the new SEI does not read back with the messages it should have \n", c->name); failures++; }
+    }
+    return failures;
+}
+
+static int check_splices(uint8_t* sei_nal, int sei_size)
+{
+    static const uint8_t aud[] = { 0x09, 0xF0 };
+    static const uint8_t sps[] = { 0x67, 0x4D, 0x00, 0x1E, 0xAB };  // not parsed by the splice
+    static const uint8_t pps[] = { 0x68, 0xCE, 0x38, 0x80 };
+    static const uint8_t idr[] = { 0x65, 0x88, 0x84, 0x00, 0x21 };
+    h264_nal_span_t au_nals[5] = { { aud, sizeof(aud) }, { sps, sizeof(sps) }, { pps, sizeof(pps) }, { sei_nal, sei_size }, { idr, sizeof(idr) } };
+
+    h264_stream_t* h = h264_new();
+    h264_stream_t* h2 = h264_new();
+    set_sps(h, h2, 1, 0);
+    sei_t* rp = sei_new();
+    rp->payloadType = SEI_TYPE_RECOVERY_POINT;
+    rp->rp.recovery_frame_cnt = 3;
+    rp->rp.changing_slice_group_idc = 1;
+    sei_t* bp = sei_new();
+    bp->payloadType = SEI_TYPE_BUFFERING_PERIOD;
+    bp->bp.seq_parameter_set_id = 1;
+
+    int failures = 0;
+    for (int i = 0; i < (int)(sizeof(splice_cases) / sizeof(splice_cases[0])); i++)
+    {
+        failures += check_splice(h, h2, &splice_cases[i], au_nals, rp, bp);
+    }
+
+    sei_free(bp);
+    sei_free(rp);
+    h264_free(h2);
+    h264_free(h);
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    int failures = 0;
+    int checks = 0;
+    uint8_t nal[128];
+    int size = make_sei_nal(nal, sizeof(nal));
+
+    // one stream for all, its messages are reused from one SEI to the next
+    h264_stream_t* h = h264_new();
+    for (int i = 0; i < (int)(sizeof(filter_cases) / sizeof(filter_cases[0])); i++)
+    {
+        failures += check_filter(h, &filter_cases[i], nal, size);
+        checks++;
+    }
+    h264_free(h);
+
+    failures += check_timing_round_trip();
+    checks++;
+    failures += check_splices(nal, size);
+    checks += (int)(sizeof(splice_cases) / sizeof(splice_cases[0]));
+
+    for (int i = 1; i < argc; i++)
+    {
+        failures += check_reread(argv[i], nal, size);
+        checks++;
+    }
+
+    printf("SEI checks: %d, mismatches: %d\n", checks, failures);
+    return (failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
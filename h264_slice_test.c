@@ -0,0 +1,255 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+// Checks that slices are written back as they were read: every slice of each input file is written unchanged and has to
+// come out byte for byte as in the file (trailing zero bytes aside), and then with a longer header (slice_qp_delta, and
+// idr_pic_id of IDR slices, changed), which has to read back with the new header and the same slice_data() bits. For every
+// NAL read, h264_peek_svc_slice_header has to find the same start of the slice header (and NAL header extension of an SVC
+// slice) as read_nal_unit, and nothing in other NALs.
+// With -s, the input files are spliced one after the other through h264_ps_remap: each file's parameter sets have to get the
+// output ids of the first file with the same content, or the next free ids, and its slices the same header and slice_data() bits
+// under the remapped pic_parameter_set_id; slices which keep theirs have to be passed through as they are.
+
+#include "h264_stream.h"
+#include "h264_rewrite.h"
+#include "h264_svc.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#define OUT_SIZE 4*1024*1024
+
+static int get_bit(const uint8_t* p, int i)
+{
+    return ( p[i >> 3] >> ( 7 - ( i & 7 ) ) ) & 1;
+}
+
+static uint8_t* read_file(const char* name, int* size)
+{
+    FILE* f = fopen(name, "rb");
+    if (f == NULL) { fprintf( stderr, "!! Error: could not open file: %s: %s \n", name, strerror(errno)); return NULL; }
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* buf = (uint8_t*)malloc(*size);
+    if (fread(buf, 1, *size, f) != (size_t)*size) { fprintf( stderr, "!! Error: read failed: %s \n", name); fclose(f); free(buf); return NULL; }
+    fclose(f);
+    return buf;
+}
+
+// the slice just read into h2 has the header of the one in h, with pic_parameter_set_id pps_id, and its slice data
+static int same_slice(h264_stream_t* h, h264_stream_t* h2, int pps_id)
+{
+    slice_header_t* sh = h->sh;
+    slice_header_t* sh2 = h2->sh;
+    slice_data_rbsp_t* sd = h->slice_data;
+    slice_data_rbsp_t* sd2 = h2->slice_data;
+    if (sh2->pic_parameter_set_id != pps_id || sh2->first_mb_in_slice != sh->first_mb_in_slice || sh2->slice_type != sh->slice_type ||
+        sh2->frame_num != sh->frame_num || sh2->slice_qp_delta != sh->slice_qp_delta || sd2->bit_size != sd->bit_size) { return 0; }
+    for (int i = 0; i < sd->bit_size; i++)
+    {
+        if (get_bit(sd->rbsp_buf, sd->bit_offset + i) != get_bit(sd2->rbsp_buf, sd2->bit_offset + i)) { return 0; }
+    }
+    return 1;
+}
+
+// h264_peek_svc_slice_header on the NAL just read into h
+static int same_peek(h264_stream_t* h, const uint8_t* nal, int size)
+{
+    h264_svc_slice_t slice;
+    int rc = h264_peek_svc_slice_header(nal, size, &slice);
+    int nal_unit_type = h->nal->nal_unit_type;
+    int svc = ( nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION && h->nal->svc_extension_flag );
+    if (nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_NON_IDR && nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_IDR && !svc) { return rc == 0; }
+    if (rc != 1 || slice.first_mb_in_slice != h->sh->first_mb_in_slice || slice.slice_type != h->sh->slice_type ||
+        slice.pic_parameter_set_id != h->sh->pic_parameter_set_id) { return 0; }
+
+    nal_svc_ext_t base_layer;
+    memset(&base_layer, 0, sizeof(nal_svc_ext_t));
+    nal_svc_ext_t* e = svc ? h->nal->nal_svc_ext : &base_layer;
+    nal_svc_ext_t* pe = &slice.nal_svc_ext;
+    return ( pe->idr_flag == e->idr_flag && pe->priority_id == e->priority_id && pe->no_inter_layer_pred_flag == e->no_inter_layer_pred_flag &&
+             pe->dependency_id == e->dependency_id && pe->quality_id == e->quality_id && pe->temporal_id == e->temporal_id &&
+             pe->use_ref_base_pic_flag == e->use_ref_base_pic_flag && pe->discardable_flag == e->discardable_flag &&
+             pe->output_flag == e->output_flag && pe->reserved_three_2bits == e->reserved_three_2bits );
+}
+
+static int check_splice(char** names, int num_inputs, int* num_slices)
+{
+    uint8_t** bufs = (uint8_t**)calloc(num_inputs, sizeof(uint8_t*));
+    int* sizes = (int*)calloc(num_inputs, sizeof(int));
+    int* pps_ids = (int*)calloc(num_inputs, sizeof(int));
+    h264_ps_remapper_t* r = h264_ps_remapper_new(num_inputs);
+    h264_stream_t* h = h264_new();
+    h264_stream_t* h2 = h264_new();
+    int next_id = 0;
+    int remapped = 0;
+    int failures = 0;
+
+    for (int i = 0; i < num_inputs; i++)
+    {
+        bufs[i] = read_file(names[i], &sizes[i]);
+        if (bufs[i] == NULL) { failures++; break; }
+
+        // a file with one SPS and one PPS: the same content as before gets the same ids, other content the next ones
+        pps_ids[i] = next_id;
+        for (int j = 0; j < i; j++)
+        {
+            if (sizes[j] == sizes[i] && memcmp(bufs[j], bufs[i], sizes[i]) == 0) { pps_ids[i] = pps_ids[j]; break; }
+        }
+        if (pps_ids[i] == next_id) { next_id++; }
+
+        h264_nal_iter_t it;
+        h264_nal_span_t nal;
+        h264_nal_span_t out;
+        int n = 0;
+        h264_nal_iter_init(&it, bufs[i], sizes[i], 0);
+        while (h264_nal_iter_next(&it, &nal) != 0)
+        {
+            n++;
+            if (h264_ps_remap(r, i, nal.buf, nal.size, &out) < 0) { printf("%s: NAL %d not remapped \n", names[i], n); failures++; continue; }
+            int nal_unit_type = nal.buf[0] & 0x1F;
+            if (nal_unit_type == NAL_UNIT_TYPE_PPS && read_nal_unit(h2, (uint8_t*)out.buf, out.size) >= 0 &&
+                h2->pps->pic_parameter_set_id != pps_ids[i])
+            {
+                printf("%s: PPS remapped to id %d instead of %d \n", names[i], h2->pps->pic_parameter_set_id, pps_ids[i]);
+                failures++;
+                continue;
+            }
+            if (nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_NON_IDR && nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_IDR)
+            {
+                read_nal_unit(h, (uint8_t*)nal.buf, nal.size);
+                read_nal_unit(h2, (uint8_t*)out.buf, out.size);
+                continue;
+            }
+            if (read_nal_unit(h, (uint8_t*)nal.buf, nal.size) < 0) { continue; }
+            (*num_slices)++;
+
+            if (read_nal_unit(h2, (uint8_t*)out.buf, out.size) < 0 || !same_slice(h, h2, pps_ids[i]))
+            {
+                printf("%s: NAL %d does not keep its header and slice data with PPS %d \n", names[i], n, pps_ids[i]);
+                failures++;
+            }
+            if (h->sh->pic_parameter_set_id != pps_ids[i]) { remapped++; }
+            else if (out.buf != nal.buf) { printf("%s: NAL %d with the same PPS id not passed through \n", names[i], n); failures++; }
+        }
+    }
+    if (r->remapped_slices != remapped) { printf("%d slices remapped instead of %d \n", r->remapped_slices, remapped); failures++; }
+
+    h264_free(h2);
+    h264_free(h);
+    h264_ps_remapper_free(r);
+    for (int i = 0; i < num_inputs; i++) { free(bufs[i]); }
+    free(pps_ids);
+    free(sizes);
+    free(bufs);
+    return failures;
+}
+
+static int check_file(const char* name, int* num_slices)
+{
+    int size;
+    uint8_t* buf = read_file(name, &size);
+    if (buf == NULL) { return 1; }
+
+    h264_stream_t* h = h264_new();
+    h264_stream_t* h2 = h264_new();
+    uint8_t* out = (uint8_t*)malloc(OUT_SIZE);
+    h264_nal_iter_t it;
+    h264_nal_span_t nal;
+    int n = 0;
+    int failures = 0;
+
+    h264_nal_iter_init(&it, buf, size, 0);
+    while (h264_nal_iter_next(&it, &nal) != 0)
+    {
+        uint8_t* p = (uint8_t*)nal.buf;
+        int len = nal.size;
+        n++;
+        if (read_nal_unit(h, p, len) < 0) { continue; }
+        read_nal_unit(h2, p, len);  // for the parameter sets
+        if (!same_peek(h, p, len))
+        {
+            printf("%s: NAL %d peeked differently from how it reads \n", name, n);
+            failures++;
+        }
+        int nal_unit_type = h->nal->nal_unit_type;
+        if (nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_NON_IDR && nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_IDR) { continue; }
+        (*num_slices)++;
+
+        // unchanged; write_nal_unit starts its output with a zero byte
+        int w = write_nal_unit(h, out, OUT_SIZE) - 1;
+        int l = len;
+        while (l > 0 && p[l - 1] == 0) { l--; }
+        if (w != l || memcmp(out + 1, p, w) != 0)
+        {
+            printf("%s: NAL %d written as %d bytes instead of %d, or differs \n", name, n, w, l);
+            failures++;
+        }
+
+        // a longer header in front of the same slice data
+        slice_data_rbsp_t* sd = h->slice_data;
+        int bit_offset = sd->bit_offset;
+        int bit_size = sd->bit_size;
+        uint8_t* data = (uint8_t*)malloc(sd->rbsp_size);
+        memcpy(data, sd->rbsp_buf, sd->rbsp_size);
+        h->sh->slice_qp_delta += 7;
+        if (nal_unit_type == NAL_UNIT_TYPE_CODED_SLICE_IDR) { h->sh->idr_pic_id += 300; }
+        w = write_nal_unit(h, out, OUT_SIZE) - 1;
+
+        int same = ( read_nal_unit(h2, out + 1, w) >= 0 && h2->sh->slice_qp_delta == h->sh->slice_qp_delta &&
+                     h2->sh->idr_pic_id == h->sh->idr_pic_id && h2->slice_data->bit_size == bit_size );
+        for (int i = 0; same && i < bit_size; i++)
+        {
+            if (get_bit(data, bit_offset + i) != get_bit(h2->slice_data->rbsp_buf, h2->slice_data->bit_offset + i)) { same = 0; }
+        }
+        if (!same)
+        {
+            printf("%s: NAL %d does not keep its slice data under a longer header \n", name, n);
+            failures++;
+        }
+        free(data);
+    }
+
+    free(out);
+    h264_free(h2);
+    h264_free(h);
+    free(buf);
+    return failures;
+}
+
+int main(int argc, char *argv[])
+{
+    int failures = 0;
+    int num_slices = 0;
+
+    if (argc > 1 && strcmp(argv[1], "-s") == 0)
+    {
+        failures += check_splice(argv + 2, argc - 2, &num_slices);
+        printf("slices spliced: %d, mismatches: %d\n", num_slices, failures);
+        return (failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    for (int i = 1; i < argc; i++) { failures += check_file(argv[i], &num_slices); }
+
+    printf("slices read and written back: %d, mismatches: %d\n", num_slices, failures);
+    return (failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -25,14 +25,142 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
 
 #include "bs.h"
 #include "h264_stream.h"
 #include "h264_sei.h"
 
-FILE* h264_dbgfile = NULL;
+#define H264_FIELD_NAME(id, name) name,
+static const char* const h264_field_names[] = { H264_FIELDS(H264_FIELD_NAME) NULL };
+#undef H264_FIELD_NAME
 
-#define printf(...) fprintf((h264_dbgfile == NULL ? stdout : h264_dbgfile), __VA_ARGS__)
+/**
+ Get the name of a syntax element reported to the debug callback.
+ @param[in] field_id  one of the H264_FIELD_* constants
+ @return    the element name as printed by read_debug_nal_unit, or NULL if the id is not valid
+ */
+const char* h264_field_name(int field_id)
+{
+    if (field_id < 0 || field_id >= H264_FIELD_COUNT) { return NULL; }
+    return h264_field_names[field_id];
+}
+
+/**
+ Look up the id of a syntax element by name, e.g. "sps->profile_idc".
+ Intended to be called once at setup, so that the debug callback only has to compare integers.
+ @return    one of the H264_FIELD_* constants, or -1 if no such element exists
+ */
+int h264_field_id(const char* name)
+{
+    for (int i = 0; i < H264_FIELD_COUNT; i++)
+    {
+        if (strcmp(h264_field_names[i], name) == 0) { return i; }
+    }
+    return -1;
+}
+
+/**
+ Write any buffered debug output of a stream to its file.  Does nothing for memory sinks.
+ @param[in,out] h   the stream object
+ */
+void h264_dbg_flush(h264_stream_t* h)
+{
+    h264_dbg_t* dbg = &h->dbg;
+    if (dbg->to_memory || dbg->buf_len == 0) { return; }
+    fwrite(dbg->buf, 1, dbg->buf_len, (dbg->file == NULL ? stdout : dbg->file));
+    dbg->buf_len = 0;
+    dbg->buf[0] = '\0';
+}
+
+/**
+ Send debug output of a stream to a file.  Output is buffered per stream and written in large blocks.
+ @param[in,out] h   the stream object
+ @param[in]     f   the file, or NULL for stdout
+ */
+void h264_dbg_set_file(h264_stream_t* h, FILE* f)
+{
+    h264_dbg_flush(h);
+    h->dbg.file = f;
+    h->dbg.to_memory = 0;
+}
+
+/**
+ Keep debug output of a stream in memory.  The text accumulates, NUL-terminated, in h->dbg.buf (h->dbg.buf_len bytes);
+ set h->dbg.buf_len to 0 to discard it.
+ @param[in,out] h   the stream object
+ */
+void h264_dbg_set_memory(h264_stream_t* h)
+{
+    h264_dbg_flush(h);
+    h->dbg.to_memory = 1;
+}
+
+/**
+ Set the callback which receives every syntax element read by read_debug_nal_unit.
+ @param[in,out] h       the stream object
+ @param[in]     cb      the callback, h264_debug_print_field to print to the debug sink, or NULL for no output
+ @param[in]     opaque  passed to the callback; h264_debug_print_field expects the stream object
+ */
+void h264_dbg_set_callback(h264_stream_t* h, h264_debug_field_cb cb, void* opaque)
+{
+    h->dbg.callback = cb;
+    h->dbg.opaque = opaque;
+}
+
+/**
+ printf into the debug sink of a stream.
+ */
+void h264_dbg_printf(h264_stream_t* h, const char* fmt, ...)
+{
+    h264_dbg_t* dbg = &h->dbg;
+    va_list ap;
+
+    if (dbg->buf == NULL)
+    {
+        dbg->buf_size = H264_DBG_BUF_SIZE;
+        dbg->buf = (char*)malloc(dbg->buf_size);
+        dbg->buf_len = 0;
+    }
+
+    while (1)
+    {
+        int room = dbg->buf_size - dbg->buf_len;
+        va_start(ap, fmt);
+        int n = vsnprintf(dbg->buf + dbg->buf_len, room, fmt, ap);
+        va_end(ap);
+        if (n < 0) { dbg->buf[dbg->buf_len] = '\0'; return; }
+        if (n < room) { dbg->buf_len += n; return; }
+
+        // did not fit: make room by flushing, or grow if it still won't fit (always, for memory sinks)
+        if (!dbg->to_memory && dbg->buf_len > 0) { h264_dbg_flush(h); continue; }
+        int size = dbg->buf_size * 2;
+        if (size < dbg->buf_len + n + 1) { size = dbg->buf_len + n + 1; }
+        dbg->buf = (char*)realloc(dbg->buf, size);
+        dbg->buf_size = size;
+    }
+}
+
+/**
+ Default debug callback, prints each element as "byte.bits_left: name: value".
+ @param[in] opaque  the stream object whose debug sink to print to; if NULL, prints to stdout
+ */
+void h264_debug_print_field(void* opaque, int field_id, int bit_offset, int bit_width, int64_t value)
+{
+    h264_stream_t* h = (h264_stream_t*)opaque;
+    // value is printed as int to keep the output identical to earlier versions
+    if (h == NULL) { printf("%d.%d: %s: %d \n", bit_offset / 8, 8 - bit_offset % 8, h264_field_name(field_id), (int)value); return; }
+    h264_dbg_printf(h, "%d.%d: %s: %d \n", bit_offset / 8, 8 - bit_offset % 8, h264_field_name(field_id), (int)value);
+}
+
+void h264_debug_field(bs_t* b, int field_id, int bit_offset, int64_t value)
+{
+    h264_stream_t* h = (h264_stream_t*)b->priv;
+    if (h == NULL) { h264_debug_print_field(NULL, field_id, bit_offset, bs_bit_pos(b) - bit_offset, value); return; }
+    if (h->dbg.callback == NULL) { return; }
+    h->dbg.callback(h->dbg.opaque, field_id, bit_offset, bs_bit_pos(b) - bit_offset, value);
+}
 
 /** 
  Calculate the log base 2 of the argument, rounded up. 
@@ -114,15 +242,27 @@ void _write_ff_coded_number(bs_t* b, int n)
     }
 }
 
-void debug_bytes(uint8_t* buf, int len)
+// number of bits of slice data from bit_offset of buf[0] up to the rbsp_stop_one_bit, leaving out the trailing bits and cabac_zero_words
+static int slice_data_bit_size(const uint8_t* buf, int size, int bit_offset)
+{
+    int i = size - 1;
+    while (i >= 0 && buf[i] == 0) { i--; }
+    if (i < 0) { return 0; }
+    int stop_bit = 0;
+    while (((buf[i] >> stop_bit) & 0x01) == 0) { stop_bit++; }
+    int bits = i * 8 + (7 - stop_bit) - bit_offset;
+    return (bits > 0) ? bits : 0;
+}
+
+void debug_bytes(h264_stream_t* h, uint8_t* buf, int len)
 {
     int i;
     for (i = 0; i < len; i++)
     {
-        printf("%02X ", buf[i]);
-        if ((i+1) % 16 == 0) { printf ("\n"); }
+        h264_dbg_printf(h, "%02X ", buf[i]);
+        if ((i+1) % 16 == 0) { h264_dbg_printf(h, "\n"); }
     }
-    printf("\n");
+    h264_dbg_printf(h, "\n");
 }
 
 
@@ -158,26 +298,42 @@ void read_dec_ref_base_pic_marking(nal_t* nal, bs_t* b);
 
 //7.3.1 NAL unit syntax
 int read_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
+{
+    uint8_t* rbsp_buf = (uint8_t*)calloc(1, size);
+    int rc = read_nal_unit_with_rbsp(h, buf, size, rbsp_buf, size);
+    free(rbsp_buf);
+    return rc;
+}
+
+/**
+ The same as nal_unit, with the rbsp in a buffer of the caller, so that nothing is allocated for the NAL itself
+ (the structures it is read into may still be, e.g. slice data or SEI payloads).
+ @param[in]  rbsp_buf       room for the rbsp; for reading it needs as many bytes as the NAL
+ @param[in]  rbsp_capacity  size of rbsp_buf
+ */
+int read_nal_unit_with_rbsp(h264_stream_t* h, uint8_t* buf, int size, uint8_t* rbsp_buf, int rbsp_capacity)
 {
     nal_t* nal = h->nal;
 
     int nal_size = size;
-    int rbsp_size = size;
-    uint8_t* rbsp_buf = (uint8_t*)calloc(1, rbsp_size);
+    int rbsp_size = rbsp_capacity;
 
     if( 1 )
     {
         int rc = nal_to_rbsp(buf, &nal_size, rbsp_buf, &rbsp_size);
 
-        if (rc < 0) { free(rbsp_buf); return -1; } // handle conversion error
+        if (rc < 0) { return -1; } // handle conversion error
     }
 
     if( 0 )
     {
         rbsp_size = size*3/4; // NOTE this may have to be slightly smaller (3/4 smaller, worst case) in order to be guaranteed to fit
+        if( rbsp_size > rbsp_capacity ) { rbsp_size = rbsp_capacity; }
     }
 
-    bs_t* b = bs_new(rbsp_buf, rbsp_size);
+    bs_t bs;
+    bs_t* b = bs_init(&bs, rbsp_buf, rbsp_size);
+    b->priv = h;
     /* forbidden_zero_bit */ bs_skip_u(b, 1);
     nal->nal_ref_idc = bs_read_u(b, 2);
     nal->nal_unit_type = bs_read_u(b, 5);
@@ -207,12 +363,14 @@ int read_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
             read_slice_layer_rbsp(h, b);
             break;
 
-#ifdef HAVE_SEI
         case NAL_UNIT_TYPE_SEI:
+#ifndef HAVE_SEI
+            // without HAVE_SEI, SEI is only read for a caller which asks for it with a filter
+            if( 1 && h->sei_filter == NULL ) { return -1; }
+#endif
             read_sei_rbsp(h, b);
             read_rbsp_trailing_bits(b);
             break;
-#endif
 
         case NAL_UNIT_TYPE_SPS: 
             read_seq_parameter_set_rbsp(h->sps, b);
@@ -221,6 +379,7 @@ int read_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
             if( 1 )
             {
                 memcpy(h->sps_table[h->sps->seq_parameter_set_id], h->sps, sizeof(sps_t));
+                h264_update_sps_ref(h, h->sps->seq_parameter_set_id);
             }
 
             break;
@@ -252,10 +411,11 @@ int read_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
             
             if( 1 )
             {
-                memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id], h->sps_subset, sizeof(sps_subset_t));
-                //memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps, h->sps_subset->sps, sizeof(sps_t));
-                //memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps_svc_ext, h->sps_subset->sps_svc_ext, sizeof(sps_svc_ext_t));
-                //h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->additional_extension2_flag = h->sps_subset->additional_extension2_flag;
+                //memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id], h->sps_subset, sizeof(sps_subset_t));
+                memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps, h->sps_subset->sps, sizeof(sps_t));
+                memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps_svc_ext, h->sps_subset->sps_svc_ext, sizeof(sps_svc_ext_t));
+                h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->additional_extension2_flag = h->sps_subset->additional_extension2_flag;
+                h264_update_sps_subset_ref(h, h->sps_subset->sps->seq_parameter_set_id);
             }
 
             break;
@@ -279,12 +439,10 @@ int read_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
         case NAL_UNIT_TYPE_CODED_SLICE_DATA_PARTITION_B: 
         case NAL_UNIT_TYPE_CODED_SLICE_DATA_PARTITION_C:
         default:
-            bs_free(b);
-            free(rbsp_buf);
             return -1;
     }
 
-    if (bs_overrun(b)) { bs_free(b); free(rbsp_buf); return -1; }
+    if (bs_overrun(b)) { return -1; }
 
     if( 0 )
     {
@@ -292,12 +450,9 @@ int read_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
         rbsp_size = bs_pos(b);
 
         int rc = rbsp_to_nal(rbsp_buf, &rbsp_size, buf, &nal_size);
-        if (rc < 0) { bs_free(b); free(rbsp_buf); return -1; }
+        if (rc < 0) { return -1; }
     }
 
-    bs_free(b);
-    free(rbsp_buf);
-
     return nal_size;
 }
 
@@ -801,28 +956,33 @@ void read_pic_parameter_set_rbsp(h264_stream_t* h, bs_t* b)
     if( 1 )
     {
         memcpy(h->pps_table[pps->pic_parameter_set_id], h->pps, sizeof(pps_t));
+        h264_update_pps_ref(h, pps->pic_parameter_set_id);
     }
 }
 
-#ifdef HAVE_SEI
 //7.3.2.3 Supplemental enhancement information RBSP syntax
 void read_sei_rbsp(h264_stream_t* h, bs_t* b)
 {
     if( 1 )
     {
-        for( int i = 0; i < h->num_seis; i++ )
-        {
-            sei_free(h->seis[i]);
-        }
-    
+        // messages and their payload storage are recycled from the previous sei, and only allocated when more are needed
+        if( h->seis_capacity < h->num_seis ) { h->seis_capacity = h->num_seis; }
         h->num_seis = 0;
         do {
+            if( h->num_seis == h->seis_capacity )
+            {
+                int capacity = ( h->seis_capacity > 0 ) ? h->seis_capacity * 2 : 4;
+                h->seis = (sei_t**)realloc(h->seis, capacity * sizeof(sei_t*));
+                for( int i = h->seis_capacity; i < capacity; i++ ) { h->seis[i] = sei_new(); }
+                h->seis_capacity = capacity;
+            }
+            h->sei = h->seis[h->num_seis];
             h->num_seis++;
-            h->seis = (sei_t**)realloc(h->seis, h->num_seis * sizeof(sei_t*));
-            h->seis[h->num_seis - 1] = sei_new();
-            h->sei = h->seis[h->num_seis - 1];
+            sei_reset(h->sei);
             read_sei_message(h, b);
+            if( h->sei == NULL ) { h->num_seis--; } // skipped by h->sei_filter, the message is reused for the next one
         } while( more_rbsp_data(b) );
+        h->sei = ( h->num_seis > 0 ) ? h->seis[h->num_seis - 1] : NULL;
     }
 
     if( 0 )
@@ -841,6 +1001,7 @@ void read_sei_message(h264_stream_t* h, bs_t* b)
 {
     if( 0 )
     {
+        h->sei->payloadSize = sei_payload_size(h, h->sei);
         _write_ff_coded_number(b, h->sei->payloadType);
         _write_ff_coded_number(b, h->sei->payloadSize);
     }
@@ -848,10 +1009,20 @@ void read_sei_message(h264_stream_t* h, bs_t* b)
     {
         h->sei->payloadType = _read_ff_coded_number(b);
         h->sei->payloadSize = _read_ff_coded_number(b);
+
+        if( h->sei_filter != NULL )
+        {
+            const uint8_t* uuid = ( bs_byte_aligned(b) && b->end - b->p >= 16 ) ? b->p : NULL;
+            if( !sei_filter_accepts( h->sei_filter, h->sei->payloadType, uuid ) )
+            {
+                bs_skip_bytes( b, h->sei->payloadSize );
+                h->sei = NULL;
+                return;
+            }
+        }
     }
     read_sei_payload( h, b );
 }
-#endif
 
 //7.3.2.4 Access unit delimiter RBSP syntax
 void read_access_unit_delimiter_rbsp(h264_stream_t* h, bs_t* b)
@@ -888,16 +1059,47 @@ void read_slice_layer_rbsp(h264_stream_t* h,  bs_t* b)
     
     slice_data_rbsp_t* slice_data = h->slice_data;
 
-    if ( slice_data != NULL )
+    if ( slice_data != NULL && 0 )
+    {
+        if ( slice_data->rbsp_buf != NULL )
+        {
+            // the header may have changed length, the slice data follows it bit for bit; with CABAC it starts byte aligned
+            if ( h->pps->entropy_coding_mode_flag )
+            {
+                while( !bs_byte_aligned(b) ) { bs_write_u1(b, 1); } // cabac_alignment_one_bit
+            }
+            bs_write_bits(b, slice_data->rbsp_buf, slice_data->bit_offset, slice_data->bit_size);
+            read_rbsp_trailing_bits(b);
+            return;
+        }
+    }
+    else if ( slice_data != NULL )
     {
         if ( slice_data->rbsp_buf != NULL ) free( slice_data->rbsp_buf ); 
-        uint8_t *sptr = b->p + (!!b->bits_left); // CABAC-specific: skip alignment bits, if there are any
+        // CAVLC slice data starts right after the header; CABAC slice data after the cabac_alignment_one_bits
+        uint8_t *sptr = b->p;
+        slice_data->bit_offset = 8 - b->bits_left;
+        if ( h->pps->entropy_coding_mode_flag && !bs_byte_aligned(b) )
+        {
+            sptr++;
+            slice_data->bit_offset = 0;
+        }
         slice_data->rbsp_size = b->end - sptr;
-        
-        slice_data->rbsp_buf = (uint8_t*)malloc(slice_data->rbsp_size);
-        memcpy( slice_data->rbsp_buf, sptr, slice_data->rbsp_size );
-        // ugly hack: since next NALU starts at byte border, we are going to be padded by trailing_bits;
-        return;
+
+        if ( slice_data->rbsp_size > 0 )
+        {
+            slice_data->rbsp_buf = (uint8_t*)malloc(slice_data->rbsp_size);
+            memcpy( slice_data->rbsp_buf, sptr, slice_data->rbsp_size );
+            slice_data->bit_size = slice_data_bit_size(slice_data->rbsp_buf, slice_data->rbsp_size, slice_data->bit_offset);
+            // ugly hack: since next NALU starts at byte border, we are going to be padded by trailing_bits;
+            return;
+        }
+        else
+        {
+            slice_data->rbsp_buf = NULL;
+            slice_data->rbsp_size = 0;
+            slice_data->bit_size = 0;
+        }
     }
 
     // FIXME should read or skip data
@@ -978,12 +1180,18 @@ void read_slice_header(h264_stream_t* h, bs_t* b)
     sps_t* sps = h->sps;
     memcpy(h->pps, h->pps_table[sh->pic_parameter_set_id], sizeof(pps_t));
     memcpy(h->sps, h->sps_table[pps->seq_parameter_set_id], sizeof(sps_t));
+    if( 1 )
+    {
+        h->pps_ref = h->pps_refs[sh->pic_parameter_set_id];
+        h->sps_ref = h->sps_refs[pps->seq_parameter_set_id];
+        h->sps_subset_ref = NULL;
+    }
 
     if (sps->residual_colour_transform_flag)
     {
         sh->colour_plane_id = bs_read_u(b, 2);
     }
-    
+
     sh->frame_num = bs_read_u(b, sps->log2_max_frame_num_minus4 + 4 ); // was u(v)
     if( !sps->frame_mbs_only_flag )
     {
@@ -1135,7 +1343,7 @@ void read_pred_weight_table(h264_stream_t* h, bs_t* b)
     int i, j;
 
     sh->pwt.luma_log2_weight_denom = bs_read_ue(b);
-    if( sps->chroma_format_idc != 0 )
+    if( sps->chroma_format_idc != 0 ) //FIXME ChromaArrayType may differ from chroma_format_idc
     {
         sh->pwt.chroma_log2_weight_denom = bs_read_ue(b);
     }
@@ -1147,7 +1355,7 @@ void read_pred_weight_table(h264_stream_t* h, bs_t* b)
             sh->pwt.luma_weight_l0[ i ] = bs_read_se(b);
             sh->pwt.luma_offset_l0[ i ] = bs_read_se(b);
         }
-        if ( sps->chroma_format_idc != 0 )
+        if ( sps->chroma_format_idc != 0 ) //FIXME ChromaArrayType may differ from chroma_format_idc
         {
             sh->pwt.chroma_weight_l0_flag[i] = bs_read_u1(b);
             if( sh->pwt.chroma_weight_l0_flag[i] )
@@ -1251,9 +1459,15 @@ void read_slice_header_in_scalable_extension(h264_stream_t* h, bs_t* b)
     pps_t* pps = h->pps;
     sps_subset_t* sps_subset = h->sps_subset;
     memcpy(h->pps, h->pps_table[sh->pic_parameter_set_id], sizeof(pps_t));
-    memcpy(sps_subset, h->sps_subset_table[pps->seq_parameter_set_id], sizeof(sps_subset_t));
-    //memcpy(h->sps_subset->sps, h->sps_subset_table[pps->seq_parameter_set_id]->sps, sizeof(sps_t));
-    //memcpy(h->sps_subset->sps_svc_ext, h->sps_subset_table[pps->seq_parameter_set_id]->sps_svc_ext, sizeof(sps_svc_ext_t));
+    //memcpy(sps_subset, h->sps_subset_table[pps->seq_parameter_set_id], sizeof(sps_subset_t));
+    memcpy(sps_subset->sps, h->sps_subset_table[pps->seq_parameter_set_id]->sps, sizeof(sps_t));
+    memcpy(sps_subset->sps_svc_ext, h->sps_subset_table[pps->seq_parameter_set_id]->sps_svc_ext, sizeof(sps_svc_ext_t));
+    if( 1 )
+    {
+        h->pps_ref = h->pps_refs[sh->pic_parameter_set_id];
+        h->sps_ref = NULL;
+        h->sps_subset_ref = h->sps_subset_refs[pps->seq_parameter_set_id];
+    }
     
     if (sps_subset->sps->residual_colour_transform_flag)
     {
@@ -1489,26 +1703,42 @@ void write_dec_ref_base_pic_marking(nal_t* nal, bs_t* b);
 
 //7.3.1 NAL unit syntax
 int write_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
+{
+    uint8_t* rbsp_buf = (uint8_t*)calloc(1, size);
+    int rc = write_nal_unit_with_rbsp(h, buf, size, rbsp_buf, size);
+    free(rbsp_buf);
+    return rc;
+}
+
+/**
+ The same as nal_unit, with the rbsp in a buffer of the caller, so that nothing is allocated for the NAL itself
+ (the structures it is read into may still be, e.g. slice data or SEI payloads).
+ @param[in]  rbsp_buf       room for the rbsp; for reading it needs as many bytes as the NAL
+ @param[in]  rbsp_capacity  size of rbsp_buf
+ */
+int write_nal_unit_with_rbsp(h264_stream_t* h, uint8_t* buf, int size, uint8_t* rbsp_buf, int rbsp_capacity)
 {
     nal_t* nal = h->nal;
 
     int nal_size = size;
-    int rbsp_size = size;
-    uint8_t* rbsp_buf = (uint8_t*)calloc(1, rbsp_size);
+    int rbsp_size = rbsp_capacity;
 
     if( 0 )
     {
         int rc = nal_to_rbsp(buf, &nal_size, rbsp_buf, &rbsp_size);
 
-        if (rc < 0) { free(rbsp_buf); return -1; } // handle conversion error
+        if (rc < 0) { return -1; } // handle conversion error
     }
 
     if( 1 )
     {
         rbsp_size = size*3/4; // NOTE this may have to be slightly smaller (3/4 smaller, worst case) in order to be guaranteed to fit
+        if( rbsp_size > rbsp_capacity ) { rbsp_size = rbsp_capacity; }
     }
 
-    bs_t* b = bs_new(rbsp_buf, rbsp_size);
+    bs_t bs;
+    bs_t* b = bs_init(&bs, rbsp_buf, rbsp_size);
+    b->priv = h;
     /* forbidden_zero_bit */ bs_write_u(b, 1, 0);
     bs_write_u(b, 2, nal->nal_ref_idc);
     bs_write_u(b, 5, nal->nal_unit_type);
@@ -1538,12 +1768,14 @@ int write_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
             write_slice_layer_rbsp(h, b);
             break;
 
-#ifdef HAVE_SEI
         case NAL_UNIT_TYPE_SEI:
+#ifndef HAVE_SEI
+            // without HAVE_SEI, SEI is only read for a caller which asks for it with a filter
+            if( 0 && h->sei_filter == NULL ) { return -1; }
+#endif
             write_sei_rbsp(h, b);
             write_rbsp_trailing_bits(b);
             break;
-#endif
 
         case NAL_UNIT_TYPE_SPS: 
             write_seq_parameter_set_rbsp(h->sps, b);
@@ -1552,6 +1784,7 @@ int write_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
             if( 0 )
             {
                 memcpy(h->sps_table[h->sps->seq_parameter_set_id], h->sps, sizeof(sps_t));
+                h264_update_sps_ref(h, h->sps->seq_parameter_set_id);
             }
 
             break;
@@ -1583,10 +1816,11 @@ int write_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
             
             if( 0 )
             {
-                memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id], h->sps_subset, sizeof(sps_subset_t));
-                //memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps, h->sps_subset->sps, sizeof(sps_t));
-                //memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps_svc_ext, h->sps_subset->sps_svc_ext, sizeof(sps_svc_ext_t));
-                //h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->additional_extension2_flag = h->sps_subset->additional_extension2_flag;
+                //memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id], h->sps_subset, sizeof(sps_subset_t));
+                memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps, h->sps_subset->sps, sizeof(sps_t));
+                memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps_svc_ext, h->sps_subset->sps_svc_ext, sizeof(sps_svc_ext_t));
+                h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->additional_extension2_flag = h->sps_subset->additional_extension2_flag;
+                h264_update_sps_subset_ref(h, h->sps_subset->sps->seq_parameter_set_id);
             }
 
             break;
@@ -1613,7 +1847,7 @@ int write_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
             return -1;
     }
 
-    if (bs_overrun(b)) { bs_free(b); free(rbsp_buf); return -1; }
+    if (bs_overrun(b)) { return -1; }
 
     if( 1 )
     {
@@ -1621,12 +1855,9 @@ int write_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
         rbsp_size = bs_pos(b);
 
         int rc = rbsp_to_nal(rbsp_buf, &rbsp_size, buf, &nal_size);
-        if (rc < 0) { bs_free(b); free(rbsp_buf); return -1; }
+        if (rc < 0) { return -1; }
     }
 
-    bs_free(b);
-    free(rbsp_buf);
-
     return nal_size;
 }
 
@@ -1724,7 +1955,7 @@ void write_seq_parameter_set_rbsp(sps_t* sps, bs_t* b)
         bs_write_u1(b, sps->seq_scaling_matrix_present_flag);
         if( sps->seq_scaling_matrix_present_flag )
         {
-            for( i = 0; i < 8; i++ )
+            for( i = 0; i < ((sps->chroma_format_idc != 3) ? 8 : 12); i++ )
             {
                 bs_write_u1(b, sps->seq_scaling_list_present_flag[ i ]);
                 if( sps->seq_scaling_list_present_flag[ i ] )
@@ -2130,28 +2361,33 @@ void write_pic_parameter_set_rbsp(h264_stream_t* h, bs_t* b)
     if( 0 )
     {
         memcpy(h->pps_table[pps->pic_parameter_set_id], h->pps, sizeof(pps_t));
+        h264_update_pps_ref(h, pps->pic_parameter_set_id);
     }
 }
 
-#ifdef HAVE_SEI
 //7.3.2.3 Supplemental enhancement information RBSP syntax
 void write_sei_rbsp(h264_stream_t* h, bs_t* b)
 {
     if( 0 )
     {
-        for( int i = 0; i < h->num_seis; i++ )
-        {
-            sei_free(h->seis[i]);
-        }
-    
+        // messages and their payload storage are recycled from the previous sei, and only allocated when more are needed
+        if( h->seis_capacity < h->num_seis ) { h->seis_capacity = h->num_seis; }
         h->num_seis = 0;
         do {
+            if( h->num_seis == h->seis_capacity )
+            {
+                int capacity = ( h->seis_capacity > 0 ) ? h->seis_capacity * 2 : 4;
+                h->seis = (sei_t**)realloc(h->seis, capacity * sizeof(sei_t*));
+                for( int i = h->seis_capacity; i < capacity; i++ ) { h->seis[i] = sei_new(); }
+                h->seis_capacity = capacity;
+            }
+            h->sei = h->seis[h->num_seis];
             h->num_seis++;
-            h->seis = (sei_t**)realloc(h->seis, h->num_seis * sizeof(sei_t*));
-            h->seis[h->num_seis - 1] = sei_new();
-            h->sei = h->seis[h->num_seis - 1];
+            sei_reset(h->sei);
             write_sei_message(h, b);
+            if( h->sei == NULL ) { h->num_seis--; } // skipped by h->sei_filter, the message is reused for the next one
         } while( more_rbsp_data(b) );
+        h->sei = ( h->num_seis > 0 ) ? h->seis[h->num_seis - 1] : NULL;
     }
 
     if( 1 )
@@ -2170,6 +2406,7 @@ void write_sei_message(h264_stream_t* h, bs_t* b)
 {
     if( 1 )
     {
+        h->sei->payloadSize = sei_payload_size(h, h->sei);
         _write_ff_coded_number(b, h->sei->payloadType);
         _write_ff_coded_number(b, h->sei->payloadSize);
     }
@@ -2177,10 +2414,20 @@ void write_sei_message(h264_stream_t* h, bs_t* b)
     {
         h->sei->payloadType = _read_ff_coded_number(b);
         h->sei->payloadSize = _read_ff_coded_number(b);
+
+        if( h->sei_filter != NULL )
+        {
+            const uint8_t* uuid = ( bs_byte_aligned(b) && b->end - b->p >= 16 ) ? b->p : NULL;
+            if( !sei_filter_accepts( h->sei_filter, h->sei->payloadType, uuid ) )
+            {
+                bs_skip_bytes( b, h->sei->payloadSize );
+                h->sei = NULL;
+                return;
+            }
+        }
     }
     write_sei_payload( h, b );
 }
-#endif
 
 //7.3.2.4 Access unit delimiter RBSP syntax
 void write_access_unit_delimiter_rbsp(h264_stream_t* h, bs_t* b)
@@ -2217,16 +2464,47 @@ void write_slice_layer_rbsp(h264_stream_t* h,  bs_t* b)
     
     slice_data_rbsp_t* slice_data = h->slice_data;
 
-    if ( slice_data != NULL )
+    if ( slice_data != NULL && 1 )
+    {
+        if ( slice_data->rbsp_buf != NULL )
+        {
+            // the header may have changed length, the slice data follows it bit for bit; with CABAC it starts byte aligned
+            if ( h->pps->entropy_coding_mode_flag )
+            {
+                while( !bs_byte_aligned(b) ) { bs_write_u1(b, 1); } // cabac_alignment_one_bit
+            }
+            bs_write_bits(b, slice_data->rbsp_buf, slice_data->bit_offset, slice_data->bit_size);
+            write_rbsp_trailing_bits(b);
+            return;
+        }
+    }
+    else if ( slice_data != NULL )
     {
         if ( slice_data->rbsp_buf != NULL ) free( slice_data->rbsp_buf ); 
-        uint8_t *sptr = b->p + (!!b->bits_left); // CABAC-specific: skip alignment bits, if there are any
+        // CAVLC slice data starts right after the header; CABAC slice data after the cabac_alignment_one_bits
+        uint8_t *sptr = b->p;
+        slice_data->bit_offset = 8 - b->bits_left;
+        if ( h->pps->entropy_coding_mode_flag && !bs_byte_aligned(b) )
+        {
+            sptr++;
+            slice_data->bit_offset = 0;
+        }
         slice_data->rbsp_size = b->end - sptr;
-        
-        slice_data->rbsp_buf = (uint8_t*)malloc(slice_data->rbsp_size);
-        memcpy( slice_data->rbsp_buf, sptr, slice_data->rbsp_size );
-        // ugly hack: since next NALU starts at byte border, we are going to be padded by trailing_bits;
-        return;
+
+        if ( slice_data->rbsp_size > 0 )
+        {
+            slice_data->rbsp_buf = (uint8_t*)malloc(slice_data->rbsp_size);
+            memcpy( slice_data->rbsp_buf, sptr, slice_data->rbsp_size );
+            slice_data->bit_size = slice_data_bit_size(slice_data->rbsp_buf, slice_data->rbsp_size, slice_data->bit_offset);
+            // ugly hack: since next NALU starts at byte border, we are going to be padded by trailing_bits;
+            return;
+        }
+        else
+        {
+            slice_data->rbsp_buf = NULL;
+            slice_data->rbsp_size = 0;
+            slice_data->bit_size = 0;
+        }
     }
 
     // FIXME should read or skip data
@@ -2307,12 +2585,18 @@ void write_slice_header(h264_stream_t* h, bs_t* b)
     sps_t* sps = h->sps;
     memcpy(h->pps, h->pps_table[sh->pic_parameter_set_id], sizeof(pps_t));
     memcpy(h->sps, h->sps_table[pps->seq_parameter_set_id], sizeof(sps_t));
+    if( 0 )
+    {
+        h->pps_ref = h->pps_refs[sh->pic_parameter_set_id];
+        h->sps_ref = h->sps_refs[pps->seq_parameter_set_id];
+        h->sps_subset_ref = NULL;
+    }
 
     if (sps->residual_colour_transform_flag)
     {
         bs_write_u(b, 2, sh->colour_plane_id);
     }
-    
+
     bs_write_u(b, sps->log2_max_frame_num_minus4 + 4 , sh->frame_num); // was u(v)
     if( !sps->frame_mbs_only_flag )
     {
@@ -2464,7 +2748,7 @@ void write_pred_weight_table(h264_stream_t* h, bs_t* b)
     int i, j;
 
     bs_write_ue(b, sh->pwt.luma_log2_weight_denom);
-    if( sps->chroma_format_idc != 0 )
+    if( sps->chroma_format_idc != 0 ) //FIXME ChromaArrayType may differ from chroma_format_idc
     {
         bs_write_ue(b, sh->pwt.chroma_log2_weight_denom);
     }
@@ -2476,7 +2760,7 @@ void write_pred_weight_table(h264_stream_t* h, bs_t* b)
             bs_write_se(b, sh->pwt.luma_weight_l0[ i ]);
             bs_write_se(b, sh->pwt.luma_offset_l0[ i ]);
         }
-        if ( sps->chroma_format_idc != 0 )
+        if ( sps->chroma_format_idc != 0 ) //FIXME ChromaArrayType may differ from chroma_format_idc
         {
             bs_write_u1(b, sh->pwt.chroma_weight_l0_flag[i]);
             if( sh->pwt.chroma_weight_l0_flag[i] )
@@ -2580,9 +2864,15 @@ void write_slice_header_in_scalable_extension(h264_stream_t* h, bs_t* b)
     pps_t* pps = h->pps;
     sps_subset_t* sps_subset = h->sps_subset;
     memcpy(h->pps, h->pps_table[sh->pic_parameter_set_id], sizeof(pps_t));
-    memcpy(sps_subset, h->sps_subset_table[pps->seq_parameter_set_id], sizeof(sps_subset_t));
-    //memcpy(h->sps_subset->sps, h->sps_subset_table[pps->seq_parameter_set_id]->sps, sizeof(sps_t));
-    //memcpy(h->sps_subset->sps_svc_ext, h->sps_subset_table[pps->seq_parameter_set_id]->sps_svc_ext, sizeof(sps_svc_ext_t));
+    //memcpy(sps_subset, h->sps_subset_table[pps->seq_parameter_set_id], sizeof(sps_subset_t));
+    memcpy(sps_subset->sps, h->sps_subset_table[pps->seq_parameter_set_id]->sps, sizeof(sps_t));
+    memcpy(sps_subset->sps_svc_ext, h->sps_subset_table[pps->seq_parameter_set_id]->sps_svc_ext, sizeof(sps_svc_ext_t));
+    if( 0 )
+    {
+        h->pps_ref = h->pps_refs[sh->pic_parameter_set_id];
+        h->sps_ref = NULL;
+        h->sps_subset_ref = h->sps_subset_refs[pps->seq_parameter_set_id];
+    }
     
     if (sps_subset->sps->residual_colour_transform_flag)
     {
@@ -2818,39 +3108,55 @@ void read_debug_dec_ref_base_pic_marking(nal_t* nal, bs_t* b);
 
 //7.3.1 NAL unit syntax
 int read_debug_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
+{
+    uint8_t* rbsp_buf = (uint8_t*)calloc(1, size);
+    int rc = read_debug_nal_unit_with_rbsp(h, buf, size, rbsp_buf, size);
+    free(rbsp_buf);
+    return rc;
+}
+
+/**
+ The same as nal_unit, with the rbsp in a buffer of the caller, so that nothing is allocated for the NAL itself
+ (the structures it is read into may still be, e.g. slice data or SEI payloads).
+ @param[in]  rbsp_buf       room for the rbsp; for reading it needs as many bytes as the NAL
+ @param[in]  rbsp_capacity  size of rbsp_buf
+ */
+int read_debug_nal_unit_with_rbsp(h264_stream_t* h, uint8_t* buf, int size, uint8_t* rbsp_buf, int rbsp_capacity)
 {
     nal_t* nal = h->nal;
 
     int nal_size = size;
-    int rbsp_size = size;
-    uint8_t* rbsp_buf = (uint8_t*)calloc(1, rbsp_size);
+    int rbsp_size = rbsp_capacity;
 
     if( 1 )
     {
         int rc = nal_to_rbsp(buf, &nal_size, rbsp_buf, &rbsp_size);
 
-        if (rc < 0) { free(rbsp_buf); return -1; } // handle conversion error
+        if (rc < 0) { return -1; } // handle conversion error
     }
 
     if( 0 )
     {
         rbsp_size = size*3/4; // NOTE this may have to be slightly smaller (3/4 smaller, worst case) in order to be guaranteed to fit
+        if( rbsp_size > rbsp_capacity ) { rbsp_size = rbsp_capacity; }
     }
 
-    bs_t* b = bs_new(rbsp_buf, rbsp_size);
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); int forbidden_zero_bit = bs_read_u(b, 1); printf("forbidden_zero_bit: %d \n", forbidden_zero_bit); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->nal_ref_idc = bs_read_u(b, 2); printf("nal->nal_ref_idc: %d \n", nal->nal_ref_idc); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->nal_unit_type = bs_read_u(b, 5); printf("nal->nal_unit_type: %d \n", nal->nal_unit_type); 
+    bs_t bs;
+    bs_t* b = bs_init(&bs, rbsp_buf, rbsp_size);
+    b->priv = h;
+    { int _pos = bs_bit_pos(b); h264_debug_field(b, H264_FIELD_FORBIDDEN_ZERO_BIT, _pos, bs_read_u(b, 1)); }
+    { int _pos = bs_bit_pos(b); nal->nal_ref_idc = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_NAL_NAL_REF_IDC, _pos, nal->nal_ref_idc); }
+    { int _pos = bs_bit_pos(b); nal->nal_unit_type = bs_read_u(b, 5); h264_debug_field(b, H264_FIELD_NAL_NAL_UNIT_TYPE, _pos, nal->nal_unit_type); }
     
     if( nal->nal_unit_type == 14 || nal->nal_unit_type == 21 || nal->nal_unit_type == 20 )
     {
         if( nal->nal_unit_type != 21 )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->svc_extension_flag = bs_read_u1(b); printf("nal->svc_extension_flag: %d \n", nal->svc_extension_flag); 
+            { int _pos = bs_bit_pos(b); nal->svc_extension_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_SVC_EXTENSION_FLAG, _pos, nal->svc_extension_flag); }
         }
         else
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->avc_3d_extension_flag = bs_read_u1(b); printf("nal->avc_3d_extension_flag: %d \n", nal->avc_3d_extension_flag); 
+            { int _pos = bs_bit_pos(b); nal->avc_3d_extension_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_AVC_3D_EXTENSION_FLAG, _pos, nal->avc_3d_extension_flag); }
         }
         
         if( nal->svc_extension_flag )
@@ -2867,12 +3173,14 @@ int read_debug_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
             read_debug_slice_layer_rbsp(h, b);
             break;
 
-#ifdef HAVE_SEI
         case NAL_UNIT_TYPE_SEI:
+#ifndef HAVE_SEI
+            // without HAVE_SEI, SEI is only read for a caller which asks for it with a filter
+            if( 1 && h->sei_filter == NULL ) { return -1; }
+#endif
             read_debug_sei_rbsp(h, b);
             read_debug_rbsp_trailing_bits(b);
             break;
-#endif
 
         case NAL_UNIT_TYPE_SPS: 
             read_debug_seq_parameter_set_rbsp(h->sps, b);
@@ -2881,6 +3189,7 @@ int read_debug_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
             if( 1 )
             {
                 memcpy(h->sps_table[h->sps->seq_parameter_set_id], h->sps, sizeof(sps_t));
+                h264_update_sps_ref(h, h->sps->seq_parameter_set_id);
             }
 
             break;
@@ -2916,6 +3225,7 @@ int read_debug_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
                 memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps, h->sps_subset->sps, sizeof(sps_t));
                 memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps_svc_ext, h->sps_subset->sps_svc_ext, sizeof(sps_svc_ext_t));
                 h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->additional_extension2_flag = h->sps_subset->additional_extension2_flag;
+                h264_update_sps_subset_ref(h, h->sps_subset->sps->seq_parameter_set_id);
             }
 
             break;
@@ -2942,7 +3252,7 @@ int read_debug_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
             return -1;
     }
 
-    if (bs_overrun(b)) { bs_free(b); free(rbsp_buf); return -1; }
+    if (bs_overrun(b)) { return -1; }
 
     if( 0 )
     {
@@ -2950,28 +3260,25 @@ int read_debug_nal_unit(h264_stream_t* h, uint8_t* buf, int size)
         rbsp_size = bs_pos(b);
 
         int rc = rbsp_to_nal(rbsp_buf, &rbsp_size, buf, &nal_size);
-        if (rc < 0) { bs_free(b); free(rbsp_buf); return -1; }
+        if (rc < 0) { return -1; }
     }
 
-    bs_free(b);
-    free(rbsp_buf);
-
     return nal_size;
 }
 
 //G.7.3.1.1 NAL unit header SVC extension syntax
 void read_debug_nal_unit_header_svc_extension(nal_svc_ext_t* nal_svc_ext, bs_t* b)
 {
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal_svc_ext->idr_flag = bs_read_u1(b); printf("nal_svc_ext->idr_flag: %d \n", nal_svc_ext->idr_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal_svc_ext->priority_id = bs_read_u(b, 6); printf("nal_svc_ext->priority_id: %d \n", nal_svc_ext->priority_id); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal_svc_ext->no_inter_layer_pred_flag = bs_read_u1(b); printf("nal_svc_ext->no_inter_layer_pred_flag: %d \n", nal_svc_ext->no_inter_layer_pred_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal_svc_ext->dependency_id = bs_read_u(b, 3); printf("nal_svc_ext->dependency_id: %d \n", nal_svc_ext->dependency_id); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal_svc_ext->quality_id = bs_read_u(b, 4); printf("nal_svc_ext->quality_id: %d \n", nal_svc_ext->quality_id); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal_svc_ext->temporal_id = bs_read_u(b, 3); printf("nal_svc_ext->temporal_id: %d \n", nal_svc_ext->temporal_id); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal_svc_ext->use_ref_base_pic_flag = bs_read_u1(b); printf("nal_svc_ext->use_ref_base_pic_flag: %d \n", nal_svc_ext->use_ref_base_pic_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal_svc_ext->discardable_flag = bs_read_u1(b); printf("nal_svc_ext->discardable_flag: %d \n", nal_svc_ext->discardable_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal_svc_ext->output_flag = bs_read_u1(b); printf("nal_svc_ext->output_flag: %d \n", nal_svc_ext->output_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal_svc_ext->reserved_three_2bits = bs_read_u(b, 2); printf("nal_svc_ext->reserved_three_2bits: %d \n", nal_svc_ext->reserved_three_2bits); 
+    { int _pos = bs_bit_pos(b); nal_svc_ext->idr_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_SVC_EXT_IDR_FLAG, _pos, nal_svc_ext->idr_flag); }
+    { int _pos = bs_bit_pos(b); nal_svc_ext->priority_id = bs_read_u(b, 6); h264_debug_field(b, H264_FIELD_NAL_SVC_EXT_PRIORITY_ID, _pos, nal_svc_ext->priority_id); }
+    { int _pos = bs_bit_pos(b); nal_svc_ext->no_inter_layer_pred_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_SVC_EXT_NO_INTER_LAYER_PRED_FLAG, _pos, nal_svc_ext->no_inter_layer_pred_flag); }
+    { int _pos = bs_bit_pos(b); nal_svc_ext->dependency_id = bs_read_u(b, 3); h264_debug_field(b, H264_FIELD_NAL_SVC_EXT_DEPENDENCY_ID, _pos, nal_svc_ext->dependency_id); }
+    { int _pos = bs_bit_pos(b); nal_svc_ext->quality_id = bs_read_u(b, 4); h264_debug_field(b, H264_FIELD_NAL_SVC_EXT_QUALITY_ID, _pos, nal_svc_ext->quality_id); }
+    { int _pos = bs_bit_pos(b); nal_svc_ext->temporal_id = bs_read_u(b, 3); h264_debug_field(b, H264_FIELD_NAL_SVC_EXT_TEMPORAL_ID, _pos, nal_svc_ext->temporal_id); }
+    { int _pos = bs_bit_pos(b); nal_svc_ext->use_ref_base_pic_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_SVC_EXT_USE_REF_BASE_PIC_FLAG, _pos, nal_svc_ext->use_ref_base_pic_flag); }
+    { int _pos = bs_bit_pos(b); nal_svc_ext->discardable_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_SVC_EXT_DISCARDABLE_FLAG, _pos, nal_svc_ext->discardable_flag); }
+    { int _pos = bs_bit_pos(b); nal_svc_ext->output_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_SVC_EXT_OUTPUT_FLAG, _pos, nal_svc_ext->output_flag); }
+    { int _pos = bs_bit_pos(b); nal_svc_ext->reserved_three_2bits = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_NAL_SVC_EXT_RESERVED_THREE_2BITS, _pos, nal_svc_ext->reserved_three_2bits); }
 }
 
 //G.7.3.2.12.1 Prefix NAL unit SVC syntax
@@ -2979,18 +3286,18 @@ void read_debug_prefix_nal_unit_svc(nal_t* nal, bs_t* b)
 {
     if( nal->nal_ref_idc != 0 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->prefix_nal_svc->store_ref_base_pic_flag = bs_read_u1(b); printf("nal->prefix_nal_svc->store_ref_base_pic_flag: %d \n", nal->prefix_nal_svc->store_ref_base_pic_flag); 
+        { int _pos = bs_bit_pos(b); nal->prefix_nal_svc->store_ref_base_pic_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_PREFIX_NAL_SVC_STORE_REF_BASE_PIC_FLAG, _pos, nal->prefix_nal_svc->store_ref_base_pic_flag); }
         if( ( nal->nal_svc_ext->use_ref_base_pic_flag || nal->prefix_nal_svc->store_ref_base_pic_flag ) &&
              !nal->nal_svc_ext->idr_flag )
         {
             read_debug_dec_ref_base_pic_marking( nal, b );
         }
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->prefix_nal_svc->additional_prefix_nal_unit_extension_flag = bs_read_u1(b); printf("nal->prefix_nal_svc->additional_prefix_nal_unit_extension_flag: %d \n", nal->prefix_nal_svc->additional_prefix_nal_unit_extension_flag); 
+        { int _pos = bs_bit_pos(b); nal->prefix_nal_svc->additional_prefix_nal_unit_extension_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_PREFIX_NAL_SVC_ADDITIONAL_PREFIX_NAL_UNIT_EXTENSION_FLAG, _pos, nal->prefix_nal_svc->additional_prefix_nal_unit_extension_flag); }
         if( nal->prefix_nal_svc->additional_prefix_nal_unit_extension_flag )
         {
             while( more_rbsp_data( b ) )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag = bs_read_u1(b); printf("nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag: %d \n", nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag); 
+                { int _pos = bs_bit_pos(b); nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_PREFIX_NAL_SVC_ADDITIONAL_PREFIX_NAL_UNIT_EXTENSION_DATA_FLAG, _pos, nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag); }
             }
         }
     }
@@ -2998,7 +3305,7 @@ void read_debug_prefix_nal_unit_svc(nal_t* nal, bs_t* b)
     {
         while( more_rbsp_data( b ) )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag = bs_read_u1(b); printf("nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag: %d \n", nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag); 
+            { int _pos = bs_bit_pos(b); nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_PREFIX_NAL_SVC_ADDITIONAL_PREFIX_NAL_UNIT_EXTENSION_DATA_FLAG, _pos, nal->prefix_nal_svc->additional_prefix_nal_unit_extension_data_flag); }
         }
     }
 }
@@ -3023,16 +3330,16 @@ void read_debug_seq_parameter_set_rbsp(sps_t* sps, bs_t* b)
         sps->chroma_format_idc = 1; 
     }
  
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->profile_idc = bs_read_u8(b); printf("sps->profile_idc: %d \n", sps->profile_idc); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->constraint_set0_flag = bs_read_u1(b); printf("sps->constraint_set0_flag: %d \n", sps->constraint_set0_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->constraint_set1_flag = bs_read_u1(b); printf("sps->constraint_set1_flag: %d \n", sps->constraint_set1_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->constraint_set2_flag = bs_read_u1(b); printf("sps->constraint_set2_flag: %d \n", sps->constraint_set2_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->constraint_set3_flag = bs_read_u1(b); printf("sps->constraint_set3_flag: %d \n", sps->constraint_set3_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->constraint_set4_flag = bs_read_u1(b); printf("sps->constraint_set4_flag: %d \n", sps->constraint_set4_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->constraint_set5_flag = bs_read_u1(b); printf("sps->constraint_set5_flag: %d \n", sps->constraint_set5_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); int reserved_zero_2bits = bs_read_u(b, 2); printf("reserved_zero_2bits: %d \n", reserved_zero_2bits); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->level_idc = bs_read_u8(b); printf("sps->level_idc: %d \n", sps->level_idc); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->seq_parameter_set_id = bs_read_ue(b); printf("sps->seq_parameter_set_id: %d \n", sps->seq_parameter_set_id); 
+    { int _pos = bs_bit_pos(b); sps->profile_idc = bs_read_u8(b); h264_debug_field(b, H264_FIELD_SPS_PROFILE_IDC, _pos, sps->profile_idc); }
+    { int _pos = bs_bit_pos(b); sps->constraint_set0_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_CONSTRAINT_SET0_FLAG, _pos, sps->constraint_set0_flag); }
+    { int _pos = bs_bit_pos(b); sps->constraint_set1_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_CONSTRAINT_SET1_FLAG, _pos, sps->constraint_set1_flag); }
+    { int _pos = bs_bit_pos(b); sps->constraint_set2_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_CONSTRAINT_SET2_FLAG, _pos, sps->constraint_set2_flag); }
+    { int _pos = bs_bit_pos(b); sps->constraint_set3_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_CONSTRAINT_SET3_FLAG, _pos, sps->constraint_set3_flag); }
+    { int _pos = bs_bit_pos(b); sps->constraint_set4_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_CONSTRAINT_SET4_FLAG, _pos, sps->constraint_set4_flag); }
+    { int _pos = bs_bit_pos(b); sps->constraint_set5_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_CONSTRAINT_SET5_FLAG, _pos, sps->constraint_set5_flag); }
+    { int _pos = bs_bit_pos(b); h264_debug_field(b, H264_FIELD_RESERVED_ZERO_2BITS, _pos, bs_read_u(b, 2)); }
+    { int _pos = bs_bit_pos(b); sps->level_idc = bs_read_u8(b); h264_debug_field(b, H264_FIELD_SPS_LEVEL_IDC, _pos, sps->level_idc); }
+    { int _pos = bs_bit_pos(b); sps->seq_parameter_set_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_SEQ_PARAMETER_SET_ID, _pos, sps->seq_parameter_set_id); }
 
     if( sps->profile_idc == 100 || sps->profile_idc == 110 ||
         sps->profile_idc == 122 || sps->profile_idc == 244 ||
@@ -3042,20 +3349,20 @@ void read_debug_seq_parameter_set_rbsp(sps_t* sps, bs_t* b)
         sps->profile_idc == 139 || sps->profile_idc == 134
        )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->chroma_format_idc = bs_read_ue(b); printf("sps->chroma_format_idc: %d \n", sps->chroma_format_idc); 
+        { int _pos = bs_bit_pos(b); sps->chroma_format_idc = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_CHROMA_FORMAT_IDC, _pos, sps->chroma_format_idc); }
         if( sps->chroma_format_idc == 3 )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->residual_colour_transform_flag = bs_read_u1(b); printf("sps->residual_colour_transform_flag: %d \n", sps->residual_colour_transform_flag); 
+            { int _pos = bs_bit_pos(b); sps->residual_colour_transform_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_RESIDUAL_COLOUR_TRANSFORM_FLAG, _pos, sps->residual_colour_transform_flag); }
         }
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->bit_depth_luma_minus8 = bs_read_ue(b); printf("sps->bit_depth_luma_minus8: %d \n", sps->bit_depth_luma_minus8); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->bit_depth_chroma_minus8 = bs_read_ue(b); printf("sps->bit_depth_chroma_minus8: %d \n", sps->bit_depth_chroma_minus8); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->qpprime_y_zero_transform_bypass_flag = bs_read_u1(b); printf("sps->qpprime_y_zero_transform_bypass_flag: %d \n", sps->qpprime_y_zero_transform_bypass_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->seq_scaling_matrix_present_flag = bs_read_u1(b); printf("sps->seq_scaling_matrix_present_flag: %d \n", sps->seq_scaling_matrix_present_flag); 
+        { int _pos = bs_bit_pos(b); sps->bit_depth_luma_minus8 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_BIT_DEPTH_LUMA_MINUS8, _pos, sps->bit_depth_luma_minus8); }
+        { int _pos = bs_bit_pos(b); sps->bit_depth_chroma_minus8 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_BIT_DEPTH_CHROMA_MINUS8, _pos, sps->bit_depth_chroma_minus8); }
+        { int _pos = bs_bit_pos(b); sps->qpprime_y_zero_transform_bypass_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_QPPRIME_Y_ZERO_TRANSFORM_BYPASS_FLAG, _pos, sps->qpprime_y_zero_transform_bypass_flag); }
+        { int _pos = bs_bit_pos(b); sps->seq_scaling_matrix_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SEQ_SCALING_MATRIX_PRESENT_FLAG, _pos, sps->seq_scaling_matrix_present_flag); }
         if( sps->seq_scaling_matrix_present_flag )
         {
-            for( i = 0; i < 8; i++ )
+            for( i = 0; i < ((sps->chroma_format_idc != 3) ? 8 : 12); i++ )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->seq_scaling_list_present_flag[ i ] = bs_read_u1(b); printf("sps->seq_scaling_list_present_flag[ i ]: %d \n", sps->seq_scaling_list_present_flag[ i ]); 
+                { int _pos = bs_bit_pos(b); sps->seq_scaling_list_present_flag[ i ] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SEQ_SCALING_LIST_PRESENT_FLAG_I, _pos, sps->seq_scaling_list_present_flag[ i ]); }
                 if( sps->seq_scaling_list_present_flag[ i ] )
                 {
                     if( i < 6 )
@@ -3072,42 +3379,42 @@ void read_debug_seq_parameter_set_rbsp(sps_t* sps, bs_t* b)
             }
         }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->log2_max_frame_num_minus4 = bs_read_ue(b); printf("sps->log2_max_frame_num_minus4: %d \n", sps->log2_max_frame_num_minus4); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->pic_order_cnt_type = bs_read_ue(b); printf("sps->pic_order_cnt_type: %d \n", sps->pic_order_cnt_type); 
+    { int _pos = bs_bit_pos(b); sps->log2_max_frame_num_minus4 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_LOG2_MAX_FRAME_NUM_MINUS4, _pos, sps->log2_max_frame_num_minus4); }
+    { int _pos = bs_bit_pos(b); sps->pic_order_cnt_type = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_PIC_ORDER_CNT_TYPE, _pos, sps->pic_order_cnt_type); }
     if( sps->pic_order_cnt_type == 0 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->log2_max_pic_order_cnt_lsb_minus4 = bs_read_ue(b); printf("sps->log2_max_pic_order_cnt_lsb_minus4: %d \n", sps->log2_max_pic_order_cnt_lsb_minus4); 
+        { int _pos = bs_bit_pos(b); sps->log2_max_pic_order_cnt_lsb_minus4 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_LOG2_MAX_PIC_ORDER_CNT_LSB_MINUS4, _pos, sps->log2_max_pic_order_cnt_lsb_minus4); }
     }
     else if( sps->pic_order_cnt_type == 1 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->delta_pic_order_always_zero_flag = bs_read_u1(b); printf("sps->delta_pic_order_always_zero_flag: %d \n", sps->delta_pic_order_always_zero_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->offset_for_non_ref_pic = bs_read_se(b); printf("sps->offset_for_non_ref_pic: %d \n", sps->offset_for_non_ref_pic); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->offset_for_top_to_bottom_field = bs_read_se(b); printf("sps->offset_for_top_to_bottom_field: %d \n", sps->offset_for_top_to_bottom_field); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->num_ref_frames_in_pic_order_cnt_cycle = bs_read_ue(b); printf("sps->num_ref_frames_in_pic_order_cnt_cycle: %d \n", sps->num_ref_frames_in_pic_order_cnt_cycle); 
+        { int _pos = bs_bit_pos(b); sps->delta_pic_order_always_zero_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_DELTA_PIC_ORDER_ALWAYS_ZERO_FLAG, _pos, sps->delta_pic_order_always_zero_flag); }
+        { int _pos = bs_bit_pos(b); sps->offset_for_non_ref_pic = bs_read_se(b); h264_debug_field(b, H264_FIELD_SPS_OFFSET_FOR_NON_REF_PIC, _pos, sps->offset_for_non_ref_pic); }
+        { int _pos = bs_bit_pos(b); sps->offset_for_top_to_bottom_field = bs_read_se(b); h264_debug_field(b, H264_FIELD_SPS_OFFSET_FOR_TOP_TO_BOTTOM_FIELD, _pos, sps->offset_for_top_to_bottom_field); }
+        { int _pos = bs_bit_pos(b); sps->num_ref_frames_in_pic_order_cnt_cycle = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_NUM_REF_FRAMES_IN_PIC_ORDER_CNT_CYCLE, _pos, sps->num_ref_frames_in_pic_order_cnt_cycle); }
         for( i = 0; i < sps->num_ref_frames_in_pic_order_cnt_cycle; i++ )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->offset_for_ref_frame[ i ] = bs_read_se(b); printf("sps->offset_for_ref_frame[ i ]: %d \n", sps->offset_for_ref_frame[ i ]); 
+            { int _pos = bs_bit_pos(b); sps->offset_for_ref_frame[ i ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SPS_OFFSET_FOR_REF_FRAME_I, _pos, sps->offset_for_ref_frame[ i ]); }
         }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->num_ref_frames = bs_read_ue(b); printf("sps->num_ref_frames: %d \n", sps->num_ref_frames); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->gaps_in_frame_num_value_allowed_flag = bs_read_u1(b); printf("sps->gaps_in_frame_num_value_allowed_flag: %d \n", sps->gaps_in_frame_num_value_allowed_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->pic_width_in_mbs_minus1 = bs_read_ue(b); printf("sps->pic_width_in_mbs_minus1: %d \n", sps->pic_width_in_mbs_minus1); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->pic_height_in_map_units_minus1 = bs_read_ue(b); printf("sps->pic_height_in_map_units_minus1: %d \n", sps->pic_height_in_map_units_minus1); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->frame_mbs_only_flag = bs_read_u1(b); printf("sps->frame_mbs_only_flag: %d \n", sps->frame_mbs_only_flag); 
+    { int _pos = bs_bit_pos(b); sps->num_ref_frames = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_NUM_REF_FRAMES, _pos, sps->num_ref_frames); }
+    { int _pos = bs_bit_pos(b); sps->gaps_in_frame_num_value_allowed_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_GAPS_IN_FRAME_NUM_VALUE_ALLOWED_FLAG, _pos, sps->gaps_in_frame_num_value_allowed_flag); }
+    { int _pos = bs_bit_pos(b); sps->pic_width_in_mbs_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_PIC_WIDTH_IN_MBS_MINUS1, _pos, sps->pic_width_in_mbs_minus1); }
+    { int _pos = bs_bit_pos(b); sps->pic_height_in_map_units_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_PIC_HEIGHT_IN_MAP_UNITS_MINUS1, _pos, sps->pic_height_in_map_units_minus1); }
+    { int _pos = bs_bit_pos(b); sps->frame_mbs_only_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_FRAME_MBS_ONLY_FLAG, _pos, sps->frame_mbs_only_flag); }
     if( !sps->frame_mbs_only_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->mb_adaptive_frame_field_flag = bs_read_u1(b); printf("sps->mb_adaptive_frame_field_flag: %d \n", sps->mb_adaptive_frame_field_flag); 
+        { int _pos = bs_bit_pos(b); sps->mb_adaptive_frame_field_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_MB_ADAPTIVE_FRAME_FIELD_FLAG, _pos, sps->mb_adaptive_frame_field_flag); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->direct_8x8_inference_flag = bs_read_u1(b); printf("sps->direct_8x8_inference_flag: %d \n", sps->direct_8x8_inference_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->frame_cropping_flag = bs_read_u1(b); printf("sps->frame_cropping_flag: %d \n", sps->frame_cropping_flag); 
+    { int _pos = bs_bit_pos(b); sps->direct_8x8_inference_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_DIRECT_8X8_INFERENCE_FLAG, _pos, sps->direct_8x8_inference_flag); }
+    { int _pos = bs_bit_pos(b); sps->frame_cropping_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_FRAME_CROPPING_FLAG, _pos, sps->frame_cropping_flag); }
     if( sps->frame_cropping_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->frame_crop_left_offset = bs_read_ue(b); printf("sps->frame_crop_left_offset: %d \n", sps->frame_crop_left_offset); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->frame_crop_right_offset = bs_read_ue(b); printf("sps->frame_crop_right_offset: %d \n", sps->frame_crop_right_offset); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->frame_crop_top_offset = bs_read_ue(b); printf("sps->frame_crop_top_offset: %d \n", sps->frame_crop_top_offset); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->frame_crop_bottom_offset = bs_read_ue(b); printf("sps->frame_crop_bottom_offset: %d \n", sps->frame_crop_bottom_offset); 
+        { int _pos = bs_bit_pos(b); sps->frame_crop_left_offset = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_FRAME_CROP_LEFT_OFFSET, _pos, sps->frame_crop_left_offset); }
+        { int _pos = bs_bit_pos(b); sps->frame_crop_right_offset = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_FRAME_CROP_RIGHT_OFFSET, _pos, sps->frame_crop_right_offset); }
+        { int _pos = bs_bit_pos(b); sps->frame_crop_top_offset = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_FRAME_CROP_TOP_OFFSET, _pos, sps->frame_crop_top_offset); }
+        { int _pos = bs_bit_pos(b); sps->frame_crop_bottom_offset = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_FRAME_CROP_BOTTOM_OFFSET, _pos, sps->frame_crop_bottom_offset); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui_parameters_present_flag = bs_read_u1(b); printf("sps->vui_parameters_present_flag: %d \n", sps->vui_parameters_present_flag); 
+    { int _pos = bs_bit_pos(b); sps->vui_parameters_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_PARAMETERS_PRESENT_FLAG, _pos, sps->vui_parameters_present_flag); }
     if( sps->vui_parameters_present_flag )
     {
         read_debug_vui_parameters(sps, b);
@@ -3132,7 +3439,7 @@ void read_debug_scaling_list(bs_t* b, int* scalingList, int sizeOfScalingList, i
                 delta_scale = (nextScale - lastScale) % 256 ;
             }
 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); delta_scale = bs_read_se(b); printf("delta_scale: %d \n", delta_scale); 
+            { int _pos = bs_bit_pos(b); delta_scale = bs_read_se(b); h264_debug_field(b, H264_FIELD_DELTA_SCALE, _pos, delta_scale); }
 
             if( 1 )
             {
@@ -3160,7 +3467,7 @@ void read_debug_subset_seq_parameter_set_rbsp(sps_subset_t* sps_subset, bs_t* b)
             read_debug_seq_parameter_set_svc_extension(sps_subset, b); /* specified in Annex G */
             
             sps_svc_ext_t* sps_svc_ext = sps_subset->sps_svc_ext;
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->svc_vui_parameters_present_flag = bs_read_u1(b); printf("sps_svc_ext->svc_vui_parameters_present_flag: %d \n", sps_svc_ext->svc_vui_parameters_present_flag); 
+            { int _pos = bs_bit_pos(b); sps_svc_ext->svc_vui_parameters_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_SVC_VUI_PARAMETERS_PRESENT_FLAG, _pos, sps_svc_ext->svc_vui_parameters_present_flag); }
             
             if( sps_svc_ext->svc_vui_parameters_present_flag )
             {
@@ -3170,12 +3477,12 @@ void read_debug_subset_seq_parameter_set_rbsp(sps_subset_t* sps_subset, bs_t* b)
         default:
             break;
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_subset->additional_extension2_flag = bs_read_u1(b); printf("sps_subset->additional_extension2_flag: %d \n", sps_subset->additional_extension2_flag); 
+    { int _pos = bs_bit_pos(b); sps_subset->additional_extension2_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SUBSET_ADDITIONAL_EXTENSION2_FLAG, _pos, sps_subset->additional_extension2_flag); }
     if( sps_subset->additional_extension2_flag )
     {
         while( more_rbsp_data( b ) )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_subset->additional_extension2_flag = bs_read_u1(b); printf("sps_subset->additional_extension2_flag: %d \n", sps_subset->additional_extension2_flag); 
+            { int _pos = bs_bit_pos(b); sps_subset->additional_extension2_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SUBSET_ADDITIONAL_EXTENSION2_FLAG, _pos, sps_subset->additional_extension2_flag); }
         }
     }
     
@@ -3185,59 +3492,59 @@ void read_debug_subset_seq_parameter_set_rbsp(sps_subset_t* sps_subset, bs_t* b)
 void read_debug_seq_parameter_set_svc_extension(sps_subset_t* sps_subset, bs_t* b)
 {
     sps_svc_ext_t* sps_svc_ext = sps_subset->sps_svc_ext;
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->inter_layer_deblocking_filter_control_present_flag = bs_read_u1(b); printf("sps_svc_ext->inter_layer_deblocking_filter_control_present_flag: %d \n", sps_svc_ext->inter_layer_deblocking_filter_control_present_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->extended_spatial_scalability_idc = bs_read_u(b, 2); printf("sps_svc_ext->extended_spatial_scalability_idc: %d \n", sps_svc_ext->extended_spatial_scalability_idc); 
+    { int _pos = bs_bit_pos(b); sps_svc_ext->inter_layer_deblocking_filter_control_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_INTER_LAYER_DEBLOCKING_FILTER_CONTROL_PRESENT_FLAG, _pos, sps_svc_ext->inter_layer_deblocking_filter_control_present_flag); }
+    { int _pos = bs_bit_pos(b); sps_svc_ext->extended_spatial_scalability_idc = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_EXTENDED_SPATIAL_SCALABILITY_IDC, _pos, sps_svc_ext->extended_spatial_scalability_idc); }
     if( sps_subset->sps->chroma_format_idc == 1 || sps_subset->sps->chroma_format_idc == 2 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->chroma_phase_x_plus1_flag = bs_read_u1(b); printf("sps_svc_ext->chroma_phase_x_plus1_flag: %d \n", sps_svc_ext->chroma_phase_x_plus1_flag); 
+        { int _pos = bs_bit_pos(b); sps_svc_ext->chroma_phase_x_plus1_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_CHROMA_PHASE_X_PLUS1_FLAG, _pos, sps_svc_ext->chroma_phase_x_plus1_flag); }
     }
     if( sps_subset->sps->chroma_format_idc == 1 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->chroma_phase_y_plus1 = bs_read_u(b, 2); printf("sps_svc_ext->chroma_phase_y_plus1: %d \n", sps_svc_ext->chroma_phase_y_plus1); 
+        { int _pos = bs_bit_pos(b); sps_svc_ext->chroma_phase_y_plus1 = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_CHROMA_PHASE_Y_PLUS1, _pos, sps_svc_ext->chroma_phase_y_plus1); }
     }
     if( sps_svc_ext->extended_spatial_scalability_idc )
     {
         if( sps_subset->sps->chroma_format_idc > 0 )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->seq_ref_layer_chroma_phase_x_plus1_flag = bs_read_u1(b); printf("sps_svc_ext->seq_ref_layer_chroma_phase_x_plus1_flag: %d \n", sps_svc_ext->seq_ref_layer_chroma_phase_x_plus1_flag); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->seq_ref_layer_chroma_phase_y_plus1 = bs_read_u(b, 2); printf("sps_svc_ext->seq_ref_layer_chroma_phase_y_plus1: %d \n", sps_svc_ext->seq_ref_layer_chroma_phase_y_plus1); 
+            { int _pos = bs_bit_pos(b); sps_svc_ext->seq_ref_layer_chroma_phase_x_plus1_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_SEQ_REF_LAYER_CHROMA_PHASE_X_PLUS1_FLAG, _pos, sps_svc_ext->seq_ref_layer_chroma_phase_x_plus1_flag); }
+            { int _pos = bs_bit_pos(b); sps_svc_ext->seq_ref_layer_chroma_phase_y_plus1 = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_SEQ_REF_LAYER_CHROMA_PHASE_Y_PLUS1, _pos, sps_svc_ext->seq_ref_layer_chroma_phase_y_plus1); }
         }
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->seq_scaled_ref_layer_left_offset = bs_read_se(b); printf("sps_svc_ext->seq_scaled_ref_layer_left_offset: %d \n", sps_svc_ext->seq_scaled_ref_layer_left_offset); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->seq_scaled_ref_layer_top_offset = bs_read_se(b); printf("sps_svc_ext->seq_scaled_ref_layer_top_offset: %d \n", sps_svc_ext->seq_scaled_ref_layer_top_offset); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->seq_scaled_ref_layer_right_offset = bs_read_se(b); printf("sps_svc_ext->seq_scaled_ref_layer_right_offset: %d \n", sps_svc_ext->seq_scaled_ref_layer_right_offset); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->seq_scaled_ref_layer_bottom_offset = bs_read_se(b); printf("sps_svc_ext->seq_scaled_ref_layer_bottom_offset: %d \n", sps_svc_ext->seq_scaled_ref_layer_bottom_offset); 
+        { int _pos = bs_bit_pos(b); sps_svc_ext->seq_scaled_ref_layer_left_offset = bs_read_se(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_SEQ_SCALED_REF_LAYER_LEFT_OFFSET, _pos, sps_svc_ext->seq_scaled_ref_layer_left_offset); }
+        { int _pos = bs_bit_pos(b); sps_svc_ext->seq_scaled_ref_layer_top_offset = bs_read_se(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_SEQ_SCALED_REF_LAYER_TOP_OFFSET, _pos, sps_svc_ext->seq_scaled_ref_layer_top_offset); }
+        { int _pos = bs_bit_pos(b); sps_svc_ext->seq_scaled_ref_layer_right_offset = bs_read_se(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_SEQ_SCALED_REF_LAYER_RIGHT_OFFSET, _pos, sps_svc_ext->seq_scaled_ref_layer_right_offset); }
+        { int _pos = bs_bit_pos(b); sps_svc_ext->seq_scaled_ref_layer_bottom_offset = bs_read_se(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_SEQ_SCALED_REF_LAYER_BOTTOM_OFFSET, _pos, sps_svc_ext->seq_scaled_ref_layer_bottom_offset); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->seq_tcoeff_level_prediction_flag = bs_read_u1(b); printf("sps_svc_ext->seq_tcoeff_level_prediction_flag: %d \n", sps_svc_ext->seq_tcoeff_level_prediction_flag); 
+    { int _pos = bs_bit_pos(b); sps_svc_ext->seq_tcoeff_level_prediction_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_SEQ_TCOEFF_LEVEL_PREDICTION_FLAG, _pos, sps_svc_ext->seq_tcoeff_level_prediction_flag); }
     if( sps_svc_ext->seq_tcoeff_level_prediction_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->adaptive_tcoeff_level_prediction_flag = bs_read_u1(b); printf("sps_svc_ext->adaptive_tcoeff_level_prediction_flag: %d \n", sps_svc_ext->adaptive_tcoeff_level_prediction_flag); 
+        { int _pos = bs_bit_pos(b); sps_svc_ext->adaptive_tcoeff_level_prediction_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_ADAPTIVE_TCOEFF_LEVEL_PREDICTION_FLAG, _pos, sps_svc_ext->adaptive_tcoeff_level_prediction_flag); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->slice_header_restriction_flag = bs_read_u1(b); printf("sps_svc_ext->slice_header_restriction_flag: %d \n", sps_svc_ext->slice_header_restriction_flag); 
+    { int _pos = bs_bit_pos(b); sps_svc_ext->slice_header_restriction_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_SLICE_HEADER_RESTRICTION_FLAG, _pos, sps_svc_ext->slice_header_restriction_flag); }
 }
 
 //Appendix G.14.1 SVC VUI parameters extension syntax
 void read_debug_svc_vui_parameters_extension(sps_svc_ext_t* sps_svc_ext, bs_t* b)
 {
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_num_entries_minus1 = bs_read_ue(b); printf("sps_svc_ext->vui.vui_ext_num_entries_minus1: %d \n", sps_svc_ext->vui.vui_ext_num_entries_minus1); 
+    { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_num_entries_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_NUM_ENTRIES_MINUS1, _pos, sps_svc_ext->vui.vui_ext_num_entries_minus1); }
     for( int i = 0; i <= sps_svc_ext->vui.vui_ext_num_entries_minus1; i++ )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_dependency_id[i] = bs_read_u(b, 3); printf("sps_svc_ext->vui.vui_ext_dependency_id[i]: %d \n", sps_svc_ext->vui.vui_ext_dependency_id[i]); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_quality_id[i] = bs_read_u(b, 4); printf("sps_svc_ext->vui.vui_ext_quality_id[i]: %d \n", sps_svc_ext->vui.vui_ext_quality_id[i]); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_temporal_id[i] = bs_read_u(b, 3); printf("sps_svc_ext->vui.vui_ext_temporal_id[i]: %d \n", sps_svc_ext->vui.vui_ext_temporal_id[i]); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_timing_info_present_flag[i] = bs_read_u1(b); printf("sps_svc_ext->vui.vui_ext_timing_info_present_flag[i]: %d \n", sps_svc_ext->vui.vui_ext_timing_info_present_flag[i]); 
+        { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_dependency_id[i] = bs_read_u(b, 3); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_DEPENDENCY_ID_I, _pos, sps_svc_ext->vui.vui_ext_dependency_id[i]); }
+        { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_quality_id[i] = bs_read_u(b, 4); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_QUALITY_ID_I, _pos, sps_svc_ext->vui.vui_ext_quality_id[i]); }
+        { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_temporal_id[i] = bs_read_u(b, 3); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_TEMPORAL_ID_I, _pos, sps_svc_ext->vui.vui_ext_temporal_id[i]); }
+        { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_timing_info_present_flag[i] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_TIMING_INFO_PRESENT_FLAG_I, _pos, sps_svc_ext->vui.vui_ext_timing_info_present_flag[i]); }
         if( sps_svc_ext->vui.vui_ext_timing_info_present_flag[i] )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_num_units_in_tick[i] = bs_read_u(b, 32); printf("sps_svc_ext->vui.vui_ext_num_units_in_tick[i]: %d \n", sps_svc_ext->vui.vui_ext_num_units_in_tick[i]); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_time_scale[i] = bs_read_u(b, 32); printf("sps_svc_ext->vui.vui_ext_time_scale[i]: %d \n", sps_svc_ext->vui.vui_ext_time_scale[i]); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_fixed_frame_rate_flag[i] = bs_read_u1(b); printf("sps_svc_ext->vui.vui_ext_fixed_frame_rate_flag[i]: %d \n", sps_svc_ext->vui.vui_ext_fixed_frame_rate_flag[i]); 
+            { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_num_units_in_tick[i] = bs_read_u(b, 32); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_NUM_UNITS_IN_TICK_I, _pos, sps_svc_ext->vui.vui_ext_num_units_in_tick[i]); }
+            { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_time_scale[i] = bs_read_u(b, 32); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_TIME_SCALE_I, _pos, sps_svc_ext->vui.vui_ext_time_scale[i]); }
+            { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_fixed_frame_rate_flag[i] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_FIXED_FRAME_RATE_FLAG_I, _pos, sps_svc_ext->vui.vui_ext_fixed_frame_rate_flag[i]); }
         }
 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i] = bs_read_u1(b); printf("sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i]: %d \n", sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i]); 
+        { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_NAL_HRD_PARAMETERS_PRESENT_FLAG_I, _pos, sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i]); }
         if( sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i] )
         {
             read_debug_hrd_parameters(&sps_svc_ext->hrd_vcl[i], b);
         }
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_vcl_hrd_parameters_present_flag[i] = bs_read_u1(b); printf("sps_svc_ext->vui.vui_ext_vcl_hrd_parameters_present_flag[i]: %d \n", sps_svc_ext->vui.vui_ext_vcl_hrd_parameters_present_flag[i]); 
+        { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_vcl_hrd_parameters_present_flag[i] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_VCL_HRD_PARAMETERS_PRESENT_FLAG_I, _pos, sps_svc_ext->vui.vui_ext_vcl_hrd_parameters_present_flag[i]); }
         if( sps_svc_ext->vui.vui_ext_vcl_hrd_parameters_present_flag[i] )
         {
             read_debug_hrd_parameters(&sps_svc_ext->hrd_nal[i], b);
@@ -3246,81 +3553,81 @@ void read_debug_svc_vui_parameters_extension(sps_svc_ext_t* sps_svc_ext, bs_t* b
         if( sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i] ||
             sps_svc_ext->vui.vui_ext_vcl_hrd_parameters_present_flag[i] )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_low_delay_hrd_flag[i] = bs_read_u1(b); printf("sps_svc_ext->vui.vui_ext_low_delay_hrd_flag[i]: %d \n", sps_svc_ext->vui.vui_ext_low_delay_hrd_flag[i]); 
+            { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_low_delay_hrd_flag[i] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_LOW_DELAY_HRD_FLAG_I, _pos, sps_svc_ext->vui.vui_ext_low_delay_hrd_flag[i]); }
         }
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps_svc_ext->vui.vui_ext_pic_struct_present_flag[i] = bs_read_u1(b); printf("sps_svc_ext->vui.vui_ext_pic_struct_present_flag[i]: %d \n", sps_svc_ext->vui.vui_ext_pic_struct_present_flag[i]); 
+        { int _pos = bs_bit_pos(b); sps_svc_ext->vui.vui_ext_pic_struct_present_flag[i] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_SVC_EXT_VUI_VUI_EXT_PIC_STRUCT_PRESENT_FLAG_I, _pos, sps_svc_ext->vui.vui_ext_pic_struct_present_flag[i]); }
     }
 }
 
 //Appendix E.1.1 VUI parameters syntax
 void read_debug_vui_parameters(sps_t* sps, bs_t* b)
 {
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.aspect_ratio_info_present_flag = bs_read_u1(b); printf("sps->vui.aspect_ratio_info_present_flag: %d \n", sps->vui.aspect_ratio_info_present_flag); 
+    { int _pos = bs_bit_pos(b); sps->vui.aspect_ratio_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_ASPECT_RATIO_INFO_PRESENT_FLAG, _pos, sps->vui.aspect_ratio_info_present_flag); }
     if( sps->vui.aspect_ratio_info_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.aspect_ratio_idc = bs_read_u8(b); printf("sps->vui.aspect_ratio_idc: %d \n", sps->vui.aspect_ratio_idc); 
+        { int _pos = bs_bit_pos(b); sps->vui.aspect_ratio_idc = bs_read_u8(b); h264_debug_field(b, H264_FIELD_SPS_VUI_ASPECT_RATIO_IDC, _pos, sps->vui.aspect_ratio_idc); }
         if( sps->vui.aspect_ratio_idc == SAR_Extended )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.sar_width = bs_read_u(b, 16); printf("sps->vui.sar_width: %d \n", sps->vui.sar_width); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.sar_height = bs_read_u(b, 16); printf("sps->vui.sar_height: %d \n", sps->vui.sar_height); 
+            { int _pos = bs_bit_pos(b); sps->vui.sar_width = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SPS_VUI_SAR_WIDTH, _pos, sps->vui.sar_width); }
+            { int _pos = bs_bit_pos(b); sps->vui.sar_height = bs_read_u(b, 16); h264_debug_field(b, H264_FIELD_SPS_VUI_SAR_HEIGHT, _pos, sps->vui.sar_height); }
         }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.overscan_info_present_flag = bs_read_u1(b); printf("sps->vui.overscan_info_present_flag: %d \n", sps->vui.overscan_info_present_flag); 
+    { int _pos = bs_bit_pos(b); sps->vui.overscan_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_OVERSCAN_INFO_PRESENT_FLAG, _pos, sps->vui.overscan_info_present_flag); }
     if( sps->vui.overscan_info_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.overscan_appropriate_flag = bs_read_u1(b); printf("sps->vui.overscan_appropriate_flag: %d \n", sps->vui.overscan_appropriate_flag); 
+        { int _pos = bs_bit_pos(b); sps->vui.overscan_appropriate_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_OVERSCAN_APPROPRIATE_FLAG, _pos, sps->vui.overscan_appropriate_flag); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.video_signal_type_present_flag = bs_read_u1(b); printf("sps->vui.video_signal_type_present_flag: %d \n", sps->vui.video_signal_type_present_flag); 
+    { int _pos = bs_bit_pos(b); sps->vui.video_signal_type_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_VIDEO_SIGNAL_TYPE_PRESENT_FLAG, _pos, sps->vui.video_signal_type_present_flag); }
     if( sps->vui.video_signal_type_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.video_format = bs_read_u(b, 3); printf("sps->vui.video_format: %d \n", sps->vui.video_format); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.video_full_range_flag = bs_read_u1(b); printf("sps->vui.video_full_range_flag: %d \n", sps->vui.video_full_range_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.colour_description_present_flag = bs_read_u1(b); printf("sps->vui.colour_description_present_flag: %d \n", sps->vui.colour_description_present_flag); 
+        { int _pos = bs_bit_pos(b); sps->vui.video_format = bs_read_u(b, 3); h264_debug_field(b, H264_FIELD_SPS_VUI_VIDEO_FORMAT, _pos, sps->vui.video_format); }
+        { int _pos = bs_bit_pos(b); sps->vui.video_full_range_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_VIDEO_FULL_RANGE_FLAG, _pos, sps->vui.video_full_range_flag); }
+        { int _pos = bs_bit_pos(b); sps->vui.colour_description_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_COLOUR_DESCRIPTION_PRESENT_FLAG, _pos, sps->vui.colour_description_present_flag); }
         if( sps->vui.colour_description_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.colour_primaries = bs_read_u8(b); printf("sps->vui.colour_primaries: %d \n", sps->vui.colour_primaries); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.transfer_characteristics = bs_read_u8(b); printf("sps->vui.transfer_characteristics: %d \n", sps->vui.transfer_characteristics); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.matrix_coefficients = bs_read_u8(b); printf("sps->vui.matrix_coefficients: %d \n", sps->vui.matrix_coefficients); 
+            { int _pos = bs_bit_pos(b); sps->vui.colour_primaries = bs_read_u8(b); h264_debug_field(b, H264_FIELD_SPS_VUI_COLOUR_PRIMARIES, _pos, sps->vui.colour_primaries); }
+            { int _pos = bs_bit_pos(b); sps->vui.transfer_characteristics = bs_read_u8(b); h264_debug_field(b, H264_FIELD_SPS_VUI_TRANSFER_CHARACTERISTICS, _pos, sps->vui.transfer_characteristics); }
+            { int _pos = bs_bit_pos(b); sps->vui.matrix_coefficients = bs_read_u8(b); h264_debug_field(b, H264_FIELD_SPS_VUI_MATRIX_COEFFICIENTS, _pos, sps->vui.matrix_coefficients); }
         }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.chroma_loc_info_present_flag = bs_read_u1(b); printf("sps->vui.chroma_loc_info_present_flag: %d \n", sps->vui.chroma_loc_info_present_flag); 
+    { int _pos = bs_bit_pos(b); sps->vui.chroma_loc_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_CHROMA_LOC_INFO_PRESENT_FLAG, _pos, sps->vui.chroma_loc_info_present_flag); }
     if( sps->vui.chroma_loc_info_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.chroma_sample_loc_type_top_field = bs_read_ue(b); printf("sps->vui.chroma_sample_loc_type_top_field: %d \n", sps->vui.chroma_sample_loc_type_top_field); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.chroma_sample_loc_type_bottom_field = bs_read_ue(b); printf("sps->vui.chroma_sample_loc_type_bottom_field: %d \n", sps->vui.chroma_sample_loc_type_bottom_field); 
+        { int _pos = bs_bit_pos(b); sps->vui.chroma_sample_loc_type_top_field = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_VUI_CHROMA_SAMPLE_LOC_TYPE_TOP_FIELD, _pos, sps->vui.chroma_sample_loc_type_top_field); }
+        { int _pos = bs_bit_pos(b); sps->vui.chroma_sample_loc_type_bottom_field = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_VUI_CHROMA_SAMPLE_LOC_TYPE_BOTTOM_FIELD, _pos, sps->vui.chroma_sample_loc_type_bottom_field); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.timing_info_present_flag = bs_read_u1(b); printf("sps->vui.timing_info_present_flag: %d \n", sps->vui.timing_info_present_flag); 
+    { int _pos = bs_bit_pos(b); sps->vui.timing_info_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_TIMING_INFO_PRESENT_FLAG, _pos, sps->vui.timing_info_present_flag); }
     if( sps->vui.timing_info_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.num_units_in_tick = bs_read_u(b, 32); printf("sps->vui.num_units_in_tick: %d \n", sps->vui.num_units_in_tick); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.time_scale = bs_read_u(b, 32); printf("sps->vui.time_scale: %d \n", sps->vui.time_scale); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.fixed_frame_rate_flag = bs_read_u1(b); printf("sps->vui.fixed_frame_rate_flag: %d \n", sps->vui.fixed_frame_rate_flag); 
+        { int _pos = bs_bit_pos(b); sps->vui.num_units_in_tick = bs_read_u(b, 32); h264_debug_field(b, H264_FIELD_SPS_VUI_NUM_UNITS_IN_TICK, _pos, sps->vui.num_units_in_tick); }
+        { int _pos = bs_bit_pos(b); sps->vui.time_scale = bs_read_u(b, 32); h264_debug_field(b, H264_FIELD_SPS_VUI_TIME_SCALE, _pos, sps->vui.time_scale); }
+        { int _pos = bs_bit_pos(b); sps->vui.fixed_frame_rate_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_FIXED_FRAME_RATE_FLAG, _pos, sps->vui.fixed_frame_rate_flag); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.nal_hrd_parameters_present_flag = bs_read_u1(b); printf("sps->vui.nal_hrd_parameters_present_flag: %d \n", sps->vui.nal_hrd_parameters_present_flag); 
+    { int _pos = bs_bit_pos(b); sps->vui.nal_hrd_parameters_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_NAL_HRD_PARAMETERS_PRESENT_FLAG, _pos, sps->vui.nal_hrd_parameters_present_flag); }
     if( sps->vui.nal_hrd_parameters_present_flag )
     {
         read_debug_hrd_parameters(&sps->hrd_nal, b);
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.vcl_hrd_parameters_present_flag = bs_read_u1(b); printf("sps->vui.vcl_hrd_parameters_present_flag: %d \n", sps->vui.vcl_hrd_parameters_present_flag); 
+    { int _pos = bs_bit_pos(b); sps->vui.vcl_hrd_parameters_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_VCL_HRD_PARAMETERS_PRESENT_FLAG, _pos, sps->vui.vcl_hrd_parameters_present_flag); }
     if( sps->vui.vcl_hrd_parameters_present_flag )
     {
         read_debug_hrd_parameters(&sps->hrd_vcl, b);
     }
     if( sps->vui.nal_hrd_parameters_present_flag || sps->vui.vcl_hrd_parameters_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.low_delay_hrd_flag = bs_read_u1(b); printf("sps->vui.low_delay_hrd_flag: %d \n", sps->vui.low_delay_hrd_flag); 
+        { int _pos = bs_bit_pos(b); sps->vui.low_delay_hrd_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_LOW_DELAY_HRD_FLAG, _pos, sps->vui.low_delay_hrd_flag); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.pic_struct_present_flag = bs_read_u1(b); printf("sps->vui.pic_struct_present_flag: %d \n", sps->vui.pic_struct_present_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.bitstream_restriction_flag = bs_read_u1(b); printf("sps->vui.bitstream_restriction_flag: %d \n", sps->vui.bitstream_restriction_flag); 
+    { int _pos = bs_bit_pos(b); sps->vui.pic_struct_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_PIC_STRUCT_PRESENT_FLAG, _pos, sps->vui.pic_struct_present_flag); }
+    { int _pos = bs_bit_pos(b); sps->vui.bitstream_restriction_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_BITSTREAM_RESTRICTION_FLAG, _pos, sps->vui.bitstream_restriction_flag); }
     if( sps->vui.bitstream_restriction_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.motion_vectors_over_pic_boundaries_flag = bs_read_u1(b); printf("sps->vui.motion_vectors_over_pic_boundaries_flag: %d \n", sps->vui.motion_vectors_over_pic_boundaries_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.max_bytes_per_pic_denom = bs_read_ue(b); printf("sps->vui.max_bytes_per_pic_denom: %d \n", sps->vui.max_bytes_per_pic_denom); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.max_bits_per_mb_denom = bs_read_ue(b); printf("sps->vui.max_bits_per_mb_denom: %d \n", sps->vui.max_bits_per_mb_denom); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.log2_max_mv_length_horizontal = bs_read_ue(b); printf("sps->vui.log2_max_mv_length_horizontal: %d \n", sps->vui.log2_max_mv_length_horizontal); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.log2_max_mv_length_vertical = bs_read_ue(b); printf("sps->vui.log2_max_mv_length_vertical: %d \n", sps->vui.log2_max_mv_length_vertical); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.num_reorder_frames = bs_read_ue(b); printf("sps->vui.num_reorder_frames: %d \n", sps->vui.num_reorder_frames); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sps->vui.max_dec_frame_buffering = bs_read_ue(b); printf("sps->vui.max_dec_frame_buffering: %d \n", sps->vui.max_dec_frame_buffering); 
+        { int _pos = bs_bit_pos(b); sps->vui.motion_vectors_over_pic_boundaries_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SPS_VUI_MOTION_VECTORS_OVER_PIC_BOUNDARIES_FLAG, _pos, sps->vui.motion_vectors_over_pic_boundaries_flag); }
+        { int _pos = bs_bit_pos(b); sps->vui.max_bytes_per_pic_denom = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_VUI_MAX_BYTES_PER_PIC_DENOM, _pos, sps->vui.max_bytes_per_pic_denom); }
+        { int _pos = bs_bit_pos(b); sps->vui.max_bits_per_mb_denom = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_VUI_MAX_BITS_PER_MB_DENOM, _pos, sps->vui.max_bits_per_mb_denom); }
+        { int _pos = bs_bit_pos(b); sps->vui.log2_max_mv_length_horizontal = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_VUI_LOG2_MAX_MV_LENGTH_HORIZONTAL, _pos, sps->vui.log2_max_mv_length_horizontal); }
+        { int _pos = bs_bit_pos(b); sps->vui.log2_max_mv_length_vertical = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_VUI_LOG2_MAX_MV_LENGTH_VERTICAL, _pos, sps->vui.log2_max_mv_length_vertical); }
+        { int _pos = bs_bit_pos(b); sps->vui.num_reorder_frames = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_VUI_NUM_REORDER_FRAMES, _pos, sps->vui.num_reorder_frames); }
+        { int _pos = bs_bit_pos(b); sps->vui.max_dec_frame_buffering = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SPS_VUI_MAX_DEC_FRAME_BUFFERING, _pos, sps->vui.max_dec_frame_buffering); }
     }
 }
 
@@ -3328,19 +3635,19 @@ void read_debug_vui_parameters(sps_t* sps, bs_t* b)
 //Appendix E.1.2 HRD parameters syntax
 void read_debug_hrd_parameters(hrd_t* hrd, bs_t* b)
 {
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); hrd->cpb_cnt_minus1 = bs_read_ue(b); printf("hrd->cpb_cnt_minus1: %d \n", hrd->cpb_cnt_minus1); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); hrd->bit_rate_scale = bs_read_u(b, 4); printf("hrd->bit_rate_scale: %d \n", hrd->bit_rate_scale); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); hrd->cpb_size_scale = bs_read_u(b, 4); printf("hrd->cpb_size_scale: %d \n", hrd->cpb_size_scale); 
+    { int _pos = bs_bit_pos(b); hrd->cpb_cnt_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_HRD_CPB_CNT_MINUS1, _pos, hrd->cpb_cnt_minus1); }
+    { int _pos = bs_bit_pos(b); hrd->bit_rate_scale = bs_read_u(b, 4); h264_debug_field(b, H264_FIELD_HRD_BIT_RATE_SCALE, _pos, hrd->bit_rate_scale); }
+    { int _pos = bs_bit_pos(b); hrd->cpb_size_scale = bs_read_u(b, 4); h264_debug_field(b, H264_FIELD_HRD_CPB_SIZE_SCALE, _pos, hrd->cpb_size_scale); }
     for( int SchedSelIdx = 0; SchedSelIdx <= hrd->cpb_cnt_minus1; SchedSelIdx++ )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); hrd->bit_rate_value_minus1[ SchedSelIdx ] = bs_read_ue(b); printf("hrd->bit_rate_value_minus1[ SchedSelIdx ]: %d \n", hrd->bit_rate_value_minus1[ SchedSelIdx ]); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); hrd->cpb_size_value_minus1[ SchedSelIdx ] = bs_read_ue(b); printf("hrd->cpb_size_value_minus1[ SchedSelIdx ]: %d \n", hrd->cpb_size_value_minus1[ SchedSelIdx ]); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); hrd->cbr_flag[ SchedSelIdx ] = bs_read_u1(b); printf("hrd->cbr_flag[ SchedSelIdx ]: %d \n", hrd->cbr_flag[ SchedSelIdx ]); 
+        { int _pos = bs_bit_pos(b); hrd->bit_rate_value_minus1[ SchedSelIdx ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_HRD_BIT_RATE_VALUE_MINUS1_SCHEDSELIDX, _pos, hrd->bit_rate_value_minus1[ SchedSelIdx ]); }
+        { int _pos = bs_bit_pos(b); hrd->cpb_size_value_minus1[ SchedSelIdx ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_HRD_CPB_SIZE_VALUE_MINUS1_SCHEDSELIDX, _pos, hrd->cpb_size_value_minus1[ SchedSelIdx ]); }
+        { int _pos = bs_bit_pos(b); hrd->cbr_flag[ SchedSelIdx ] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_HRD_CBR_FLAG_SCHEDSELIDX, _pos, hrd->cbr_flag[ SchedSelIdx ]); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); hrd->initial_cpb_removal_delay_length_minus1 = bs_read_u(b, 5); printf("hrd->initial_cpb_removal_delay_length_minus1: %d \n", hrd->initial_cpb_removal_delay_length_minus1); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); hrd->cpb_removal_delay_length_minus1 = bs_read_u(b, 5); printf("hrd->cpb_removal_delay_length_minus1: %d \n", hrd->cpb_removal_delay_length_minus1); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); hrd->dpb_output_delay_length_minus1 = bs_read_u(b, 5); printf("hrd->dpb_output_delay_length_minus1: %d \n", hrd->dpb_output_delay_length_minus1); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); hrd->time_offset_length = bs_read_u(b, 5); printf("hrd->time_offset_length: %d \n", hrd->time_offset_length); 
+    { int _pos = bs_bit_pos(b); hrd->initial_cpb_removal_delay_length_minus1 = bs_read_u(b, 5); h264_debug_field(b, H264_FIELD_HRD_INITIAL_CPB_REMOVAL_DELAY_LENGTH_MINUS1, _pos, hrd->initial_cpb_removal_delay_length_minus1); }
+    { int _pos = bs_bit_pos(b); hrd->cpb_removal_delay_length_minus1 = bs_read_u(b, 5); h264_debug_field(b, H264_FIELD_HRD_CPB_REMOVAL_DELAY_LENGTH_MINUS1, _pos, hrd->cpb_removal_delay_length_minus1); }
+    { int _pos = bs_bit_pos(b); hrd->dpb_output_delay_length_minus1 = bs_read_u(b, 5); h264_debug_field(b, H264_FIELD_HRD_DPB_OUTPUT_DELAY_LENGTH_MINUS1, _pos, hrd->dpb_output_delay_length_minus1); }
+    { int _pos = bs_bit_pos(b); hrd->time_offset_length = bs_read_u(b, 5); h264_debug_field(b, H264_FIELD_HRD_TIME_OFFSET_LENGTH, _pos, hrd->time_offset_length); }
 }
 
 
@@ -3348,15 +3655,15 @@ void read_debug_hrd_parameters(hrd_t* hrd, bs_t* b)
 UNIMPLEMENTED
 //7.3.2.1.2 Sequence parameter set extension RBSP syntax
 int read_debug_seq_parameter_set_extension_rbsp(bs_t* b, sps_ext_t* sps_ext) {
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); seq_parameter_set_id = bs_read_ue(b); printf("seq_parameter_set_id: %d \n", seq_parameter_set_id); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); aux_format_idc = bs_read_ue(b); printf("aux_format_idc: %d \n", aux_format_idc); 
+    { int _pos = bs_bit_pos(b); seq_parameter_set_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SEQ_PARAMETER_SET_ID, _pos, seq_parameter_set_id); }
+    { int _pos = bs_bit_pos(b); aux_format_idc = bs_read_ue(b); h264_debug_field(b, H264_FIELD_AUX_FORMAT_IDC, _pos, aux_format_idc); }
     if( aux_format_idc != 0 ) {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); bit_depth_aux_minus8 = bs_read_ue(b); printf("bit_depth_aux_minus8: %d \n", bit_depth_aux_minus8); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); alpha_incr_flag = bs_read_u1(b); printf("alpha_incr_flag: %d \n", alpha_incr_flag); 
+        { int _pos = bs_bit_pos(b); bit_depth_aux_minus8 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_BIT_DEPTH_AUX_MINUS8, _pos, bit_depth_aux_minus8); }
+        { int _pos = bs_bit_pos(b); alpha_incr_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_ALPHA_INCR_FLAG, _pos, alpha_incr_flag); }
         alpha_opaque_value = bs_read_debug_u(v);
         alpha_transparent_value = bs_read_debug_u(v);
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); additional_extension_flag = bs_read_u1(b); printf("additional_extension_flag: %d \n", additional_extension_flag); 
+    { int _pos = bs_bit_pos(b); additional_extension_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_ADDITIONAL_EXTENSION_FLAG, _pos, additional_extension_flag); }
     read_debug_rbsp_trailing_bits();
 }
 */
@@ -3370,57 +3677,57 @@ void read_debug_pic_parameter_set_rbsp(h264_stream_t* h, bs_t* b)
         memset(pps, 0, sizeof(pps_t));
     }
 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->pic_parameter_set_id = bs_read_ue(b); printf("pps->pic_parameter_set_id: %d \n", pps->pic_parameter_set_id); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->seq_parameter_set_id = bs_read_ue(b); printf("pps->seq_parameter_set_id: %d \n", pps->seq_parameter_set_id); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->entropy_coding_mode_flag = bs_read_u1(b); printf("pps->entropy_coding_mode_flag: %d \n", pps->entropy_coding_mode_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->pic_order_present_flag = bs_read_u1(b); printf("pps->pic_order_present_flag: %d \n", pps->pic_order_present_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->num_slice_groups_minus1 = bs_read_ue(b); printf("pps->num_slice_groups_minus1: %d \n", pps->num_slice_groups_minus1); 
+    { int _pos = bs_bit_pos(b); pps->pic_parameter_set_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_PIC_PARAMETER_SET_ID, _pos, pps->pic_parameter_set_id); }
+    { int _pos = bs_bit_pos(b); pps->seq_parameter_set_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_SEQ_PARAMETER_SET_ID, _pos, pps->seq_parameter_set_id); }
+    { int _pos = bs_bit_pos(b); pps->entropy_coding_mode_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PPS_ENTROPY_CODING_MODE_FLAG, _pos, pps->entropy_coding_mode_flag); }
+    { int _pos = bs_bit_pos(b); pps->pic_order_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PPS_PIC_ORDER_PRESENT_FLAG, _pos, pps->pic_order_present_flag); }
+    { int _pos = bs_bit_pos(b); pps->num_slice_groups_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_NUM_SLICE_GROUPS_MINUS1, _pos, pps->num_slice_groups_minus1); }
 
     if( pps->num_slice_groups_minus1 > 0 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->slice_group_map_type = bs_read_ue(b); printf("pps->slice_group_map_type: %d \n", pps->slice_group_map_type); 
+        { int _pos = bs_bit_pos(b); pps->slice_group_map_type = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_SLICE_GROUP_MAP_TYPE, _pos, pps->slice_group_map_type); }
         if( pps->slice_group_map_type == 0 )
         {
             for( int i_group = 0; i_group <= pps->num_slice_groups_minus1; i_group++ )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->run_length_minus1[ i_group ] = bs_read_ue(b); printf("pps->run_length_minus1[ i_group ]: %d \n", pps->run_length_minus1[ i_group ]); 
+                { int _pos = bs_bit_pos(b); pps->run_length_minus1[ i_group ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_RUN_LENGTH_MINUS1_I_GROUP, _pos, pps->run_length_minus1[ i_group ]); }
             }
         }
         else if( pps->slice_group_map_type == 2 )
         {
             for( int i_group = 0; i_group < pps->num_slice_groups_minus1; i_group++ )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->top_left[ i_group ] = bs_read_ue(b); printf("pps->top_left[ i_group ]: %d \n", pps->top_left[ i_group ]); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->bottom_right[ i_group ] = bs_read_ue(b); printf("pps->bottom_right[ i_group ]: %d \n", pps->bottom_right[ i_group ]); 
+                { int _pos = bs_bit_pos(b); pps->top_left[ i_group ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_TOP_LEFT_I_GROUP, _pos, pps->top_left[ i_group ]); }
+                { int _pos = bs_bit_pos(b); pps->bottom_right[ i_group ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_BOTTOM_RIGHT_I_GROUP, _pos, pps->bottom_right[ i_group ]); }
             }
         }
         else if( pps->slice_group_map_type == 3 ||
                  pps->slice_group_map_type == 4 ||
                  pps->slice_group_map_type == 5 )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->slice_group_change_direction_flag = bs_read_u1(b); printf("pps->slice_group_change_direction_flag: %d \n", pps->slice_group_change_direction_flag); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->slice_group_change_rate_minus1 = bs_read_ue(b); printf("pps->slice_group_change_rate_minus1: %d \n", pps->slice_group_change_rate_minus1); 
+            { int _pos = bs_bit_pos(b); pps->slice_group_change_direction_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PPS_SLICE_GROUP_CHANGE_DIRECTION_FLAG, _pos, pps->slice_group_change_direction_flag); }
+            { int _pos = bs_bit_pos(b); pps->slice_group_change_rate_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_SLICE_GROUP_CHANGE_RATE_MINUS1, _pos, pps->slice_group_change_rate_minus1); }
         }
         else if( pps->slice_group_map_type == 6 )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->pic_size_in_map_units_minus1 = bs_read_ue(b); printf("pps->pic_size_in_map_units_minus1: %d \n", pps->pic_size_in_map_units_minus1); 
+            { int _pos = bs_bit_pos(b); pps->pic_size_in_map_units_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_PIC_SIZE_IN_MAP_UNITS_MINUS1, _pos, pps->pic_size_in_map_units_minus1); }
             for( int i = 0; i <= pps->pic_size_in_map_units_minus1; i++ )
             {
                 int v = intlog2( pps->num_slice_groups_minus1 + 1 );
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->slice_group_id[ i ] = bs_read_u(b, v); printf("pps->slice_group_id[ i ]: %d \n", pps->slice_group_id[ i ]); 
+                { int _pos = bs_bit_pos(b); pps->slice_group_id[ i ] = bs_read_u(b, v); h264_debug_field(b, H264_FIELD_PPS_SLICE_GROUP_ID_I, _pos, pps->slice_group_id[ i ]); }
             }
         }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->num_ref_idx_l0_active_minus1 = bs_read_ue(b); printf("pps->num_ref_idx_l0_active_minus1: %d \n", pps->num_ref_idx_l0_active_minus1); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->num_ref_idx_l1_active_minus1 = bs_read_ue(b); printf("pps->num_ref_idx_l1_active_minus1: %d \n", pps->num_ref_idx_l1_active_minus1); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->weighted_pred_flag = bs_read_u1(b); printf("pps->weighted_pred_flag: %d \n", pps->weighted_pred_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->weighted_bipred_idc = bs_read_u(b, 2); printf("pps->weighted_bipred_idc: %d \n", pps->weighted_bipred_idc); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->pic_init_qp_minus26 = bs_read_se(b); printf("pps->pic_init_qp_minus26: %d \n", pps->pic_init_qp_minus26); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->pic_init_qs_minus26 = bs_read_se(b); printf("pps->pic_init_qs_minus26: %d \n", pps->pic_init_qs_minus26); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->chroma_qp_index_offset = bs_read_se(b); printf("pps->chroma_qp_index_offset: %d \n", pps->chroma_qp_index_offset); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->deblocking_filter_control_present_flag = bs_read_u1(b); printf("pps->deblocking_filter_control_present_flag: %d \n", pps->deblocking_filter_control_present_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->constrained_intra_pred_flag = bs_read_u1(b); printf("pps->constrained_intra_pred_flag: %d \n", pps->constrained_intra_pred_flag); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->redundant_pic_cnt_present_flag = bs_read_u1(b); printf("pps->redundant_pic_cnt_present_flag: %d \n", pps->redundant_pic_cnt_present_flag); 
+    { int _pos = bs_bit_pos(b); pps->num_ref_idx_l0_active_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_NUM_REF_IDX_L0_ACTIVE_MINUS1, _pos, pps->num_ref_idx_l0_active_minus1); }
+    { int _pos = bs_bit_pos(b); pps->num_ref_idx_l1_active_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_PPS_NUM_REF_IDX_L1_ACTIVE_MINUS1, _pos, pps->num_ref_idx_l1_active_minus1); }
+    { int _pos = bs_bit_pos(b); pps->weighted_pred_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PPS_WEIGHTED_PRED_FLAG, _pos, pps->weighted_pred_flag); }
+    { int _pos = bs_bit_pos(b); pps->weighted_bipred_idc = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_PPS_WEIGHTED_BIPRED_IDC, _pos, pps->weighted_bipred_idc); }
+    { int _pos = bs_bit_pos(b); pps->pic_init_qp_minus26 = bs_read_se(b); h264_debug_field(b, H264_FIELD_PPS_PIC_INIT_QP_MINUS26, _pos, pps->pic_init_qp_minus26); }
+    { int _pos = bs_bit_pos(b); pps->pic_init_qs_minus26 = bs_read_se(b); h264_debug_field(b, H264_FIELD_PPS_PIC_INIT_QS_MINUS26, _pos, pps->pic_init_qs_minus26); }
+    { int _pos = bs_bit_pos(b); pps->chroma_qp_index_offset = bs_read_se(b); h264_debug_field(b, H264_FIELD_PPS_CHROMA_QP_INDEX_OFFSET, _pos, pps->chroma_qp_index_offset); }
+    { int _pos = bs_bit_pos(b); pps->deblocking_filter_control_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PPS_DEBLOCKING_FILTER_CONTROL_PRESENT_FLAG, _pos, pps->deblocking_filter_control_present_flag); }
+    { int _pos = bs_bit_pos(b); pps->constrained_intra_pred_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PPS_CONSTRAINED_INTRA_PRED_FLAG, _pos, pps->constrained_intra_pred_flag); }
+    { int _pos = bs_bit_pos(b); pps->redundant_pic_cnt_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PPS_REDUNDANT_PIC_CNT_PRESENT_FLAG, _pos, pps->redundant_pic_cnt_present_flag); }
 
     int have_more_data = 0;
     if( 1 ) { have_more_data = more_rbsp_data(b); }
@@ -3431,13 +3738,13 @@ void read_debug_pic_parameter_set_rbsp(h264_stream_t* h, bs_t* b)
 
     if( have_more_data )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->transform_8x8_mode_flag = bs_read_u1(b); printf("pps->transform_8x8_mode_flag: %d \n", pps->transform_8x8_mode_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->pic_scaling_matrix_present_flag = bs_read_u1(b); printf("pps->pic_scaling_matrix_present_flag: %d \n", pps->pic_scaling_matrix_present_flag); 
+        { int _pos = bs_bit_pos(b); pps->transform_8x8_mode_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PPS_TRANSFORM_8X8_MODE_FLAG, _pos, pps->transform_8x8_mode_flag); }
+        { int _pos = bs_bit_pos(b); pps->pic_scaling_matrix_present_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PPS_PIC_SCALING_MATRIX_PRESENT_FLAG, _pos, pps->pic_scaling_matrix_present_flag); }
         if( pps->pic_scaling_matrix_present_flag )
         {
             for( int i = 0; i < 6 + 2* pps->transform_8x8_mode_flag; i++ )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->pic_scaling_list_present_flag[ i ] = bs_read_u1(b); printf("pps->pic_scaling_list_present_flag[ i ]: %d \n", pps->pic_scaling_list_present_flag[ i ]); 
+                { int _pos = bs_bit_pos(b); pps->pic_scaling_list_present_flag[ i ] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_PPS_PIC_SCALING_LIST_PRESENT_FLAG_I, _pos, pps->pic_scaling_list_present_flag[ i ]); }
                 if( pps->pic_scaling_list_present_flag[ i ] )
                 {
                     if( i < 6 )
@@ -3453,34 +3760,39 @@ void read_debug_pic_parameter_set_rbsp(h264_stream_t* h, bs_t* b)
                 }
             }
         }
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); pps->second_chroma_qp_index_offset = bs_read_se(b); printf("pps->second_chroma_qp_index_offset: %d \n", pps->second_chroma_qp_index_offset); 
+        { int _pos = bs_bit_pos(b); pps->second_chroma_qp_index_offset = bs_read_se(b); h264_debug_field(b, H264_FIELD_PPS_SECOND_CHROMA_QP_INDEX_OFFSET, _pos, pps->second_chroma_qp_index_offset); }
     }
 
     if( 1 )
     {
         memcpy(h->pps_table[pps->pic_parameter_set_id], h->pps, sizeof(pps_t));
+        h264_update_pps_ref(h, pps->pic_parameter_set_id);
     }
 }
 
-#ifdef HAVE_SEI
 //7.3.2.3 Supplemental enhancement information RBSP syntax
 void read_debug_sei_rbsp(h264_stream_t* h, bs_t* b)
 {
     if( 1 )
     {
-        for( int i = 0; i < h->num_seis; i++ )
-        {
-            sei_free(h->seis[i]);
-        }
-    
+        // messages and their payload storage are recycled from the previous sei, and only allocated when more are needed
+        if( h->seis_capacity < h->num_seis ) { h->seis_capacity = h->num_seis; }
         h->num_seis = 0;
         do {
+            if( h->num_seis == h->seis_capacity )
+            {
+                int capacity = ( h->seis_capacity > 0 ) ? h->seis_capacity * 2 : 4;
+                h->seis = (sei_t**)realloc(h->seis, capacity * sizeof(sei_t*));
+                for( int i = h->seis_capacity; i < capacity; i++ ) { h->seis[i] = sei_new(); }
+                h->seis_capacity = capacity;
+            }
+            h->sei = h->seis[h->num_seis];
             h->num_seis++;
-            h->seis = (sei_t**)realloc(h->seis, h->num_seis * sizeof(sei_t*));
-            h->seis[h->num_seis - 1] = sei_new();
-            h->sei = h->seis[h->num_seis - 1];
+            sei_reset(h->sei);
             read_debug_sei_message(h, b);
+            if( h->sei == NULL ) { h->num_seis--; } // skipped by h->sei_filter, the message is reused for the next one
         } while( more_rbsp_data(b) );
+        h->sei = ( h->num_seis > 0 ) ? h->seis[h->num_seis - 1] : NULL;
     }
 
     if( 0 )
@@ -3499,6 +3811,7 @@ void read_debug_sei_message(h264_stream_t* h, bs_t* b)
 {
     if( 0 )
     {
+        h->sei->payloadSize = sei_payload_size(h, h->sei);
         _write_ff_coded_number(b, h->sei->payloadType);
         _write_ff_coded_number(b, h->sei->payloadSize);
     }
@@ -3506,15 +3819,25 @@ void read_debug_sei_message(h264_stream_t* h, bs_t* b)
     {
         h->sei->payloadType = _read_ff_coded_number(b);
         h->sei->payloadSize = _read_ff_coded_number(b);
+
+        if( h->sei_filter != NULL )
+        {
+            const uint8_t* uuid = ( bs_byte_aligned(b) && b->end - b->p >= 16 ) ? b->p : NULL;
+            if( !sei_filter_accepts( h->sei_filter, h->sei->payloadType, uuid ) )
+            {
+                bs_skip_bytes( b, h->sei->payloadSize );
+                h->sei = NULL;
+                return;
+            }
+        }
     }
     read_debug_sei_payload( h, b );
 }
-#endif
 
 //7.3.2.4 Access unit delimiter RBSP syntax
 void read_debug_access_unit_delimiter_rbsp(h264_stream_t* h, bs_t* b)
 {
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); h->aud->primary_pic_type = bs_read_u(b, 3); printf("h->aud->primary_pic_type: %d \n", h->aud->primary_pic_type); 
+    { int _pos = bs_bit_pos(b); h->aud->primary_pic_type = bs_read_u(b, 3); h264_debug_field(b, H264_FIELD_H_AUD_PRIMARY_PIC_TYPE, _pos, h->aud->primary_pic_type); }
 }
 
 //7.3.2.5 End of sequence RBSP syntax
@@ -3532,7 +3855,7 @@ void read_debug_filler_data_rbsp(h264_stream_t* h, bs_t* b)
 {
     while( bs_next_bits(b, 8) == 0xFF )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); int ff_byte = bs_read_u(b, 8); printf("ff_byte: %d \n", ff_byte); 
+        { int _pos = bs_bit_pos(b); h264_debug_field(b, H264_FIELD_FF_BYTE, _pos, bs_read_u(b, 8)); }
     }
 }
 
@@ -3546,16 +3869,38 @@ void read_debug_slice_layer_rbsp(h264_stream_t* h,  bs_t* b)
     
     slice_data_rbsp_t* slice_data = h->slice_data;
 
-    if ( slice_data != NULL )
+    if ( slice_data != NULL && 0 )
+    {
+        if ( slice_data->rbsp_buf != NULL )
+        {
+            // the header may have changed length, the slice data follows it bit for bit; with CABAC it starts byte aligned
+            if ( h->pps->entropy_coding_mode_flag )
+            {
+                while( !bs_byte_aligned(b) ) { bs_write_u1(b, 1); } // cabac_alignment_one_bit
+            }
+            bs_write_bits(b, slice_data->rbsp_buf, slice_data->bit_offset, slice_data->bit_size);
+            read_debug_rbsp_trailing_bits(b);
+            return;
+        }
+    }
+    else if ( slice_data != NULL )
     {
         if ( slice_data->rbsp_buf != NULL ) free( slice_data->rbsp_buf ); 
-        uint8_t *sptr = b->p + (!!b->bits_left); // CABAC-specific: skip alignment bits, if there are any
+        // CAVLC slice data starts right after the header; CABAC slice data after the cabac_alignment_one_bits
+        uint8_t *sptr = b->p;
+        slice_data->bit_offset = 8 - b->bits_left;
+        if ( h->pps->entropy_coding_mode_flag && !bs_byte_aligned(b) )
+        {
+            sptr++;
+            slice_data->bit_offset = 0;
+        }
         slice_data->rbsp_size = b->end - sptr;
 
         if ( slice_data->rbsp_size > 0 )
         {
             slice_data->rbsp_buf = (uint8_t*)malloc(slice_data->rbsp_size);
             memcpy( slice_data->rbsp_buf, sptr, slice_data->rbsp_size );
+            slice_data->bit_size = slice_data_bit_size(slice_data->rbsp_buf, slice_data->rbsp_size, slice_data->bit_offset);
             // ugly hack: since next NALU starts at byte border, we are going to be padded by trailing_bits;
             return;
         }
@@ -3563,6 +3908,7 @@ void read_debug_slice_layer_rbsp(h264_stream_t* h,  bs_t* b)
         {
             slice_data->rbsp_buf = NULL;
             slice_data->rbsp_size = 0;
+            slice_data->bit_size = 0;
         }
     }
 
@@ -3583,18 +3929,18 @@ slice_data_partition_a_layer_rbsp( ) {
 
 //7.3.2.9.2 Slice data partition B RBSP syntax
 slice_data_partition_b_layer_rbsp( ) {
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); slice_id = bs_read_ue(b); printf("slice_id: %d \n", slice_id);     // only category 3
+    { int _pos = bs_bit_pos(b); slice_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SLICE_ID, _pos, slice_id); }    // only category 3
     if( redundant_pic_cnt_present_flag )
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); redundant_pic_cnt = bs_read_ue(b); printf("redundant_pic_cnt: %d \n", redundant_pic_cnt); 
+        { int _pos = bs_bit_pos(b); redundant_pic_cnt = bs_read_ue(b); h264_debug_field(b, H264_FIELD_REDUNDANT_PIC_CNT, _pos, redundant_pic_cnt); }
     read_debug_slice_data( );               // only category 3
     read_debug_rbsp_slice_trailing_bits( ); // only category 3
 }
 
 //7.3.2.9.3 Slice data partition C RBSP syntax
 slice_data_partition_c_layer_rbsp( ) {
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); slice_id = bs_read_ue(b); printf("slice_id: %d \n", slice_id);     // only category 4
+    { int _pos = bs_bit_pos(b); slice_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SLICE_ID, _pos, slice_id); }    // only category 4
     if( redundant_pic_cnt_present_flag )
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); redundant_pic_cnt = bs_read_ue(b); printf("redundant_pic_cnt: %d \n", redundant_pic_cnt); 
+        { int _pos = bs_bit_pos(b); redundant_pic_cnt = bs_read_ue(b); h264_debug_field(b, H264_FIELD_REDUNDANT_PIC_CNT, _pos, redundant_pic_cnt); }
     read_debug_slice_data( );               // only category 4
     rbsp_slice_trailing_bits( ); // only category 4
 }
@@ -3608,7 +3954,7 @@ void read_debug_rbsp_slice_trailing_bits(h264_stream_t* h, bs_t* b)
     {
         while( more_rbsp_trailing_data(h, b) )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); int cabac_zero_word = bs_read_u(b, 16); printf("cabac_zero_word: %d \n", cabac_zero_word); 
+            { int _pos = bs_bit_pos(b); h264_debug_field(b, H264_FIELD_CABAC_ZERO_WORD, _pos, bs_read_u(b, 16)); }
         }
     }
 }
@@ -3616,11 +3962,11 @@ void read_debug_rbsp_slice_trailing_bits(h264_stream_t* h, bs_t* b)
 //7.3.2.11 RBSP trailing bits syntax
 void read_debug_rbsp_trailing_bits(bs_t* b)
 {
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); int rbsp_stop_one_bit = bs_read_u(b, 1); printf("rbsp_stop_one_bit: %d \n", rbsp_stop_one_bit); 
+    { int _pos = bs_bit_pos(b); h264_debug_field(b, H264_FIELD_RBSP_STOP_ONE_BIT, _pos, bs_read_u(b, 1)); }
 
     while( !bs_byte_aligned(b) )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); int rbsp_alignment_zero_bit = bs_read_u(b, 1); printf("rbsp_alignment_zero_bit: %d \n", rbsp_alignment_zero_bit); 
+        { int _pos = bs_bit_pos(b); h264_debug_field(b, H264_FIELD_RBSP_ALIGNMENT_ZERO_BIT, _pos, bs_read_u(b, 1)); }
     }
 }
 
@@ -3635,67 +3981,73 @@ void read_debug_slice_header(h264_stream_t* h, bs_t* b)
 
     nal_t* nal = h->nal;
 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->first_mb_in_slice = bs_read_ue(b); printf("sh->first_mb_in_slice: %d \n", sh->first_mb_in_slice); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_type = bs_read_ue(b); printf("sh->slice_type: %d \n", sh->slice_type); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pic_parameter_set_id = bs_read_ue(b); printf("sh->pic_parameter_set_id: %d \n", sh->pic_parameter_set_id); 
+    { int _pos = bs_bit_pos(b); sh->first_mb_in_slice = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_FIRST_MB_IN_SLICE, _pos, sh->first_mb_in_slice); }
+    { int _pos = bs_bit_pos(b); sh->slice_type = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_SLICE_TYPE, _pos, sh->slice_type); }
+    { int _pos = bs_bit_pos(b); sh->pic_parameter_set_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_PIC_PARAMETER_SET_ID, _pos, sh->pic_parameter_set_id); }
 
     // TODO check existence, otherwise fail
     pps_t* pps = h->pps;
     sps_t* sps = h->sps;
     memcpy(h->pps, h->pps_table[sh->pic_parameter_set_id], sizeof(pps_t));
     memcpy(h->sps, h->sps_table[pps->seq_parameter_set_id], sizeof(sps_t));
+    if( 1 )
+    {
+        h->pps_ref = h->pps_refs[sh->pic_parameter_set_id];
+        h->sps_ref = h->sps_refs[pps->seq_parameter_set_id];
+        h->sps_subset_ref = NULL;
+    }
 
     if (sps->residual_colour_transform_flag)
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->colour_plane_id = bs_read_u(b, 2); printf("sh->colour_plane_id: %d \n", sh->colour_plane_id); 
+        { int _pos = bs_bit_pos(b); sh->colour_plane_id = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_SH_COLOUR_PLANE_ID, _pos, sh->colour_plane_id); }
     }
 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->frame_num = bs_read_u(b, sps->log2_max_frame_num_minus4 + 4 ); printf("sh->frame_num: %d \n", sh->frame_num);  // was u(v)
+    { int _pos = bs_bit_pos(b); sh->frame_num = bs_read_u(b, sps->log2_max_frame_num_minus4 + 4 ); h264_debug_field(b, H264_FIELD_SH_FRAME_NUM, _pos, sh->frame_num); } // was u(v)
     if( !sps->frame_mbs_only_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->field_pic_flag = bs_read_u1(b); printf("sh->field_pic_flag: %d \n", sh->field_pic_flag); 
+        { int _pos = bs_bit_pos(b); sh->field_pic_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_FIELD_PIC_FLAG, _pos, sh->field_pic_flag); }
         if( sh->field_pic_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->bottom_field_flag = bs_read_u1(b); printf("sh->bottom_field_flag: %d \n", sh->bottom_field_flag); 
+            { int _pos = bs_bit_pos(b); sh->bottom_field_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_BOTTOM_FIELD_FLAG, _pos, sh->bottom_field_flag); }
         }
     }
     if( nal->nal_unit_type == 5 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->idr_pic_id = bs_read_ue(b); printf("sh->idr_pic_id: %d \n", sh->idr_pic_id); 
+        { int _pos = bs_bit_pos(b); sh->idr_pic_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_IDR_PIC_ID, _pos, sh->idr_pic_id); }
     }
     if( sps->pic_order_cnt_type == 0 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pic_order_cnt_lsb = bs_read_u(b, sps->log2_max_pic_order_cnt_lsb_minus4 + 4 ); printf("sh->pic_order_cnt_lsb: %d \n", sh->pic_order_cnt_lsb);  // was u(v)
+        { int _pos = bs_bit_pos(b); sh->pic_order_cnt_lsb = bs_read_u(b, sps->log2_max_pic_order_cnt_lsb_minus4 + 4 ); h264_debug_field(b, H264_FIELD_SH_PIC_ORDER_CNT_LSB, _pos, sh->pic_order_cnt_lsb); } // was u(v)
         if( pps->pic_order_present_flag && !sh->field_pic_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->delta_pic_order_cnt_bottom = bs_read_se(b); printf("sh->delta_pic_order_cnt_bottom: %d \n", sh->delta_pic_order_cnt_bottom); 
+            { int _pos = bs_bit_pos(b); sh->delta_pic_order_cnt_bottom = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_DELTA_PIC_ORDER_CNT_BOTTOM, _pos, sh->delta_pic_order_cnt_bottom); }
         }
     }
     if( sps->pic_order_cnt_type == 1 && !sps->delta_pic_order_always_zero_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->delta_pic_order_cnt[ 0 ] = bs_read_se(b); printf("sh->delta_pic_order_cnt[ 0 ]: %d \n", sh->delta_pic_order_cnt[ 0 ]); 
+        { int _pos = bs_bit_pos(b); sh->delta_pic_order_cnt[ 0 ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_DELTA_PIC_ORDER_CNT_0, _pos, sh->delta_pic_order_cnt[ 0 ]); }
         if( pps->pic_order_present_flag && !sh->field_pic_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->delta_pic_order_cnt[ 1 ] = bs_read_se(b); printf("sh->delta_pic_order_cnt[ 1 ]: %d \n", sh->delta_pic_order_cnt[ 1 ]); 
+            { int _pos = bs_bit_pos(b); sh->delta_pic_order_cnt[ 1 ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_DELTA_PIC_ORDER_CNT_1, _pos, sh->delta_pic_order_cnt[ 1 ]); }
         }
     }
     if( pps->redundant_pic_cnt_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->redundant_pic_cnt = bs_read_ue(b); printf("sh->redundant_pic_cnt: %d \n", sh->redundant_pic_cnt); 
+        { int _pos = bs_bit_pos(b); sh->redundant_pic_cnt = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_REDUNDANT_PIC_CNT, _pos, sh->redundant_pic_cnt); }
     }
     if( is_slice_type( sh->slice_type, SH_SLICE_TYPE_B ) )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->direct_spatial_mv_pred_flag = bs_read_u1(b); printf("sh->direct_spatial_mv_pred_flag: %d \n", sh->direct_spatial_mv_pred_flag); 
+        { int _pos = bs_bit_pos(b); sh->direct_spatial_mv_pred_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_DIRECT_SPATIAL_MV_PRED_FLAG, _pos, sh->direct_spatial_mv_pred_flag); }
     }
     if( is_slice_type( sh->slice_type, SH_SLICE_TYPE_P ) || is_slice_type( sh->slice_type, SH_SLICE_TYPE_SP ) || is_slice_type( sh->slice_type, SH_SLICE_TYPE_B ) )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->num_ref_idx_active_override_flag = bs_read_u1(b); printf("sh->num_ref_idx_active_override_flag: %d \n", sh->num_ref_idx_active_override_flag); 
+        { int _pos = bs_bit_pos(b); sh->num_ref_idx_active_override_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_NUM_REF_IDX_ACTIVE_OVERRIDE_FLAG, _pos, sh->num_ref_idx_active_override_flag); }
         if( sh->num_ref_idx_active_override_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->num_ref_idx_l0_active_minus1 = bs_read_ue(b); printf("sh->num_ref_idx_l0_active_minus1: %d \n", sh->num_ref_idx_l0_active_minus1);  // FIXME does this modify the pps?
+            { int _pos = bs_bit_pos(b); sh->num_ref_idx_l0_active_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_NUM_REF_IDX_L0_ACTIVE_MINUS1, _pos, sh->num_ref_idx_l0_active_minus1); } // FIXME does this modify the pps?
             if( is_slice_type( sh->slice_type, SH_SLICE_TYPE_B ) )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->num_ref_idx_l1_active_minus1 = bs_read_ue(b); printf("sh->num_ref_idx_l1_active_minus1: %d \n", sh->num_ref_idx_l1_active_minus1); 
+                { int _pos = bs_bit_pos(b); sh->num_ref_idx_l1_active_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_NUM_REF_IDX_L1_ACTIVE_MINUS1, _pos, sh->num_ref_idx_l1_active_minus1); }
             }
         }
     }
@@ -3711,31 +4063,31 @@ void read_debug_slice_header(h264_stream_t* h, bs_t* b)
     }
     if( pps->entropy_coding_mode_flag && ! is_slice_type( sh->slice_type, SH_SLICE_TYPE_I ) && ! is_slice_type( sh->slice_type, SH_SLICE_TYPE_SI ) )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->cabac_init_idc = bs_read_ue(b); printf("sh->cabac_init_idc: %d \n", sh->cabac_init_idc); 
+        { int _pos = bs_bit_pos(b); sh->cabac_init_idc = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_CABAC_INIT_IDC, _pos, sh->cabac_init_idc); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_qp_delta = bs_read_se(b); printf("sh->slice_qp_delta: %d \n", sh->slice_qp_delta); 
+    { int _pos = bs_bit_pos(b); sh->slice_qp_delta = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SLICE_QP_DELTA, _pos, sh->slice_qp_delta); }
     if( is_slice_type( sh->slice_type, SH_SLICE_TYPE_SP ) || is_slice_type( sh->slice_type, SH_SLICE_TYPE_SI ) )
     {
         if( is_slice_type( sh->slice_type, SH_SLICE_TYPE_SP ) )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->sp_for_switch_flag = bs_read_u1(b); printf("sh->sp_for_switch_flag: %d \n", sh->sp_for_switch_flag); 
+            { int _pos = bs_bit_pos(b); sh->sp_for_switch_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SP_FOR_SWITCH_FLAG, _pos, sh->sp_for_switch_flag); }
         }
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_qs_delta = bs_read_se(b); printf("sh->slice_qs_delta: %d \n", sh->slice_qs_delta); 
+        { int _pos = bs_bit_pos(b); sh->slice_qs_delta = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SLICE_QS_DELTA, _pos, sh->slice_qs_delta); }
     }
     if( pps->deblocking_filter_control_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->disable_deblocking_filter_idc = bs_read_ue(b); printf("sh->disable_deblocking_filter_idc: %d \n", sh->disable_deblocking_filter_idc); 
+        { int _pos = bs_bit_pos(b); sh->disable_deblocking_filter_idc = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_DISABLE_DEBLOCKING_FILTER_IDC, _pos, sh->disable_deblocking_filter_idc); }
         if( sh->disable_deblocking_filter_idc != 1 )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_alpha_c0_offset_div2 = bs_read_se(b); printf("sh->slice_alpha_c0_offset_div2: %d \n", sh->slice_alpha_c0_offset_div2); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_beta_offset_div2 = bs_read_se(b); printf("sh->slice_beta_offset_div2: %d \n", sh->slice_beta_offset_div2); 
+            { int _pos = bs_bit_pos(b); sh->slice_alpha_c0_offset_div2 = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SLICE_ALPHA_C0_OFFSET_DIV2, _pos, sh->slice_alpha_c0_offset_div2); }
+            { int _pos = bs_bit_pos(b); sh->slice_beta_offset_div2 = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SLICE_BETA_OFFSET_DIV2, _pos, sh->slice_beta_offset_div2); }
         }
     }
     if( pps->num_slice_groups_minus1 > 0 &&
         pps->slice_group_map_type >= 3 && pps->slice_group_map_type <= 5)
     {
         int v = intlog2( pps->pic_size_in_map_units_minus1 +  pps->slice_group_change_rate_minus1 + 1 );
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_group_change_cycle = bs_read_u(b, v); printf("sh->slice_group_change_cycle: %d \n", sh->slice_group_change_cycle);  // FIXME add 2?
+        { int _pos = bs_bit_pos(b); sh->slice_group_change_cycle = bs_read_u(b, v); h264_debug_field(b, H264_FIELD_SH_SLICE_GROUP_CHANGE_CYCLE, _pos, sh->slice_group_change_cycle); } // FIXME add 2?
     }
 }
 
@@ -3747,44 +4099,44 @@ void read_debug_ref_pic_list_reordering(h264_stream_t* h, bs_t* b)
 
     if( ! is_slice_type( sh->slice_type, SH_SLICE_TYPE_I ) && ! is_slice_type( sh->slice_type, SH_SLICE_TYPE_SI ) )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->rplr.ref_pic_list_reordering_flag_l0 = bs_read_u1(b); printf("sh->rplr.ref_pic_list_reordering_flag_l0: %d \n", sh->rplr.ref_pic_list_reordering_flag_l0); 
+        { int _pos = bs_bit_pos(b); sh->rplr.ref_pic_list_reordering_flag_l0 = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_RPLR_REF_PIC_LIST_REORDERING_FLAG_L0, _pos, sh->rplr.ref_pic_list_reordering_flag_l0); }
         if( sh->rplr.ref_pic_list_reordering_flag_l0 )
         {
             int n = -1;
             do
             {
                 n++;
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->rplr.reorder_l0.reordering_of_pic_nums_idc[ n ] = bs_read_ue(b); printf("sh->rplr.reorder_l0.reordering_of_pic_nums_idc[ n ]: %d \n", sh->rplr.reorder_l0.reordering_of_pic_nums_idc[ n ]); 
+                { int _pos = bs_bit_pos(b); sh->rplr.reorder_l0.reordering_of_pic_nums_idc[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_RPLR_REORDER_L0_REORDERING_OF_PIC_NUMS_IDC_N, _pos, sh->rplr.reorder_l0.reordering_of_pic_nums_idc[ n ]); }
                 if( sh->rplr.reorder_l0.reordering_of_pic_nums_idc[ n ] == 0 ||
                     sh->rplr.reorder_l0.reordering_of_pic_nums_idc[ n ] == 1 )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->rplr.reorder_l0.abs_diff_pic_num_minus1[ n ] = bs_read_ue(b); printf("sh->rplr.reorder_l0.abs_diff_pic_num_minus1[ n ]: %d \n", sh->rplr.reorder_l0.abs_diff_pic_num_minus1[ n ]); 
+                    { int _pos = bs_bit_pos(b); sh->rplr.reorder_l0.abs_diff_pic_num_minus1[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_RPLR_REORDER_L0_ABS_DIFF_PIC_NUM_MINUS1_N, _pos, sh->rplr.reorder_l0.abs_diff_pic_num_minus1[ n ]); }
                 }
                 else if( sh->rplr.reorder_l0.reordering_of_pic_nums_idc[ n ] == 2 )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->rplr.reorder_l0.long_term_pic_num[ n ] = bs_read_ue(b); printf("sh->rplr.reorder_l0.long_term_pic_num[ n ]: %d \n", sh->rplr.reorder_l0.long_term_pic_num[ n ]); 
+                    { int _pos = bs_bit_pos(b); sh->rplr.reorder_l0.long_term_pic_num[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_RPLR_REORDER_L0_LONG_TERM_PIC_NUM_N, _pos, sh->rplr.reorder_l0.long_term_pic_num[ n ]); }
                 }
             } while( sh->rplr.reorder_l0.reordering_of_pic_nums_idc[ n ] != 3 && ! bs_eof(b) );
         }
     }
     if( is_slice_type( sh->slice_type, SH_SLICE_TYPE_B ) )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->rplr.ref_pic_list_reordering_flag_l1 = bs_read_u1(b); printf("sh->rplr.ref_pic_list_reordering_flag_l1: %d \n", sh->rplr.ref_pic_list_reordering_flag_l1); 
+        { int _pos = bs_bit_pos(b); sh->rplr.ref_pic_list_reordering_flag_l1 = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_RPLR_REF_PIC_LIST_REORDERING_FLAG_L1, _pos, sh->rplr.ref_pic_list_reordering_flag_l1); }
         if( sh->rplr.ref_pic_list_reordering_flag_l1 )
         {
             int n = -1;
             do
             {
                 n++;
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->rplr.reorder_l1.reordering_of_pic_nums_idc[ n ] = bs_read_ue(b); printf("sh->rplr.reorder_l1.reordering_of_pic_nums_idc[ n ]: %d \n", sh->rplr.reorder_l1.reordering_of_pic_nums_idc[ n ]); 
+                { int _pos = bs_bit_pos(b); sh->rplr.reorder_l1.reordering_of_pic_nums_idc[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_RPLR_REORDER_L1_REORDERING_OF_PIC_NUMS_IDC_N, _pos, sh->rplr.reorder_l1.reordering_of_pic_nums_idc[ n ]); }
                 if( sh->rplr.reorder_l1.reordering_of_pic_nums_idc[ n ] == 0 ||
                     sh->rplr.reorder_l1.reordering_of_pic_nums_idc[ n ] == 1 )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->rplr.reorder_l1.abs_diff_pic_num_minus1[ n ] = bs_read_ue(b); printf("sh->rplr.reorder_l1.abs_diff_pic_num_minus1[ n ]: %d \n", sh->rplr.reorder_l1.abs_diff_pic_num_minus1[ n ]); 
+                    { int _pos = bs_bit_pos(b); sh->rplr.reorder_l1.abs_diff_pic_num_minus1[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_RPLR_REORDER_L1_ABS_DIFF_PIC_NUM_MINUS1_N, _pos, sh->rplr.reorder_l1.abs_diff_pic_num_minus1[ n ]); }
                 }
                 else if( sh->rplr.reorder_l1.reordering_of_pic_nums_idc[ n ] == 2 )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->rplr.reorder_l1.long_term_pic_num[ n ] = bs_read_ue(b); printf("sh->rplr.reorder_l1.long_term_pic_num[ n ]: %d \n", sh->rplr.reorder_l1.long_term_pic_num[ n ]); 
+                    { int _pos = bs_bit_pos(b); sh->rplr.reorder_l1.long_term_pic_num[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_RPLR_REORDER_L1_LONG_TERM_PIC_NUM_N, _pos, sh->rplr.reorder_l1.long_term_pic_num[ n ]); }
                 }
             } while( sh->rplr.reorder_l1.reordering_of_pic_nums_idc[ n ] != 3 && ! bs_eof(b) );
         }
@@ -3800,28 +4152,28 @@ void read_debug_pred_weight_table(h264_stream_t* h, bs_t* b)
 
     int i, j;
 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.luma_log2_weight_denom = bs_read_ue(b); printf("sh->pwt.luma_log2_weight_denom: %d \n", sh->pwt.luma_log2_weight_denom); 
+    { int _pos = bs_bit_pos(b); sh->pwt.luma_log2_weight_denom = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_PWT_LUMA_LOG2_WEIGHT_DENOM, _pos, sh->pwt.luma_log2_weight_denom); }
     if( sps->chroma_format_idc != 0 ) //FIXME ChromaArrayType may differ from chroma_format_idc
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.chroma_log2_weight_denom = bs_read_ue(b); printf("sh->pwt.chroma_log2_weight_denom: %d \n", sh->pwt.chroma_log2_weight_denom); 
+        { int _pos = bs_bit_pos(b); sh->pwt.chroma_log2_weight_denom = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_PWT_CHROMA_LOG2_WEIGHT_DENOM, _pos, sh->pwt.chroma_log2_weight_denom); }
     }
     for( i = 0; i <= pps->num_ref_idx_l0_active_minus1; i++ )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.luma_weight_l0_flag[i] = bs_read_u1(b); printf("sh->pwt.luma_weight_l0_flag[i]: %d \n", sh->pwt.luma_weight_l0_flag[i]); 
+        { int _pos = bs_bit_pos(b); sh->pwt.luma_weight_l0_flag[i] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_PWT_LUMA_WEIGHT_L0_FLAG_I, _pos, sh->pwt.luma_weight_l0_flag[i]); }
         if( sh->pwt.luma_weight_l0_flag[i] )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.luma_weight_l0[ i ] = bs_read_se(b); printf("sh->pwt.luma_weight_l0[ i ]: %d \n", sh->pwt.luma_weight_l0[ i ]); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.luma_offset_l0[ i ] = bs_read_se(b); printf("sh->pwt.luma_offset_l0[ i ]: %d \n", sh->pwt.luma_offset_l0[ i ]); 
+            { int _pos = bs_bit_pos(b); sh->pwt.luma_weight_l0[ i ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_PWT_LUMA_WEIGHT_L0_I, _pos, sh->pwt.luma_weight_l0[ i ]); }
+            { int _pos = bs_bit_pos(b); sh->pwt.luma_offset_l0[ i ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_PWT_LUMA_OFFSET_L0_I, _pos, sh->pwt.luma_offset_l0[ i ]); }
         }
         if ( sps->chroma_format_idc != 0 ) //FIXME ChromaArrayType may differ from chroma_format_idc
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.chroma_weight_l0_flag[i] = bs_read_u1(b); printf("sh->pwt.chroma_weight_l0_flag[i]: %d \n", sh->pwt.chroma_weight_l0_flag[i]); 
+            { int _pos = bs_bit_pos(b); sh->pwt.chroma_weight_l0_flag[i] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_PWT_CHROMA_WEIGHT_L0_FLAG_I, _pos, sh->pwt.chroma_weight_l0_flag[i]); }
             if( sh->pwt.chroma_weight_l0_flag[i] )
             {
                 for( j =0; j < 2; j++ )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.chroma_weight_l0[ i ][ j ] = bs_read_se(b); printf("sh->pwt.chroma_weight_l0[ i ][ j ]: %d \n", sh->pwt.chroma_weight_l0[ i ][ j ]); 
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.chroma_offset_l0[ i ][ j ] = bs_read_se(b); printf("sh->pwt.chroma_offset_l0[ i ][ j ]: %d \n", sh->pwt.chroma_offset_l0[ i ][ j ]); 
+                    { int _pos = bs_bit_pos(b); sh->pwt.chroma_weight_l0[ i ][ j ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_PWT_CHROMA_WEIGHT_L0_I_J, _pos, sh->pwt.chroma_weight_l0[ i ][ j ]); }
+                    { int _pos = bs_bit_pos(b); sh->pwt.chroma_offset_l0[ i ][ j ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_PWT_CHROMA_OFFSET_L0_I_J, _pos, sh->pwt.chroma_offset_l0[ i ][ j ]); }
                 }
             }
         }
@@ -3830,21 +4182,21 @@ void read_debug_pred_weight_table(h264_stream_t* h, bs_t* b)
     {
         for( i = 0; i <= pps->num_ref_idx_l1_active_minus1; i++ )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.luma_weight_l1_flag[i] = bs_read_u1(b); printf("sh->pwt.luma_weight_l1_flag[i]: %d \n", sh->pwt.luma_weight_l1_flag[i]); 
+            { int _pos = bs_bit_pos(b); sh->pwt.luma_weight_l1_flag[i] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_PWT_LUMA_WEIGHT_L1_FLAG_I, _pos, sh->pwt.luma_weight_l1_flag[i]); }
             if( sh->pwt.luma_weight_l1_flag[i] )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.luma_weight_l1[ i ] = bs_read_se(b); printf("sh->pwt.luma_weight_l1[ i ]: %d \n", sh->pwt.luma_weight_l1[ i ]); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.luma_offset_l1[ i ] = bs_read_se(b); printf("sh->pwt.luma_offset_l1[ i ]: %d \n", sh->pwt.luma_offset_l1[ i ]); 
+                { int _pos = bs_bit_pos(b); sh->pwt.luma_weight_l1[ i ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_PWT_LUMA_WEIGHT_L1_I, _pos, sh->pwt.luma_weight_l1[ i ]); }
+                { int _pos = bs_bit_pos(b); sh->pwt.luma_offset_l1[ i ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_PWT_LUMA_OFFSET_L1_I, _pos, sh->pwt.luma_offset_l1[ i ]); }
             }
             if( sps->chroma_format_idc != 0 )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.chroma_weight_l1_flag[i] = bs_read_u1(b); printf("sh->pwt.chroma_weight_l1_flag[i]: %d \n", sh->pwt.chroma_weight_l1_flag[i]); 
+                { int _pos = bs_bit_pos(b); sh->pwt.chroma_weight_l1_flag[i] = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_PWT_CHROMA_WEIGHT_L1_FLAG_I, _pos, sh->pwt.chroma_weight_l1_flag[i]); }
                 if( sh->pwt.chroma_weight_l1_flag[i] )
                 {
                     for( j = 0; j < 2; j++ )
                     {
-                        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.chroma_weight_l1[ i ][ j ] = bs_read_se(b); printf("sh->pwt.chroma_weight_l1[ i ][ j ]: %d \n", sh->pwt.chroma_weight_l1[ i ][ j ]); 
-                        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pwt.chroma_offset_l1[ i ][ j ] = bs_read_se(b); printf("sh->pwt.chroma_offset_l1[ i ][ j ]: %d \n", sh->pwt.chroma_offset_l1[ i ][ j ]); 
+                        { int _pos = bs_bit_pos(b); sh->pwt.chroma_weight_l1[ i ][ j ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_PWT_CHROMA_WEIGHT_L1_I_J, _pos, sh->pwt.chroma_weight_l1[ i ][ j ]); }
+                        { int _pos = bs_bit_pos(b); sh->pwt.chroma_offset_l1[ i ][ j ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_PWT_CHROMA_OFFSET_L1_I_J, _pos, sh->pwt.chroma_offset_l1[ i ][ j ]); }
                     }
                 }
             }
@@ -3860,36 +4212,36 @@ void read_debug_dec_ref_pic_marking(h264_stream_t* h, bs_t* b)
 
     if( h->nal->nal_unit_type == 5 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->drpm.no_output_of_prior_pics_flag = bs_read_u1(b); printf("sh->drpm.no_output_of_prior_pics_flag: %d \n", sh->drpm.no_output_of_prior_pics_flag); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->drpm.long_term_reference_flag = bs_read_u1(b); printf("sh->drpm.long_term_reference_flag: %d \n", sh->drpm.long_term_reference_flag); 
+        { int _pos = bs_bit_pos(b); sh->drpm.no_output_of_prior_pics_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_DRPM_NO_OUTPUT_OF_PRIOR_PICS_FLAG, _pos, sh->drpm.no_output_of_prior_pics_flag); }
+        { int _pos = bs_bit_pos(b); sh->drpm.long_term_reference_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_DRPM_LONG_TERM_REFERENCE_FLAG, _pos, sh->drpm.long_term_reference_flag); }
     }
     else
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->drpm.adaptive_ref_pic_marking_mode_flag = bs_read_u1(b); printf("sh->drpm.adaptive_ref_pic_marking_mode_flag: %d \n", sh->drpm.adaptive_ref_pic_marking_mode_flag); 
+        { int _pos = bs_bit_pos(b); sh->drpm.adaptive_ref_pic_marking_mode_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_DRPM_ADAPTIVE_REF_PIC_MARKING_MODE_FLAG, _pos, sh->drpm.adaptive_ref_pic_marking_mode_flag); }
         if( sh->drpm.adaptive_ref_pic_marking_mode_flag )
         {
             int n = -1;
             do
             {
                 n++;
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->drpm.memory_management_control_operation[ n ] = bs_read_ue(b); printf("sh->drpm.memory_management_control_operation[ n ]: %d \n", sh->drpm.memory_management_control_operation[ n ]); 
+                { int _pos = bs_bit_pos(b); sh->drpm.memory_management_control_operation[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_DRPM_MEMORY_MANAGEMENT_CONTROL_OPERATION_N, _pos, sh->drpm.memory_management_control_operation[ n ]); }
                 if( sh->drpm.memory_management_control_operation[ n ] == 1 ||
                     sh->drpm.memory_management_control_operation[ n ] == 3 )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->drpm.difference_of_pic_nums_minus1[ n ] = bs_read_ue(b); printf("sh->drpm.difference_of_pic_nums_minus1[ n ]: %d \n", sh->drpm.difference_of_pic_nums_minus1[ n ]); 
+                    { int _pos = bs_bit_pos(b); sh->drpm.difference_of_pic_nums_minus1[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_DRPM_DIFFERENCE_OF_PIC_NUMS_MINUS1_N, _pos, sh->drpm.difference_of_pic_nums_minus1[ n ]); }
                 }
                 if(sh->drpm.memory_management_control_operation[ n ] == 2 )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->drpm.long_term_pic_num[ n ] = bs_read_ue(b); printf("sh->drpm.long_term_pic_num[ n ]: %d \n", sh->drpm.long_term_pic_num[ n ]); 
+                    { int _pos = bs_bit_pos(b); sh->drpm.long_term_pic_num[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_DRPM_LONG_TERM_PIC_NUM_N, _pos, sh->drpm.long_term_pic_num[ n ]); }
                 }
                 if( sh->drpm.memory_management_control_operation[ n ] == 3 ||
                     sh->drpm.memory_management_control_operation[ n ] == 6 )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->drpm.long_term_frame_idx[ n ] = bs_read_ue(b); printf("sh->drpm.long_term_frame_idx[ n ]: %d \n", sh->drpm.long_term_frame_idx[ n ]); 
+                    { int _pos = bs_bit_pos(b); sh->drpm.long_term_frame_idx[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_DRPM_LONG_TERM_FRAME_IDX_N, _pos, sh->drpm.long_term_frame_idx[ n ]); }
                 }
                 if( sh->drpm.memory_management_control_operation[ n ] == 4 )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->drpm.max_long_term_frame_idx_plus1[ n ] = bs_read_ue(b); printf("sh->drpm.max_long_term_frame_idx_plus1[ n ]: %d \n", sh->drpm.max_long_term_frame_idx_plus1[ n ]); 
+                    { int _pos = bs_bit_pos(b); sh->drpm.max_long_term_frame_idx_plus1[ n ] = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_DRPM_MAX_LONG_TERM_FRAME_IDX_PLUS1_N, _pos, sh->drpm.max_long_term_frame_idx_plus1[ n ]); }
                 }
             } while( sh->drpm.memory_management_control_operation[ n ] != 0 && ! bs_eof(b) );
         }
@@ -3909,9 +4261,9 @@ void read_debug_slice_header_in_scalable_extension(h264_stream_t* h, bs_t* b)
     
     nal_t* nal = h->nal;
     
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->first_mb_in_slice = bs_read_ue(b); printf("sh->first_mb_in_slice: %d \n", sh->first_mb_in_slice); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_type = bs_read_ue(b); printf("sh->slice_type: %d \n", sh->slice_type); 
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pic_parameter_set_id = bs_read_ue(b); printf("sh->pic_parameter_set_id: %d \n", sh->pic_parameter_set_id); 
+    { int _pos = bs_bit_pos(b); sh->first_mb_in_slice = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_FIRST_MB_IN_SLICE, _pos, sh->first_mb_in_slice); }
+    { int _pos = bs_bit_pos(b); sh->slice_type = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_SLICE_TYPE, _pos, sh->slice_type); }
+    { int _pos = bs_bit_pos(b); sh->pic_parameter_set_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_PIC_PARAMETER_SET_ID, _pos, sh->pic_parameter_set_id); }
     
     // TODO check existence, otherwise fail
     pps_t* pps = h->pps;
@@ -3920,61 +4272,67 @@ void read_debug_slice_header_in_scalable_extension(h264_stream_t* h, bs_t* b)
     //memcpy(sps_subset, h->sps_subset_table[pps->seq_parameter_set_id], sizeof(sps_subset_t));
     memcpy(sps_subset->sps, h->sps_subset_table[pps->seq_parameter_set_id]->sps, sizeof(sps_t));
     memcpy(sps_subset->sps_svc_ext, h->sps_subset_table[pps->seq_parameter_set_id]->sps_svc_ext, sizeof(sps_svc_ext_t));
+    if( 1 )
+    {
+        h->pps_ref = h->pps_refs[sh->pic_parameter_set_id];
+        h->sps_ref = NULL;
+        h->sps_subset_ref = h->sps_subset_refs[pps->seq_parameter_set_id];
+    }
     
     if (sps_subset->sps->residual_colour_transform_flag)
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->colour_plane_id = bs_read_u(b, 2); printf("sh->colour_plane_id: %d \n", sh->colour_plane_id); 
+        { int _pos = bs_bit_pos(b); sh->colour_plane_id = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_SH_COLOUR_PLANE_ID, _pos, sh->colour_plane_id); }
     }
     
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->frame_num = bs_read_u(b, sps_subset->sps->log2_max_frame_num_minus4 + 4 ); printf("sh->frame_num: %d \n", sh->frame_num);  // was u(v)
+    { int _pos = bs_bit_pos(b); sh->frame_num = bs_read_u(b, sps_subset->sps->log2_max_frame_num_minus4 + 4 ); h264_debug_field(b, H264_FIELD_SH_FRAME_NUM, _pos, sh->frame_num); } // was u(v)
     if( !sps_subset->sps->frame_mbs_only_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->field_pic_flag = bs_read_u1(b); printf("sh->field_pic_flag: %d \n", sh->field_pic_flag); 
+        { int _pos = bs_bit_pos(b); sh->field_pic_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_FIELD_PIC_FLAG, _pos, sh->field_pic_flag); }
         if( sh->field_pic_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->bottom_field_flag = bs_read_u1(b); printf("sh->bottom_field_flag: %d \n", sh->bottom_field_flag); 
+            { int _pos = bs_bit_pos(b); sh->bottom_field_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_BOTTOM_FIELD_FLAG, _pos, sh->bottom_field_flag); }
         }
     }
     if( nal->nal_unit_type == 5 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->idr_pic_id = bs_read_ue(b); printf("sh->idr_pic_id: %d \n", sh->idr_pic_id); 
+        { int _pos = bs_bit_pos(b); sh->idr_pic_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_IDR_PIC_ID, _pos, sh->idr_pic_id); }
     }
     if( sps_subset->sps->pic_order_cnt_type == 0 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->pic_order_cnt_lsb = bs_read_u(b, sps_subset->sps->log2_max_pic_order_cnt_lsb_minus4 + 4 ); printf("sh->pic_order_cnt_lsb: %d \n", sh->pic_order_cnt_lsb);  // was u(v)
+        { int _pos = bs_bit_pos(b); sh->pic_order_cnt_lsb = bs_read_u(b, sps_subset->sps->log2_max_pic_order_cnt_lsb_minus4 + 4 ); h264_debug_field(b, H264_FIELD_SH_PIC_ORDER_CNT_LSB, _pos, sh->pic_order_cnt_lsb); } // was u(v)
         if( pps->pic_order_present_flag && !sh->field_pic_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->delta_pic_order_cnt_bottom = bs_read_se(b); printf("sh->delta_pic_order_cnt_bottom: %d \n", sh->delta_pic_order_cnt_bottom); 
+            { int _pos = bs_bit_pos(b); sh->delta_pic_order_cnt_bottom = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_DELTA_PIC_ORDER_CNT_BOTTOM, _pos, sh->delta_pic_order_cnt_bottom); }
         }
     }
     if( sps_subset->sps->pic_order_cnt_type == 1 && !sps_subset->sps->delta_pic_order_always_zero_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->delta_pic_order_cnt[ 0 ] = bs_read_se(b); printf("sh->delta_pic_order_cnt[ 0 ]: %d \n", sh->delta_pic_order_cnt[ 0 ]); 
+        { int _pos = bs_bit_pos(b); sh->delta_pic_order_cnt[ 0 ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_DELTA_PIC_ORDER_CNT_0, _pos, sh->delta_pic_order_cnt[ 0 ]); }
         if( pps->pic_order_present_flag && !sh->field_pic_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->delta_pic_order_cnt[ 1 ] = bs_read_se(b); printf("sh->delta_pic_order_cnt[ 1 ]: %d \n", sh->delta_pic_order_cnt[ 1 ]); 
+            { int _pos = bs_bit_pos(b); sh->delta_pic_order_cnt[ 1 ] = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_DELTA_PIC_ORDER_CNT_1, _pos, sh->delta_pic_order_cnt[ 1 ]); }
         }
     }
     if( pps->redundant_pic_cnt_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->redundant_pic_cnt = bs_read_ue(b); printf("sh->redundant_pic_cnt: %d \n", sh->redundant_pic_cnt); 
+        { int _pos = bs_bit_pos(b); sh->redundant_pic_cnt = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_REDUNDANT_PIC_CNT, _pos, sh->redundant_pic_cnt); }
     }
     if( nal->nal_svc_ext->quality_id == 0)
     {
         if( is_slice_type( sh->slice_type, SH_SLICE_TYPE_EB ) )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->direct_spatial_mv_pred_flag = bs_read_u1(b); printf("sh->direct_spatial_mv_pred_flag: %d \n", sh->direct_spatial_mv_pred_flag); 
+            { int _pos = bs_bit_pos(b); sh->direct_spatial_mv_pred_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_DIRECT_SPATIAL_MV_PRED_FLAG, _pos, sh->direct_spatial_mv_pred_flag); }
         }
         if( is_slice_type( sh->slice_type, SH_SLICE_TYPE_EP ) ||
             is_slice_type( sh->slice_type, SH_SLICE_TYPE_EB ) )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->num_ref_idx_active_override_flag = bs_read_u1(b); printf("sh->num_ref_idx_active_override_flag: %d \n", sh->num_ref_idx_active_override_flag); 
+            { int _pos = bs_bit_pos(b); sh->num_ref_idx_active_override_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_NUM_REF_IDX_ACTIVE_OVERRIDE_FLAG, _pos, sh->num_ref_idx_active_override_flag); }
             if( sh->num_ref_idx_active_override_flag )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->num_ref_idx_l0_active_minus1 = bs_read_ue(b); printf("sh->num_ref_idx_l0_active_minus1: %d \n", sh->num_ref_idx_l0_active_minus1);  // FIXME does this modify the pps?
+                { int _pos = bs_bit_pos(b); sh->num_ref_idx_l0_active_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_NUM_REF_IDX_L0_ACTIVE_MINUS1, _pos, sh->num_ref_idx_l0_active_minus1); } // FIXME does this modify the pps?
                 if( is_slice_type( sh->slice_type, SH_SLICE_TYPE_EB ) )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->num_ref_idx_l1_active_minus1 = bs_read_ue(b); printf("sh->num_ref_idx_l1_active_minus1: %d \n", sh->num_ref_idx_l1_active_minus1); 
+                    { int _pos = bs_bit_pos(b); sh->num_ref_idx_l1_active_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_NUM_REF_IDX_L1_ACTIVE_MINUS1, _pos, sh->num_ref_idx_l1_active_minus1); }
                 }
             }
         }
@@ -3985,7 +4343,7 @@ void read_debug_slice_header_in_scalable_extension(h264_stream_t* h, bs_t* b)
             //svc specific
             if( !nal->nal_svc_ext->no_inter_layer_pred_flag )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->base_pred_weight_table_flag = bs_read_u1(b); printf("sh_svc_ext->base_pred_weight_table_flag: %d \n", sh_svc_ext->base_pred_weight_table_flag); 
+                { int _pos = bs_bit_pos(b); sh_svc_ext->base_pred_weight_table_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_BASE_PRED_WEIGHT_TABLE_FLAG, _pos, sh_svc_ext->base_pred_weight_table_flag); }
             }
             if( nal->nal_svc_ext->no_inter_layer_pred_flag || !sh_svc_ext->base_pred_weight_table_flag )
             {
@@ -3999,7 +4357,7 @@ void read_debug_slice_header_in_scalable_extension(h264_stream_t* h, bs_t* b)
             //svc specific
             if( !sps_subset->sps_svc_ext->slice_header_restriction_flag )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->store_ref_base_pic_flag = bs_read_u1(b); printf("sh_svc_ext->store_ref_base_pic_flag: %d \n", sh_svc_ext->store_ref_base_pic_flag); 
+                { int _pos = bs_bit_pos(b); sh_svc_ext->store_ref_base_pic_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_STORE_REF_BASE_PIC_FLAG, _pos, sh_svc_ext->store_ref_base_pic_flag); }
                 if( ( nal->nal_svc_ext->use_ref_base_pic_flag || sh_svc_ext->store_ref_base_pic_flag ) &&
                    ( nal->nal_unit_type != 5 ) )
                 {
@@ -4011,112 +4369,112 @@ void read_debug_slice_header_in_scalable_extension(h264_stream_t* h, bs_t* b)
     
     if( pps->entropy_coding_mode_flag && ! is_slice_type( sh->slice_type, SH_SLICE_TYPE_EI ) )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->cabac_init_idc = bs_read_ue(b); printf("sh->cabac_init_idc: %d \n", sh->cabac_init_idc); 
+        { int _pos = bs_bit_pos(b); sh->cabac_init_idc = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_CABAC_INIT_IDC, _pos, sh->cabac_init_idc); }
     }
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_qp_delta = bs_read_se(b); printf("sh->slice_qp_delta: %d \n", sh->slice_qp_delta); 
+    { int _pos = bs_bit_pos(b); sh->slice_qp_delta = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SLICE_QP_DELTA, _pos, sh->slice_qp_delta); }
     if( pps->deblocking_filter_control_present_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->disable_deblocking_filter_idc = bs_read_ue(b); printf("sh->disable_deblocking_filter_idc: %d \n", sh->disable_deblocking_filter_idc); 
+        { int _pos = bs_bit_pos(b); sh->disable_deblocking_filter_idc = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_DISABLE_DEBLOCKING_FILTER_IDC, _pos, sh->disable_deblocking_filter_idc); }
         if( sh->disable_deblocking_filter_idc != 1 )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_alpha_c0_offset_div2 = bs_read_se(b); printf("sh->slice_alpha_c0_offset_div2: %d \n", sh->slice_alpha_c0_offset_div2); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_beta_offset_div2 = bs_read_se(b); printf("sh->slice_beta_offset_div2: %d \n", sh->slice_beta_offset_div2); 
+            { int _pos = bs_bit_pos(b); sh->slice_alpha_c0_offset_div2 = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SLICE_ALPHA_C0_OFFSET_DIV2, _pos, sh->slice_alpha_c0_offset_div2); }
+            { int _pos = bs_bit_pos(b); sh->slice_beta_offset_div2 = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SLICE_BETA_OFFSET_DIV2, _pos, sh->slice_beta_offset_div2); }
         }
     }
     if( pps->num_slice_groups_minus1 > 0 &&
        pps->slice_group_map_type >= 3 && pps->slice_group_map_type <= 5)
     {
         int v = intlog2( pps->pic_size_in_map_units_minus1 +  pps->slice_group_change_rate_minus1 + 1 );
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh->slice_group_change_cycle = bs_read_u(b, v); printf("sh->slice_group_change_cycle: %d \n", sh->slice_group_change_cycle);  // FIXME add 2?
+        { int _pos = bs_bit_pos(b); sh->slice_group_change_cycle = bs_read_u(b, v); h264_debug_field(b, H264_FIELD_SH_SLICE_GROUP_CHANGE_CYCLE, _pos, sh->slice_group_change_cycle); } // FIXME add 2?
     }
     
     //svc specific
     if( !nal->nal_svc_ext->no_inter_layer_pred_flag && nal->nal_svc_ext->quality_id == 0 )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->ref_layer_dq_id = bs_read_ue(b); printf("sh_svc_ext->ref_layer_dq_id: %d \n", sh_svc_ext->ref_layer_dq_id); 
+        { int _pos = bs_bit_pos(b); sh_svc_ext->ref_layer_dq_id = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_REF_LAYER_DQ_ID, _pos, sh_svc_ext->ref_layer_dq_id); }
         if( sps_subset->sps_svc_ext->inter_layer_deblocking_filter_control_present_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->disable_inter_layer_deblocking_filter_idc = bs_read_ue(b); printf("sh_svc_ext->disable_inter_layer_deblocking_filter_idc: %d \n", sh_svc_ext->disable_inter_layer_deblocking_filter_idc); 
+            { int _pos = bs_bit_pos(b); sh_svc_ext->disable_inter_layer_deblocking_filter_idc = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_DISABLE_INTER_LAYER_DEBLOCKING_FILTER_IDC, _pos, sh_svc_ext->disable_inter_layer_deblocking_filter_idc); }
             if( sh_svc_ext->disable_inter_layer_deblocking_filter_idc != 1 )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->inter_layer_slice_alpha_c0_offset_div2 = bs_read_se(b); printf("sh_svc_ext->inter_layer_slice_alpha_c0_offset_div2: %d \n", sh_svc_ext->inter_layer_slice_alpha_c0_offset_div2); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->inter_layer_slice_beta_offset_div2 = bs_read_se(b); printf("sh_svc_ext->inter_layer_slice_beta_offset_div2: %d \n", sh_svc_ext->inter_layer_slice_beta_offset_div2); 
+                { int _pos = bs_bit_pos(b); sh_svc_ext->inter_layer_slice_alpha_c0_offset_div2 = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_INTER_LAYER_SLICE_ALPHA_C0_OFFSET_DIV2, _pos, sh_svc_ext->inter_layer_slice_alpha_c0_offset_div2); }
+                { int _pos = bs_bit_pos(b); sh_svc_ext->inter_layer_slice_beta_offset_div2 = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_INTER_LAYER_SLICE_BETA_OFFSET_DIV2, _pos, sh_svc_ext->inter_layer_slice_beta_offset_div2); }
             }
         }
         
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->constrained_intra_resampling_flag = bs_read_u1(b); printf("sh_svc_ext->constrained_intra_resampling_flag: %d \n", sh_svc_ext->constrained_intra_resampling_flag); 
+        { int _pos = bs_bit_pos(b); sh_svc_ext->constrained_intra_resampling_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_CONSTRAINED_INTRA_RESAMPLING_FLAG, _pos, sh_svc_ext->constrained_intra_resampling_flag); }
         if( sps_subset->sps_svc_ext->extended_spatial_scalability_idc == 2 )
         {
             if( sps_subset->sps->chroma_format_idc > 0 )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->ref_layer_chroma_phase_x_plus1_flag = bs_read_u1(b); printf("sh_svc_ext->ref_layer_chroma_phase_x_plus1_flag: %d \n", sh_svc_ext->ref_layer_chroma_phase_x_plus1_flag); 
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->ref_layer_chroma_phase_y_plus1 = bs_read_u(b, 2); printf("sh_svc_ext->ref_layer_chroma_phase_y_plus1: %d \n", sh_svc_ext->ref_layer_chroma_phase_y_plus1); 
+                { int _pos = bs_bit_pos(b); sh_svc_ext->ref_layer_chroma_phase_x_plus1_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_REF_LAYER_CHROMA_PHASE_X_PLUS1_FLAG, _pos, sh_svc_ext->ref_layer_chroma_phase_x_plus1_flag); }
+                { int _pos = bs_bit_pos(b); sh_svc_ext->ref_layer_chroma_phase_y_plus1 = bs_read_u(b, 2); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_REF_LAYER_CHROMA_PHASE_Y_PLUS1, _pos, sh_svc_ext->ref_layer_chroma_phase_y_plus1); }
             }
             
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->scaled_ref_layer_left_offset = bs_read_se(b); printf("sh_svc_ext->scaled_ref_layer_left_offset: %d \n", sh_svc_ext->scaled_ref_layer_left_offset); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->scaled_ref_layer_top_offset = bs_read_se(b); printf("sh_svc_ext->scaled_ref_layer_top_offset: %d \n", sh_svc_ext->scaled_ref_layer_top_offset); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->scaled_ref_layer_right_offset = bs_read_se(b); printf("sh_svc_ext->scaled_ref_layer_right_offset: %d \n", sh_svc_ext->scaled_ref_layer_right_offset); 
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->scaled_ref_layer_bottom_offset = bs_read_se(b); printf("sh_svc_ext->scaled_ref_layer_bottom_offset: %d \n", sh_svc_ext->scaled_ref_layer_bottom_offset); 
+            { int _pos = bs_bit_pos(b); sh_svc_ext->scaled_ref_layer_left_offset = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_SCALED_REF_LAYER_LEFT_OFFSET, _pos, sh_svc_ext->scaled_ref_layer_left_offset); }
+            { int _pos = bs_bit_pos(b); sh_svc_ext->scaled_ref_layer_top_offset = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_SCALED_REF_LAYER_TOP_OFFSET, _pos, sh_svc_ext->scaled_ref_layer_top_offset); }
+            { int _pos = bs_bit_pos(b); sh_svc_ext->scaled_ref_layer_right_offset = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_SCALED_REF_LAYER_RIGHT_OFFSET, _pos, sh_svc_ext->scaled_ref_layer_right_offset); }
+            { int _pos = bs_bit_pos(b); sh_svc_ext->scaled_ref_layer_bottom_offset = bs_read_se(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_SCALED_REF_LAYER_BOTTOM_OFFSET, _pos, sh_svc_ext->scaled_ref_layer_bottom_offset); }
         }
     }
     
     if( !nal->nal_svc_ext->no_inter_layer_pred_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->slice_skip_flag = bs_read_u1(b); printf("sh_svc_ext->slice_skip_flag: %d \n", sh_svc_ext->slice_skip_flag); 
+        { int _pos = bs_bit_pos(b); sh_svc_ext->slice_skip_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_SLICE_SKIP_FLAG, _pos, sh_svc_ext->slice_skip_flag); }
         if( sh_svc_ext->slice_skip_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->num_mbs_in_slice_minus1 = bs_read_ue(b); printf("sh_svc_ext->num_mbs_in_slice_minus1: %d \n", sh_svc_ext->num_mbs_in_slice_minus1); 
+            { int _pos = bs_bit_pos(b); sh_svc_ext->num_mbs_in_slice_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_NUM_MBS_IN_SLICE_MINUS1, _pos, sh_svc_ext->num_mbs_in_slice_minus1); }
         }
         else
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->adaptive_base_mode_flag = bs_read_u1(b); printf("sh_svc_ext->adaptive_base_mode_flag: %d \n", sh_svc_ext->adaptive_base_mode_flag); 
+            { int _pos = bs_bit_pos(b); sh_svc_ext->adaptive_base_mode_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_ADAPTIVE_BASE_MODE_FLAG, _pos, sh_svc_ext->adaptive_base_mode_flag); }
             if( !sh_svc_ext->adaptive_base_mode_flag )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->default_base_mode_flag = bs_read_u1(b); printf("sh_svc_ext->default_base_mode_flag: %d \n", sh_svc_ext->default_base_mode_flag); 
+                { int _pos = bs_bit_pos(b); sh_svc_ext->default_base_mode_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_DEFAULT_BASE_MODE_FLAG, _pos, sh_svc_ext->default_base_mode_flag); }
             }
             if( !sh_svc_ext->default_base_mode_flag )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->adaptive_motion_prediction_flag = bs_read_u1(b); printf("sh_svc_ext->adaptive_motion_prediction_flag: %d \n", sh_svc_ext->adaptive_motion_prediction_flag); 
+                { int _pos = bs_bit_pos(b); sh_svc_ext->adaptive_motion_prediction_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_ADAPTIVE_MOTION_PREDICTION_FLAG, _pos, sh_svc_ext->adaptive_motion_prediction_flag); }
                 if( !sh_svc_ext->adaptive_motion_prediction_flag )
                 {
-                    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->default_motion_prediction_flag = bs_read_u1(b); printf("sh_svc_ext->default_motion_prediction_flag: %d \n", sh_svc_ext->default_motion_prediction_flag); 
+                    { int _pos = bs_bit_pos(b); sh_svc_ext->default_motion_prediction_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_DEFAULT_MOTION_PREDICTION_FLAG, _pos, sh_svc_ext->default_motion_prediction_flag); }
                 }
             }
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->adaptive_residual_prediction_flag = bs_read_u1(b); printf("sh_svc_ext->adaptive_residual_prediction_flag: %d \n", sh_svc_ext->adaptive_residual_prediction_flag); 
+            { int _pos = bs_bit_pos(b); sh_svc_ext->adaptive_residual_prediction_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_ADAPTIVE_RESIDUAL_PREDICTION_FLAG, _pos, sh_svc_ext->adaptive_residual_prediction_flag); }
             if( !sh_svc_ext->adaptive_residual_prediction_flag )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->default_residual_prediction_flag = bs_read_u1(b); printf("sh_svc_ext->default_residual_prediction_flag: %d \n", sh_svc_ext->default_residual_prediction_flag); 
+                { int _pos = bs_bit_pos(b); sh_svc_ext->default_residual_prediction_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_DEFAULT_RESIDUAL_PREDICTION_FLAG, _pos, sh_svc_ext->default_residual_prediction_flag); }
             }
         }
         if( sps_subset->sps_svc_ext->adaptive_tcoeff_level_prediction_flag )
         {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->tcoeff_level_prediction_flag = bs_read_u1(b); printf("sh_svc_ext->tcoeff_level_prediction_flag: %d \n", sh_svc_ext->tcoeff_level_prediction_flag); 
+            { int _pos = bs_bit_pos(b); sh_svc_ext->tcoeff_level_prediction_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_TCOEFF_LEVEL_PREDICTION_FLAG, _pos, sh_svc_ext->tcoeff_level_prediction_flag); }
         }
     }
     
     if( !sps_subset->sps_svc_ext->slice_header_restriction_flag && !sh_svc_ext->slice_skip_flag )
     {
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->scan_idx_start = bs_read_u(b, 4); printf("sh_svc_ext->scan_idx_start: %d \n", sh_svc_ext->scan_idx_start); 
-        printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); sh_svc_ext->scan_idx_end = bs_read_u(b, 4); printf("sh_svc_ext->scan_idx_end: %d \n", sh_svc_ext->scan_idx_end); 
+        { int _pos = bs_bit_pos(b); sh_svc_ext->scan_idx_start = bs_read_u(b, 4); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_SCAN_IDX_START, _pos, sh_svc_ext->scan_idx_start); }
+        { int _pos = bs_bit_pos(b); sh_svc_ext->scan_idx_end = bs_read_u(b, 4); h264_debug_field(b, H264_FIELD_SH_SVC_EXT_SCAN_IDX_END, _pos, sh_svc_ext->scan_idx_end); }
     }
 }
 
 //G.7.3.3.5 Decoded reference base picture marking syntax
 void read_debug_dec_ref_base_pic_marking(nal_t* nal, bs_t* b)
 {
-    printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->prefix_nal_svc->adaptive_ref_base_pic_marking_mode_flag = bs_read_u1(b); printf("nal->prefix_nal_svc->adaptive_ref_base_pic_marking_mode_flag: %d \n", nal->prefix_nal_svc->adaptive_ref_base_pic_marking_mode_flag); 
+    { int _pos = bs_bit_pos(b); nal->prefix_nal_svc->adaptive_ref_base_pic_marking_mode_flag = bs_read_u1(b); h264_debug_field(b, H264_FIELD_NAL_PREFIX_NAL_SVC_ADAPTIVE_REF_BASE_PIC_MARKING_MODE_FLAG, _pos, nal->prefix_nal_svc->adaptive_ref_base_pic_marking_mode_flag); }
     if( nal->prefix_nal_svc->adaptive_ref_base_pic_marking_mode_flag )
     {
         do {
-            printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->prefix_nal_svc->memory_management_base_control_operation = bs_read_ue(b); printf("nal->prefix_nal_svc->memory_management_base_control_operation: %d \n", nal->prefix_nal_svc->memory_management_base_control_operation); 
+            { int _pos = bs_bit_pos(b); nal->prefix_nal_svc->memory_management_base_control_operation = bs_read_ue(b); h264_debug_field(b, H264_FIELD_NAL_PREFIX_NAL_SVC_MEMORY_MANAGEMENT_BASE_CONTROL_OPERATION, _pos, nal->prefix_nal_svc->memory_management_base_control_operation); }
             
             if( nal->prefix_nal_svc->memory_management_base_control_operation == 1 )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->prefix_nal_svc->difference_of_base_pic_nums_minus1 = bs_read_ue(b); printf("nal->prefix_nal_svc->difference_of_base_pic_nums_minus1: %d \n", nal->prefix_nal_svc->difference_of_base_pic_nums_minus1); 
+                { int _pos = bs_bit_pos(b); nal->prefix_nal_svc->difference_of_base_pic_nums_minus1 = bs_read_ue(b); h264_debug_field(b, H264_FIELD_NAL_PREFIX_NAL_SVC_DIFFERENCE_OF_BASE_PIC_NUMS_MINUS1, _pos, nal->prefix_nal_svc->difference_of_base_pic_nums_minus1); }
             }
             if( nal->prefix_nal_svc->memory_management_base_control_operation == 2 )
             {
-                printf("%ld.%d: ", (long int)(b->p - b->start), b->bits_left); nal->prefix_nal_svc->long_term_base_pic_num = bs_read_ue(b); printf("nal->prefix_nal_svc->long_term_base_pic_num: %d \n", nal->prefix_nal_svc->long_term_base_pic_num); 
+                { int _pos = bs_bit_pos(b); nal->prefix_nal_svc->long_term_base_pic_num = bs_read_ue(b); h264_debug_field(b, H264_FIELD_NAL_PREFIX_NAL_SVC_LONG_TERM_BASE_PIC_NUM, _pos, nal->prefix_nal_svc->long_term_base_pic_num); }
             }
         } while( nal->prefix_nal_svc->memory_management_base_control_operation != 0 );
     }
@@ -29,6 +29,7 @@
 
 #include "bs.h"
 #include "h264_sei.h"
+#include "h264_fields.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -452,51 +453,80 @@ typedef struct
     //int rbsp_size;
 } nal_t;
 
+/**
+   Slice data, kept as is when a slice is read, and written back after the slice header
+*/
+typedef struct
+{
+    int rbsp_size;
+    uint8_t* rbsp_buf;  // the rbsp from the byte with the first bit of slice_data() on
+    int bit_offset;     // of the first bit in rbsp_buf[0], 0 for CABAC (the cabac_alignment_one_bits are left out)
+    int bit_size;       // of slice_data(), up to the rbsp_stop_one_bit
+} slice_data_rbsp_t;
+
+/**
+   Callback invoked by read_debug_nal_unit for every syntax element it reads
+   @param[in] opaque      the opaque pointer given to h264_dbg_set_callback
+   @param[in] field_id    one of the H264_FIELD_* constants from h264_fields.h
+   @param[in] bit_offset  position of the element in the rbsp, in bits
+   @param[in] bit_width   number of bits the element occupies
+   @param[in] value       the decoded value
+   @see h264_field_name
+*/
+typedef void (*h264_debug_field_cb)(void* opaque, int field_id, int bit_offset, int bit_width, int64_t value);
+
+/**
+   Common header of refcounted parameter set snapshots.
+   A snapshot is never modified after it is created; reading a parameter set with different content
+   creates a new snapshot with the next generation number instead.
+   @see h264_ps_retain
+   @see h264_ps_release
+*/
+typedef struct
+{
+    volatile int refcount;
+    uint32_t generation;   // value of h264_stream_t.ps_generation when this snapshot was created
+} h264_ps_ref_t;
+
 typedef struct
 {
-    int _is_initialized;
-    int sps_id;
-    int initial_cpb_removal_delay;
-    int initial_cpb_delay_offset;
-} sei_buffering_t;
+    h264_ps_ref_t ref;
+    sps_t sps;
+} h264_sps_ref_t;
 
 typedef struct
 {
-    int clock_timestamp_flag;
-    int ct_type;
-    int nuit_field_based_flag;
-    int counting_type;
-    int full_timestamp_flag;
-    int discontinuity_flag;
-    int cnt_dropped_flag;
-    int n_frames;
-
-    int seconds_value;
-    int minutes_value;
-    int hours_value;
-
-    int seconds_flag;
-    int minutes_flag;
-    int hours_flag;
-
-    int time_offset;
-} picture_timestamp_t;
+    h264_ps_ref_t ref;
+    sps_t sps;
+    sps_svc_ext_t sps_svc_ext;
+    bool additional_extension2_flag;
+} h264_sps_subset_ref_t;
 
 typedef struct
 {
-    int _is_initialized;
-    int cpb_removal_delay;
-    int dpb_output_delay;
-    int pic_struct;
-    picture_timestamp_t clock_timestamps[3]; // 3 is the maximum possible value
-} sei_picture_timing_t;
+    h264_ps_ref_t ref;
+    pps_t pps;
+} h264_pps_ref_t;
 
+#define H264_DBG_BUF_SIZE (64*1024)
 
+/**
+   Debug output sink of a stream.
+   Text output is buffered and written to file in blocks, or kept in buf for memory sinks.
+   @see h264_dbg_set_file
+   @see h264_dbg_set_memory
+   @see h264_dbg_set_callback
+*/
 typedef struct
 {
-    int rbsp_size;
-    uint8_t* rbsp_buf;
-} slice_data_rbsp_t;
+    h264_debug_field_cb callback; // receives each syntax element read by read_debug_*; NULL disables them
+    void* opaque;
+    FILE* file;      // NULL means stdout
+    int to_memory;
+    char* buf;
+    int buf_len;
+    int buf_size;
+} h264_dbg_t;
 
 /**
    H264 stream
@@ -504,6 +534,8 @@ typedef struct
    When reading, data is read into those, and when writing it is written from those.  
    The reason why they are all contained in one place is that some of them depend on others, we need to 
    have all of them available to read or write correctly.
+   The library has no global mutable state: separate stream objects may be used concurrently from different threads,
+   a single stream object must only be used by one thread at a time.
  */
 typedef struct
 {
@@ -523,18 +555,74 @@ typedef struct
     sps_subset_t* sps_subset_table[64];  //refer to base SPS
     pps_t* pps_table[256];
     sei_t** seis;
+    int seis_capacity; // number of allocated messages in seis, at least num_seis; messages beyond num_seis are kept for reuse
+    const sei_filter_t* sei_filter; // SEI payloads to keep when reading, the others are skipped unparsed and not added to seis;
+                                    // NULL for all, but unless built with HAVE_SEI SEI NALs are only parsed with a filter (one with no types and uuids keeps all)
+
+    // snapshots of the parameter sets in the tables above, replaced (never modified) when different content is read
+    h264_sps_ref_t* sps_refs[32];
+    h264_sps_subset_ref_t* sps_subset_refs[64];
+    h264_pps_ref_t* pps_refs[256];
+    uint32_t ps_generation;  // number of parameter set changes read so far
+    // parameter sets used by the last slice read; owned by the tables, use h264_ps_retain to keep them
+    h264_sps_ref_t* sps_ref;
+    h264_sps_subset_ref_t* sps_subset_ref;
+    h264_pps_ref_t* pps_ref;
+
+    h264_dbg_t dbg;
 
 } h264_stream_t;
 
+/**
+   A NAL unit in memory, starting at the NAL header byte (no start code or length prefix)
+*/
+typedef struct
+{
+    const uint8_t* buf;
+    int size;
+} h264_nal_span_t;
+
+/**
+   One piece of scatter-gather output; the pieces are to be written out in order (e.g. with writev)
+*/
+typedef struct
+{
+    const uint8_t* base;
+    int len;
+} h264_iovec_t;
+
 h264_stream_t* h264_new();
 void h264_free(h264_stream_t* h);
 
+void* h264_ps_retain(void* ps);
+void h264_ps_release(void* ps);
+void h264_update_sps_ref(h264_stream_t* h, int id);
+void h264_update_sps_subset_ref(h264_stream_t* h, int id);
+void h264_update_pps_ref(h264_stream_t* h, int id);
+
 int find_nal_unit(uint8_t* buf, int size, int* nal_start, int* nal_end);
+int find_nal_unit_length_prefixed(const uint8_t* buf, int size, int length_size, int* nal_start, int* nal_end);
+
+/**
+   Iterator over the NAL units of a buffer, either Annex B or length-prefixed
+   @see h264_nal_iter_next
+*/
+typedef struct
+{
+    const uint8_t* p;
+    const uint8_t* end;
+    int length_size;  // 1 to 4, or 0 for Annex B
+} h264_nal_iter_t;
+
+void h264_nal_iter_init(h264_nal_iter_t* it, const uint8_t* buf, int size, int length_size);
+int h264_nal_iter_next(h264_nal_iter_t* it, h264_nal_span_t* nal);
 
 int rbsp_to_nal(const uint8_t* rbsp_buf, const int* rbsp_size, uint8_t* nal_buf, int* nal_size);
 int nal_to_rbsp(const uint8_t* nal_buf, int* nal_size, uint8_t* rbsp_buf, int* rbsp_size);
+int h264_peek_ue(const uint8_t* nal, int size, int skip, uint32_t* values, int num_values);
 
 int read_nal_unit(h264_stream_t* h, uint8_t* buf, int size);
+int read_nal_unit_with_rbsp(h264_stream_t* h, uint8_t* buf, int size, uint8_t* rbsp_buf, int rbsp_capacity);
 int peek_nal_unit(h264_stream_t* h, uint8_t* buf, int size);
 
 void read_seq_parameter_set_rbsp(sps_t* sps, bs_t* b);
@@ -544,6 +632,10 @@ void read_hrd_parameters(hrd_t* hrd, bs_t* b);
 
 void read_pic_parameter_set_rbsp(h264_stream_t* h, bs_t* b);
 
+int _read_ff_coded_number(bs_t* b);
+void _write_ff_coded_number(bs_t* b, int n);
+int sei_payload_size(h264_stream_t* h, sei_t* s);
+
 void read_sei_rbsp(h264_stream_t* h, bs_t* b);
 void read_sei_message(h264_stream_t* h, bs_t* b);
 void read_access_unit_delimiter_rbsp(h264_stream_t* h, bs_t* b);
@@ -562,6 +654,7 @@ void read_dec_ref_pic_marking(h264_stream_t* h, bs_t* b);
 int more_rbsp_trailing_data(h264_stream_t* h, bs_t* b);
 
 int write_nal_unit(h264_stream_t* h, uint8_t* buf, int size);
+int write_nal_unit_with_rbsp(h264_stream_t* h, uint8_t* buf, int size, uint8_t* rbsp_buf, int rbsp_capacity);
 
 void write_seq_parameter_set_rbsp(sps_t* sps, bs_t* b);
 void write_scaling_list(bs_t* b, int* scalingList, int sizeOfScalingList, int* useDefaultScalingMatrixFlag );
@@ -586,13 +679,14 @@ void write_pred_weight_table(h264_stream_t* h, bs_t* b);
 void write_dec_ref_pic_marking(h264_stream_t* h, bs_t* b);
 
 int read_debug_nal_unit(h264_stream_t* h, uint8_t* buf, int size);
+int read_debug_nal_unit_with_rbsp(h264_stream_t* h, uint8_t* buf, int size, uint8_t* rbsp_buf, int rbsp_capacity);
 
 void debug_sps(sps_t* sps);
 void debug_pps(pps_t* pps);
 void debug_slice_header(slice_header_t* sh);
 void debug_nal(h264_stream_t* h, nal_t* nal);
 
-void debug_bytes(uint8_t* buf, int len);
+void debug_bytes(h264_stream_t* h, uint8_t* buf, int len);
 
 void read_sei_payload( h264_stream_t* h, bs_t* b);
 void read_debug_sei_payload( h264_stream_t* h, bs_t* b);
@@ -697,8 +791,17 @@ void write_sei_payload( h264_stream_t* h, bs_t* b);
 #define H264_PROFILE_EXTENDED  88
 #define H264_PROFILE_HIGH     100
 
-// file handle for debug output
-extern FILE* h264_dbgfile;
+const char* h264_field_name(int field_id);
+int h264_field_id(const char* name);
+
+void h264_dbg_set_file(h264_stream_t* h, FILE* f);
+void h264_dbg_set_memory(h264_stream_t* h);
+void h264_dbg_set_callback(h264_stream_t* h, h264_debug_field_cb cb, void* opaque);
+void h264_dbg_printf(h264_stream_t* h, const char* fmt, ...);
+void h264_dbg_flush(h264_stream_t* h);
+
+void h264_debug_print_field(void* opaque, int field_id, int bit_offset, int bit_width, int64_t value);
+void h264_debug_field(bs_t* b, int field_id, int bit_offset, int64_t value);
 
 #ifdef __cplusplus
 }
@@ -25,14 +25,142 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
 
 #include "bs.h"
 #include "h264_stream.h"
 #include "h264_sei.h"
 
-FILE* h264_dbgfile = NULL;
+#define H264_FIELD_NAME(id, name) name,
+static const char* const h264_field_names[] = { H264_FIELDS(H264_FIELD_NAME) NULL };
+#undef H264_FIELD_NAME
 
-#define printf(...) fprintf((h264_dbgfile == NULL ? stdout : h264_dbgfile), __VA_ARGS__)
+/**
+ Get the name of a syntax element reported to the debug callback.
+ @param[in] field_id  one of the H264_FIELD_* constants
+ @return    the element name as printed by read_debug_nal_unit, or NULL if the id is not valid
+ */
+const char* h264_field_name(int field_id)
+{
+    if (field_id < 0 || field_id >= H264_FIELD_COUNT) { return NULL; }
+    return h264_field_names[field_id];
+}
+
+/**
+ Look up the id of a syntax element by name, e.g. "sps->profile_idc".
+ Intended to be called once at setup, so that the debug callback only has to compare integers.
+ @return    one of the H264_FIELD_* constants, or -1 if no such element exists
+ */
+int h264_field_id(const char* name)
+{
+    for (int i = 0; i < H264_FIELD_COUNT; i++)
+    {
+        if (strcmp(h264_field_names[i], name) == 0) { return i; }
+    }
+    return -1;
+}
+
+/**
+ Write any buffered debug output of a stream to its file.  Does nothing for memory sinks.
+ @param[in,out] h   the stream object
+ */
+void h264_dbg_flush(h264_stream_t* h)
+{
+    h264_dbg_t* dbg = &h->dbg;
+    if (dbg->to_memory || dbg->buf_len == 0) { return; }
+    fwrite(dbg->buf, 1, dbg->buf_len, (dbg->file == NULL ? stdout : dbg->file));
+    dbg->buf_len = 0;
+    dbg->buf[0] = '\0';
+}
+
+/**
+ Send debug output of a stream to a file.  Output is buffered per stream and written in large blocks.
+ @param[in,out] h   the stream object
+ @param[in]     f   the file, or NULL for stdout
+ */
+void h264_dbg_set_file(h264_stream_t* h, FILE* f)
+{
+    h264_dbg_flush(h);
+    h->dbg.file = f;
+    h->dbg.to_memory = 0;
+}
+
+/**
+ Keep debug output of a stream in memory.  The text accumulates, NUL-terminated, in h->dbg.buf (h->dbg.buf_len bytes);
+ set h->dbg.buf_len to 0 to discard it.
+ @param[in,out] h   the stream object
+ */
+void h264_dbg_set_memory(h264_stream_t* h)
+{
+    h264_dbg_flush(h);
+    h->dbg.to_memory = 1;
+}
+
+/**
+ Set the callback which receives every syntax element read by read_debug_nal_unit.
+ @param[in,out] h       the stream object
+ @param[in]     cb      the callback, h264_debug_print_field to print to the debug sink, or NULL for no output
+ @param[in]     opaque  passed to the callback; h264_debug_print_field expects the stream object
+ */
+void h264_dbg_set_callback(h264_stream_t* h, h264_debug_field_cb cb, void* opaque)
+{
+    h->dbg.callback = cb;
+    h->dbg.opaque = opaque;
+}
+
+/**
+ printf into the debug sink of a stream.
+ */
+void h264_dbg_printf(h264_stream_t* h, const char* fmt, ...)
+{
+    h264_dbg_t* dbg = &h->dbg;
+    va_list ap;
+
+    if (dbg->buf == NULL)
+    {
+        dbg->buf_size = H264_DBG_BUF_SIZE;
+        dbg->buf = (char*)malloc(dbg->buf_size);
+        dbg->buf_len = 0;
+    }
+
+    while (1)
+    {
+        int room = dbg->buf_size - dbg->buf_len;
+        va_start(ap, fmt);
+        int n = vsnprintf(dbg->buf + dbg->buf_len, room, fmt, ap);
+        va_end(ap);
+        if (n < 0) { dbg->buf[dbg->buf_len] = '\0'; return; }
+        if (n < room) { dbg->buf_len += n; return; }
+
+        // did not fit: make room by flushing, or grow if it still won't fit (always, for memory sinks)
+        if (!dbg->to_memory && dbg->buf_len > 0) { h264_dbg_flush(h); continue; }
+        int size = dbg->buf_size * 2;
+        if (size < dbg->buf_len + n + 1) { size = dbg->buf_len + n + 1; }
+        dbg->buf = (char*)realloc(dbg->buf, size);
+        dbg->buf_size = size;
+    }
+}
+
+/**
+ Default debug callback, prints each element as "byte.bits_left: name: value".
+ @param[in] opaque  the stream object whose debug sink to print to; if NULL, prints to stdout
+ */
+void h264_debug_print_field(void* opaque, int field_id, int bit_offset, int bit_width, int64_t value)
+{
+    h264_stream_t* h = (h264_stream_t*)opaque;
+    // value is printed as int to keep the output identical to earlier versions
+    if (h == NULL) { printf("%d.%d: %s: %d \n", bit_offset / 8, 8 - bit_offset % 8, h264_field_name(field_id), (int)value); return; }
+    h264_dbg_printf(h, "%d.%d: %s: %d \n", bit_offset / 8, 8 - bit_offset % 8, h264_field_name(field_id), (int)value);
+}
+
+void h264_debug_field(bs_t* b, int field_id, int bit_offset, int64_t value)
+{
+    h264_stream_t* h = (h264_stream_t*)b->priv;
+    if (h == NULL) { h264_debug_print_field(NULL, field_id, bit_offset, bs_bit_pos(b) - bit_offset, value); return; }
+    if (h->dbg.callback == NULL) { return; }
+    h->dbg.callback(h->dbg.opaque, field_id, bit_offset, bs_bit_pos(b) - bit_offset, value);
+}
 
 /** 
  Calculate the log base 2 of the argument, rounded up. 
@@ -114,15 +242,27 @@ void _write_ff_coded_number(bs_t* b, int n)
     }
 }
 
-void debug_bytes(uint8_t* buf, int len)
+// number of bits of slice data from bit_offset of buf[0] up to the rbsp_stop_one_bit, leaving out the trailing bits and cabac_zero_words
+static int slice_data_bit_size(const uint8_t* buf, int size, int bit_offset)
+{
+    int i = size - 1;
+    while (i >= 0 && buf[i] == 0) { i--; }
+    if (i < 0) { return 0; }
+    int stop_bit = 0;
+    while (((buf[i] >> stop_bit) & 0x01) == 0) { stop_bit++; }
+    int bits = i * 8 + (7 - stop_bit) - bit_offset;
+    return (bits > 0) ? bits : 0;
+}
+
+void debug_bytes(h264_stream_t* h, uint8_t* buf, int len)
 {
     int i;
     for (i = 0; i < len; i++)
     {
-        printf("%02X ", buf[i]);
-        if ((i+1) % 16 == 0) { printf ("\n"); }
+        h264_dbg_printf(h, "%02X ", buf[i]);
+        if ((i+1) % 16 == 0) { h264_dbg_printf(h, "\n"); }
     }
-    printf("\n");
+    h264_dbg_printf(h, "\n");
 }
 
 #end_preamble
@@ -132,26 +272,42 @@ void debug_bytes(uint8_t* buf, int len)
 
 //7.3.1 NAL unit syntax
 int structure(nal_unit)(h264_stream_t* h, uint8_t* buf, int size)
+{
+    uint8_t* rbsp_buf = (uint8_t*)calloc(1, size);
+    int rc = structure(nal_unit_with_rbsp)(h, buf, size, rbsp_buf, size);
+    free(rbsp_buf);
+    return rc;
+}
+
+/**
+ The same as nal_unit, with the rbsp in a buffer of the caller, so that nothing is allocated for the NAL itself
+ (the structures it is read into may still be, e.g. slice data or SEI payloads).
+ @param[in]  rbsp_buf       room for the rbsp; for reading it needs as many bytes as the NAL
+ @param[in]  rbsp_capacity  size of rbsp_buf
+ */
+int structure(nal_unit_with_rbsp)(h264_stream_t* h, uint8_t* buf, int size, uint8_t* rbsp_buf, int rbsp_capacity)
 {
     nal_t* nal = h->nal;
 
     int nal_size = size;
-    int rbsp_size = size;
-    uint8_t* rbsp_buf = (uint8_t*)calloc(1, rbsp_size);
+    int rbsp_size = rbsp_capacity;
 
     if( is_reading )
     {
         int rc = nal_to_rbsp(buf, &nal_size, rbsp_buf, &rbsp_size);
 
-        if (rc < 0) { free(rbsp_buf); return -1; } // handle conversion error
+        if (rc < 0) { return -1; } // handle conversion error
     }
 
     if( is_writing )
     {
         rbsp_size = size*3/4; // NOTE this may have to be slightly smaller (3/4 smaller, worst case) in order to be guaranteed to fit
+        if( rbsp_size > rbsp_capacity ) { rbsp_size = rbsp_capacity; }
     }
 
-    bs_t* b = bs_new(rbsp_buf, rbsp_size);
+    bs_t bs;
+    bs_t* b = bs_init(&bs, rbsp_buf, rbsp_size);
+    b->priv = h;
     value( forbidden_zero_bit, f(1, 0) );
     value( nal->nal_ref_idc, u(2) );
     value( nal->nal_unit_type, u(5) );
@@ -181,12 +337,14 @@ int structure(nal_unit)(h264_stream_t* h, uint8_t* buf, int size)
             structure(slice_layer_rbsp)(h, b);
             break;
 
-#ifdef HAVE_SEI
         case NAL_UNIT_TYPE_SEI:
+#ifndef HAVE_SEI
+            // without HAVE_SEI, SEI is only read for a caller which asks for it with a filter
+            if( is_reading && h->sei_filter == NULL ) { return -1; }
+#endif
             structure(sei_rbsp)(h, b);
             structure(rbsp_trailing_bits)(b);
             break;
-#endif
 
         case NAL_UNIT_TYPE_SPS: 
             structure(seq_parameter_set_rbsp)(h->sps, b);
@@ -195,6 +353,7 @@ int structure(nal_unit)(h264_stream_t* h, uint8_t* buf, int size)
             if( is_reading )
             {
                 memcpy(h->sps_table[h->sps->seq_parameter_set_id], h->sps, sizeof(sps_t));
+                h264_update_sps_ref(h, h->sps->seq_parameter_set_id);
             }
 
             break;
@@ -226,10 +385,11 @@ int structure(nal_unit)(h264_stream_t* h, uint8_t* buf, int size)
             
             if( is_reading )
             {
-                memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id], h->sps_subset, sizeof(sps_subset_t));
-                //memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps, h->sps_subset->sps, sizeof(sps_t));
-                //memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps_svc_ext, h->sps_subset->sps_svc_ext, sizeof(sps_svc_ext_t));
-                //h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->additional_extension2_flag = h->sps_subset->additional_extension2_flag;
+                //memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id], h->sps_subset, sizeof(sps_subset_t));
+                memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps, h->sps_subset->sps, sizeof(sps_t));
+                memcpy(h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->sps_svc_ext, h->sps_subset->sps_svc_ext, sizeof(sps_svc_ext_t));
+                h->sps_subset_table[h->sps_subset->sps->seq_parameter_set_id]->additional_extension2_flag = h->sps_subset->additional_extension2_flag;
+                h264_update_sps_subset_ref(h, h->sps_subset->sps->seq_parameter_set_id);
             }
 
             break;
@@ -256,7 +416,7 @@ int structure(nal_unit)(h264_stream_t* h, uint8_t* buf, int size)
             return -1;
     }
 
-    if (bs_overrun(b)) { bs_free(b); free(rbsp_buf); return -1; }
+    if (bs_overrun(b)) { return -1; }
 
     if( is_writing )
     {
@@ -264,12 +424,9 @@ int structure(nal_unit)(h264_stream_t* h, uint8_t* buf, int size)
         rbsp_size = bs_pos(b);
 
         int rc = rbsp_to_nal(rbsp_buf, &rbsp_size, buf, &nal_size);
-        if (rc < 0) { bs_free(b); free(rbsp_buf); return -1; }
+        if (rc < 0) { return -1; }
     }
 
-    bs_free(b);
-    free(rbsp_buf);
-
     return nal_size;
 }
 
@@ -367,7 +524,7 @@ void structure(seq_parameter_set_rbsp)(sps_t* sps, bs_t* b)
         value( sps->seq_scaling_matrix_present_flag, u1 );
         if( sps->seq_scaling_matrix_present_flag )
         {
-            for( i = 0; i < 8; i++ )
+            for( i = 0; i < ((sps->chroma_format_idc != 3) ? 8 : 12); i++ )
             {
                 value( sps->seq_scaling_list_present_flag[ i ], u1 );
                 if( sps->seq_scaling_list_present_flag[ i ] )
@@ -549,12 +706,12 @@ void structure(svc_vui_parameters_extension)(sps_svc_ext_t* sps_svc_ext, bs_t* b
         value( sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i], u1 );
         if( sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i] )
         {
-            structure(hrd_parameters)(&sps_svc_ext->hrd_vcl, b);
+            structure(hrd_parameters)(&sps_svc_ext->hrd_vcl[i], b);
         }
         value( sps_svc_ext->vui.vui_ext_vcl_hrd_parameters_present_flag[i], u1 );
         if( sps_svc_ext->vui.vui_ext_vcl_hrd_parameters_present_flag[i] )
         {
-            structure(hrd_parameters)(&sps_svc_ext->hrd_nal, b);
+            structure(hrd_parameters)(&sps_svc_ext->hrd_nal[i], b);
         }
         
         if( sps_svc_ext->vui.vui_ext_nal_hrd_parameters_present_flag[i] ||
@@ -773,28 +930,33 @@ void structure(pic_parameter_set_rbsp)(h264_stream_t* h, bs_t* b)
     if( is_reading )
     {
         memcpy(h->pps_table[pps->pic_parameter_set_id], h->pps, sizeof(pps_t));
+        h264_update_pps_ref(h, pps->pic_parameter_set_id);
     }
 }
 
-#ifdef HAVE_SEI
 //7.3.2.3 Supplemental enhancement information RBSP syntax
 void structure(sei_rbsp)(h264_stream_t* h, bs_t* b)
 {
     if( is_reading )
     {
-        for( int i = 0; i < h->num_seis; i++ )
-        {
-            sei_free(h->seis[i]);
-        }
-    
+        // messages and their payload storage are recycled from the previous sei, and only allocated when more are needed
+        if( h->seis_capacity < h->num_seis ) { h->seis_capacity = h->num_seis; }
         h->num_seis = 0;
         do {
+            if( h->num_seis == h->seis_capacity )
+            {
+                int capacity = ( h->seis_capacity > 0 ) ? h->seis_capacity * 2 : 4;
+                h->seis = (sei_t**)realloc(h->seis, capacity * sizeof(sei_t*));
+                for( int i = h->seis_capacity; i < capacity; i++ ) { h->seis[i] = sei_new(); }
+                h->seis_capacity = capacity;
+            }
+            h->sei = h->seis[h->num_seis];
             h->num_seis++;
-            h->seis = (sei_t**)realloc(h->seis, h->num_seis * sizeof(sei_t*));
-            h->seis[h->num_seis - 1] = sei_new();
-            h->sei = h->seis[h->num_seis - 1];
+            sei_reset(h->sei);
             structure(sei_message)(h, b);
+            if( h->sei == NULL ) { h->num_seis--; } // skipped by h->sei_filter, the message is reused for the next one
         } while( more_rbsp_data(b) );
+        h->sei = ( h->num_seis > 0 ) ? h->seis[h->num_seis - 1] : NULL;
     }
 
     if( is_writing )
@@ -813,6 +975,7 @@ void structure(sei_message)(h264_stream_t* h, bs_t* b)
 {
     if( is_writing )
     {
+        h->sei->payloadSize = sei_payload_size(h, h->sei);
         _write_ff_coded_number(b, h->sei->payloadType);
         _write_ff_coded_number(b, h->sei->payloadSize);
     }
@@ -820,10 +983,20 @@ void structure(sei_message)(h264_stream_t* h, bs_t* b)
     {
         h->sei->payloadType = _read_ff_coded_number(b);
         h->sei->payloadSize = _read_ff_coded_number(b);
+
+        if( h->sei_filter != NULL )
+        {
+            const uint8_t* uuid = ( bs_byte_aligned(b) && b->end - b->p >= 16 ) ? b->p : NULL;
+            if( !sei_filter_accepts( h->sei_filter, h->sei->payloadType, uuid ) )
+            {
+                bs_skip_bytes( b, h->sei->payloadSize );
+                h->sei = NULL;
+                return;
+            }
+        }
     }
     structure(sei_payload)( h, b );
 }
-#endif
 
 //7.3.2.4 Access unit delimiter RBSP syntax
 void structure(access_unit_delimiter_rbsp)(h264_stream_t* h, bs_t* b)
@@ -860,16 +1033,47 @@ void structure(slice_layer_rbsp)(h264_stream_t* h,  bs_t* b)
     
     slice_data_rbsp_t* slice_data = h->slice_data;
 
-    if ( slice_data != NULL )
+    if ( slice_data != NULL && is_writing )
+    {
+        if ( slice_data->rbsp_buf != NULL )
+        {
+            // the header may have changed length, the slice data follows it bit for bit; with CABAC it starts byte aligned
+            if ( h->pps->entropy_coding_mode_flag )
+            {
+                while( !bs_byte_aligned(b) ) { bs_write_u1(b, 1); } // cabac_alignment_one_bit
+            }
+            bs_write_bits(b, slice_data->rbsp_buf, slice_data->bit_offset, slice_data->bit_size);
+            structure(rbsp_trailing_bits)(b);
+            return;
+        }
+    }
+    else if ( slice_data != NULL )
     {
         if ( slice_data->rbsp_buf != NULL ) free( slice_data->rbsp_buf ); 
-        uint8_t *sptr = b->p + (!!b->bits_left); // CABAC-specific: skip alignment bits, if there are any
+        // CAVLC slice data starts right after the header; CABAC slice data after the cabac_alignment_one_bits
+        uint8_t *sptr = b->p;
+        slice_data->bit_offset = 8 - b->bits_left;
+        if ( h->pps->entropy_coding_mode_flag && !bs_byte_aligned(b) )
+        {
+            sptr++;
+            slice_data->bit_offset = 0;
+        }
         slice_data->rbsp_size = b->end - sptr;
-        
-        slice_data->rbsp_buf = (uint8_t*)malloc(slice_data->rbsp_size);
-        memcpy( slice_data->rbsp_buf, sptr, slice_data->rbsp_size );
-        // ugly hack: since next NALU starts at byte border, we are going to be padded by trailing_bits;
-        return;
+
+        if ( slice_data->rbsp_size > 0 )
+        {
+            slice_data->rbsp_buf = (uint8_t*)malloc(slice_data->rbsp_size);
+            memcpy( slice_data->rbsp_buf, sptr, slice_data->rbsp_size );
+            slice_data->bit_size = slice_data_bit_size(slice_data->rbsp_buf, slice_data->rbsp_size, slice_data->bit_offset);
+            // ugly hack: since next NALU starts at byte border, we are going to be padded by trailing_bits;
+            return;
+        }
+        else
+        {
+            slice_data->rbsp_buf = NULL;
+            slice_data->rbsp_size = 0;
+            slice_data->bit_size = 0;
+        }
     }
 
     // FIXME should read or skip data
@@ -950,12 +1154,18 @@ void structure(slice_header)(h264_stream_t* h, bs_t* b)
     sps_t* sps = h->sps;
     memcpy(h->pps, h->pps_table[sh->pic_parameter_set_id], sizeof(pps_t));
     memcpy(h->sps, h->sps_table[pps->seq_parameter_set_id], sizeof(sps_t));
+    if( is_reading )
+    {
+        h->pps_ref = h->pps_refs[sh->pic_parameter_set_id];
+        h->sps_ref = h->sps_refs[pps->seq_parameter_set_id];
+        h->sps_subset_ref = NULL;
+    }
 
     if (sps->residual_colour_transform_flag)
     {
         value( sh->colour_plane_id, u(2) );
     }
-    
+
     value( sh->frame_num, u(sps->log2_max_frame_num_minus4 + 4 ) ); // was u(v)
     if( !sps->frame_mbs_only_flag )
     {
@@ -1107,7 +1317,7 @@ void structure(pred_weight_table)(h264_stream_t* h, bs_t* b)
     int i, j;
 
     value( sh->pwt.luma_log2_weight_denom, ue );
-    if( sps->chroma_format_idc != 0 )
+    if( sps->chroma_format_idc != 0 ) //FIXME ChromaArrayType may differ from chroma_format_idc
     {
         value( sh->pwt.chroma_log2_weight_denom, ue );
     }
@@ -1119,7 +1329,7 @@ void structure(pred_weight_table)(h264_stream_t* h, bs_t* b)
             value( sh->pwt.luma_weight_l0[ i ], se );
             value( sh->pwt.luma_offset_l0[ i ], se );
         }
-        if ( sps->chroma_format_idc != 0 )
+        if ( sps->chroma_format_idc != 0 ) //FIXME ChromaArrayType may differ from chroma_format_idc
         {
             value( sh->pwt.chroma_weight_l0_flag[i], u1 );
             if( sh->pwt.chroma_weight_l0_flag[i] )
@@ -1223,9 +1433,15 @@ void structure(slice_header_in_scalable_extension)(h264_stream_t* h, bs_t* b)
     pps_t* pps = h->pps;
     sps_subset_t* sps_subset = h->sps_subset;
     memcpy(h->pps, h->pps_table[sh->pic_parameter_set_id], sizeof(pps_t));
-    memcpy(sps_subset, h->sps_subset_table[pps->seq_parameter_set_id], sizeof(sps_subset_t));
-    //memcpy(h->sps_subset->sps, h->sps_subset_table[pps->seq_parameter_set_id]->sps, sizeof(sps_t));
-    //memcpy(h->sps_subset->sps_svc_ext, h->sps_subset_table[pps->seq_parameter_set_id]->sps_svc_ext, sizeof(sps_svc_ext_t));
+    //memcpy(sps_subset, h->sps_subset_table[pps->seq_parameter_set_id], sizeof(sps_subset_t));
+    memcpy(sps_subset->sps, h->sps_subset_table[pps->seq_parameter_set_id]->sps, sizeof(sps_t));
+    memcpy(sps_subset->sps_svc_ext, h->sps_subset_table[pps->seq_parameter_set_id]->sps_svc_ext, sizeof(sps_svc_ext_t));
+    if( is_reading )
+    {
+        h->pps_ref = h->pps_refs[sh->pic_parameter_set_id];
+        h->sps_ref = NULL;
+        h->sps_subset_ref = h->sps_subset_refs[pps->seq_parameter_set_id];
+    }
     
     if (sps_subset->sps->residual_colour_transform_flag)
     {
@@ -1309,7 +1525,7 @@ void structure(slice_header_in_scalable_extension)(h264_stream_t* h, bs_t* b)
                 if( ( nal->nal_svc_ext->use_ref_base_pic_flag || sh_svc_ext->store_ref_base_pic_flag ) &&
                    ( nal->nal_unit_type != 5 ) )
                 {
-                    structure(dec_ref_base_pic_marking)(h, b);
+                    structure(dec_ref_base_pic_marking)(nal, b);
                 }
             }
         }
@@ -0,0 +1,409 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bs.h"
+#include "h264_stream.h"
+#include "h264_filter.h"
+#include "h264_svc.h"
+
+/**
+ Read the NAL header extension and the first fields of the slice header of a slice, without parsing the rest of the slice
+ header as read_slice_header_in_scalable_extension does, or allocating anything; only the first bytes of the NAL are unescaped.
+ @param[in]  nal    the NAL, starting with its header byte
+ @param[in]  size   size of the NAL
+ @param[out] slice  the fields read
+ @return     1 for a base layer slice or a slice in scalable extension, 0 for any other NAL (including slices of an MVC
+             extension), or -1 if the slice header is broken
+ */
+int h264_peek_svc_slice_header(const uint8_t* nal, int size, h264_svc_slice_t* slice)
+{
+    if ( size < 1 ) { return 0; }
+    int header_size = 1;
+    uint32_t v[3];
+
+    switch ( nal[0] & 0x1F )
+    {
+        case NAL_UNIT_TYPE_CODED_SLICE_NON_IDR:
+        case NAL_UNIT_TYPE_CODED_SLICE_IDR:
+            memset(&slice->nal_svc_ext, 0, sizeof(nal_svc_ext_t));
+            break;
+
+        case NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION:
+            if ( !h264_peek_nal_svc_ext(nal, size, &slice->nal_svc_ext) ) { return 0; }
+            header_size = 4;
+            break;
+
+        default:
+            return 0;
+    }
+
+    // first_mb_in_slice, slice_type, pic_parameter_set_id
+    if ( h264_peek_ue(nal, size, header_size, v, 3) < 0 || v[1] > 9 || v[2] > 255 ) { return -1; }
+    slice->first_mb_in_slice = v[0];
+    slice->slice_type = v[1];
+    slice->pic_parameter_set_id = v[2];
+    return 1;
+}
+
+/**
+ Create an SVC layer demuxer.
+ @param[in]  flags     H264_SVC_SPLIT_QUALITY and/or H264_SVC_SPLIT_TEMPORAL, to tell layers apart by more than dependency_id
+ @param[in]  layer_cb  receives the NALs of each layer
+ @param[in]  opaque    passed to layer_cb
+ */
+h264_svc_demux_t* h264_svc_demux_new(int flags, h264_svc_layer_cb layer_cb, void* opaque)
+{
+    h264_svc_demux_t* d = (h264_svc_demux_t*)calloc(1, sizeof(h264_svc_demux_t));
+    d->flags = flags;
+    d->prefix_layer = H264_SVC_NO_LAYER;
+    d->layer_cb = layer_cb;
+    d->opaque = opaque;
+    return d;
+}
+
+void h264_svc_demux_free(h264_svc_demux_t* d)
+{
+    if ( d == NULL ) { return; }
+    for ( int i = 0; i < 32; i++ ) { free(d->sps[i].nal); free(d->subset_sps[i].nal); }
+    for ( int i = 0; i < 256; i++ ) { free(d->pps[i].nal); }
+    for ( int i = 0; i < H264_SVC_MAX_LAYERS; i++ ) { free(d->sent[i]); }
+    free(d->prefix);
+    free(d);
+}
+
+static void svc_keep_ps(h264_svc_ps_t* ps, const uint8_t* nal, int size)
+{
+    if ( ps->nal != NULL && ps->size == size && memcmp(ps->nal, nal, size) == 0 ) { return; }
+    free(ps->nal);
+    ps->nal = (uint8_t*)malloc(size);
+    memcpy(ps->nal, nal, size);
+    ps->size = size;
+    ps->generation++;
+}
+
+// pass a parameter set on to a layer, unless it got this one already
+static void svc_send_ps(h264_svc_demux_t* d, int layer, h264_svc_ps_t* ps, int* sent)
+{
+    if ( ps->nal == NULL || *sent == ps->generation ) { return; }
+    *sent = ps->generation;
+    d->layer_cb(d->opaque, layer, ps->nal, ps->size);
+}
+
+static int svc_layer(h264_svc_demux_t* d, const nal_svc_ext_t* nal_svc_ext)
+{
+    return H264_SVC_LAYER(nal_svc_ext->dependency_id,
+                          ( d->flags & H264_SVC_SPLIT_QUALITY ) ? nal_svc_ext->quality_id : 0,
+                          ( d->flags & H264_SVC_SPLIT_TEMPORAL ) ? nal_svc_ext->temporal_id : 0);
+}
+
+/**
+ Pass a NAL unit on to the layer it belongs to, in stream order.
+ Slices and prefix NALs go to their layer; base layer slices to the layer of the prefix NAL before them, or to layer 0 in a
+ stream without prefix NALs.  A prefix NAL is held back until its slice comes, so that it still goes right before it.  Parameter sets are kept, and passed on to each layer right before its first slice which refers to
+ them, again whenever they change: an SPS or subset SPS, then the PPS.  All other NALs go to H264_SVC_NO_LAYER.
+ Only the NAL header, its SVC extension, and the first exp-Golomb codes of slice headers and parameter sets are looked at.
+ @param[in]  d     the demuxer
+ @param[in]  nal   the NAL, starting with its header byte
+ @param[in]  size  size of the NAL
+ @return     the layer the NAL was passed to, or -2 if it is broken
+ */
+int h264_svc_demux_nal(h264_svc_demux_t* d, const uint8_t* nal, int size)
+{
+    if ( size < 1 ) { return -2; }
+    int nal_unit_type = nal[0] & 0x1F;
+    int layer = H264_SVC_NO_LAYER;
+    h264_svc_ps_t* sps_table = d->sps;
+    int* sent_sps;
+    nal_svc_ext_t nal_svc_ext;
+    h264_svc_slice_t slice;
+    uint32_t v[2];
+
+    // a prefix NAL without a base layer slice after it
+    if ( d->prefix_layer != H264_SVC_NO_LAYER && nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_NON_IDR && nal_unit_type != NAL_UNIT_TYPE_CODED_SLICE_IDR )
+    {
+        d->layer_cb(d->opaque, d->prefix_layer, d->prefix, d->prefix_size);
+        d->prefix_layer = H264_SVC_NO_LAYER;
+    }
+
+    switch ( nal_unit_type )
+    {
+        case NAL_UNIT_TYPE_SPS:
+        case NAL_UNIT_TYPE_SUBSET_SPS:
+            // seq_parameter_set_id follows profile_idc, the constraint flags and level_idc
+            if ( h264_peek_ue(nal, size, 4, v, 1) < 0 || v[0] > 31 ) { return -2; }
+            svc_keep_ps(( nal_unit_type == NAL_UNIT_TYPE_SPS ) ? &d->sps[v[0]] : &d->subset_sps[v[0]], nal, size);
+            return H264_SVC_NO_LAYER;
+
+        case NAL_UNIT_TYPE_PPS:
+            if ( h264_peek_ue(nal, size, 1, v, 1) < 0 || v[0] > 255 ) { return -2; }
+            svc_keep_ps(&d->pps[v[0]], nal, size);
+            return H264_SVC_NO_LAYER;
+
+        case NAL_UNIT_TYPE_PREFIX_NAL:
+            if ( !h264_peek_nal_svc_ext(nal, size, &nal_svc_ext) ) { return -2; }
+            if ( d->prefix_capacity < size )
+            {
+                d->prefix_capacity = size;
+                d->prefix = (uint8_t*)realloc(d->prefix, size);
+            }
+            memcpy(d->prefix, nal, size);
+            d->prefix_size = size;
+            d->prefix_layer = svc_layer(d, &nal_svc_ext);
+            return d->prefix_layer;
+
+        case NAL_UNIT_TYPE_CODED_SLICE_NON_IDR:
+        case NAL_UNIT_TYPE_CODED_SLICE_IDR:
+            if ( h264_peek_svc_slice_header(nal, size, &slice) < 1 ) { return -2; }
+            layer = ( d->prefix_layer != H264_SVC_NO_LAYER ) ? d->prefix_layer : 0;
+            break;
+
+        case NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION:
+            if ( h264_peek_svc_slice_header(nal, size, &slice) < 1 ) { return -2; }
+            layer = svc_layer(d, &slice.nal_svc_ext);
+            sps_table = d->subset_sps;
+            break;
+
+        default:
+            d->layer_cb(d->opaque, H264_SVC_NO_LAYER, nal, size);
+            return H264_SVC_NO_LAYER;
+    }
+
+    if ( d->sent[layer] == NULL ) { d->sent[layer] = (int*)calloc(32 + 32 + 256, sizeof(int)); }
+    sent_sps = d->sent[layer] + ( ( sps_table == d->sps ) ? 0 : 32 );
+
+    h264_svc_ps_t* pps = &d->pps[slice.pic_parameter_set_id];
+    if ( pps->nal != NULL && h264_peek_ue(pps->nal, pps->size, 1, v, 2) == 0 && v[1] < 32 )
+    {
+        svc_send_ps(d, layer, &sps_table[v[1]], &sent_sps[v[1]]);
+        svc_send_ps(d, layer, pps, &d->sent[layer][64 + v[0]]);
+    }
+    if ( d->prefix_layer != H264_SVC_NO_LAYER )
+    {
+        d->layer_cb(d->opaque, d->prefix_layer, d->prefix, d->prefix_size);
+        d->prefix_layer = H264_SVC_NO_LAYER;
+    }
+    d->layer_cb(d->opaque, layer, nal, size);
+    return layer;
+}
+
+/**
+ Create an extractor of an operation point.
+ @param[in]  dependency_id  the target: the highest dependency_id to keep
+ @param[in]  quality_id     the highest quality_id to keep of the target dependency_id; lower dependency_ids keep all of theirs
+ @param[in]  temporal_id    the highest temporal_id to keep
+ */
+h264_svc_extractor_t* h264_svc_extractor_new(int dependency_id, int quality_id, int temporal_id)
+{
+    h264_svc_extractor_t* x = (h264_svc_extractor_t*)calloc(1, sizeof(h264_svc_extractor_t));
+    x->dependency_id = dependency_id;
+    x->quality_id = quality_id;
+    x->temporal_id = temporal_id;
+    x->prefix_kept = -1;
+    x->h = h264_new();
+    x->sei = sei_new();
+    return x;
+}
+
+void h264_svc_extractor_free(h264_svc_extractor_t* x)
+{
+    if ( x == NULL ) { return; }
+    h264_free(x->h);
+    sei_free(x->sei);
+    free(x->rbsp);
+    free(x->out);
+    free(x);
+}
+
+// G.8.8.1: a layer is part of the operation point if neither its DQId nor its temporal_id is above the target
+static int svc_in_operation_point(const h264_svc_extractor_t* x, int dependency_id, int quality_id, int temporal_id)
+{
+    return ( dependency_id * 16 + quality_id <= x->dependency_id * 16 + x->quality_id ) && temporal_id <= x->temporal_id;
+}
+
+// keep the layers of the operation point in the scalability information, and the priority layer information of their
+// dependency_ids; returns the number of layers left
+static int svc_extract_scalability_info(const h264_svc_extractor_t* x, sei_scalability_info_t* sei_svc)
+{
+    int num_layers = 0;
+    for ( int i = 0; i <= sei_svc->num_layers_minus1; i++ )
+    {
+        sei_scalability_layer_info_t* l = &sei_svc->layers[i];
+        if ( !svc_in_operation_point(x, l->dependency_id, l->quality_id, l->temporal_id) ) { continue; }
+        if ( num_layers != i ) { sei_svc->layers[num_layers] = *l; }
+        num_layers++;
+    }
+    if ( num_layers == 0 ) { return 0; }
+    sei_svc->num_layers_minus1 = num_layers - 1;
+
+    if ( sei_svc->priority_layer_info_present_flag )
+    {
+        int num_pr = 0;
+        for ( int i = 0; i <= sei_svc->pr_num_dIds_minus1; i++ )
+        {
+            if ( sei_svc->pr[i].pr_dependency_id > x->dependency_id ) { continue; }
+            if ( num_pr != i )
+            {
+                // swapped rather than copied, each entry owns its pr_info
+                sei_scalability_pr_t pr = sei_svc->pr[num_pr];
+                sei_svc->pr[num_pr] = sei_svc->pr[i];
+                sei_svc->pr[i] = pr;
+            }
+            num_pr++;
+        }
+        if ( num_pr == 0 ) { sei_svc->priority_layer_info_present_flag = 0; }
+        else { sei_svc->pr_num_dIds_minus1 = num_pr - 1; }
+    }
+    return num_layers;
+}
+
+// a SEI NAL with its scalability information messages rewritten for the operation point, and the other messages copied as
+// they are, into x->out after the zero byte rbsp_to_nal puts first; returns the size of the NAL, 0 if no message is left,
+// or -1 if it could not be rewritten
+static int svc_extract_sei(h264_svc_extractor_t* x, const uint8_t* nal, int size)
+{
+    // the rbsp read, then the rbsp written, which is at most a few bytes larger
+    int capacity = 2 * size + 16;
+    if ( x->rbsp_capacity < capacity )
+    {
+        x->rbsp_capacity = capacity;
+        x->rbsp = (uint8_t*)realloc(x->rbsp, capacity);
+    }
+    int nal_size = size;
+    int rbsp_size = size;
+    if ( nal_to_rbsp(nal, &nal_size, x->rbsp, &rbsp_size) < 0 || rbsp_size < 1 ) { return -1; }
+    uint8_t* rbsp_out = x->rbsp + rbsp_size;
+    rbsp_out[0] = x->rbsp[0];
+
+    bs_t b;
+    bs_t o;
+    bs_init(&b, x->rbsp + 1, rbsp_size - 1);
+    bs_init(&o, rbsp_out + 1, capacity - rbsp_size - 1);
+    int messages = 0;
+    x->h->sei = x->sei;
+    // a message takes at least 2 bytes, the last byte is the rbsp trailing bits
+    while ( b.end - b.p >= 2 )
+    {
+        uint8_t* start = b.p;
+        int payloadType = _read_ff_coded_number(&b);
+        int payloadSize = _read_ff_coded_number(&b);
+        if ( bs_overrun(&b) ) { break; }
+
+        if ( payloadType != SEI_TYPE_SCALABILITY_INFO )
+        {
+            bs_skip_bytes(&b, payloadSize);
+            bs_write_bytes(&o, start, ( ( b.p < b.end ) ? b.p : b.end ) - start);
+            messages++;
+            continue;
+        }
+
+        x->sei->payloadType = payloadType;
+        x->sei->payloadSize = payloadSize;
+        read_sei_payload(x->h, &b);
+        if ( svc_extract_scalability_info(x, x->sei->sei_svc) == 0 ) { continue; }
+        _write_ff_coded_number(&o, payloadType);
+        _write_ff_coded_number(&o, sei_payload_size(x->h, x->sei));
+        write_sei_payload(x->h, &o);
+        messages++;
+    }
+    x->h->sei = NULL;
+    if ( messages == 0 ) { return 0; }
+
+    write_rbsp_trailing_bits(&o);
+    if ( bs_overrun(&o) ) { return -1; }
+    rbsp_size = o.p - rbsp_out;
+    if ( x->out_capacity < rbsp_size * 3 / 2 + 2 )
+    {
+        x->out_capacity = rbsp_size * 3 / 2 + 2;
+        x->out = (uint8_t*)realloc(x->out, x->out_capacity);
+    }
+    nal_size = x->out_capacity;
+    if ( rbsp_to_nal(rbsp_out, &rbsp_size, x->out, &nal_size) < 0 ) { return -1; }
+    return nal_size - 1;
+}
+
+/**
+ Extract the operation point from a stream, one NAL unit at a time, in stream order (G.8.8.1).
+ Slices in scalable extension and prefix NALs are dropped if their dependency_id and quality_id, or their temporal_id, are above
+ the target, and base layer slices along with the prefix NAL before them.  In SEI NALs, the layers above the target are
+ removed from the scalability information.  Parameter sets and all other NALs are kept.
+ Only the NAL header and its SVC extension are looked at, and SEI NALs with scalability information parsed.
+ @param[in]  x     the extractor
+ @param[in]  nal   the NAL, starting with its header byte
+ @param[in]  size  size of the NAL
+ @param[out] out   the NAL to keep: nal itself, or a rewritten SEI valid until the next call
+ @return     1 to keep the NAL, 0 to drop it, or -1 for a SEI NAL whose scalability information could not be rewritten, which
+             out is the NAL as it is
+ */
+int h264_svc_extract_nal(h264_svc_extractor_t* x, const uint8_t* nal, int size, h264_nal_span_t* out)
+{
+    static const int scalability_info_type[] = { SEI_TYPE_SCALABILITY_INFO };
+    static const sei_filter_t scalability_info = { scalability_info_type, 1, NULL, 0 };
+
+    out->buf = nal;
+    out->size = size;
+    if ( size < 1 ) { x->kept++; return 1; }
+    int nal_unit_type = nal[0] & 0x1F;
+    int keep = 1;
+    nal_svc_ext_t nal_svc_ext;
+
+    switch ( nal_unit_type )
+    {
+        case NAL_UNIT_TYPE_CODED_SLICE_NON_IDR:
+        case NAL_UNIT_TYPE_CODED_SLICE_IDR:
+        case NAL_UNIT_TYPE_CODED_SLICE_DATA_PARTITION_A:
+        case NAL_UNIT_TYPE_CODED_SLICE_DATA_PARTITION_B:
+        case NAL_UNIT_TYPE_CODED_SLICE_DATA_PARTITION_C:
+            // without a prefix NAL, the temporal_id of a base layer slice is 0
+            if ( x->prefix_kept >= 0 )
+            {
+                keep = x->prefix_kept;
+                x->prefix_kept = -1;
+            }
+            break;
+
+        case NAL_UNIT_TYPE_PREFIX_NAL:
+        case NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION:
+            if ( h264_peek_nal_svc_ext(nal, size, &nal_svc_ext) )
+            {
+                keep = svc_in_operation_point(x, nal_svc_ext.dependency_id, nal_svc_ext.quality_id, nal_svc_ext.temporal_id);
+            }
+            if ( nal_unit_type == NAL_UNIT_TYPE_PREFIX_NAL ) { x->prefix_kept = keep; }
+            break;
+
+        case NAL_UNIT_TYPE_SEI:
+            if ( sei_find_payloads(nal, size, &scalability_info, NULL, 0, NULL, 0) > 0 )
+            {
+                int rc = svc_extract_sei(x, nal, size);
+                if ( rc < 0 ) { x->kept++; return -1; }
+                if ( rc == 0 ) { keep = 0; break; }
+                out->buf = x->out + 1;
+                out->size = rc;
+                x->rewritten_seis++;
+            }
+            break;
+    }
+
+    if ( keep ) { x->kept++; } else { x->dropped++; }
+    return keep;
+}
@@ -0,0 +1,132 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _H264_SVC_H
+#define _H264_SVC_H        1
+
+#include <stdint.h>
+
+#include "h264_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// a layer of an SVC stream, as passed to h264_svc_layer_cb; the base layer is H264_SVC_LAYER(0, 0, temporal_id)
+#define H264_SVC_LAYER(dependency_id, quality_id, temporal_id)  ( ((dependency_id) << 7) | ((quality_id) << 3) | (temporal_id) )
+#define H264_SVC_LAYER_DEPENDENCY_ID(layer)  ( (layer) >> 7 )
+#define H264_SVC_LAYER_QUALITY_ID(layer)     ( ((layer) >> 3) & 0x0F )
+#define H264_SVC_LAYER_TEMPORAL_ID(layer)    ( (layer) & 0x07 )
+#define H264_SVC_MAX_LAYERS      1024
+#define H264_SVC_NO_LAYER        -1  // NALs which are not part of a layer: SEI, access unit delimiters and such
+
+// flags for h264_svc_demux_new: the layers are told apart by dependency_id, and optionally also by
+#define H264_SVC_SPLIT_QUALITY   1  // quality_id
+#define H264_SVC_SPLIT_TEMPORAL  2  // temporal_id
+
+/**
+   The start of a slice header of an SVC stream, as read by h264_peek_svc_slice_header
+*/
+typedef struct
+{
+    nal_svc_ext_t nal_svc_ext;    // all 0 for a base layer slice, the prefix NAL before it has its extension
+    int first_mb_in_slice;
+    int slice_type;
+    int pic_parameter_set_id;
+} h264_svc_slice_t;
+
+/**
+   Receives the NALs of each layer from the demuxer, with the parameter sets of the layer put before its first slice which
+   needs them.  The NAL is only valid during the call.
+*/
+typedef void (*h264_svc_layer_cb)(void* opaque, int layer, const uint8_t* nal, int size);
+
+/**
+   A parameter set kept by the demuxer
+*/
+typedef struct
+{
+    uint8_t* nal;                 // NULL if none was seen with this id
+    int size;
+    int generation;               // number of times it changed
+} h264_svc_ps_t;
+
+/**
+   Demuxer of the layers of an SVC stream, by the dependency_id, quality_id and temporal_id of the NAL header extensions
+   @see h264_svc_demux_nal
+*/
+typedef struct
+{
+    int flags;
+
+    h264_svc_ps_t sps[32];
+    h264_svc_ps_t subset_sps[32];
+    h264_svc_ps_t pps[256];
+    // for each layer seen, the generation of each parameter set it got (sps, subset_sps, then pps); NULL for a layer not seen
+    int* sent[H264_SVC_MAX_LAYERS];
+
+    // the last prefix NAL, held back to go right before its base layer slice, after the parameter sets
+    uint8_t* prefix;
+    int prefix_size;
+    int prefix_capacity;
+    int prefix_layer;             // its layer, or H264_SVC_NO_LAYER if there is none
+
+    h264_svc_layer_cb layer_cb;
+    void* opaque;
+} h264_svc_demux_t;
+
+/**
+   Extractor of an operation point of an SVC stream, G.8.8.1: the sub-bitstream of the layers up to a target dependency_id,
+   quality_id and temporal_id, with the scalability information SEI rewritten to describe only those layers
+   @see h264_svc_extract_nal
+*/
+typedef struct
+{
+    // the target
+    int dependency_id;
+    int quality_id;
+    int temporal_id;
+
+    int prefix_kept;              // whether the last prefix NAL was kept, and so is its base layer slice; -1 if there is none
+    int kept;                     // number of NALs kept
+    int dropped;                  // number of NALs dropped
+    int rewritten_seis;           // number of scalability information SEI NALs rewritten
+
+    h264_stream_t* h;             // reads and writes the scalability information
+    sei_t* sei;
+    uint8_t* rbsp;                // the SEI NAL being rewritten, then as rewritten
+    int rbsp_capacity;
+    uint8_t* out;                 // the output of the last h264_svc_extract_nal, if it is a rewritten SEI
+    int out_capacity;
+} h264_svc_extractor_t;
+
+int h264_peek_svc_slice_header(const uint8_t* nal, int size, h264_svc_slice_t* slice);
+
+h264_svc_demux_t* h264_svc_demux_new(int flags, h264_svc_layer_cb layer_cb, void* opaque);
+void h264_svc_demux_free(h264_svc_demux_t* d);
+int h264_svc_demux_nal(h264_svc_demux_t* d, const uint8_t* nal, int size);
+
+h264_svc_extractor_t* h264_svc_extractor_new(int dependency_id, int quality_id, int temporal_id);
+void h264_svc_extractor_free(h264_svc_extractor_t* x);
+int h264_svc_extract_nal(h264_svc_extractor_t* x, const uint8_t* nal, int size, h264_nal_span_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
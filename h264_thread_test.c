@@ -0,0 +1,219 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+// Stress test for concurrent use of separate stream objects.
+// Parses every input file with read_debug_nal_unit once on the main thread, then on N threads at the same time,
+// each thread with its own h264_stream_t and in-memory debug sink, and checks that all outputs are identical.
+// Also checks that h264_parse_nals gives the same records on N threads as on one.
+// Build with -fsanitize=thread (make -f Makefile.unix test_threads) to check for data races.
+
+#include "h264_stream.h"
+#include "h264_batch.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+typedef struct
+{
+    const char* name;
+    uint8_t* buf;
+    int size;
+    char* expected;
+    int expected_len;
+} input_t;
+
+typedef struct
+{
+    input_t* inputs;
+    int num_inputs;
+    int iterations;
+    int first;
+    int failures;
+} worker_t;
+
+static int read_file(input_t* in)
+{
+    FILE* f = fopen(in->name, "rb");
+    if (f == NULL) { fprintf( stderr, "!! Error: could not open file: %s: %s \n", in->name, strerror(errno)); return -1; }
+    fseek(f, 0, SEEK_END);
+    in->size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    in->buf = (uint8_t*)calloc(in->size + 4, 1); // find_nal_unit may look a few bytes past the end
+    if (fread(in->buf, 1, in->size, f) != (size_t)in->size) { fprintf( stderr, "!! Error: read failed: %s \n", in->name); fclose(f); return -1; }
+    fclose(f);
+    return 0;
+}
+
+// parse a whole file the same way h264_analyze does, leaving the debug output in h->dbg.buf
+static void parse(h264_stream_t* h, input_t* in)
+{
+    uint8_t* p = in->buf;
+    int sz = in->size;
+    int nal_start, nal_end;
+
+    h->dbg.buf_len = 0;
+    while (find_nal_unit(p, sz, &nal_start, &nal_end) > 0)
+    {
+        h264_dbg_printf(h, "!! Found NAL at offset %d, size %d \n", (int)(p - in->buf) + nal_start, nal_end - nal_start);
+        p += nal_start;
+        read_debug_nal_unit(h, p, nal_end - nal_start);
+        p += (nal_end - nal_start);
+        sz -= nal_end;
+    }
+}
+
+// compare h264_parse_nals on one thread and on num_threads
+static int check_batch(input_t* in, int num_threads)
+{
+    int max_nals = in->size / 3 + 1;
+    h264_nal_span_t* nals = (h264_nal_span_t*)malloc(max_nals * sizeof(h264_nal_span_t));
+    uint8_t* p = in->buf;
+    int sz = in->size;
+    int num_nals = 0;
+    int nal_start, nal_end;
+
+    while (find_nal_unit(p, sz, &nal_start, &nal_end) > 0)
+    {
+        nals[num_nals].buf = p + nal_start;
+        nals[num_nals].size = nal_end - nal_start;
+        num_nals++;
+        p += nal_end;
+        sz -= nal_end;
+    }
+
+    h264_nal_record_t* serial = (h264_nal_record_t*)malloc(num_nals * sizeof(h264_nal_record_t));
+    h264_nal_record_t* parallel = (h264_nal_record_t*)malloc(num_nals * sizeof(h264_nal_record_t));
+    int rc = 0;
+    if (h264_parse_nals(nals, num_nals, serial, 1) != h264_parse_nals(nals, num_nals, parallel, num_threads)) { rc = 1; }
+
+    // the two runs have their own parameter set snapshots, compare those by content
+    for (int i = 0; i < num_nals; i++)
+    {
+        h264_nal_record_t* rs = &serial[i];
+        h264_nal_record_t* rp = &parallel[i];
+        if ((rs->sps == NULL) != (rp->sps == NULL) ||
+            (rs->sps != NULL && (rs->sps->ref.generation != rp->sps->ref.generation || memcmp(&rs->sps->sps, &rp->sps->sps, sizeof(sps_t)) != 0)) ||
+            (rs->pps == NULL) != (rp->pps == NULL) ||
+            (rs->pps != NULL && (rs->pps->ref.generation != rp->pps->ref.generation || memcmp(&rs->pps->pps, &rp->pps->pps, sizeof(pps_t)) != 0)) ||
+            (rs->sps_subset == NULL) != (rp->sps_subset == NULL) ||
+            (rs->sps_subset != NULL && rs->sps_subset->ref.generation != rp->sps_subset->ref.generation))
+        {
+            rc = 1;
+        }
+    }
+    h264_nal_records_release(serial, num_nals);
+    h264_nal_records_release(parallel, num_nals);
+    if (memcmp(serial, parallel, num_nals * sizeof(h264_nal_record_t)) != 0) { rc = 1; }
+
+    free(nals);
+    free(serial);
+    free(parallel);
+    return rc;
+}
+
+static void* worker(void* arg)
+{
+    worker_t* w = (worker_t*)arg;
+    h264_stream_t* h = h264_new();
+    h264_dbg_set_memory(h);
+
+    for (int i = 0; i < w->iterations * w->num_inputs; i++)
+    {
+        input_t* in = &w->inputs[(w->first + i) % w->num_inputs];
+        parse(h, in);
+        if (h->dbg.buf_len != in->expected_len || memcmp(h->dbg.buf, in->expected, in->expected_len) != 0)
+        {
+            w->failures++;
+        }
+    }
+
+    h264_free(h);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = 8;
+    int iterations = 2;
+    int argi = 1;
+
+    while (argi < argc && argv[argi][0] == '-')
+    {
+        if (strcmp(argv[argi], "-t") == 0 && argi + 1 < argc) { num_threads = atoi(argv[argi + 1]); argi += 2; }
+        else if (strcmp(argv[argi], "-n") == 0 && argi + 1 < argc) { iterations = atoi(argv[argi + 1]); argi += 2; }
+        else { argc = 0; }
+    }
+    if (argi >= argc || num_threads < 1)
+    {
+        fprintf( stderr, "Usage: h264_thread_test [-t threads] [-n iterations] <input bitstream>...\n");
+        return EXIT_FAILURE;
+    }
+
+    int num_inputs = argc - argi;
+    input_t* inputs = (input_t*)calloc(num_inputs, sizeof(input_t));
+    for (int i = 0; i < num_inputs; i++)
+    {
+        inputs[i].name = argv[argi + i];
+        if (read_file(&inputs[i]) < 0) { return EXIT_FAILURE; }
+
+        // reference output, single-threaded
+        h264_stream_t* h = h264_new();
+        h264_dbg_set_memory(h);
+        parse(h, &inputs[i]);
+        inputs[i].expected = h->dbg.buf;
+        inputs[i].expected_len = h->dbg.buf_len;
+        h->dbg.buf = NULL;
+        h264_free(h);
+    }
+
+    pthread_t* threads = (pthread_t*)calloc(num_threads, sizeof(pthread_t));
+    worker_t* workers = (worker_t*)calloc(num_threads, sizeof(worker_t));
+    for (int i = 0; i < num_threads; i++)
+    {
+        workers[i].inputs = inputs;
+        workers[i].num_inputs = num_inputs;
+        workers[i].iterations = iterations;
+        workers[i].first = i; // start at different files, so different files are parsed at the same time
+        pthread_create(&threads[i], NULL, worker, &workers[i]);
+    }
+
+    int failures = 0;
+    for (int i = 0; i < num_threads; i++)
+    {
+        pthread_join(threads[i], NULL);
+        failures += workers[i].failures;
+    }
+
+    printf("%d threads, %d files, %d iterations: %d mismatches\n", num_threads, num_inputs, iterations, failures);
+
+    int batch_failures = 0;
+    for (int i = 0; i < num_inputs; i++) { batch_failures += check_batch(&inputs[i], num_threads); }
+    printf("h264_parse_nals on %d threads: %d mismatches\n", num_threads, batch_failures);
+    failures += batch_failures;
+
+    for (int i = 0; i < num_inputs; i++) { free(inputs[i].buf); free(inputs[i].expected); }
+    free(inputs);
+    free(threads);
+    free(workers);
+
+    return (failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,259 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "h264_stream.h"
+#include "h264_ts.h"
+
+#define TS_SYNC_BYTE             0x47
+#define TS_STREAM_TYPE_H264      0x1B
+
+// zero bytes held back at the end of a fragment are passed on from here, once it is clear they belong to the NAL
+static const uint8_t zero_bytes[64] = { 0 };
+
+/**
+ Create a transport stream demuxer.
+ @param[in]  nal_cb   receives the NAL units of the first H.264 stream of the first program
+ @param[in]  opaque   passed to nal_cb
+ */
+h264_ts_t* h264_ts_new(h264_ts_nal_cb nal_cb, void* opaque)
+{
+    h264_ts_t* ts = (h264_ts_t*)calloc(1, sizeof(h264_ts_t));
+    ts->pmt_pid = -1;
+    ts->video_pid = -1;
+    ts->continuity_counter = -1;
+    ts->pts = H264_TS_NO_TIMESTAMP;
+    ts->dts = H264_TS_NO_TIMESTAMP;
+    ts->nal_cb = nal_cb;
+    ts->opaque = opaque;
+    return ts;
+}
+
+void h264_ts_free(h264_ts_t* ts)
+{
+    free(ts);
+}
+
+static void ts_emit(h264_ts_t* ts, const uint8_t* data, int size, int end)
+{
+    if ( size <= 0 && !end ) { return; }
+    int flags = ts->nal_flags | (end ? H264_TS_NAL_END : 0);
+    ts->nal_flags = 0;
+    ts->nal_cb(ts->opaque, data, (size > 0) ? size : 0, flags, ts->nal_pts, ts->nal_dts);
+}
+
+static void ts_emit_zeros(h264_ts_t* ts, int n)
+{
+    while ( n > 0 )
+    {
+        int len = (n < (int)sizeof(zero_bytes)) ? n : (int)sizeof(zero_bytes);
+        ts_emit(ts, zero_bytes, len, 0);
+        n -= len;
+    }
+}
+
+// incremental NAL splitter: finds start codes in a fragment of the elementary stream, also those split across fragments,
+// and passes the NAL data on in place
+static void ts_split(h264_ts_t* ts, const uint8_t* buf, int size)
+{
+    const uint8_t* p = buf;
+    const uint8_t* end = buf + size;
+    const uint8_t* start = buf;     // data of the current NAL not passed on yet
+    int zeros = ts->zeros;
+    int held = ts->zeros;           // the first zeros, from earlier fragments
+
+    while ( p < end )
+    {
+        if ( zeros == 0 )
+        {
+            const uint8_t* z = (const uint8_t*)memchr(p, 0x00, end - p);
+            if ( z == NULL ) { p = end; break; }
+            p = z;
+        }
+
+        if ( *p == 0x00 ) { zeros++; p++; continue; }
+
+        if ( *p == 0x01 && zeros >= 2 )
+        {
+            if ( ts->in_nal )
+            {
+                ts_emit(ts, start, (p - start) - (zeros - held), 1);
+            }
+            ts->in_nal = 1;
+            ts->nal_flags = H264_TS_NAL_START | (ts->pes_new ? H264_TS_AU_START : 0);
+            ts->nal_pts = ts->pts;
+            ts->nal_dts = ts->dts;
+            ts->pes_new = 0;
+            start = p + 1;
+        }
+        else if ( held > 0 && ts->in_nal )
+        {
+            // not a start code after all
+            ts_emit_zeros(ts, held);
+        }
+        zeros = 0;
+        held = 0;
+        p++;
+    }
+
+    if ( ts->in_nal )
+    {
+        ts_emit(ts, start, (end - start) - (zeros - held), 0);
+    }
+    ts->zeros = zeros;
+}
+
+static int64_t ts_timestamp(const uint8_t* p)
+{
+    return ((int64_t)((p[0] >> 1) & 0x07) << 30) | (p[1] << 22) | ((p[2] >> 1) << 15) | (p[3] << 7) | (p[4] >> 1);
+}
+
+// PAT and PMT; sections are expected to fit in the packet which starts them, as they do in practice
+static void ts_psi(h264_ts_t* ts, const uint8_t* p, const uint8_t* end)
+{
+    p += 1 + p[0]; // pointer_field
+    if ( end - p < 12 ) { return; }
+    int table_id = p[0];
+    int section_length = ((p[1] & 0x0F) << 8) | p[2];
+    const uint8_t* section_end = p + 3 + section_length - 4; // without CRC_32
+    if ( section_end > end ) { return; }
+
+    if ( table_id == 0x00 )
+    {
+        for ( const uint8_t* e = p + 8; e + 4 <= section_end; e += 4 )
+        {
+            int program_number = (e[0] << 8) | e[1];
+            if ( program_number != 0 ) { ts->pmt_pid = ((e[2] & 0x1F) << 8) | e[3]; break; }
+        }
+    }
+    else if ( table_id == 0x02 && ts->video_pid < 0 )
+    {
+        int program_info_length = ((p[10] & 0x0F) << 8) | p[11];
+        for ( const uint8_t* e = p + 12 + program_info_length; e + 5 <= section_end; )
+        {
+            int es_info_length = ((e[3] & 0x0F) << 8) | e[4];
+            if ( e[0] == TS_STREAM_TYPE_H264 ) { ts->video_pid = ((e[1] & 0x1F) << 8) | e[2]; break; }
+            e += 5 + es_info_length;
+        }
+    }
+}
+
+static void ts_pes(h264_ts_t* ts, const uint8_t* p, const uint8_t* end, int payload_unit_start)
+{
+    if ( payload_unit_start )
+    {
+        ts->in_pes = 0;
+        if ( end - p < 9 || p[0] != 0x00 || p[1] != 0x00 || p[2] != 0x01 ) { return; }
+        int pts_dts_flags = p[7] >> 6;
+        int header_data_length = p[8];
+        if ( end - p < 9 + header_data_length ) { return; }
+
+        ts->pts = H264_TS_NO_TIMESTAMP;
+        if ( (pts_dts_flags & 0x02) && header_data_length >= 5 ) { ts->pts = ts_timestamp(p + 9); }
+        ts->dts = ts->pts;
+        if ( pts_dts_flags == 0x03 && header_data_length >= 10 ) { ts->dts = ts_timestamp(p + 14); }
+
+        p += 9 + header_data_length;
+        ts->in_pes = 1;
+        ts->pes_new = 1;
+    }
+    if ( !ts->in_pes ) { return; }
+    ts_split(ts, p, end - p);
+}
+
+static void ts_packet(h264_ts_t* ts, const uint8_t* pkt)
+{
+    const uint8_t* p = pkt + 4;
+    const uint8_t* end = pkt + H264_TS_PACKET_SIZE;
+    int transport_error_indicator = pkt[1] >> 7;
+    int payload_unit_start = (pkt[1] >> 6) & 0x01;
+    int pid = ((pkt[1] & 0x1F) << 8) | pkt[2];
+    int adaptation_field_control = (pkt[3] >> 4) & 0x03;
+    int continuity_counter = pkt[3] & 0x0F;
+    int discontinuity_indicator = 0;
+
+    if ( transport_error_indicator ) { return; }
+    if ( adaptation_field_control & 0x02 )
+    {
+        if ( p[0] > 0 ) { discontinuity_indicator = p[1] >> 7; }
+        p += 1 + p[0];
+    }
+    if ( !(adaptation_field_control & 0x01) || p >= end ) { return; }
+
+    if ( pid == 0x0000 )
+    {
+        if ( payload_unit_start ) { ts_psi(ts, p, end); }
+    }
+    else if ( pid == ts->video_pid )
+    {
+        if ( ts->continuity_counter >= 0 && !discontinuity_indicator &&
+             continuity_counter != ((ts->continuity_counter + 1) & 0x0F) )
+        {
+            if ( continuity_counter == ts->continuity_counter ) { return; } // duplicate packet
+            ts->discontinuities++;
+        }
+        ts->continuity_counter = continuity_counter;
+        ts_pes(ts, p, end, payload_unit_start);
+    }
+    else if ( pid == ts->pmt_pid )
+    {
+        if ( payload_unit_start ) { ts_psi(ts, p, end); }
+    }
+}
+
+/**
+ Demux transport stream packets, passing the NAL units of the video stream to the callback as they are found.
+ Each payload fragment goes to the NAL splitter in place; nothing is copied.
+ @param[in]  buf   packets; bytes before a sync byte are skipped
+ @param[in]  size  size of buf
+ @return           the number of bytes used, the rest is a partial packet to pass again with the data following it
+ */
+int h264_ts_demux(h264_ts_t* ts, const uint8_t* buf, int size)
+{
+    const uint8_t* p = buf;
+    const uint8_t* end = buf + size;
+
+    while ( end - p >= H264_TS_PACKET_SIZE )
+    {
+        // resynchronize, checking the next sync byte too where there is one
+        if ( p[0] != TS_SYNC_BYTE ||
+             (end - p > H264_TS_PACKET_SIZE && p[H264_TS_PACKET_SIZE] != TS_SYNC_BYTE) )
+        {
+            p++;
+            continue;
+        }
+        ts_packet(ts, p);
+        p += H264_TS_PACKET_SIZE;
+    }
+    return p - buf;
+}
+
+/**
+ End the last NAL unit, at the end of the stream.
+ */
+void h264_ts_flush(h264_ts_t* ts)
+{
+    if ( ts->in_nal ) { ts_emit(ts, NULL, 0, 1); }
+    ts->in_nal = 0;
+    ts->in_pes = 0;
+    ts->zeros = 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * h264bitstream - a library for reading and writing H.264 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _H264_TS_H
+#define _H264_TS_H        1
+
+#include <stdint.h>
+
+#include "h264_stream.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define H264_TS_PACKET_SIZE      188
+#define H264_TS_NO_TIMESTAMP     (-1)
+
+// flags of h264_ts_nal_cb
+#define H264_TS_NAL_START        1  // the first bytes of a NAL
+#define H264_TS_NAL_END          2  // the NAL is complete; the data may be empty
+#define H264_TS_AU_START         4  // the NAL is the first one of its PES, which carries one access unit
+
+/**
+   Receives the NAL units of the video stream, a piece at a time, without start codes.
+   The data points into the packets passed to h264_ts_demux and is only valid during the call.
+   pts and dts (90 kHz) are those of the PES the NAL started in, H264_TS_NO_TIMESTAMP if it had none.
+*/
+typedef void (*h264_ts_nal_cb)(void* opaque, const uint8_t* data, int size, int flags, int64_t pts, int64_t dts);
+
+/**
+   Demuxer of the H.264 elementary stream of an MPEG-2 transport stream, ISO/IEC 13818-1
+   @see h264_ts_demux
+*/
+typedef struct
+{
+    int pmt_pid;                // -1 until the PAT is seen
+    int video_pid;              // -1 until the PMT is seen, may be set by the caller instead
+    int continuity_counter;     // of the last video packet, -1 if none
+    int discontinuities;        // gaps in the video continuity counter, i.e. lost packets
+
+    // PES
+    int in_pes;                 // the payload of the current PES goes to the splitter
+    int pes_new;                // no NAL has started in the current PES yet
+    int64_t pts;
+    int64_t dts;
+
+    // NAL splitter, carried over from one payload fragment to the next
+    int in_nal;
+    int zeros;                  // zero bytes seen last; part of the NAL unless a start code follows, so not passed on yet
+    int nal_flags;              // to pass with the next data of the NAL
+    int64_t nal_pts;
+    int64_t nal_dts;
+
+    h264_ts_nal_cb nal_cb;
+    void* opaque;
+} h264_ts_t;
+
+h264_ts_t* h264_ts_new(h264_ts_nal_cb nal_cb, void* opaque);
+void h264_ts_free(h264_ts_t* ts);
+int h264_ts_demux(h264_ts_t* ts, const uint8_t* buf, int size);
+void h264_ts_flush(h264_ts_t* ts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -21,6 +21,17 @@
 # * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 # */
 
+# usage:
+#   perl process.pl < foo.in.c > foo.c
+#   perl process.pl --fields h264_stream.in.c h264_sei.in.c ... > h264_fields.h
+
+if (@ARGV && $ARGV[0] eq '--fields')
+{
+    shift @ARGV;
+    print_fields(@ARGV);
+    exit 0;
+}
+
 undef $/;
 $code = <>;
 $/ = "\n";
@@ -43,6 +54,7 @@ $code_read =~ s{^(\s*) value \s* \( \s* ([^,]*) , (.*) \);}{ &proc_value_read($2
 $code_read =~ s{structure\( (\w+) \)}{read_$1}xg;
 $code_read =~ s{is_reading}{1}g;
 $code_read =~ s{is_writing}{0}g;
+$code_read =~ s{is_debug}{0}g;
 print $code_read;
 
 $code_write = $code;
@@ -50,6 +62,7 @@ $code_write =~ s{^(\s*) value \s* \( \s* ([^,]*) , (.*) \);}{ &proc_value_write(
 $code_write =~ s{structure\( (\w+) \)}{write_$1}xg;
 $code_write =~ s{is_reading}{0}g;
 $code_write =~ s{is_writing}{1}g;
+$code_write =~ s{is_debug}{0}g;
 print $code_write;
 
 $code_read_debug = $code;
@@ -57,6 +70,7 @@ $code_read_debug =~ s{^(\s*) value \s* \( \s* ([^,]*) , (.*) \);}{ &proc_value_r
 $code_read_debug =~ s{structure\( (\w+) \)}{read_debug_$1}xg;
 $code_read_debug =~ s{is_reading}{1}g;
 $code_read_debug =~ s{is_writing}{0}g;
+$code_read_debug =~ s{is_debug}{1}g;
 print $code_read_debug;
 
 sub proc_value_read
@@ -98,13 +112,72 @@ sub proc_value_read_debug
         $code = "if (cabac) { $s = bs_read_ae(b); }" . "\n${indent}" . "else { $code }";
     }
 
-    $code = "printf(\"\%d.\%d: \", b->p - b->start, b->bits_left); ".
-        $code .
-        " printf(\"$s: \%d \\n\", $s); ";
+    my $id = field_id($s);
+    if ($code =~ m{^// ERROR})
+    {
+        # leave unparseable elements as a comment
+    }
+    elsif ($values =~ m{f\((\d+),\s*(.*)\)})
+    {
+        # reserved/fixed bits have no variable to read into
+        $code = "{ int _pos = bs_bit_pos(b); h264_debug_field(b, $id, _pos, bs_read_u(b, $1)); }";
+    }
+    else
+    {
+        $code = "{ int _pos = bs_bit_pos(b); $code h264_debug_field(b, $id, _pos, $s); }";
+    }
 
     return $indent . $code;
 }
 
+# name of the H264_FIELD_* constant for a syntax element, e.g. sps->vui.time_scale -> H264_FIELD_SPS_VUI_TIME_SCALE
+sub field_id
+{
+    my ($s) = @_;
+    my $id = uc($s);
+    $id =~ s{[^A-Z0-9]+}{_}g;
+    $id =~ s{^_|_$}{}g;
+    return "H264_FIELD_$id";
+}
+
+sub print_fields
+{
+    my @files = @_;
+    my @ids;
+    my %names;
+
+    foreach my $file (@files)
+    {
+        open(my $fh, '<', $file) or die "$file: $!";
+        local $/;
+        my $text = <$fh>;
+        close($fh);
+        $text =~ s{^.*#end_preamble}{}s;
+        while ($text =~ m{^\s* value \s* \( \s* ([^,]*) , (.*) \);}xmg)
+        {
+            my $id = field_id($1);
+            next if (exists $names{$id});
+            $names{$id} = $1;
+            push @ids, $id;
+        }
+    }
+
+    print "/* generated by process.pl --fields from " . join(' ', @files) . ", do not edit */\n\n";
+    print "#ifndef _H264_FIELDS_H\n";
+    print "#define _H264_FIELDS_H        1\n\n";
+    print "// X(id, name) for every syntax element printed by read_debug_*, in order of first appearance\n";
+    print "#define H264_FIELDS(X) \\\n";
+    foreach my $id (@ids)
+    {
+        print "    X( $id, \"$names{$id}\" ) \\\n";
+    }
+    print "\n";
+    print "#define H264_FIELD_ENUM(id, name) id,\n";
+    print "enum { H264_FIELDS(H264_FIELD_ENUM) H264_FIELD_COUNT };\n";
+    print "#undef H264_FIELD_ENUM\n\n";
+    print "#endif\n";
+}
+
 sub proc_value_write
 {
     my ($s, $values, $indent) = @_;
@@ -9,6 +9,9 @@
 #include <stdio.h>
 
 #include "h264_stream.h"
+#include "h264_filter.h"
+#include "h264_au.h"
+#include "h264_svc.h"
 
 #include <stdlib.h>
 #include <stdint.h>
@@ -17,172 +20,297 @@
 #include <errno.h>
 
 #define BUFSIZE 32*1024*1024
+#define OUTBUFSIZE 1024*1024
+
+#if (defined(__GNUC__))
+#define HAVE_GETOPT_LONG
+
+#include <getopt.h>
+
+
+static struct option long_options[] =
+{
+    { "temporal-id",  required_argument, NULL, 't'},
+    { "drop-non-ref", no_argument,       NULL, 'n'},
+    { "keyframes",    no_argument,       NULL, 'k'},
+    { "operation-point", required_argument, NULL, 'x'},
+    { "split-temporal", no_argument,     NULL, 'T'},
+    { "help",         no_argument,       NULL, 'h'},
+    { NULL,           0,                 NULL, 0 },
+};
+#endif
+
+static char options[] =
+"\t-T also split the layers by temporal_id\n"
+"\t-t max_temporal_id, instead of splitting, keep the temporal layers up to max_temporal_id and write them to <input>.filtered\n"
+"\t-n instead of splitting, drop non-reference pictures and write the rest to <input>.filtered\n"
+"\t-x dependency_id,quality_id,temporal_id, instead of splitting, extract the operation point of the layers up to these ids\n"
+"\t   and write it to <input>.filtered\n"
+"\t-k instead of splitting, write the IDR and recovery point access units to <input>.filtered, and print their byte ranges\n"
+"\t-h print this message and exit\n";
+
+void usage( )
+{
+    fprintf( stderr, "svc_split\n");
+    fprintf( stderr, "Split an H.264 SVC bitstream in Annex B format into its base layer (<input>.base), scalable layers\n");
+    fprintf( stderr, "(<input>.l_<dependency_id>_<quality_id>_<temporal_id>, each with the parameter sets it needs) and other NALs (<input>.misc)\n");
+    fprintf( stderr, "Usage: \n");
+
+    fprintf( stderr, "svc_split [options] <input bitstream>\noptions:\n%s\n", options);
+}
+
+static const uint8_t start_code[4] = { 0x00, 0x00, 0x00, 0x01 };
+
+static FILE* open_output(const char* infile_name, const char* suffix)
+{
+    char fname_buf[1024] = {0};
+    snprintf(fname_buf, sizeof(fname_buf), "%s.%s", infile_name, suffix);
+    FILE* f = fopen(fname_buf, "wb");
+    if (f == NULL) { fprintf( stderr, "!! Error: could not open file: %s \n", strerror(errno)); exit(EXIT_FAILURE); }
+    setvbuf(f, NULL, _IOFBF, OUTBUFSIZE);
+    return f;
+}
+
+static void write_nal(FILE* f, const uint8_t* nal, int size)
+{
+    fwrite(start_code, 1, sizeof(start_code), f);
+    fwrite(nal, 1, size, f);
+}
+
+// the output files of the split, opened as their layers are found
+typedef struct
+{
+    const char* infile_name;
+    FILE* base;
+    FILE* misc;
+    FILE* layers[H264_SVC_MAX_LAYERS];
+    int num_nals[H264_SVC_MAX_LAYERS];
+} outputs_t;
+
+static void write_layer(void* opaque, int layer, const uint8_t* nal, int size)
+{
+    outputs_t* o = (outputs_t*)opaque;
+    FILE* f = o->misc;
+    if (layer == 0) { f = o->base; }
+    else if (layer != H264_SVC_NO_LAYER)
+    {
+        if (o->layers[layer] == NULL)
+        {
+            char suffix[64];
+            sprintf(suffix, "l_%d_%d_%d", H264_SVC_LAYER_DEPENDENCY_ID(layer), H264_SVC_LAYER_QUALITY_ID(layer), H264_SVC_LAYER_TEMPORAL_ID(layer));
+            o->layers[layer] = open_output(o->infile_name, suffix);
+        }
+        f = o->layers[layer];
+    }
+    if (layer != H264_SVC_NO_LAYER) { o->num_nals[layer]++; }
+    write_nal(f, nal, size);
+}
+
+// the keyframes of infile, with the parameter sets they need, to outfile; their byte ranges in infile to stdout
+static void extract_keyframes(FILE* infile, FILE* outfile, uint8_t* buf)
+{
+    h264_keyframes_t* k = h264_keyframes_new();
+    int sz = 0;
+    int keyframes = 0;
+
+    while (1)
+    {
+        size_t rsz = fread(buf + sz, 1, BUFSIZE - sz, infile);
+        if (rsz == 0 && ferror(infile)) { fprintf( stderr, "!! Error: read failed: %s \n", strerror(errno)); break; }
+        sz += rsz;
+
+        int used = h264_extract_keyframes(k, buf, sz, rsz == 0);
+        keyframes += k->num_keyframes;
+        for (int i = 0; i < k->num_keyframes; i++)
+        {
+            h264_keyframe_t* kf = &k->keyframes[i];
+            if (kf->idr_flag) { printf("!! IDR at offset %lld, size %d\n", (long long int)kf->offset, kf->size); }
+            else { printf("!! Recovery point at offset %lld, size %d, recovery_frame_cnt %d\n", (long long int)kf->offset, kf->size, kf->recovery_frame_cnt); }
+        }
+        for (int i = 0; i < k->num_iov; i++) { fwrite(k->iov[i].base, 1, k->iov[i].len, outfile); }
+
+        if (rsz == 0) { break; }
+        if (used == 0 && sz == BUFSIZE) { fprintf( stderr, "!! Error: access unit larger than %d bytes\n", BUFSIZE); break; }
+        memmove(buf, buf + used, sz - used);
+        sz -= used;
+    }
+
+    fprintf( stderr, "%d keyframes in %d access units\n", keyframes, k->access_units);
+    h264_keyframes_free(k);
+}
 
 int main(int argc, char *argv[])
 {
+    if (argc < 2) { usage(); return EXIT_FAILURE; }
+
+    int opt_filter = 0;
+    int opt_filter_flags = 0;
+    int opt_max_temporal_id = 7;
+    int opt_keyframes = 0;
+    int opt_extract = 0;
+    int opt_dependency_id = 7;
+    int opt_quality_id = 15;
+    int opt_split_flags = H264_SVC_SPLIT_QUALITY;
+    const char* infile_name = argv[1];
+
+#ifdef HAVE_GETOPT_LONG
+    int c;
+    int long_options_index;
+    extern char* optarg;
+    extern int   optind;
+
+    while ( ( c = getopt_long( argc, argv, "t:nkx:Th", long_options, &long_options_index) ) != -1 )
+    {
+        switch ( c )
+        {
+            case 't':
+                opt_filter = 1;
+                opt_max_temporal_id = atoi( optarg );
+                break;
+            case 'n':
+                opt_filter = 1;
+                opt_filter_flags |= H264_FILTER_DROP_NON_REF;
+                break;
+            case 'k':
+                opt_keyframes = 1;
+                break;
+            case 'x':
+                opt_extract = 1;
+                if (sscanf( optarg, "%d,%d,%d", &opt_dependency_id, &opt_quality_id, &opt_max_temporal_id ) != 3) { usage( ); return 1; }
+                break;
+            case 'T':
+                opt_split_flags |= H264_SVC_SPLIT_TEMPORAL;
+                break;
+            case 'h':
+            default:
+                usage( );
+                return 1;
+        }
+    }
+    if (optind >= argc) { usage(); return EXIT_FAILURE; }
+    infile_name = argv[optind];
+#endif
+
     uint8_t* buf = (uint8_t*)malloc( BUFSIZE );
-    
-    h264_stream_t* h = h264_new();
-    
-    FILE* infile = fopen(argv[1], "rb");
+
+    FILE* infile = fopen(infile_name, "rb");
     if (infile == NULL) { fprintf( stderr, "!! Error: could not open file: %s \n", strerror(errno)); exit(EXIT_FAILURE); }
-    
-    char fname_buf[1024] = {0};
-    
-    //create base layer file
-    sprintf(fname_buf, "%s.base", argv[1]);
-    FILE* outfile_base = fopen(fname_buf, "wb");
-    if (outfile_base == NULL) { fprintf( stderr, "!! Error: could not open file: %s \n", strerror(errno)); exit(EXIT_FAILURE); }
-    
-    //scalable layer
-    FILE* outfile_layers[32] = {0};
-    
-    //misc packets file
-    memset(fname_buf, 0, 1024);
-    sprintf(fname_buf, "%s.misc", argv[1]);
-    FILE* outfile_misc = fopen(fname_buf, "wb");
-    if (outfile_misc == NULL) { fprintf( stderr, "!! Error: could not open file: %s \n", strerror(errno)); exit(EXIT_FAILURE); }
-    
-
-    if (h264_dbgfile == NULL) { h264_dbgfile = stdout; }
-    
-    size_t rsz = 0;
-    size_t sz = 0;
+
+    if (opt_keyframes)
+    {
+        FILE* outfile = open_output(infile_name, "filtered");
+        extract_keyframes(infile, outfile, buf);
+        fclose(outfile);
+        fclose(infile);
+        free(buf);
+        return 0;
+    }
+
+    // filtered stream, or the split
+    h264_nal_filter_t* filter = NULL;
+    h264_svc_extractor_t* extractor = NULL;
+    FILE* outfile_filtered = NULL;
+    h264_svc_demux_t* demux = NULL;
+    outputs_t* outputs = NULL;
+
+    if (opt_extract)
+    {
+        extractor = h264_svc_extractor_new(opt_dependency_id, opt_quality_id, opt_max_temporal_id);
+        outfile_filtered = open_output(infile_name, "filtered");
+    }
+    else if (opt_filter)
+    {
+        filter = h264_nal_filter_new(opt_filter_flags, opt_max_temporal_id);
+        outfile_filtered = open_output(infile_name, "filtered");
+    }
+    else
+    {
+        outputs = (outputs_t*)calloc(1, sizeof(outputs_t));
+        outputs->infile_name = infile_name;
+        outputs->base = open_output(infile_name, "base");
+        outputs->misc = open_output(infile_name, "misc");
+        demux = h264_svc_demux_new(opt_split_flags, write_layer, outputs);
+    }
+
+    // one pass over the NALs, each decided on from its header; only the last one, which may be incomplete, is read again
+    h264_nal_iter_t it;
+    h264_nal_span_t nal;
+    int sz = 0;
     int64_t off = 0;
-    uint8_t* p = buf;
-    
-    int nal_start, nal_end;
-    
-    //this is to identify whether pps is written or not
-    char *pps_buf[32];
-    int pps_buf_size[32];
-    
+    int broken = 0;
+
     while (1)
     {
-        rsz = fread(buf + sz, 1, BUFSIZE - sz, infile);
-        if (rsz == 0)
-        {
-            if (ferror(infile)) { fprintf( stderr, "!! Error: read failed: %s \n", strerror(errno)); break; }
-            break;  // if (feof(infile))
-        }
-        
+        size_t rsz = fread(buf + sz, 1, BUFSIZE - sz, infile);
+        if (rsz == 0 && ferror(infile)) { fprintf( stderr, "!! Error: read failed: %s \n", strerror(errno)); break; }
         sz += rsz;
-        
-        while (find_nal_unit(p, sz, &nal_start, &nal_end) > 0)
+
+        const uint8_t* used = buf;
+        int rc;
+        h264_nal_iter_init(&it, buf, sz, 0);
+        while ( ( rc = h264_nal_iter_next(&it, &nal) ) != 0 )
         {
-            fprintf( h264_dbgfile, "!! Found NAL at offset %lld (0x%04llX), size %lld (0x%04llX) \n",
-                        (long long int)(off + (p - buf) + nal_start),
-                        (long long int)(off + (p - buf) + nal_start),
-                        (long long int)(nal_end - nal_start),
-                        (long long int)(nal_end - nal_start) );
-            
-            fprintf( h264_dbgfile, "XX ");
-            debug_bytes(p, nal_end - nal_start >= 16 ? 16: nal_end - nal_start);
-            
-            p += nal_start;
-            read_debug_nal_unit(h, p, nal_end - nal_start);
-            
-            //check nal type
-            switch (h->nal->nal_unit_type)
+            if (rc < 0 && rsz != 0) { break; }
+            used = it.p;
+            if (nal.size < 1) { continue; }
+
+            if (extractor != NULL)
             {
-                case NAL_UNIT_TYPE_CODED_SLICE_IDR:
-                case NAL_UNIT_TYPE_CODED_SLICE_NON_IDR:
-                case NAL_UNIT_TYPE_CODED_SLICE_AUX:
-                    printf("reference pps: %d & sps: %d\n", h->sh->pic_parameter_set_id,
-                           h->pps_table[h->sh->pic_parameter_set_id]->seq_parameter_set_id);
-                    
-                    if (pps_buf[h->sh->pic_parameter_set_id] != NULL)
-                    {
-                        fwrite(pps_buf[h->sh->pic_parameter_set_id], 1, pps_buf_size[h->sh->pic_parameter_set_id], outfile_base);
-                        free(pps_buf[h->sh->pic_parameter_set_id]);
-                        pps_buf[h->sh->pic_parameter_set_id] = NULL;
-                    }
-                    
-                    //start saving the slices
-                    fwrite(p - nal_start, 1, nal_end, outfile_base);
-                    
-                    break;
-                    
-                case NAL_UNIT_TYPE_SPS:
-                    fwrite(p - nal_start, 1, nal_end, outfile_base);
-                    break;
-                    
-                case NAL_UNIT_TYPE_PPS:
-                    pps_buf[h->pps->pic_parameter_set_id] = malloc(nal_end);
-                    memcpy(pps_buf[h->pps->pic_parameter_set_id], p - nal_start, nal_end);
-                    pps_buf_size[h->pps->pic_parameter_set_id] = nal_end;
-                    
-                    break;
-                    
-                    //SVC support
-                case NAL_UNIT_TYPE_SUBSET_SPS:
-                    printf("sps_ext id: %d\n", h->sps_subset->sps->seq_parameter_set_id);
-                    memset(fname_buf, 0, 1024);
-                    sprintf(fname_buf, "%s.l_%d", argv[1], h->sps_subset->sps->seq_parameter_set_id);
-                    outfile_layers[h->sps_subset->sps->seq_parameter_set_id] = fopen(fname_buf, "wb");
-                    if (outfile_layers[h->sps_subset->sps->seq_parameter_set_id] == NULL) { fprintf( stderr, "!! Error: could not open file: %s \n", strerror(errno)); exit(EXIT_FAILURE); }
-                    
-                    fwrite(p - nal_start, 1, nal_end, outfile_layers[h->sps_subset->sps->seq_parameter_set_id]);
-                    break;
-                    
-                    //SVC support
-                case NAL_UNIT_TYPE_CODED_SLICE_SVC_EXTENSION:            
-                    printf("reference extension pps: %d & sps: %d\n", h->sh->pic_parameter_set_id,
-                           h->pps_table[h->sh->pic_parameter_set_id]->seq_parameter_set_id);
-                    
-                    if (pps_buf[h->sh->pic_parameter_set_id] != NULL)
-                    {
-                        fwrite(pps_buf[h->sh->pic_parameter_set_id], 1, pps_buf_size[h->sh->pic_parameter_set_id], outfile_layers[h->pps_table[h->sh->pic_parameter_set_id]->seq_parameter_set_id]);
-                        free(pps_buf[h->sh->pic_parameter_set_id]);
-                        pps_buf[h->sh->pic_parameter_set_id] = NULL;
-                    }
-                    
-                    //start saving the slices
-                    fwrite(p - nal_start, 1, nal_end, outfile_layers[h->pps_table[h->sh->pic_parameter_set_id]->seq_parameter_set_id]);
-                    break;
-                    
-                default:
-                    fwrite(p - nal_start, 1, nal_end, outfile_misc);
-                    break;
+                h264_nal_span_t out;
+                int keep = h264_svc_extract_nal(extractor, nal.buf, nal.size, &out);
+                if (keep < 0) { fprintf( stderr, "!! Scalability information SEI at offset %lld could not be rewritten, kept as it is\n", (long long int)(off + (nal.buf - buf))); }
+                if (keep != 0) { write_nal(outfile_filtered, out.buf, out.size); }
+            }
+            else if (filter != NULL)
+            {
+                if (h264_nal_filter_keep(filter, nal.buf, nal.size)) { write_nal(outfile_filtered, nal.buf, nal.size); }
+            }
+            else if (h264_svc_demux_nal(demux, nal.buf, nal.size) < -1)
+            {
+                fprintf( stderr, "!! Broken NAL at offset %lld, skipped\n", (long long int)(off + (nal.buf - buf)));
+                broken++;
             }
-            
-            //save nal to corresponding file
-            
-            //skip to next NAL
-            p += (nal_end - nal_start);
-            sz -= nal_end;
-            
         }
-        
-        // if no NALs found in buffer, discard it
-        if (p == buf)
+
+        if (rsz == 0) { break; }
+        if (used == buf && sz == BUFSIZE) { fprintf( stderr, "!! Error: NAL larger than %d bytes\n", BUFSIZE); break; }
+        off += used - buf;
+        sz -= used - buf;
+        memmove(buf, used, sz);
+    }
+
+    if (extractor != NULL)
+    {
+        fprintf( stderr, "kept %d NALs, dropped %d, rewrote %d scalability information SEI\n", extractor->kept, extractor->dropped, extractor->rewritten_seis);
+        h264_svc_extractor_free(extractor);
+        fclose(outfile_filtered);
+    }
+    if (filter != NULL)
+    {
+        fprintf( stderr, "kept %d NALs, dropped %d\n", filter->kept, filter->dropped);
+        h264_nal_filter_free(filter);
+        fclose(outfile_filtered);
+    }
+    if (demux != NULL)
+    {
+        for (int i = 0; i < H264_SVC_MAX_LAYERS; i++)
+        {
+            if (outputs->num_nals[i] == 0) { continue; }
+            fprintf( stderr, "layer dependency_id %d, quality_id %d, temporal_id %d: %d NALs\n", H264_SVC_LAYER_DEPENDENCY_ID(i),
+                     H264_SVC_LAYER_QUALITY_ID(i), H264_SVC_LAYER_TEMPORAL_ID(i), outputs->num_nals[i]);
+        }
+        h264_svc_demux_free(demux);
+        fclose(outputs->base);
+        fclose(outputs->misc);
+        for (int i = 0; i < H264_SVC_MAX_LAYERS; i++)
         {
-            fprintf( stderr, "!! Did not find any NALs between offset %lld (0x%04llX), size %lld (0x%04llX), discarding \n",
-                    (long long int)off,
-                    (long long int)off,
-                    (long long int)off + sz,
-                    (long long int)off + sz);
-            
-            p = buf + sz;
-            sz = 0;
+            if (outputs->layers[i] != NULL) { fclose(outputs->layers[i]); }
         }
-        
-        memmove(buf, p, sz);
-        off += p - buf;
-        p = buf;
+        free(outputs);
     }
-    
-    h264_free(h);
-    free(buf);
-    
-    fclose(h264_dbgfile);
+
     fclose(infile);
-    fclose(outfile_base);
-    fclose(outfile_misc);
-    for(int i = 0; i < 32; i++) {
-        if (outfile_layers[i] != NULL)
-            fclose(outfile_layers[i]);
-    }
+    free(buf);
 
-    return 0;
+    return broken > 0 ? EXIT_FAILURE : 0;
 }